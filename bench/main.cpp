@@ -0,0 +1,137 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Microbenchmark of the EventBuffer queue.
+ * A producer thread pushes N pointer-sized items through a ring buffer, and the main thread consumes them.
+ * Runs the lock-free SpscThreadBuffer against the ThreadBuffer it replaced, once with single items
+ * (like RunThread queueing events one by one) and once with batches (like PluginThread draining the buffer).
+ *
+ * Usage: spscbench [items] [buffer size]
+ */
+
+#include "threadbuffer.h"
+#include "spscthreadbuffer.h"
+
+#include <QThread>
+#include <cstdio>
+#include <cstdlib>
+#include <time.h>
+#include <stdint.h>
+
+typedef uintptr_t Item; // the EventBuffer queues Event pointers
+
+static uint64_t now () {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static ThreadBuffer<Item> *createBuffer (ThreadBuffer<Item> *, uint32_t size) {
+    return new ThreadBuffer<Item> (size, size, 0, 0);
+}
+
+static SpscThreadBuffer<Item> *createBuffer (SpscThreadBuffer<Item> *, uint32_t size) {
+    return new SpscThreadBuffer<Item> (size, 0);
+}
+
+template<class Buffer>
+class Producer : public QThread
+{
+public:
+    Producer (Buffer *buf, uint64_t n, uint32_t batch) : buf_ (buf), n_ (n), batch_ (batch) {}
+
+protected:
+    void run () {
+        std::vector<Item> items (batch_);
+        for (uint64_t i = 0; i < n_; i += batch_) {
+            uint32_t len = (n_ - i < batch_) ? n_ - i : batch_;
+            for (uint32_t k = 0; k < len; ++k)
+                items [k] = i + k + 1;
+            buf_->write (&items [0], len);
+        }
+    }
+
+private:
+    Buffer *buf_;
+    uint64_t n_;
+    uint32_t batch_;
+};
+
+/* Returns the time per item in ns, or a negative value if items arrived out of order. */
+template<class Buffer>
+static double measure (uint64_t n, uint32_t size, uint32_t batch)
+{
+    Buffer *buf = createBuffer (static_cast<Buffer*> (NULL), size);
+    Producer<Buffer> producer (buf, n, batch);
+    std::vector<Item> items (batch);
+    bool ordered = true;
+    Item expected = 1;
+
+    uint64_t start = now ();
+    producer.start ();
+    while (expected <= n) {
+        // single items are polled for without waiting, batches are drained like in PluginThread::process
+        uint32_t got = (batch == 1) ? buf->read (items, 1) : buf->readAvailable (items);
+        if (!got)
+            QThread::yieldCurrentThread ();
+        for (uint32_t k = 0; k < got; ++k)
+            ordered &= (items [k] == expected++);
+    }
+    uint64_t elapsed = now () - start;
+
+    producer.wait ();
+    delete buf;
+    return ordered ? (double) elapsed / n : -1;
+}
+
+template<class Buffer>
+static void report (const char *name, uint64_t n, uint32_t size, uint32_t batch)
+{
+    // best of three, to smooth out scheduling noise
+    double best = -1;
+    for (int i = 0; i < 3; ++i) {
+        double t = measure<Buffer> (n, size, batch);
+        if (t < 0) {
+            printf ("%-16s %6u  items arrived out of order!\n", name, batch);
+            return;
+        }
+        if (best < 0 || t < best)
+            best = t;
+    }
+    printf ("%-16s %6u  %10.1f\n", name, batch, best);
+}
+
+int main (int argc, char **argv)
+{
+    uint64_t n = (argc > 1) ? strtoull (argv [1], NULL, 0) : 10000000;
+    uint32_t size = (argc > 2) ? strtoul (argv [2], NULL, 0) : 1000;
+
+    printf ("%llu items, buffer size %u\n", (unsigned long long) n, size);
+    printf ("%-16s %6s  %10s\n", "buffer", "batch", "ns/item");
+
+    const uint32_t batches [] = { 1, 64 };
+    for (unsigned i = 0; i < sizeof (batches) / sizeof (batches [0]); ++i) {
+        uint32_t batch = batches [i] < size ? batches [i] : size;
+        report< ThreadBuffer<Item> > ("ThreadBuffer", n, size, batch);
+        report< SpscThreadBuffer<Item> > ("SpscThreadBuffer", n, size, batch);
+    }
+
+    return 0;
+}
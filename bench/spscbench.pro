@@ -0,0 +1,19 @@
+# -------------------------------------------------
+# Microbenchmark: SpscThreadBuffer against ThreadBuffer
+# Build with qmake && make, run ./spscbench [items] [buffer size]
+# -------------------------------------------------
+TARGET = spscbench
+TEMPLATE = app
+CONFIG += qt \
+    console \
+    thread
+CONFIG -= app_bundle
+QT -= gui
+QMAKE_CXXFLAGS_RELEASE += -g \
+    -O3
+INCLUDEPATH += ../include \
+    ../core
+HEADERS += ../core/threadbuffer.h \
+    ../core/spscthreadbuffer.h
+SOURCES += main.cpp \
+    ../core/threadbuffer.cpp
@@ -167,11 +167,16 @@ int BasePlugin::updateConnList (ConnectorList *lst, QListWidget *w) {
     {
         if(pc->hasOtherSide())
         {
-            QString itemText;
-            itemText = pc->getName () + "->" + pc->getConnectedPluginName() + ": " + pc->getOthersideName();
-            QListWidgetItem *it = new QListWidgetItem (itemText, w);
-            it->setData(Qt::UserRole, QVariant::fromValue (pc));
-            w->addItem(it);
+            // one line per connection, outputs may feed several inputs
+            foreach(PluginConnector* other, pc->getConnections())
+            {
+                QString itemText;
+                itemText = pc->getName () + "->" + other->getPlugin()->getName() + ": " + other->getName();
+                QListWidgetItem *it = new QListWidgetItem (itemText, w);
+                it->setData(Qt::UserRole, QVariant::fromValue (pc));
+                it->setData(Qt::UserRole + 1, QVariant::fromValue (other));
+                w->addItem(it);
+            }
             cnt++;
         }
         else
@@ -198,14 +203,14 @@ void BasePlugin::updateDisplayedConnections()
 }
 
 void BasePlugin::itemDblClicked(QListWidgetItem *item) {
-    PluginConnector *pc = item->data (Qt::UserRole).value<PluginConnector*> ();
-    if (pc && pc->hasOtherSide ()) {
+    PluginConnector *other = item->data (Qt::UserRole + 1).value<PluginConnector*> ();
+    if (other) {
         // check whether the connector belongs to a daq module, demux plugins have no inputs
         // XXX: Do this The Right Way (tm), other plugins may also have no inputs
-        if (pc->getConnectedPlugin ()->getInputs ()->size () == 0)
+        if (other->getPlugin ()->getInputs ()->size () == 0)
             return;
 
-        emit jumpToPluginRequested (pc->getConnectedPlugin ());
+        emit jumpToPluginRequested (other->getPlugin ());
     }
 }
 
@@ -235,10 +240,9 @@ void BasePlugin::displayInputConnectionPopup (const QPoint &p) {
     if (act) {
         PluginConnector *newOtherSide = act->data ().value<PluginConnector*> ();
         thisSide->disconnect ();
-        if (newOtherSide) {
-            newOtherSide->disconnect ();
+        // the output keeps feeding its other inputs
+        if (newOtherSide)
             thisSide->connectTo (newOtherSide);
-        }
         updateDisplayedConnections ();
     }
 }
@@ -252,6 +256,7 @@ void BasePlugin::displayOutputConnectionPopup (const QPoint &p) {
         return;
 
     PluginConnector *thisSide = outputList->currentItem ()->data(Qt::UserRole).value<PluginConnector*> ();
+    PluginConnector *curOtherSide = outputList->currentItem ()->data(Qt::UserRole + 1).value<PluginConnector*> ();
 
     QMenu popup;
     popup.addAction (tr("<none>"))->setData (QVariant::fromValue (static_cast<PluginConnector*> (NULL)));
@@ -263,10 +268,14 @@ void BasePlugin::displayOutputConnectionPopup (const QPoint &p) {
     QAction *act = popup.exec (outputList->mapToGlobal(p));
     if (act) {
         PluginConnector *newOtherSide = act->data ().value<PluginConnector*> ();
-        thisSide->disconnect ();
         if (newOtherSide) {
+            // adds a reader, the input gives up its previous source
             newOtherSide->disconnect ();
             thisSide->connectTo (newOtherSide);
+        } else if (curOtherSide) {
+            thisSide->disconnect (curOtherSide);
+        } else {
+            thisSide->disconnect ();
         }
         updateDisplayedConnections ();
     }
@@ -292,6 +301,17 @@ void BasePlugin::createPluginSubmenu (QMenu *popup, PluginConnector::DataType dt
     }
 }
 
+void BasePlugin::processBatch(int nofEvents)
+{
+    // the executor makes the whole batch visible. Step through it, so every call only sees its own event
+    uint32_t last = PluginConnector::currentEvent();
+    for(int i = 0; i < nofEvents; ++i)
+    {
+        PluginConnector::setCurrentEvent(last - (nofEvents - 1) + i);
+        process();
+    }
+}
+
 void BasePlugin::process()
 {
     int cnt = 0;
@@ -0,0 +1,204 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "blockcodec.h"
+
+#include <QtEndian>
+
+#include <cstring>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+size_t BlockCodec::maxBlockSize (size_t size)
+{
+    size_t bound = qMax<size_t> (LZ4_compressBound (size), ZSTD_compressBound (size));
+    return HeaderSize + qMax (bound, size);
+}
+
+bool BlockCodec::readHeader (const char *p, Header *h)
+{
+    const uchar *u = reinterpret_cast<const uchar*> (p);
+    if (qFromLittleEndian<quint32> (u) != Magic || u [4] != Version)
+        return false;
+    if (qFromLittleEndian<quint16> (u + 6) != HeaderSize || u [5] > Zstd)
+        return false;
+
+    h->codec = u [5];
+    h->packedSize = qFromLittleEndian<quint32> (u + 8);
+    h->size = qFromLittleEndian<quint32> (u + 12);
+    h->checksum = qFromLittleEndian<quint32> (u + 16);
+    return true;
+}
+
+static void writeHeader (char *p, const BlockCodec::Header &h)
+{
+    uchar *u = reinterpret_cast<uchar*> (p);
+    qToLittleEndian<quint32> (BlockCodec::Magic, u);
+    u [4] = BlockCodec::Version;
+    u [5] = h.codec;
+    qToLittleEndian<quint16> (BlockCodec::HeaderSize, u + 6);
+    qToLittleEndian<quint32> (h.packedSize, u + 8);
+    qToLittleEndian<quint32> (h.size, u + 12);
+    qToLittleEndian<quint32> (h.checksum, u + 16);
+    qToLittleEndian<quint32> (0, u + 20);
+}
+
+#ifndef __SSE4_2__
+static uint32_t crcTable [256];
+
+static bool initCrcTable ()
+{
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+            c = c & 1 ? (c >> 1) ^ 0x82f63b78 : c >> 1;
+        crcTable [i] = c;
+    }
+    return true;
+}
+#endif
+
+uint32_t BlockCodec::crc32c (const char *data, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+#ifdef __SSE4_2__
+    // the crc32 instruction computes CRC-32C
+    uint64_t crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t v;
+        memcpy (&v, data, 8);
+        crc64 = _mm_crc32_u64 (crc64, v);
+    }
+    crc = crc64;
+    for (; len; ++data, --len)
+        crc = _mm_crc32_u8 (crc, *data);
+#else
+    static bool tableReady = initCrcTable ();
+    Q_UNUSED (tableReady);
+    for (; len; ++data, --len)
+        crc = crcTable [(crc ^ static_cast<uint8_t> (*data)) & 0xff] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+const char *BlockCodec::codecName (int codec)
+{
+    switch (codec) {
+    case None: return "none";
+    case Lz4: return "LZ4";
+    case Zstd: return "zstd";
+    }
+    return "unknown";
+}
+
+BlockCompressor::BlockCompressor (int codec, int level)
+    : codec_ (codec)
+    , level_ (level)
+    , zstd_ (codec == BlockCodec::Zstd ? ZSTD_createCCtx () : NULL)
+{
+}
+
+BlockCompressor::~BlockCompressor ()
+{
+    if (zstd_)
+        ZSTD_freeCCtx (zstd_);
+}
+
+size_t BlockCompressor::pack (const char *src, size_t size, char *dst)
+{
+    using namespace BlockCodec;
+
+    Header h;
+    h.codec = codec_;
+    h.size = size;
+    h.checksum = crc32c (src, size);
+
+    char *payload = dst + HeaderSize;
+    size_t capacity = maxBlockSize (size) - HeaderSize;
+    size_t packed = 0;
+
+    switch (codec_) {
+    case Lz4:
+        if (level_ < 3)
+            packed = LZ4_compress_fast (src, payload, size, capacity, 1);
+        else
+            packed = LZ4_compress_HC (src, payload, size, capacity, level_);
+        break;
+    case Zstd: {
+        size_t ret = ZSTD_compressCCtx (zstd_, payload, capacity, src, size, level_);
+        packed = ZSTD_isError (ret) ? 0 : ret;
+        break;
+    }
+    default:
+        break;
+    }
+
+    // store incompressible data as it is
+    if (packed == 0 || packed >= size) {
+        h.codec = None;
+        packed = size;
+        memcpy (payload, src, size);
+    }
+
+    h.packedSize = packed;
+    writeHeader (dst, h);
+    return HeaderSize + packed;
+}
+
+BlockDecompressor::BlockDecompressor ()
+    : zstd_ (ZSTD_createDCtx ())
+{
+}
+
+BlockDecompressor::~BlockDecompressor ()
+{
+    ZSTD_freeDCtx (zstd_);
+}
+
+bool BlockDecompressor::unpack (const BlockCodec::Header &h, const char *payload, char *dst)
+{
+    using namespace BlockCodec;
+
+    switch (h.codec) {
+    case None:
+        if (h.packedSize != h.size)
+            return false;
+        memcpy (dst, payload, h.size);
+        break;
+    case Lz4:
+        if (LZ4_decompress_safe (payload, dst, h.packedSize, h.size) != static_cast<int> (h.size))
+            return false;
+        break;
+    case Zstd: {
+        size_t ret = ZSTD_decompressDCtx (zstd_, dst, h.size, payload, h.packedSize);
+        if (ZSTD_isError (ret) || ret != h.size)
+            return false;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    return crc32c (dst, h.size) == h.checksum;
+}
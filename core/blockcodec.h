@@ -0,0 +1,116 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include <stdint.h>
+#include <cstddef>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+/*! Block framing of compressed data files.
+ *  A compressed file is a sequence of blocks, one per FileWriter buffer. Each block starts with a header
+ *  of #HeaderSize bytes, all fields little endian:
+ *  \code
+ *    offset  size  field
+ *         0     4  magic, "GCKZ"
+ *         4     1  format version, currently 1
+ *         5     1  codec of the payload
+ *         6     2  header size in bytes
+ *         8     4  payload size in bytes
+ *        12     4  uncompressed size in bytes
+ *        16     4  CRC-32C of the uncompressed data
+ *        20     4  reserved, 0
+ *  \endcode
+ *  Blocks never split a record, so every block can be decoded on its own. Data that does not compress
+ *  is stored with codec None.
+ */
+namespace BlockCodec {
+    enum Codec { None, Lz4, Zstd };
+
+    enum { HeaderSize = 24, Version = 1 };
+    static const uint32_t Magic = 0x5a4b4347;
+
+    struct Header {
+        uint8_t codec;
+        uint32_t packedSize;
+        uint32_t size;
+        uint32_t checksum;
+    };
+
+    /*! Returns the largest block, including the header, that #BlockCompressor::pack creates from \c size bytes. */
+    size_t maxBlockSize (size_t size);
+
+    /*! Decodes the header at \c p. Returns false if it is not a valid block header. */
+    bool readHeader (const char *p, Header *h);
+
+    /*! Returns the CRC-32C (Castagnoli) checksum of \c len bytes at \c data. */
+    uint32_t crc32c (const char *data, size_t len);
+
+    /*! Returns a readable name of \c codec. */
+    const char *codecName (int codec);
+}
+
+/*! Compresses data into blocks. Each thread needs its own instance. */
+class BlockCompressor
+{
+public:
+    /*! \param level codec specific, 1 is the fastest. LZ4 uses its high compression mode from level 3 on. */
+    BlockCompressor (int codec, int level);
+    ~BlockCompressor ();
+
+    /*! Writes the block for \c size bytes at \c src to \c dst, which must hold BlockCodec::maxBlockSize (size) bytes.
+     *  \return the size of the block, including the header
+     */
+    size_t pack (const char *src, size_t size, char *dst);
+
+private:
+    int codec_;
+    int level_;
+    ZSTD_CCtx_s *zstd_;
+
+private: // no copying
+    BlockCompressor (const BlockCompressor &);
+    BlockCompressor &operator= (const BlockCompressor &);
+};
+
+/*! Decompresses blocks created by BlockCompressor. */
+class BlockDecompressor
+{
+public:
+    BlockDecompressor ();
+    ~BlockDecompressor ();
+
+    /*! Decompresses the payload of the block described by \c h into \c dst, which must hold h.size bytes,
+     *  and verifies the checksum.
+     *  \return false if the payload is corrupt
+     */
+    bool unpack (const BlockCodec::Header &h, const char *payload, char *dst);
+
+private:
+    ZSTD_DCtx_s *zstd_;
+
+private: // no copying
+    BlockDecompressor (const BlockDecompressor &);
+    BlockDecompressor &operator= (const BlockDecompressor &);
+};
+
+#endif // BLOCKCODEC_H
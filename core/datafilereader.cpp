@@ -0,0 +1,246 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "datafilereader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+
+DataFileReader::DataFileReader ()
+    : map_ (NULL)
+    , compressed_ (false)
+    , size_ (0)
+    , pos_ (0)
+    , current_ (-1)
+{
+}
+
+DataFileReader::~DataFileReader ()
+{
+    close ();
+}
+
+bool DataFileReader::open (const QString &fileName)
+{
+    close ();
+
+    file_.setFileName (fileName);
+    if (!file_.open (QIODevice::ReadOnly))
+        return false;
+
+    // with the file mapped, reading is a copy from the page cache, which the kernel fills ahead of us
+    uint64_t fileSize = file_.size ();
+    if (fileSize > 0 && (map_ = file_.map (0, fileSize)) != NULL)
+        madvise (map_, fileSize, MADV_SEQUENTIAL);
+
+    char hdr [BlockCodec::HeaderSize];
+    BlockCodec::Header h;
+    compressed_ = readAt (0, hdr, sizeof (hdr)) && BlockCodec::readHeader (hdr, &h);
+
+    if (compressed_)
+        return scanBlocks ();
+
+    size_ = fileSize;
+    return map_ || file_.seek (0);
+}
+
+void DataFileReader::close ()
+{
+    if (map_)
+        file_.unmap (map_);
+    map_ = NULL;
+    file_.close ();
+    compressed_ = false;
+    size_ = 0;
+    pos_ = 0;
+    blocks_.clear ();
+    current_ = -1;
+    data_.clear ();
+    packed_.clear ();
+    scratch_.clear ();
+}
+
+bool DataFileReader::readAt (uint64_t offset, char *data, size_t len)
+{
+    if (map_) {
+        if (offset + len > static_cast<uint64_t> (file_.size ()))
+            return false;
+        memcpy (data, map_ + offset, len);
+        return true;
+    }
+    return file_.seek (offset) && file_.read (data, len) == static_cast<int64_t> (len);
+}
+
+bool DataFileReader::scanBlocks ()
+{
+    uint64_t fileSize = file_.size ();
+    uint64_t offset = 0;
+    char hdr [BlockCodec::HeaderSize];
+
+    while (offset + BlockCodec::HeaderSize <= fileSize) {
+        Block b;
+        if (!readAt (offset, hdr, sizeof (hdr)))
+            return false;
+        if (!BlockCodec::readHeader (hdr, &b.header)) {
+            printf ("DataFileReader: %s: no block header at offset %llu, ignoring the rest of the file\n",
+                    qPrintable (file_.fileName ()), static_cast<unsigned long long> (offset));
+            break;
+        }
+        if (offset + BlockCodec::HeaderSize + b.header.packedSize > fileSize)
+            break; // incomplete block
+
+        b.offset = offset;
+        b.start = size_;
+        if (b.header.size)
+            blocks_.append (b);
+
+        offset += BlockCodec::HeaderSize + b.header.packedSize;
+        size_ += b.header.size;
+    }
+    return true;
+}
+
+bool DataFileReader::loadBlock (int index)
+{
+    const Block &b = blocks_.at (index);
+    data_.resize (b.header.size);
+
+    // mapped files are decompressed straight from the page cache
+    const char *packed = NULL;
+    if (map_) {
+        packed = reinterpret_cast<const char*> (map_) + b.offset + BlockCodec::HeaderSize;
+    } else {
+        packed_.resize (b.header.packedSize);
+        if (readAt (b.offset + BlockCodec::HeaderSize, packed_.data (), packed_.size ()))
+            packed = packed_.constData ();
+    }
+
+    if (!packed || !decompressor_.unpack (b.header, packed, data_.data ())) {
+        printf ("DataFileReader: %s: block at offset %llu is corrupt\n",
+                qPrintable (file_.fileName ()), static_cast<unsigned long long> (b.offset));
+        size_ = b.start;
+        current_ = -1;
+        return false;
+    }
+
+    current_ = index;
+    return true;
+}
+
+// Makes the block holding pos_ the current one
+bool DataFileReader::findBlock ()
+{
+    if (current_ >= 0) {
+        const Block &b = blocks_.at (current_);
+        if (pos_ >= b.start && pos_ < b.start + b.header.size)
+            return true;
+    }
+    if (pos_ >= size_)
+        return false;
+
+    // blocks are mostly read in order, so try the next one first
+    if (current_ + 1 < blocks_.size () && blocks_.at (current_ + 1).start == pos_)
+        return loadBlock (current_ + 1);
+
+    // last block starting at or before pos_
+    int lo = 0, hi = blocks_.size ();
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (blocks_.at (mid).start <= pos_)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return loadBlock (lo);
+}
+
+bool DataFileReader::seek (uint64_t pos)
+{
+    if (!isOpen () || pos > size_)
+        return false;
+
+    if (!compressed_) {
+        if (!map_ && !file_.seek (pos))
+            return false;
+        pos_ = pos;
+        return true;
+    }
+
+    pos_ = pos;
+    return pos_ == size_ || findBlock ();
+}
+
+int64_t DataFileReader::read (char *data, size_t len)
+{
+    if (!isOpen ())
+        return -1;
+
+    if (!compressed_) {
+        if (!map_) {
+            int64_t n = file_.read (data, len);
+            if (n > 0)
+                pos_ += n;
+            return n;
+        }
+        size_t n = qMin<uint64_t> (len, size_ - pos_);
+        memcpy (data, map_ + pos_, n);
+        pos_ += n;
+        return n;
+    }
+
+    size_t done = 0;
+    while (done < len && pos_ < size_) {
+        if (!findBlock ())
+            return done ? static_cast<int64_t> (done) : -1;
+
+        const Block &b = blocks_.at (current_);
+        size_t offset = pos_ - b.start;
+        size_t n = qMin<size_t> (len - done, b.header.size - offset);
+        memcpy (data + done, data_.constData () + offset, n);
+        done += n;
+        pos_ += n;
+    }
+    return done;
+}
+
+const char *DataFileReader::peek (size_t len)
+{
+    if (!isOpen () || len > size_ - pos_)
+        return NULL;
+
+    if (!compressed_ && map_)
+        return reinterpret_cast<const char*> (map_) + pos_;
+
+    if (compressed_) {
+        if (!findBlock ())
+            return NULL;
+        const Block &b = blocks_.at (current_);
+        size_t offset = pos_ - b.start;
+        if (offset + len <= b.header.size)
+            return data_.constData () + offset;
+    }
+
+    // FileWriter does not split records across blocks, so this is rare
+    uint64_t pos = pos_;
+    scratch_.resize (len);
+    if (read (scratch_.data (), len) != static_cast<int64_t> (len) || !seek (pos))
+        return NULL;
+    return scratch_.constData ();
+}
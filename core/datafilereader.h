@@ -0,0 +1,107 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATAFILEREADER_H
+#define DATAFILEREADER_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#include <QFile>
+#include <QVector>
+
+#include "blockcodec.h"
+
+/*! Reads data files written by FileWriter, compressed or not.
+ *  Compressed files are recognised by the block header at the start of the file and decompressed block by block
+ *  while reading, so the caller always sees the original byte stream. Blocks with a bad checksum end the data.
+ *  A block cut off at the end of the file, eg. because the writer is still running, is ignored.
+ *
+ *  The file is mapped into memory if possible and read sequentially by the kernel ahead of the caller.
+ *  #peek then hands out the data of uncompressed files, and of the current block of compressed files, without copying it.
+ */
+class DataFileReader
+{
+public:
+    DataFileReader ();
+    ~DataFileReader ();
+
+    /*! Opens \c fileName and, for compressed files, reads the table of blocks.
+     *  \return false if the file could not be opened
+     */
+    bool open (const QString &fileName);
+    void close ();
+    bool isOpen () const { return file_.isOpen (); }
+
+    /*! Returns whether the file consists of compressed blocks. */
+    bool isCompressed () const { return compressed_; }
+    /*! Returns the size of the uncompressed data. */
+    uint64_t size () const { return size_; }
+    /*! Returns the position in the uncompressed data. */
+    uint64_t pos () const { return pos_; }
+    bool atEnd () const { return pos_ >= size_; }
+
+    /*! Moves to position \c pos of the uncompressed data. Returns false if it is beyond the end. */
+    bool seek (uint64_t pos);
+
+    /*! Copies up to \c len bytes to \c data and advances the position.
+     *  \return the number of bytes read, 0 at the end of the data and -1 on errors
+     */
+    int64_t read (char *data, size_t len);
+
+    /*! Returns the next \c len bytes without advancing the position, or NULL if fewer are left.
+     *  The data is only copied if the file could not be mapped or the bytes span two blocks.
+     *  The pointer stays valid until the next call of #read, #seek, #skip or #peek.
+     */
+    const char *peek (size_t len);
+    /*! Advances the position by \c len bytes. Returns false if that is beyond the end. */
+    bool skip (size_t len) { return seek (pos_ + len); }
+
+private:
+    struct Block {
+        uint64_t offset;   // of the header in the file
+        uint64_t start;    // of the data in the uncompressed stream
+        BlockCodec::Header header;
+    };
+
+    bool readAt (uint64_t offset, char *data, size_t len);
+    bool scanBlocks ();
+    bool loadBlock (int index);
+    bool findBlock ();
+
+private:
+    QFile file_;
+    uchar *map_;           // the whole file, NULL if it is not mapped
+    bool compressed_;
+    uint64_t size_;
+    uint64_t pos_;
+
+    QVector<Block> blocks_;
+    int current_;          // block in data_, -1 if none
+    QVector<char> data_;   // uncompressed data of the current block
+    QVector<char> packed_; // compressed data of the current block, if the file is not mapped
+    QVector<char> scratch_;
+    BlockDecompressor decompressor_;
+
+private: // no copying
+    DataFileReader (const DataFileReader &);
+    DataFileReader &operator= (const DataFileReader &);
+};
+
+#endif // DATAFILEREADER_H
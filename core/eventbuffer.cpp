@@ -18,13 +18,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "eventbuffer.h"
-#include "threadbuffer.h"
+#include "spscthreadbuffer.h"
 
-#include <QAtomicInt>
+#include <iostream>
 
 EventBuffer::EventBuffer (size_t size)
-: Buffer_ (new ThreadBuffer<Event*> (size, 1, -1))
-, UnusedQ_ (new ThreadBuffer<Event*> (size, 1, -1))
+: SlotCount_ (0)
+, Buffer_ (new SpscThreadBuffer<Event*> (size, NULL))
+, UnusedQ_ (new SpscThreadBuffer<Event*> (size, NULL))
+, Policy_ (Block)
+, MemoryBudget_ (0)
+, Limit_ ((int) size)
+, Lost_ (0)
+, Arrivals_ (0)
+, Offered_ (0)
+, Rng_ (0x9e3779b97f4a7c15ULL)
 {
 }
 
@@ -33,11 +41,11 @@ bool EventBuffer::empty () const {
 }
 
 bool EventBuffer::full () const {
-    return Buffer_->free () == 0;
+    return level () >= size ();
 }
 
 size_t EventBuffer::size () const {
-    return Buffer_->getSize ();
+    return Limit_;
 }
 
 size_t EventBuffer::level () const {
@@ -45,10 +53,10 @@ size_t EventBuffer::level () const {
 }
 
 void EventBuffer::setSize (size_t newsz) {
-    ThreadBuffer<Event*>* newbuf = new ThreadBuffer<Event*> (newsz, 1, -1);
-    ThreadBuffer<Event*>* newq = new ThreadBuffer<Event*> (newsz, 1, -1);
-    ThreadBuffer<Event*>* oldbuf = Buffer_;
-    ThreadBuffer<Event*>* oldq = UnusedQ_;
+    SpscThreadBuffer<Event*>* newbuf = new SpscThreadBuffer<Event*> (newsz, NULL);
+    SpscThreadBuffer<Event*>* newq = new SpscThreadBuffer<Event*> (newsz, NULL);
+    SpscThreadBuffer<Event*>* oldbuf = Buffer_;
+    SpscThreadBuffer<Event*>* oldq = UnusedQ_;
 
     // prepare the event pool
     std::vector<Event*> evs;
@@ -65,9 +73,50 @@ void EventBuffer::setSize (size_t newsz) {
     UnusedQ_ = newq;
     delete oldbuf;
     delete oldq;
+
+    Limit_ = (int) newsz;
+    MemoryBudget_ = 0;
+    // the producer never holds more than the buffer size in discarded or held back events
+    Spare_.reserve (newsz);
+    Reservoir_.reserve (newsz / 2 + 1);
+}
+
+void EventBuffer::setMemoryBudget (size_t bytes) {
+    if (bytes == 0) {
+        MemoryBudget_ = 0;
+        return;
+    }
+    if (Buffer_->getSize () != MaxBudgetEvents)
+        setSize (MaxBudgetEvents);
+    MemoryBudget_ = bytes;
+    Limit_ = EventPayloadArena::WarmupEvents;
+}
+
+EventBuffer::OverflowPolicy EventBuffer::toOverflowPolicy (int p) {
+    switch (p) {
+    case DropNewest: return DropNewest;
+    case DropOldest: return DropOldest;
+    case Sample: return Sample;
+    default: return Block;
+    }
+}
+
+QString EventBuffer::getOverflowPolicyName (OverflowPolicy p) {
+    switch (p) {
+    case DropNewest: return "drop newest";
+    case DropOldest: return "drop oldest";
+    case Sample: return "sample";
+    default: return "block";
+    }
 }
 
 Event* EventBuffer::createEvent () {
+    if (!Spare_.empty ()) {
+        Event *ev = Spare_.back ();
+        Spare_.pop_back ();
+        return ev;
+    }
+
     std::vector<Event*> rd (1);
     if (UnusedQ_->read (rd, 1) != 1) {
         return new Event (this);
@@ -77,16 +126,143 @@ Event* EventBuffer::createEvent () {
 }
 
 void EventBuffer::releaseEvent (Event *ev) {
+    bool warmedUp = Arena_.isWarmingUp () && Arena_.record (ev);
+
     if (UnusedQ_->free() != 0) {
         ev->clear ();
+        Arena_.prepare (ev);
         UnusedQ_->write(&ev, 1);
     } else {
         delete ev;
     }
+
+    if (warmedUp) {
+        if (MemoryBudget_) {
+            size_t n = MemoryBudget_ / Arena_.getEventBytes (SlotCount_);
+            Limit_ = (int) std::max<size_t> (1, std::min<size_t> (n, Buffer_->getSize ()));
+        }
+        fillPool ();
+    }
+}
+
+void EventBuffer::startRun () {
+    Arena_.restart ();
+    Lost_ = 0;
+    Arrivals_ = 0;
+    Offered_ = 0;
+    if (MemoryBudget_)
+        Limit_ = EventPayloadArena::WarmupEvents;
+}
+
+void EventBuffer::stopRun () {
+    if (!Reservoir_.empty ())
+        std::cout << "EventBuffer: " << Reservoir_.size () << " sampled events could not be delivered before the end of the run." << std::endl;
+    for (size_t i = 0; i < Reservoir_.size (); ++i) {
+        recycle (Reservoir_ [i].second);
+        Lost_.ref ();
+    }
+    Reservoir_.clear ();
+    Offered_ = 0;
+}
+
+void EventBuffer::recycle (Event *ev) {
+    ev->clear ();
+    Spare_.push_back (ev);
+}
+
+void EventBuffer::fillPool () {
+    // preallocate the events the run thread is going to ask for, so it does not have to allocate during the run
+    size_t used = Buffer_->available () + UnusedQ_->available ();
+    size_t n = std::min<size_t> (UnusedQ_->free (), used < size () ? size () - used : 0);
+    for (size_t i = 0; i < n; ++i) {
+        Event *ev = new Event (this);
+        Arena_.prepare (ev);
+        UnusedQ_->write (&ev, 1);
+    }
+}
+
+int EventBuffer::queue (Event *ev) {
+    ++Arrivals_;
+    int queued = Reservoir_.empty () ? 0 : flushReservoir ();
+
+    if (Buffer_->available () < (size_t) Limit_ && Reservoir_.empty ()) {
+        Buffer_->write (&ev, 1);
+        return queued + 1;
+    }
+
+    return queued + queueOverflow (ev);
 }
 
-bool EventBuffer::queue (Event *ev) {
-    return Buffer_->write(&ev, 1) == 1;
+int EventBuffer::queueOverflow (Event *ev) {
+    switch (Policy_) {
+    case DropNewest:
+        recycle (ev);
+        Lost_.ref ();
+        return 0;
+
+    case DropOldest: {
+        Event *old;
+        if (!Buffer_->tryReclaim (old)) {
+            // the consumer took it first, so there is room now
+            Buffer_->write (&ev, 1);
+            return 1;
+        }
+        recycle (old);
+        Lost_.ref ();
+        Buffer_->write (&ev, 1);
+        return 0;
+    }
+
+    case Sample: {
+        // reservoir sampling (algorithm R) over the events of the overflow period
+        ++Offered_;
+        size_t capacity = std::max<size_t> (1, (size_t) Limit_ / 2);
+        if (Reservoir_.size () < capacity) {
+            Reservoir_.push_back (std::make_pair (Arrivals_, ev));
+            return 0;
+        }
+
+        Rng_ ^= Rng_ << 13;
+        Rng_ ^= Rng_ >> 7;
+        Rng_ ^= Rng_ << 17;
+        uint64_t j = Rng_ % Offered_;
+        if (j < capacity) {
+            recycle (Reservoir_ [j].second);
+            Reservoir_ [j] = std::make_pair (Arrivals_, ev);
+        } else {
+            recycle (ev);
+        }
+        Lost_.ref ();
+        return 0;
+    }
+
+    default:
+        // wait until the level drops below the limit, which may be smaller than the ring
+        Buffer_->waitForFree (Buffer_->getSize () - Limit_ + 1);
+        Buffer_->write (&ev, 1);
+        return 1;
+    }
+}
+
+int EventBuffer::flushReservoir () {
+    if (Reservoir_.empty ())
+        return 0;
+
+    size_t level = Buffer_->available ();
+    size_t limit = Limit_;
+    if (level >= limit)
+        return 0;
+
+    // queue the oldest held back events first
+    std::sort (Reservoir_.begin (), Reservoir_.end ());
+    size_t n = std::min (limit - level, Reservoir_.size ());
+    for (size_t i = 0; i < n; ++i)
+        Buffer_->write (&Reservoir_ [i].second, 1);
+    Reservoir_.erase (Reservoir_.begin (), Reservoir_.begin () + n);
+
+    if (Reservoir_.empty ())
+        Offered_ = 0;
+    return n;
 }
 
 Event* EventBuffer::dequeue () {
@@ -97,8 +273,18 @@ Event* EventBuffer::dequeue () {
     return rd.front ();
 }
 
+size_t EventBuffer::dequeue (std::vector<Event*> &evs, size_t max) {
+    size_t n = std::min<size_t> (Buffer_->available (), max);
+    evs.resize (n);
+    if (n != 0)
+        n = Buffer_->read (evs, n);
+    evs.resize (n);
+    return n;
+}
+
 EventSlot *EventBuffer::registerSlot (const AbstractModule *owner, QString name, PluginConnector::DataType type) {
-    EventSlot *slot = new EventSlot (owner, name, type);
+    // indices are never reused, so stale references to destroyed slots can not alias new ones
+    EventSlot *slot = new EventSlot (owner, name, type, SlotCount_++);
     if (Slots_.find (owner) == Slots_.end ()) // owning module not yet in registry
         Slots_.insert (owner, new SlotSet ());
     Slots_.value (owner)->push_back (slot);
@@ -151,54 +337,180 @@ EventBuffer::~EventBuffer () {
     UnusedQ_->readAvailable (rd);
     for (std::vector<Event*>::iterator i = rd.begin (); i != rd.end (); ++i)
         delete *i;
+    for (std::vector<Event*>::iterator i = Spare_.begin (); i != Spare_.end (); ++i)
+        delete *i;
+    for (size_t i = 0; i < Reservoir_.size (); ++i)
+        delete Reservoir_ [i].second;
 
     delete Buffer_;
     delete UnusedQ_;
 }
 
 Event::Event (EventBuffer *buffer)
-: EvBuf_ (buffer)
+: Cells_ (buffer->getSlotCount ())
+, EvBuf_ (buffer)
+, QueueTime_ (0)
 {
+    Occupied_.reserve (Cells_.size ());
 }
 
 Event::~Event ()
 {
 }
 
+EventPayload &Event::cell (int idx) {
+    // slots registered after the event was created
+    if (idx >= Cells_.size ())
+        Cells_.resize (qMax (idx + 1, EvBuf_->getSlotCount ()));
+    return Cells_ [idx];
+}
+
 void Event::put (const EventSlot *slot, QVariant data) {
-    Data_.insert (slot, data);
+    if (data.isNull ()) {
+        Occupied_.reset (slot->getIndex ());
+        return;
+    }
+
+    switch (slot->getDataType ()) {
+    case PluginConnector::Uint32:
+        putData (slot, data.value<uint32_t> ());
+        break;
+    case PluginConnector::Double:
+        putData (slot, data.value<double> ());
+        break;
+    case PluginConnector::VectorUint32:
+        putData (slot, data.value< QVector<uint32_t> > ());
+        break;
+    case PluginConnector::VectorDouble:
+        putData (slot, data.value< QVector<double> > ());
+        break;
+    }
 }
 
 QVariant Event::get(const EventSlot *slot) const {
-    DataMap::const_iterator i = Data_.find (slot);
-    if (i != Data_.end ())
-        return i.value ();
+    if (!isOccupied (slot))
+        return QVariant ();
+
+    switch (slot->getDataType ()) {
+    case PluginConnector::Uint32:
+        return QVariant::fromValue (getData<uint32_t> (slot));
+    case PluginConnector::Double:
+        return QVariant::fromValue (getData<double> (slot));
+    case PluginConnector::VectorUint32:
+        return QVariant::fromValue (getData< QVector<uint32_t> > (slot));
+    case PluginConnector::VectorDouble:
+        return QVariant::fromValue (getData< QVector<double> > (slot));
+    }
     return QVariant ();
 }
 
-QSet<const EventSlot *> Event::getOccupiedSlots () const {
-    QSet<const EventSlot *> ret;
-    ret.reserve (Data_.size ());
+namespace {
+    // empty a vector for the next event, see Event::clear
+    template<typename E> void recycleVector (QVector<E> &v) {
+        if (v.isDetached ()) {
+            v.reserve (v.size ());
+            v.resize (0);
+        } else {
+            v = QVector<E> ();
+        }
+    }
+}
 
-    for (DataMap::const_iterator i = Data_.begin (); i != Data_.end (); ++i)
-        if (!i.value ().isNull ())
-            ret.insert (i.key ());
-    return ret;
+bool Event::isOccupied (const EventSlot *slot) const {
+    return Occupied_.test (slot->getIndex ());
 }
 
 void Event::clear () {
-    for (DataMap::iterator i = Data_.begin (); i != Data_.end (); ++i) {
-        if (i.value ().canConvert< QVector<uint32_t> > ()) {
-            QVector<uint32_t> v = i.value().value< QVector<uint32_t> > ();
-            v.reserve (v.size ());
-            v.resize (0);
-            i.value () = QVariant::fromValue (v);
-        }
+    for (int i = Occupied_.next (0); i >= 0; i = Occupied_.next (i + 1)) {
+        EventPayload &p = Cells_ [i];
+        // keep the allocated storage for the next event, unless someone else still holds a copy
+        recycleVector (p.VectorUint32_);
+        recycleVector (p.VectorDouble_);
+        p.LatchedUint32_ = 0;
+        p.LatchedDouble_ = 0;
+    }
+    Occupied_.clear ();
+    for (std::vector<RawData>::iterator i = Raw_.begin (); i != Raw_.end (); ++i) {
+        i->Valid_ = false;
+        recycleVector (i->Data_);
+    }
+    QueueTime_ = 0;
+}
 
-        i.value ().clear ();
+QVector<uint32_t> &Event::storeRaw (const AbstractModule *m) {
+    // decoders running in parallel must not resize the cells or the mask
+    int count = EvBuf_->getSlotCount ();
+    if (count > Cells_.size ())
+        Cells_.resize (count);
+    Occupied_.reserve (count);
+
+    for (std::vector<RawData>::iterator i = Raw_.begin (); i != Raw_.end (); ++i) {
+        if (i->Module_ == m) {
+            i->Valid_ = true;
+            return i->Data_;
+        }
     }
+
+    RawData r;
+    r.Module_ = m;
+    r.Valid_ = true;
+    Raw_.push_back (r);
+    return Raw_.back ().Data_;
+}
+
+const QVector<uint32_t> *Event::getRaw (const AbstractModule *m) const {
+    for (std::vector<RawData>::const_iterator i = Raw_.begin (); i != Raw_.end (); ++i)
+        if (i->Module_ == m)
+            return i->Valid_ ? &i->Data_ : NULL;
+    return NULL;
 }
 
 EventBuffer *Event::getBuffer () const {
     return EvBuf_;
 }
+
+void EventPayloadArena::restart () {
+    Uint32Sizes_.clear ();
+    DoubleSizes_.clear ();
+    RawWords_ = 0;
+    Warmup_ = WarmupEvents;
+}
+
+bool EventPayloadArena::record (const Event *ev) {
+    const EventSlotMask &occ = ev->getOccupiedSlots ();
+    for (int i = occ.next (0); i >= 0; i = occ.next (i + 1)) {
+        const EventPayload &p = ev->Cells_.at (i);
+        if ((size_t) i >= Uint32Sizes_.size ()) {
+            Uint32Sizes_.resize (i + 1, 0);
+            DoubleSizes_.resize (i + 1, 0);
+        }
+        Uint32Sizes_ [i] = std::max (Uint32Sizes_ [i], std::max (p.VectorUint32_.size (), p.LatchedUint32_));
+        DoubleSizes_ [i] = std::max (DoubleSizes_ [i], std::max (p.VectorDouble_.size (), p.LatchedDouble_));
+    }
+
+    int raw = 0;
+    for (std::vector<Event::RawData>::const_iterator i = ev->Raw_.begin (); i != ev->Raw_.end (); ++i)
+        raw += i->Data_.size ();
+    RawWords_ = std::max (RawWords_, raw);
+    return --Warmup_ == 0;
+}
+
+size_t EventPayloadArena::getEventBytes (int cells) const {
+    size_t bytes = sizeof (Event) + cells * sizeof (EventPayload) + RawWords_ * sizeof (uint32_t);
+    for (size_t i = 0; i < Uint32Sizes_.size (); ++i)
+        bytes += Uint32Sizes_ [i] * sizeof (uint32_t) + DoubleSizes_ [i] * sizeof (double);
+    return bytes;
+}
+
+void EventPayloadArena::prepare (Event *ev) const {
+    for (size_t i = 0; i < Uint32Sizes_.size (); ++i) {
+        if (!Uint32Sizes_ [i] && !DoubleSizes_ [i])
+            continue;
+        // reserve does nothing if the cell already has enough storage
+        EventPayload &p = ev->cell (i);
+        if (Uint32Sizes_ [i])
+            p.VectorUint32_.reserve (Uint32Sizes_ [i]);
+        if (DoubleSizes_ [i])
+            p.VectorDouble_.reserve (DoubleSizes_ [i]);
+    }
+}
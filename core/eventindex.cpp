@@ -0,0 +1,292 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "eventindex.h"
+#include "datafilereader.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <cstdio>
+#include <ctime>
+
+// meta words of the SIS3350 demultiplexer: marker, length, time stamp high, time stamp low, ...
+static const uint32_t Sis3350MetaMarker = 0xBBBB3000;
+
+static void encodeEntry (uchar *p, const EventIndexEntry &e)
+{
+    qToLittleEndian<quint64> (e.event, p);
+    qToLittleEndian<quint64> (e.offset, p + 8);
+    qToLittleEndian<quint64> (e.timestamp, p + 16);
+    qToLittleEndian<quint64> (e.time, p + 24);
+    qToLittleEndian<quint32> (e.chMask, p + 32);
+    qToLittleEndian<quint32> (0, p + 36);
+}
+
+static void encodeHeader (uchar *p, uint32_t stride)
+{
+    qToLittleEndian<quint32> (EventIndex::Magic, p);
+    qToLittleEndian<quint16> (EventIndex::Version, p + 4);
+    qToLittleEndian<quint16> (EventIndex::HeaderSize, p + 6);
+    qToLittleEndian<quint16> (EventIndex::EntrySize, p + 8);
+    qToLittleEndian<quint16> (0, p + 10);
+    qToLittleEndian<quint32> (stride, p + 12);
+}
+
+// entries are ordered by event, and by time as long as the clocks do not jump
+static int lastAtOrBefore (const QVector<EventIndexEntry> &entries, uint64_t EventIndexEntry::*field, uint64_t value)
+{
+    int lo = 0, hi = entries.size ();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (entries.at (mid).*field <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+
+bool EventIndex::load (const QString &dataFileName)
+{
+    entries_.clear ();
+    stride_ = 0;
+
+    QFile file (fileNameFor (dataFileName));
+    if (!file.open (QIODevice::ReadOnly))
+        return false;
+
+    QByteArray data = file.readAll ();
+    const uchar *p = reinterpret_cast<const uchar*> (data.constData ());
+    if (data.size () < HeaderSize
+        || qFromLittleEndian<quint32> (p) != Magic
+        || qFromLittleEndian<quint16> (p + 4) != Version)
+    {
+        printf ("EventIndex: %s is not a valid index\n", qPrintable (file.fileName ()));
+        return false;
+    }
+
+    int headerSize = qFromLittleEndian<quint16> (p + 6);
+    int entrySize = qFromLittleEndian<quint16> (p + 8);
+    if (headerSize < HeaderSize || entrySize < EntrySize) {
+        printf ("EventIndex: %s is not a valid index\n", qPrintable (file.fileName ()));
+        return false;
+    }
+    stride_ = qFromLittleEndian<quint32> (p + 12);
+
+    // a partly written entry at the end is ignored
+    for (int pos = headerSize; pos + entrySize <= data.size (); pos += entrySize) {
+        EventIndexEntry e;
+        e.event = qFromLittleEndian<quint64> (p + pos);
+        e.offset = qFromLittleEndian<quint64> (p + pos + 8);
+        e.timestamp = qFromLittleEndian<quint64> (p + pos + 16);
+        e.time = qFromLittleEndian<quint64> (p + pos + 24);
+        e.chMask = qFromLittleEndian<quint32> (p + pos + 32);
+        entries_.append (e);
+    }
+    return true;
+}
+
+bool EventIndex::save (const QString &dataFileName) const
+{
+    QFile file (fileNameFor (dataFileName));
+    if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QByteArray data (HeaderSize + entries_.size () * EntrySize, 0);
+    uchar *p = reinterpret_cast<uchar*> (data.data ());
+    encodeHeader (p, stride_);
+    for (int i = 0; i < entries_.size (); ++i)
+        encodeEntry (p + HeaderSize + i * EntrySize, entries_.at (i));
+
+    return file.write (data) == data.size ();
+}
+
+bool EventIndex::build (DataFileReader *reader, uint32_t stride)
+{
+    entries_.clear ();
+    stride_ = qMax<uint32_t> (stride, 1);
+
+    if (!reader->seek (0))
+        return false;
+
+    QVector<uint32_t> words;
+    uint64_t event = 0;
+    uint64_t offset = 0;
+    while (readEvent (reader, &words)) {
+        if (event % stride_ == 0) {
+            // the first input with data follows the header, the lengths and nothing else
+            uint32_t nofInputs = (words.at (0) >> 16) - 2;
+            const uint32_t *first = words.constData () + 2 + nofInputs;
+            uint32_t firstLen = nofInputs ? words.at (2) : 0;
+
+            EventIndexEntry e;
+            e.event = event;
+            e.offset = offset;
+            e.timestamp = moduleTimestamp (first, firstLen);
+            e.time = 0;
+            e.chMask = words.at (1);
+            entries_.append (e);
+        }
+        ++event;
+        offset = reader->pos ();
+    }
+
+    if (!reader->atEnd ())
+        printf ("EventIndex: no valid event at offset %llu\n", static_cast<unsigned long long> (offset));
+    return event > 0;
+}
+
+int EventIndex::findEvent (uint64_t event) const
+{
+    return lastAtOrBefore (entries_, &EventIndexEntry::event, event);
+}
+
+int EventIndex::findTimestamp (uint64_t timestamp) const
+{
+    int i = lastAtOrBefore (entries_, &EventIndexEntry::timestamp, timestamp);
+    return i >= 0 && entries_.at (i).timestamp ? i : -1;
+}
+
+int EventIndex::findTime (uint64_t time) const
+{
+    int i = lastAtOrBefore (entries_, &EventIndexEntry::time, time);
+    return i >= 0 && entries_.at (i).time ? i : -1;
+}
+
+int EventIndex::findOffset (uint64_t offset) const
+{
+    return lastAtOrBefore (entries_, &EventIndexEntry::offset, offset);
+}
+
+bool EventIndex::readEvent (DataFileReader *reader, QVector<uint32_t> *words)
+{
+    uchar hdr [8];
+    if (reader->read (reinterpret_cast<char*> (hdr), sizeof (hdr)) != sizeof (hdr))
+        return false;
+
+    uint16_t magic = qFromLittleEndian<quint16> (hdr);
+    uint16_t headerLength = qFromLittleEndian<quint16> (hdr + 2);
+    uint32_t chMask = qFromLittleEndian<quint32> (hdr + 4);
+    if (magic != 0xFEED || headerLength < 2)
+        return false;
+
+    uint32_t nofInputs = headerLength - 2;
+    words->resize (headerLength);
+    // header words as written: 0xFEED in the low half, the header length in the high half
+    (*words) [0] = qFromLittleEndian<quint32> (hdr);
+    (*words) [1] = chMask;
+
+    if (nofInputs) {
+        int64_t len = nofInputs * sizeof (uint32_t);
+        if (reader->read (reinterpret_cast<char*> (words->data () + 2), len) != len)
+            return false;
+    }
+
+    uint64_t total = headerLength + nofInputs; // separators
+    for (uint32_t i = 0; i < nofInputs; ++i) {
+        (*words) [2 + i] = qFromLittleEndian<quint32> (reinterpret_cast<const uchar*> (words->constData () + 2 + i));
+        total += words->at (2 + i);
+    }
+    // more than 1 GiB is no event but garbage
+    if (total > (1 << 28))
+        return false;
+
+    words->resize (total);
+    int64_t len = (total - headerLength) * sizeof (uint32_t);
+    if (len && reader->read (reinterpret_cast<char*> (words->data () + headerLength), len) != len)
+        return false;
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    for (int i = headerLength; i < words->size (); ++i)
+        (*words) [i] = qFromLittleEndian<quint32> (reinterpret_cast<const uchar*> (words->constData () + i));
+#endif
+    return true;
+}
+
+uint64_t EventIndex::moduleTimestamp (const uint32_t *data, size_t len)
+{
+    if (len >= 4 && data [0] == Sis3350MetaMarker)
+        return (static_cast<uint64_t> (data [2]) << 32) | data [3];
+    return 0;
+}
+
+uint64_t EventIndex::currentTime ()
+{
+    timespec ts;
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return ts.tv_sec * UINT64_C (1000000) + ts.tv_nsec / 1000;
+}
+
+EventIndexWriter::EventIndexWriter ()
+    : stride_ (1)
+    , fileIndex_ (0)
+{
+}
+
+bool EventIndexWriter::open (const FileWriter &data, uint32_t stride)
+{
+    // a few entries per second, no need for big buffers
+    FileWriterConfig conf;
+    conf.buffer_kib = 64;
+    conf.nof_buffers = 4;
+    writer_.setConfig (conf);
+
+    stride_ = qMax<uint32_t> (stride, 1);
+    fileIndex_ = data.getFileIndex ();
+    if (!writer_.open (EventIndex::fileNameFor (data.getFileName ()))) {
+        printf ("EventIndex: could not open %s\n", qPrintable (EventIndex::fileNameFor (data.getFileName ())));
+        return false;
+    }
+    writeHeader ();
+    return true;
+}
+
+void EventIndexWriter::close ()
+{
+    writer_.close ();
+}
+
+void EventIndexWriter::add (const FileWriter &data, uint64_t event, uint32_t chMask, uint64_t timestamp)
+{
+    // follow the data to its next file
+    if (data.getFileIndex () != fileIndex_) {
+        fileIndex_ = data.getFileIndex ();
+        writer_.switchFile (EventIndex::fileNameFor (data.getFileName ()));
+        writeHeader ();
+    }
+
+    EventIndexEntry e;
+    e.event = event;
+    e.offset = data.getFileBytes ();
+    e.timestamp = timestamp;
+    e.time = EventIndex::currentTime ();
+    e.chMask = chMask;
+
+    uchar *p = reinterpret_cast<uchar*> (writer_.reserve (EventIndex::EntrySize));
+    encodeEntry (p, e);
+    writer_.commit (EventIndex::EntrySize);
+}
+
+void EventIndexWriter::writeHeader ()
+{
+    uchar *p = reinterpret_cast<uchar*> (writer_.reserve (EventIndex::HeaderSize));
+    encodeHeader (p, stride_);
+    writer_.commit (EventIndex::HeaderSize);
+}
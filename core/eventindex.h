@@ -0,0 +1,146 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTINDEX_H
+#define EVENTINDEX_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#include <QString>
+#include <QVector>
+
+#include "filewriter.h"
+
+class DataFileReader;
+
+/*! One entry of an event index. */
+struct EventIndexEntry {
+    uint64_t event;      // number of the event in the run (or in the file, for indexes built by EventIndex::build)
+    uint64_t offset;     // position of the event header in the uncompressed data, see DataFileReader::seek
+    uint64_t timestamp;  // module time stamp of the event, 0 if it carries none
+    uint64_t time;       // time of recording in microseconds since the epoch, 0 if unknown
+    uint32_t chMask;     // inputs with data
+};
+
+/*! Offset table of the events in a data file written by EventBuilderPlugin.
+ *  The table is kept in a sidecar file named after the data file with .idx appended, so it can be written
+ *  while the data file grows and works for compressed files as well. Entries are written every \c stride events
+ *  and for the first event of every data file, so each sidecar is complete on its own.
+ *
+ *  Sidecar layout, all fields little endian:
+ *  \code
+ *    header, 16 bytes: magic "GCKX", u16 version (1), u16 header size, u16 entry size, u16 reserved, u32 stride
+ *    entries, 40 bytes each: u64 event, u64 offset, u64 timestamp, u64 time, u32 channel mask, u32 reserved
+ *  \endcode
+ *
+ *  Event format of the data files:
+ *  \code
+ *    u16 0xFEED, u16 header length in words (2 + n), u32 channel mask,
+ *    n x u32 data length of each input with data,
+ *    n x (data words, u32 0xFFFFFFFF separator)
+ *  \endcode
+ */
+class EventIndex
+{
+public:
+    enum { Version = 1, HeaderSize = 16, EntrySize = 40 };
+    static const uint32_t Magic = 0x584b4347;
+
+    EventIndex () : stride_ (0) {}
+
+    /*! Returns the name of the sidecar of \c dataFileName. */
+    static QString fileNameFor (const QString &dataFileName) { return dataFileName + ".idx"; }
+
+    /*! Loads the sidecar of \c dataFileName. Returns false if there is none or it is invalid. */
+    bool load (const QString &dataFileName);
+    /*! Saves the table as the sidecar of \c dataFileName. */
+    bool save (const QString &dataFileName) const;
+    /*! Builds the table by reading all events from the start of \c reader, for files without a sidecar.
+     *  Events are counted from 0 at the start of the file and the recording time is unknown.
+     *  \return false if the file does not contain events in the EventBuilder format
+     */
+    bool build (DataFileReader *reader, uint32_t stride);
+
+    bool isEmpty () const { return entries_.isEmpty (); }
+    int size () const { return entries_.size (); }
+    const EventIndexEntry &at (int i) const { return entries_.at (i); }
+    uint32_t stride () const { return stride_; }
+
+    /*! Returns the last entry at or before \c event, -1 if there is none. */
+    int findEvent (uint64_t event) const;
+    /*! Returns the last entry with a module time stamp at or before \c timestamp, -1 if there is none. */
+    int findTimestamp (uint64_t timestamp) const;
+    /*! Returns the last entry recorded at or before \c time (microseconds since the epoch), -1 if there is none. */
+    int findTime (uint64_t time) const;
+    /*! Returns the last entry at or before position \c offset of the data file, -1 if there is none. */
+    int findOffset (uint64_t offset) const;
+
+    /*! Reads the event at the current position of \c reader into \c words, converted to host byte order.
+     *  \return false at the end of the data or if there is no valid event header
+     */
+    static bool readEvent (DataFileReader *reader, QVector<uint32_t> *words);
+    /*! Returns the module time stamp at the start of the \c len words of input data at \c data, 0 if there is none.
+     *  Only the meta words of the SIS3350 demultiplexer (as packed by PackSis3350Plugin) carry a time stamp.
+     */
+    static uint64_t moduleTimestamp (const uint32_t *data, size_t len);
+    /*! Returns the current time in microseconds since the epoch. */
+    static uint64_t currentTime ();
+
+private:
+    uint32_t stride_;
+    QVector<EventIndexEntry> entries_;
+};
+
+/*! Writes the index of the events written to a FileWriter, see EventIndex.
+ *  The sidecars follow the data files when the FileWriter starts a new one. They are written by their own FileWriter,
+ *  so the producer does not touch the disk.
+ *  \code
+ *    char *p = data.reserve (len);
+ *    if (index.isDue (data, event))
+ *        index.add (data, event, chMask, timestamp);
+ *  \endcode
+ */
+class EventIndexWriter
+{
+public:
+    EventIndexWriter ();
+
+    /*! Opens the sidecar of the current file of \c data, writing an entry every \c stride events. */
+    bool open (const FileWriter &data, uint32_t stride);
+    void close ();
+    bool isOpen () const { return writer_.isOpen (); }
+
+    /*! Returns whether an entry is to be added for \c event, which is about to be written to \c data. */
+    bool isDue (const FileWriter &data, uint64_t event) const {
+        return writer_.isOpen () && (event % stride_ == 0 || data.getFileIndex () != fileIndex_);
+    }
+    /*! Adds an entry for \c event, which starts at the current position of \c data. Call #reserve on \c data first. */
+    void add (const FileWriter &data, uint64_t event, uint32_t chMask, uint64_t timestamp);
+
+private:
+    void writeHeader ();
+
+private:
+    FileWriter writer_;
+    uint32_t stride_;
+    int fileIndex_;   // data file the current sidecar belongs to
+};
+
+#endif // EVENTINDEX_H
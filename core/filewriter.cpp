@@ -0,0 +1,512 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filewriter.h"
+#include "blockcodec.h"
+#include "profiler.h"
+#include "confmap.h"
+
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef ConfMap::confmap_t<FileWriterConfig> confmap_t;
+static const confmap_t confmap [] = {
+    confmap_t ("writer_buffer_kib", &FileWriterConfig::buffer_kib),
+    confmap_t ("writer_nof_buffers", &FileWriterConfig::nof_buffers),
+    confmap_t ("writer_sync_policy", &FileWriterConfig::sync_policy),
+    confmap_t ("writer_sync_interval_ms", &FileWriterConfig::sync_interval_ms),
+    confmap_t ("writer_flush_ms", &FileWriterConfig::flush_ms),
+    confmap_t ("writer_rotate_mib", &FileWriterConfig::rotate_mib),
+    confmap_t ("writer_rotate_minutes", &FileWriterConfig::rotate_minutes),
+    confmap_t ("writer_direct_io", &FileWriterConfig::direct_io),
+    confmap_t ("writer_codec", &FileWriterConfig::codec),
+    confmap_t ("writer_codec_level", &FileWriterConfig::codec_level),
+    confmap_t ("writer_codec_threads", &FileWriterConfig::codec_threads)
+};
+
+void FileWriterConfig::apply (QSettings *s) {
+    ConfMap::apply (s, this, confmap);
+}
+
+void FileWriterConfig::save (QSettings *s) {
+    ConfMap::save (s, this, confmap);
+}
+
+class FileWriterThread : public QThread
+{
+public:
+    FileWriterThread (FileWriter *_writer, bool _compressor)
+        : writer (_writer), compressor (_compressor)
+    {}
+
+protected:
+    void run () {
+        if (compressor)
+            writer->compressLoop ();
+        else
+            writer->writerLoop ();
+    }
+
+private:
+    FileWriter *writer;
+    bool compressor;
+};
+
+// buffers are page aligned and a multiple of the page size, as required for direct I/O
+static const size_t BufferAlignment = 4096;
+
+static char *allocBuffer (size_t size) {
+    void *p = NULL;
+    if (posix_memalign (&p, BufferAlignment, size) != 0)
+        return NULL;
+    return static_cast<char*> (p);
+}
+
+FileWriter::FileWriter ()
+    : thread_ (NULL)
+    , cur_ (NULL)
+    , limit_ (0)
+    , deadline_ (0)
+    , flushAt_ (0)
+    , rotateAt_ (0)
+    , fileBytes_ (0)
+    , fileIndex_ (0)
+    , stalls_ (0)
+    , fd_ (-1)
+    , fdIndex_ (0)
+    , fdDirect_ (false)
+    , lastSync_ (0)
+    , written_ (0)
+    , failed_ (false)
+    , allocated_ (0)
+    , stop_ (false)
+{
+}
+
+FileWriter::~FileWriter ()
+{
+    close ();
+}
+
+bool FileWriter::open (const QString &fileName)
+{
+    close ();
+
+    baseName_ = fileName;
+    names_ = QStringList () << makeFileName (0);
+    nextName_.clear ();
+    fileIndex_ = 0;
+    fileBytes_ = 0;
+    stalls_ = 0;
+    written_ = 0;
+    failed_ = false;
+    stop_ = false;
+
+    // compressed blocks have arbitrary sizes
+    if (conf_.codec != BlockCodec::None)
+        conf_.direct_io = false;
+
+    // open the first file right away, so the caller learns about errors
+    if (!openFile (0))
+        return false;
+
+    uint64_t now = Profiler::now ();
+    rotateAt_ = conf_.rotate_minutes ? now + conf_.rotate_minutes * UINT64_C (60000000000) : 0;
+    flushAt_ = 0;
+    deadline_ = rotateAt_;
+
+    thread_ = new FileWriterThread (this, false);
+    thread_->start ();
+
+    if (conf_.codec != BlockCodec::None) {
+        for (uint32_t i = 0; i < qMax<uint32_t> (conf_.codec_threads, 1); ++i) {
+            FileWriterThread *t = new FileWriterThread (this, true);
+            compressors_.push_back (t);
+            t->start ();
+        }
+    }
+    return true;
+}
+
+void FileWriter::close ()
+{
+    if (!thread_)
+        return;
+
+    if (cur_) {
+        if (cur_->used)
+            submit (cur_);
+        else
+            release (cur_);
+        cur_ = NULL;
+    }
+
+    {
+        QMutexLocker l (&mutex_);
+        stop_ = true;
+        cond_.wakeAll ();
+    }
+    foreach (FileWriterThread *t, compressors_) {
+        t->wait ();
+        delete t;
+    }
+    compressors_.clear ();
+    thread_->wait ();
+    delete thread_;
+    thread_ = NULL;
+
+    // the configuration may change until the next open
+    foreach (Buffer *buf, free_)
+        freeBuffer (buf);
+    free_.clear ();
+    allocated_ = 0;
+    limit_ = 0;
+}
+
+void FileWriter::switchFile (const QString &fileName)
+{
+    nextName_ = fileName;
+    // take the slow path with the next record
+    limit_ = 0;
+}
+
+void FileWriter::write (const void *data, size_t len)
+{
+    memcpy (reserve (len), data, len);
+    commit (len);
+}
+
+bool FileWriter::deadlinePassed () const
+{
+    return Profiler::now () >= deadline_;
+}
+
+char *FileWriter::reserveSlow (size_t len)
+{
+    uint64_t now = Profiler::now ();
+    uint64_t rotateBytes = conf_.rotate_mib * UINT64_C (1048576);
+
+    // a file is never left empty by a rotation
+    bool rotate = (fileBytes_ && rotateBytes && fileBytes_ + len > rotateBytes) || !nextName_.isEmpty ();
+    if (rotateAt_ && now >= rotateAt_) {
+        if (fileBytes_)
+            rotate = true;
+        else
+            rotateAt_ = now + conf_.rotate_minutes * UINT64_C (60000000000);
+    }
+
+    if (cur_ && cur_->used) {
+        // with direct I/O, only the last write to a file may end off a page boundary.
+        // The rest of the last page moves to the next buffer.
+        size_t tail = conf_.direct_io && !rotate ? cur_->used & (BufferAlignment - 1) : 0;
+        Buffer *next = takeBuffer (tail + len);
+        memcpy (next->data, cur_->data + cur_->used - tail, tail);
+        next->used = tail;
+        cur_->used -= tail;
+        if (cur_->used)
+            submit (cur_);
+        else
+            release (cur_);
+        cur_ = next;
+    } else if (cur_ && cur_->size < len) {
+        release (cur_);
+        cur_ = NULL;
+    }
+    if (!cur_)
+        cur_ = takeBuffer (len);
+
+    if (rotate) {
+        ++fileIndex_;
+        fileBytes_ = 0;
+        rotateAt_ = conf_.rotate_minutes ? now + conf_.rotate_minutes * UINT64_C (60000000000) : 0;
+
+        QMutexLocker l (&mutex_);
+        names_ << (nextName_.isEmpty () ? makeFileName (fileIndex_) : nextName_);
+        nextName_.clear ();
+    }
+    cur_->file = fileIndex_;
+
+    flushAt_ = conf_.flush_ms ? now + conf_.flush_ms * UINT64_C (1000000) : 0;
+    deadline_ = flushAt_;
+    if (rotateAt_ && (!deadline_ || rotateAt_ < deadline_))
+        deadline_ = rotateAt_;
+
+    // stop at the rotation size, unless a single record exceeds it
+    limit_ = cur_->size;
+    if (rotateBytes) {
+        uint64_t room = fileBytes_ < rotateBytes ? rotateBytes - fileBytes_ : 0;
+        if (cur_->used + room < limit_)
+            limit_ = cur_->used + qMax<size_t> (room, len);
+    }
+
+    return cur_->data + cur_->used;
+}
+
+FileWriter::Buffer *FileWriter::takeBuffer (size_t len)
+{
+    size_t size = qMax<uint32_t> (conf_.buffer_kib, BufferAlignment / 1024) * size_t (1024);
+    size = (size + BufferAlignment - 1) & ~(BufferAlignment - 1);
+
+    Buffer *buf = NULL;
+    if (len <= size) {
+        QMutexLocker l (&mutex_);
+        int max = qMax<uint32_t> (conf_.nof_buffers, 2);
+        if (free_.empty () && allocated_ >= max) {
+            ++stalls_;
+            while (free_.empty ())
+                cond_.wait (&mutex_);
+        }
+        if (!free_.empty ())
+            buf = free_.takeLast ();
+        else
+            ++allocated_;
+    }
+
+    if (!buf) {
+        buf = new Buffer;
+        buf->spare = len > size;
+        buf->size = buf->spare ? (len + BufferAlignment - 1) & ~(BufferAlignment - 1) : size;
+        buf->data = allocBuffer (buf->size);
+        buf->block = conf_.codec != BlockCodec::None ? allocBuffer (BlockCodec::maxBlockSize (buf->size)) : NULL;
+        if (!buf->data || (conf_.codec != BlockCodec::None && !buf->block)) {
+            std::cout << "FileWriter: could not allocate " << buf->size << " bytes." << std::endl;
+            abort ();
+        }
+    }
+    buf->used = 0;
+    return buf;
+}
+
+void FileWriter::submit (Buffer *buf)
+{
+    QMutexLocker l (&mutex_);
+    buf->state = conf_.codec != BlockCodec::None ? Buffer::Pending : Buffer::Ready;
+    queue_.append (buf);
+    cond_.wakeAll ();
+}
+
+void FileWriter::release (Buffer *buf)
+{
+    if (buf->spare) {
+        freeBuffer (buf);
+        return;
+    }
+
+    QMutexLocker l (&mutex_);
+    buf->used = 0;
+    free_.append (buf);
+    cond_.wakeAll ();
+}
+
+void FileWriter::freeBuffer (Buffer *buf)
+{
+    free (buf->data);
+    free (buf->block);
+    delete buf;
+}
+
+QString FileWriter::makeFileName (int index) const
+{
+    if (baseName_.contains ("%1"))
+        return baseName_.arg (index, 4, 10, QChar ('0'));
+    if (index == 0)
+        return baseName_;
+
+    QFileInfo fi (baseName_);
+    QString name = QString ("%1/%2_%3").arg (fi.path ()).arg (fi.completeBaseName ()).arg (index, 3, 10, QChar ('0'));
+    if (!fi.suffix ().isEmpty ())
+        name += "." + fi.suffix ();
+    return name;
+}
+
+void FileWriter::writerLoop ()
+{
+    for (;;) {
+        Buffer *buf;
+        {
+            // buffers are written in order, even if a later one was compressed first
+            QMutexLocker l (&mutex_);
+            while (queue_.empty () ? !stop_ : queue_.first ()->state != Buffer::Ready)
+                cond_.wait (&mutex_);
+            if (queue_.empty ())
+                break;
+            buf = queue_.takeFirst ();
+        }
+
+        writeBuffer (buf);
+        release (buf);
+    }
+
+    closeFile ();
+}
+
+void FileWriter::compressLoop ()
+{
+    BlockCompressor compressor (conf_.codec, conf_.codec_level);
+
+    for (;;) {
+        Buffer *buf = NULL;
+        {
+            QMutexLocker l (&mutex_);
+            for (;;) {
+                foreach (Buffer *b, queue_) {
+                    if (b->state == Buffer::Pending) {
+                        buf = b;
+                        break;
+                    }
+                }
+                if (buf || stop_)
+                    break;
+                cond_.wait (&mutex_);
+            }
+            if (!buf)
+                break;
+            buf->state = Buffer::Packing;
+        }
+
+        buf->blockUsed = compressor.pack (buf->data, buf->used, buf->block);
+
+        QMutexLocker l (&mutex_);
+        buf->state = Buffer::Ready;
+        cond_.wakeAll ();
+    }
+}
+
+bool FileWriter::openFile (int index)
+{
+    QByteArray name;
+    {
+        QMutexLocker l (&mutex_);
+        name = names_.at (index).toLocal8Bit ();
+    }
+    int flags = O_WRONLY | O_CREAT | O_APPEND;
+
+    fdIndex_ = index;
+    fdDirect_ = conf_.direct_io;
+    fd_ = ::open (name.constData (), flags | (fdDirect_ ? O_DIRECT : 0), 0644);
+    if (fd_ < 0 && fdDirect_ && errno == EINVAL) {
+        // not every file system supports direct I/O
+        std::cout << "FileWriter: no direct I/O for " << name.constData () << std::endl;
+        fdDirect_ = false;
+        fd_ = ::open (name.constData (), flags, 0644);
+    }
+    if (fd_ < 0) {
+        fail ("open");
+        return false;
+    }
+
+    // appending to a file that does not end on a page boundary
+    struct stat st;
+    if (fdDirect_ && (fstat (fd_, &st) != 0 || st.st_size % BufferAlignment != 0))
+        setDirect (false);
+
+    lastSync_ = Profiler::now ();
+    return true;
+}
+
+void FileWriter::setDirect (bool enable)
+{
+    int flags = fcntl (fd_, F_GETFL);
+    if (flags != -1)
+        fcntl (fd_, F_SETFL, enable ? flags | O_DIRECT : flags & ~O_DIRECT);
+    fdDirect_ = enable;
+}
+
+void FileWriter::closeFile ()
+{
+    if (fd_ < 0)
+        return;
+
+    if (conf_.sync_policy != FileWriterConfig::SyncNever && fdatasync (fd_) != 0)
+        fail ("sync");
+    if (fd_ >= 0)
+        ::close (fd_);
+    fd_ = -1;
+}
+
+void FileWriter::writeBuffer (Buffer *buf)
+{
+    if (buf->file != fdIndex_) {
+        closeFile ();
+        openFile (buf->file);
+    }
+    if (fd_ < 0)
+        return;
+
+    const char *p = buf->block ? buf->block : buf->data;
+    size_t left = buf->block ? buf->blockUsed : buf->used;
+    size_t total = left;
+    while (left) {
+        // the last piece of a file may not fill a whole page
+        if (fdDirect_ && left < BufferAlignment)
+            setDirect (false);
+
+        ssize_t n = ::write (fd_, p, fdDirect_ ? left & ~(BufferAlignment - 1) : left);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fail ("write");
+            return;
+        }
+        p += n;
+        left -= n;
+    }
+    __atomic_fetch_add (&written_, total, __ATOMIC_RELAXED);
+
+    bool sync = conf_.sync_policy == FileWriterConfig::SyncEveryBuffer;
+    if (conf_.sync_policy == FileWriterConfig::SyncPeriodic) {
+        uint64_t now = Profiler::now ();
+        if (now - lastSync_ >= conf_.sync_interval_ms * UINT64_C (1000000)) {
+            lastSync_ = now;
+            sync = true;
+        }
+    }
+    if (sync && fdatasync (fd_) != 0)
+        fail ("sync");
+}
+
+void FileWriter::fail (const char *what)
+{
+    int err = errno;
+    if (!hasFailed ()) {
+        QString name;
+        {
+            QMutexLocker l (&mutex_);
+            name = names_.at (fdIndex_);
+        }
+        std::cout << "FileWriter: " << what << " of " << name.toStdString ()
+                  << " failed: " << strerror (err) << std::endl;
+    }
+    __atomic_store_n (&failed_, true, __ATOMIC_RELAXED);
+
+    // drop the data of this file rather than blocking the producer
+    if (fd_ >= 0) {
+        ::close (fd_);
+        fd_ = -1;
+    }
+}
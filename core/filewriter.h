@@ -0,0 +1,219 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+class QSettings;
+class FileWriterThread;
+
+/*! Settings of a FileWriter.
+ *  Output plugins keep one of these in their configuration and store it with #apply and #save
+ *  inside their own settings group.
+ */
+struct FileWriterConfig {
+    enum SyncPolicy {
+        SyncNever,       /*!< leave it to the kernel when data reaches the disk */
+        SyncOnClose,     /*!< sync when a file is closed or rotated */
+        SyncPeriodic,    /*!< sync every sync_interval_ms and when a file is closed */
+        SyncEveryBuffer  /*!< sync after every buffer written */
+    };
+
+    uint32_t buffer_kib;        // size of one buffer
+    uint32_t nof_buffers;       // buffers in memory at most, the producer waits when all of them are in use
+    int sync_policy;            // one of SyncPolicy
+    uint32_t sync_interval_ms;
+    uint32_t flush_ms;          // hand a partly filled buffer to the writer after this time, 0 waits until it is full
+    uint32_t rotate_mib;        // start a new file after this many MiB, 0 disables
+    uint32_t rotate_minutes;    // start a new file after this many minutes, 0 disables
+    bool direct_io;             // bypass the page cache (O_DIRECT) where the file system supports it
+    int codec;                  // compress the buffers, one of BlockCodec::Codec
+    int codec_level;
+    uint32_t codec_threads;     // threads compressing buffers in parallel
+
+    FileWriterConfig ()
+    : buffer_kib (4096)
+    , nof_buffers (8)
+    , sync_policy (SyncOnClose)
+    , sync_interval_ms (1000)
+    , flush_ms (1000)
+    , rotate_mib (0)
+    , rotate_minutes (0)
+    , direct_io (false)
+    , codec (0)
+    , codec_level (1)
+    , codec_threads (2)
+    {}
+
+    /*! Loads the writer settings from the current group of \c s. */
+    void apply (QSettings *s);
+    /*! Saves the writer settings to the current group of \c s. */
+    void save (QSettings *s);
+};
+
+/*! Buffered output to a file, written by a separate thread.
+ *  The producer (usually an output plugin) opens the file once per run and appends records to an in-memory buffer.
+ *  Full buffers are handed to the writer thread, which writes them with one system call each, so the producer
+ *  never touches the disk. At most nof_buffers buffers exist; if the disk cannot keep up, #reserve waits
+ *  for the writer thread to return one (counted in #getStalls).
+ *
+ *  Records are never split between files. When a rotation limit is reached, the next record goes to a new file
+ *  named after the first one with a running number appended, eg. raw_120131_1200_001.dat.
+ *
+ *  With direct I/O, the writer thread writes whole pages from the page aligned buffers and the data bypasses
+ *  the page cache, which keeps the rest of the system from being slowed down by writeback at high data rates.
+ *  Only the end of a file is written through the page cache.
+ *
+ *  With a codec selected, a pool of codec_threads threads compresses the full buffers before the writer thread
+ *  writes them, in their original order, as blocks in the format described in BlockCodec. DataFileReader reads
+ *  both formats. Direct I/O is not used for compressed files.
+ *
+ *  A record is either copied with #write or encoded in place:
+ *  \code
+ *    char *p = writer.reserve (maxLen);
+ *    size_t len = encode (p);
+ *    writer.commit (len);
+ *  \endcode
+ *  All functions except the statistics getters must be called from the same thread,
+ *  and records may only be written while the writer is open.
+ */
+class FileWriter
+{
+public:
+    FileWriter ();
+    ~FileWriter ();
+
+    /*! Sets the configuration used by the next #open. */
+    void setConfig (const FileWriterConfig &conf) { conf_ = conf; }
+
+    /*! Opens \c fileName for appending and starts the writer thread.
+     *  If \c fileName contains %1, it is replaced by the four digit file number, starting at 0000,
+     *  instead of appending the number of rotated files.
+     *  A file that is still open is closed first.
+     *  \return false if the file could not be opened
+     */
+    bool open (const QString &fileName);
+    /*! Writes out all buffered data, syncs according to the policy and closes the file. */
+    void close ();
+    /*! Continues with the file \c fileName from the next record on, without waiting for the writer thread. */
+    void switchFile (const QString &fileName);
+    bool isOpen () const { return thread_ != NULL; }
+
+    /*! Returns space for a record of up to \c len bytes. The space stays valid until the next call to any other function. */
+    char *reserve (size_t len) {
+        if (cur_ && cur_->used + len <= limit_ && (!deadline_ || !deadlinePassed ()))
+            return cur_->data + cur_->used;
+        return reserveSlow (len);
+    }
+    /*! Appends the first \c len bytes of the space returned by #reserve to the file. */
+    void commit (size_t len) { cur_->used += len; fileBytes_ += len; }
+    /*! Appends \c len bytes to the file. */
+    void write (const void *data, size_t len);
+
+    /*! Returns the name of the file the next record goes to. */
+    QString getFileName () const { return names_.isEmpty () ? QString () : names_.last (); }
+    /*! Returns the number of the file the next record goes to, counting from 0 at #open. */
+    int getFileIndex () const { return fileIndex_; }
+    /*! Returns the number of bytes written to the current file so far, including buffered data. */
+    uint64_t getFileBytes () const { return fileBytes_; }
+    /*! Returns the number of bytes that reached the file system since #open, after compression. */
+    uint64_t getBytesWritten () const { return __atomic_load_n (&written_, __ATOMIC_RELAXED); }
+    /*! Returns how often #reserve had to wait for the writer thread since #open. */
+    uint64_t getStalls () const { return stalls_; }
+    /*! Returns whether a write or open failed since #open. Data after the failure is discarded. */
+    bool hasFailed () const { return __atomic_load_n (&failed_, __ATOMIC_RELAXED); }
+
+private:
+    struct Buffer {
+        char *data;
+        size_t size;   // capacity
+        size_t used;
+        int file;      // index of the file the data belongs to
+        bool spare;    // not one of the nof_buffers regular buffers, freed after writing
+        enum { Pending, Packing, Ready } state;
+        char *block;   // compressed data, allocated with the buffer if a codec is used
+        size_t blockUsed;
+    };
+
+    bool deadlinePassed () const;
+    char *reserveSlow (size_t len);
+    Buffer *takeBuffer (size_t len);
+    void submit (Buffer *buf);
+    void release (Buffer *buf);
+    void freeBuffer (Buffer *buf);
+    QString makeFileName (int index) const;
+
+    bool openFile (int index);
+    void setDirect (bool enable);
+    void closeFile ();
+    void writeBuffer (Buffer *buf);
+    void writerLoop ();
+    void compressLoop ();
+    void fail (const char *what);
+
+    friend class FileWriterThread;
+
+private:
+    FileWriterConfig conf_;
+    QString baseName_;
+    FileWriterThread *thread_;
+    QList<FileWriterThread*> compressors_;
+
+    // producer side
+    Buffer *cur_;
+    size_t limit_;         // end of the space in cur_ that may be used before the next check
+    uint64_t deadline_;    // time of the next flush or rotation check, 0 if none
+    uint64_t flushAt_;
+    uint64_t rotateAt_;
+    uint64_t fileBytes_;   // bytes committed to the current file
+    int fileIndex_;
+    QString nextName_;     // set by switchFile
+    uint64_t stalls_;
+
+    // writer side
+    int fd_;
+    int fdIndex_;
+    bool fdDirect_;
+    uint64_t lastSync_;
+    uint64_t written_;
+    bool failed_;
+
+    QMutex mutex_;
+    QWaitCondition cond_;
+    QList<Buffer*> queue_;  // buffers waiting to be written
+    QList<Buffer*> free_;
+    QStringList names_;     // file names by index, appended by the producer
+    int allocated_;
+    bool stop_;
+
+private: // no copying
+    FileWriter (const FileWriter &);
+    FileWriter &operator= (const FileWriter &);
+};
+
+#endif // FILEWRITER_H
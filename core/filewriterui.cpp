@@ -0,0 +1,179 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filewriterui.h"
+#include "filewriter.h"
+#include "blockcodec.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QGridLayout>
+#include <QLabel>
+#include <QSpinBox>
+
+#include <climits>
+
+static QSpinBox *spinBox (int min, int max, const QString &suffix, const QString &special = QString ()) {
+    QSpinBox *sb = new QSpinBox ();
+    sb->setMinimum (min);
+    sb->setMaximum (max);
+    sb->setSuffix (suffix);
+    sb->setSpecialValueText (special);
+    sb->setAccelerated (true);
+    return sb;
+}
+
+FileWriterUI::FileWriterUI (FileWriterConfig *conf, QWidget *parent)
+: QGroupBox (tr ("File writer"), parent)
+, conf_ (conf)
+{
+    QGridLayout *l = new QGridLayout (this);
+    int row = 0;
+
+    sbBufferSize = spinBox (4, 1024 * 1024, tr (" KiB"));
+    sbBufferSize->setSingleStep (1024);
+    l->addWidget (new QLabel (tr ("Buffer size:")), row, 0, 1, 1);
+    l->addWidget (sbBufferSize, row++, 1, 1, 1);
+
+    sbNofBuffers = spinBox (2, 1024, QString ());
+    l->addWidget (new QLabel (tr ("Buffers:")), row, 0, 1, 1);
+    l->addWidget (sbNofBuffers, row++, 1, 1, 1);
+
+    sbFlush = spinBox (0, INT_MAX, tr (" ms"), tr ("when full"));
+    l->addWidget (new QLabel (tr ("Flush after:")), row, 0, 1, 1);
+    l->addWidget (sbFlush, row++, 1, 1, 1);
+
+    cbSyncPolicy = new QComboBox ();
+    cbSyncPolicy->addItem (tr ("Never"), FileWriterConfig::SyncNever);
+    cbSyncPolicy->addItem (tr ("On close"), FileWriterConfig::SyncOnClose);
+    cbSyncPolicy->addItem (tr ("Periodically"), FileWriterConfig::SyncPeriodic);
+    cbSyncPolicy->addItem (tr ("Every buffer"), FileWriterConfig::SyncEveryBuffer);
+    l->addWidget (new QLabel (tr ("Sync to disk:")), row, 0, 1, 1);
+    l->addWidget (cbSyncPolicy, row++, 1, 1, 1);
+
+    sbSyncInterval = spinBox (1, INT_MAX, tr (" ms"));
+    l->addWidget (new QLabel (tr ("Sync interval:")), row, 0, 1, 1);
+    l->addWidget (sbSyncInterval, row++, 1, 1, 1);
+
+    sbRotateSize = spinBox (0, INT_MAX, tr (" MiB"), tr ("never"));
+    l->addWidget (new QLabel (tr ("New file after:")), row, 0, 1, 1);
+    l->addWidget (sbRotateSize, row++, 1, 1, 1);
+
+    sbRotateTime = spinBox (0, INT_MAX, tr (" min"), tr ("never"));
+    l->addWidget (new QLabel (tr ("New file every:")), row, 0, 1, 1);
+    l->addWidget (sbRotateTime, row++, 1, 1, 1);
+
+    boxDirectIo = new QCheckBox (tr ("Bypass page cache (direct I/O)"));
+    l->addWidget (boxDirectIo, row++, 0, 1, 2);
+
+    cbCodec = new QComboBox ();
+    cbCodec->addItem (tr ("None"), BlockCodec::None);
+    cbCodec->addItem (tr ("LZ4 (fast)"), BlockCodec::Lz4);
+    cbCodec->addItem (tr ("zstd (small)"), BlockCodec::Zstd);
+    l->addWidget (new QLabel (tr ("Compression:")), row, 0, 1, 1);
+    l->addWidget (cbCodec, row++, 1, 1, 1);
+
+    sbCodecLevel = spinBox (1, 19, QString ());
+    l->addWidget (new QLabel (tr ("Compression level:")), row, 0, 1, 1);
+    l->addWidget (sbCodecLevel, row++, 1, 1, 1);
+
+    sbCodecThreads = spinBox (1, 64, QString ());
+    l->addWidget (new QLabel (tr ("Compression threads:")), row, 0, 1, 1);
+    l->addWidget (sbCodecThreads, row++, 1, 1, 1);
+
+    applySettings ();
+
+    connect (sbBufferSize, SIGNAL(valueChanged(int)), SLOT(updateBufferSize(int)));
+    connect (sbNofBuffers, SIGNAL(valueChanged(int)), SLOT(updateNofBuffers(int)));
+    connect (cbSyncPolicy, SIGNAL(currentIndexChanged(int)), SLOT(updateSyncPolicy(int)));
+    connect (sbSyncInterval, SIGNAL(valueChanged(int)), SLOT(updateSyncInterval(int)));
+    connect (sbFlush, SIGNAL(valueChanged(int)), SLOT(updateFlush(int)));
+    connect (sbRotateSize, SIGNAL(valueChanged(int)), SLOT(updateRotateSize(int)));
+    connect (sbRotateTime, SIGNAL(valueChanged(int)), SLOT(updateRotateTime(int)));
+    connect (boxDirectIo, SIGNAL(toggled(bool)), SLOT(updateDirectIo(bool)));
+    connect (cbCodec, SIGNAL(currentIndexChanged(int)), SLOT(updateCodec(int)));
+    connect (sbCodecLevel, SIGNAL(valueChanged(int)), SLOT(updateCodecLevel(int)));
+    connect (sbCodecThreads, SIGNAL(valueChanged(int)), SLOT(updateCodecThreads(int)));
+}
+
+void FileWriterUI::applySettings () {
+    sbBufferSize->setValue (conf_->buffer_kib);
+    sbNofBuffers->setValue (conf_->nof_buffers);
+    cbSyncPolicy->setCurrentIndex (cbSyncPolicy->findData (conf_->sync_policy));
+    sbSyncInterval->setValue (conf_->sync_interval_ms);
+    sbSyncInterval->setEnabled (conf_->sync_policy == FileWriterConfig::SyncPeriodic);
+    sbFlush->setValue (conf_->flush_ms);
+    sbRotateSize->setValue (conf_->rotate_mib);
+    sbRotateTime->setValue (conf_->rotate_minutes);
+    boxDirectIo->setChecked (conf_->direct_io);
+    boxDirectIo->setEnabled (conf_->codec == BlockCodec::None);
+    cbCodec->setCurrentIndex (cbCodec->findData (conf_->codec));
+    sbCodecLevel->setValue (conf_->codec_level);
+    sbCodecLevel->setEnabled (conf_->codec != BlockCodec::None);
+    sbCodecThreads->setValue (conf_->codec_threads);
+    sbCodecThreads->setEnabled (conf_->codec != BlockCodec::None);
+}
+
+void FileWriterUI::updateBufferSize (int kib) {
+    conf_->buffer_kib = kib;
+}
+
+void FileWriterUI::updateNofBuffers (int n) {
+    conf_->nof_buffers = n;
+}
+
+void FileWriterUI::updateSyncPolicy (int idx) {
+    conf_->sync_policy = cbSyncPolicy->itemData (idx).toInt ();
+    sbSyncInterval->setEnabled (conf_->sync_policy == FileWriterConfig::SyncPeriodic);
+}
+
+void FileWriterUI::updateSyncInterval (int ms) {
+    conf_->sync_interval_ms = ms;
+}
+
+void FileWriterUI::updateFlush (int ms) {
+    conf_->flush_ms = ms;
+}
+
+void FileWriterUI::updateRotateSize (int mib) {
+    conf_->rotate_mib = mib;
+}
+
+void FileWriterUI::updateRotateTime (int min) {
+    conf_->rotate_minutes = min;
+}
+
+void FileWriterUI::updateDirectIo (bool enable) {
+    conf_->direct_io = enable;
+}
+
+void FileWriterUI::updateCodec (int idx) {
+    conf_->codec = cbCodec->itemData (idx).toInt ();
+    boxDirectIo->setEnabled (conf_->codec == BlockCodec::None);
+    sbCodecLevel->setEnabled (conf_->codec != BlockCodec::None);
+    sbCodecThreads->setEnabled (conf_->codec != BlockCodec::None);
+}
+
+void FileWriterUI::updateCodecLevel (int level) {
+    conf_->codec_level = level;
+}
+
+void FileWriterUI::updateCodecThreads (int n) {
+    conf_->codec_threads = n;
+}
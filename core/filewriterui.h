@@ -0,0 +1,71 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEWRITERUI_H
+#define FILEWRITERUI_H
+
+#include <QGroupBox>
+
+struct FileWriterConfig;
+class QCheckBox;
+class QComboBox;
+class QSpinBox;
+
+/*! Settings box for the FileWriter of an output plugin.
+ *  Edits the FileWriterConfig passed to the constructor directly. Changes take effect with the next run.
+ */
+class FileWriterUI : public QGroupBox
+{
+    Q_OBJECT
+public:
+    explicit FileWriterUI (FileWriterConfig *conf, QWidget *parent = NULL);
+
+    /*! Updates the widgets from the configuration, eg. after loading settings. */
+    void applySettings ();
+
+private slots:
+    void updateBufferSize (int);
+    void updateNofBuffers (int);
+    void updateSyncPolicy (int);
+    void updateSyncInterval (int);
+    void updateFlush (int);
+    void updateRotateSize (int);
+    void updateRotateTime (int);
+    void updateDirectIo (bool);
+    void updateCodec (int);
+    void updateCodecLevel (int);
+    void updateCodecThreads (int);
+
+private:
+    FileWriterConfig *conf_;
+
+    QSpinBox *sbBufferSize;
+    QSpinBox *sbNofBuffers;
+    QComboBox *cbSyncPolicy;
+    QSpinBox *sbSyncInterval;
+    QSpinBox *sbFlush;
+    QSpinBox *sbRotateSize;
+    QSpinBox *sbRotateTime;
+    QCheckBox *boxDirectIo;
+    QComboBox *cbCodec;
+    QSpinBox *sbCodecLevel;
+    QSpinBox *sbCodecThreads;
+};
+
+#endif // FILEWRITERUI_H
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "geckoremote.h"
 #include "runmanager.h"
 #include "systeminfo.h"
+#include "profiler.h"
 
 #include <stdexcept>
 #include <iostream>
@@ -229,6 +230,12 @@ void GeckoRemote::processQuery(QStringList query, QHostAddress sender)
         datagram += QString::number (RunManager::ref ().getEventRate (), 'f', 2);
         UdpSock_->writeDatagram(datagram, sender, LocalPort_);
 
+        datagram = "POST ";
+        datagram += "update ";
+        datagram += "lostevents ";
+        datagram += QString::number (RunManager::ref ().getLostEventCount ());
+        UdpSock_->writeDatagram(datagram, sender, LocalPort_);
+
         datagram = "POST ";
         datagram += "update ";
         datagram += "info ";
@@ -241,6 +248,17 @@ void GeckoRemote::processQuery(QStringList query, QHostAddress sender)
         datagram += QString::number(int (RunManager::ref().getSystemInfo()->getCpuLoad ()*100));
         UdpSock_->writeDatagram(datagram, sender, LocalPort_);
 
+        // one datagram per line of the profile table
+        if (Profiler::isEnabled ()) {
+            foreach (QString line, Profiler::ref ().report ()) {
+                datagram = "POST ";
+                datagram += "update ";
+                datagram += "profile ";
+                datagram += line;
+                UdpSock_->writeDatagram(datagram, sender, LocalPort_);
+            }
+        }
+
         datagram = "POST update end";
         UdpSock_->writeDatagram (datagram, sender, LocalPort_);
 
@@ -357,6 +375,8 @@ void GeckoRemote::processPost(QStringList post, QHostAddress sender)
         {
             post.removeFirst();
             processRemoteState(post);
+            // the state is sent first, a new profile follows
+            RemoteState_.profile.clear ();
         }
         else if(post.first() == "runname")
         {
@@ -381,6 +401,11 @@ void GeckoRemote::processPost(QStringList post, QHostAddress sender)
             post.removeFirst();
             RemoteState_.nofevents = post.join(" ").toLong ();
         }
+        else if(post.first() == "lostevents")
+        {
+            post.removeFirst();
+            RemoteState_.lostevents = post.join(" ").toLong ();
+        }
         else if(post.first() == "eventrate")
         {
             post.removeFirst();
@@ -396,6 +421,11 @@ void GeckoRemote::processPost(QStringList post, QHostAddress sender)
             post.removeFirst();
             RemoteState_.cpuload = post.join(" ").toInt ();
         }
+        else if(post.first() == "profile")
+        {
+            post.removeFirst();
+            RemoteState_.profile << post.join(" ");
+        }
         else if(post.first() == "end")
         {
             emit updateComplete ();
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHostAddress>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 #include <QMetaType>
 
@@ -41,15 +42,18 @@ struct RemoteGeckoState {
     QDateTime starttime;
     QDateTime stoptime;
     long nofevents;
+    long lostevents;
     float eventrate;
     QString runinfo;
     int cpuload;
+    QStringList profile; // lines of the profile table, empty if profiling is disabled
 
     RemoteGeckoState ()
     : running (false)
     , controlled (false)
     , controller (QHostAddress::Null)
     , nofevents (-1)
+    , lostevents (-1)
     , eventrate (-1)
     , cpuload (-1)
     {}
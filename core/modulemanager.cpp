@@ -59,6 +59,7 @@ void ModuleManager::clear()
         remove (items->first ());
 
     triggers.clear ();
+    chains.clear ();
     mandatoryslots.clear ();
 }
 
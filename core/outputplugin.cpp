@@ -21,10 +21,39 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "abstractmodule.h"
 #include "runmanager.h"
 #include "eventbuffer.h"
-#include "pluginconnectorplain.h"
+#include "pluginconnectortyped.h"
 
 #include <algorithm>
 
+// Output connectors are queued, so the data of a whole batch of events can be latched at once
+static PluginConnector *createOutputConnector (AbstractPlugin *p, QString name, PluginConnector::DataType dt) {
+    switch (dt) {
+    case PluginConnector::Uint32: return new PluginConnectorTyped<uint32_t> (p, ScopeCommon::out, name);
+    case PluginConnector::Double: return new PluginConnectorTyped<double> (p, ScopeCommon::out, name);
+    case PluginConnector::VectorUint32: return new PluginConnectorTyped< QVector<uint32_t> > (p, ScopeCommon::out, name);
+    case PluginConnector::VectorDouble: return new PluginConnectorTyped< QVector<double> > (p, ScopeCommon::out, name);
+    }
+    return NULL;
+}
+
+template<typename T>
+static void swapPayload (Event *ev, const EventSlot *sl, T &buf) {
+    qSwap (buf, ev->store<T> (sl));
+}
+
+// vector payloads leave their length behind, the EventPayloadArena sizes the pooled events by it
+template<typename E>
+static void swapPayload (Event *ev, const EventSlot *sl, QVector<E> &buf) {
+    ev->swapData (sl, buf);
+}
+
+// Hand the payload over to the connector and give the event the connector's recycled buffer in exchange.
+// Neither side allocates, and the event's storage is never shared with the plugins.
+template<typename T>
+static void latchSlot (Event *ev, const EventSlot *sl, PluginConnector *c) {
+    swapPayload (ev, sl, static_cast<PluginConnectorTyped<T>*> (c)->produce ());
+}
+
 OutputPlugin::OutputPlugin (AbstractModule *mod)
 : BasePlugin (-1, mod->getName () + " out"),
   owner(mod)
@@ -32,7 +61,7 @@ OutputPlugin::OutputPlugin (AbstractModule *mod)
     const QList<EventSlot*>* evslots = RunManager::ref ().getEventBuffer()->getEventSlots (mod);
     foreach (EventSlot *i, *evslots)
     {
-        PluginConnector *conn = new PluginConnectorPlain (this, ScopeCommon::out, i->getName (), i->getDataType ());
+        PluginConnector *conn = createOutputConnector (this, i->getName (), i->getDataType ());
         datamap_ [i] = conn;
         addConnector (conn);
     }
@@ -43,12 +72,23 @@ void OutputPlugin::runStartingEvent() {
 }
 
 void OutputPlugin::latchData (Event *ev) {
+    // modules with split readout left their data undecoded, see AbstractModule::acquireRaw
+    const QVector<uint32_t> *raw = ev->getRaw (owner);
+    if (raw)
+        owner->decode (ev, *raw);
+
     for (std::map<const EventSlot*, PluginConnector*>::const_iterator i = datamap_.begin ();
          i != datamap_.end ();
          ++i)
     {
-        QVariant d = ev->get (i->first);
-        if (!d.isNull ())
-            i->second->setData (d);
+        if (!ev->isOccupied (i->first))
+            continue;
+
+        switch (i->first->getDataType ()) {
+        case PluginConnector::Uint32: latchSlot<uint32_t> (ev, i->first, i->second); break;
+        case PluginConnector::Double: latchSlot<double> (ev, i->first, i->second); break;
+        case PluginConnector::VectorUint32: latchSlot< QVector<uint32_t> > (ev, i->first, i->second); break;
+        case PluginConnector::VectorDouble: latchSlot< QVector<double> > (ev, i->first, i->second); break;
+        }
     }
 }
@@ -23,8 +23,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdexcept>
 #include <iostream>
 
+// event sequence numbers are per thread: every processing thread may be working on a different event
+static __thread uint32_t curEvent = 0;
+static __thread bool curEventValid = false;
+
 PluginConnector::PluginConnector(AbstractPlugin* _plugin, ScopeCommon::ConnectorType _type, QString _name, DataType _dt)
-        : plugin(_plugin), type(_type), otherSide(NULL), name(_name), dtype (_dt)
+        : plugin(_plugin), type(_type), consumerIdx (-1), name(_name), dtype (_dt)
 {
 
 }
@@ -42,61 +46,110 @@ void PluginConnector::connectTo(PluginConnector* _otherSide)
     if (dtype != _otherSide->dtype)
         throw std::invalid_argument (std::string ("connectors have different data types"));
 
-    if (hasOtherSide())
-        return;
+    PluginConnector* in = (type == ScopeCommon::in ? this : _otherSide);
+    PluginConnector* out = (type == ScopeCommon::in ? _otherSide : this);
 
-    otherSide = _otherSide;
+    // an input reads from exactly one output
+    if (in->hasOtherSide())
+        return;
 
-    // Reverse connection
-    otherSide->connectTo(this);
+    in->others.push_back (out);
+    out->others.push_back (in);
+    in->consumerIdx = out->others.size () - 1;
+    out->consumerAdded ();
 
     QString from;
 
-    if(plugin != NULL)
-        from = plugin->getName();
+    if(out->plugin != NULL)
+        from = out->plugin->getName();
     else
         from = "root";
 
     std::cout << "Connected " << from.toStdString()
-              << " to " << getConnectedPluginName().toStdString() << std::endl;
+              << " to " << in->plugin->getName().toStdString() << std::endl;
 
-    this->getPlugin()->updateDisplayedConnections();
+    out->getPlugin()->updateDisplayedConnections();
+    in->getPlugin()->updateDisplayedConnections();
 }
 
 void PluginConnector::disconnect()
 {
-    if(hasOtherSide())
-    {
-        std::cout << "Disconnecting " << getName().toStdString()
-                  << " from " << getConnectedPluginName().toStdString() << std::endl;
+    while(hasOtherSide())
+        disconnect (others.last ());
+}
+
+void PluginConnector::disconnect(PluginConnector* _otherSide)
+{
+    if (!others.contains (_otherSide))
+        return;
+
+    PluginConnector* in = (type == ScopeCommon::in ? this : _otherSide);
+    PluginConnector* out = (type == ScopeCommon::in ? _otherSide : this);
+
+    std::cout << "Disconnecting " << in->getName().toStdString()
+              << " from " << out->getPlugin()->getName().toStdString() << std::endl;
 
-        PluginConnector* tmp = otherSide;
-        otherSide = NULL;
-        tmp->disconnect ();
+    int idx = out->others.indexOf (in);
+    out->others.removeAt (idx);
+    in->others.clear ();
+    in->consumerIdx = -1;
+    out->renumberConsumers ();
+    out->consumerRemoved (idx);
 
-        this->getPlugin()->updateDisplayedConnections();
-    }
+    out->getPlugin()->updateDisplayedConnections();
+    in->getPlugin()->updateDisplayedConnections();
+}
+
+void PluginConnector::renumberConsumers()
+{
+    for (int i = 0; i < others.size (); ++i)
+        others.at (i)->consumerIdx = i;
 }
 
 bool PluginConnector::hasOtherSide() const
 {
-    return (otherSide != NULL);
+    return !others.empty ();
+}
+
+QList<AbstractPlugin*> PluginConnector::getConnectedPlugins() const
+{
+    QList<AbstractPlugin*> plugins;
+    foreach (PluginConnector* c, others)
+        plugins << c->getPlugin();
+    return plugins;
 }
 
 QString PluginConnector::getConnectedPluginName() const
 {
-    if(hasOtherSide()) return otherSide->getPlugin()->getName();
+    if(hasOtherSide()) return others.first()->getPlugin()->getName();
     else return "";
 }
 
 AbstractPlugin* PluginConnector::getConnectedPlugin() const
 {
-    if(hasOtherSide()) return otherSide->getPlugin();
+    if(hasOtherSide()) return others.first()->getPlugin();
     else return NULL;
 }
 
 QString PluginConnector::getOthersideName() const
 {
-    if(hasOtherSide()) return otherSide->getName();
+    if(hasOtherSide()) return others.first()->getName();
     else return "";
 }
+
+void PluginConnector::setCurrentEvent (uint32_t seq)
+{
+    curEvent = seq;
+    curEventValid = true;
+}
+
+bool PluginConnector::isEventVisible (uint32_t seq)
+{
+    // difference as signed, so the comparison survives the wrap-around of the counter
+    return !curEventValid || static_cast<int32_t> (seq - curEvent) <= 0;
+}
+
+uint32_t PluginConnector::currentEvent ()
+{
+    return curEvent;
+}
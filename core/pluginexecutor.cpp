@@ -0,0 +1,377 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pluginexecutor.h"
+#include "abstractplugin.h"
+#include "pluginconnector.h"
+#include "outputplugin.h"
+#include "profiler.h"
+
+#include <QThread>
+
+class PluginExecutorWorker : public QThread
+{
+public:
+    PluginExecutorWorker (PluginExecutor *_exec, int _self)
+        : exec (_exec), self (_self)
+    {}
+
+protected:
+    void run () { exec->workerLoop (self); }
+
+private:
+    PluginExecutor *exec;
+    int self;
+};
+
+PluginExecutor::PluginExecutor (int nofThreads, int depth)
+    : nofOutputs_ (0)
+    , events_ (0)
+    , submitted_ (0)
+    , retired_ (0)
+    , queued_ (0)
+    , idle_ (0)
+    , stop_ (false)
+{
+    if (nofThreads < 1)
+        nofThreads = 1;
+    if (depth < 1)
+        depth = 1;
+
+    for (int i = 0; i < depth; ++i) {
+        Slot *sl = new Slot;
+        sl->first = 0;
+        slots_.push_back (sl);
+    }
+
+    for (int i = 0; i < nofThreads; ++i)
+        queues_.push_back (new WorkQueue);
+
+    // queue 0 belongs to the thread calling submit ()
+    for (int i = 1; i < nofThreads; ++i) {
+        PluginExecutorWorker *w = new PluginExecutorWorker (this, i);
+        workers_.push_back (w);
+        w->start ();
+    }
+}
+
+PluginExecutor::~PluginExecutor ()
+{
+    {
+        QMutexLocker l (&mutex_);
+        stop_ = true;
+        cond_.wakeAll ();
+    }
+
+    foreach (PluginExecutorWorker *w, workers_) {
+        w->wait ();
+        delete w;
+    }
+    workers_.clear ();
+
+    qDeleteAll (queues_);
+    qDeleteAll (slots_);
+    qDeleteAll (nodes_);
+}
+
+void PluginExecutor::setPlugins (const QList<OutputPlugin*> &outputs, const QList< QList<AbstractPlugin*> > &levels)
+{
+    qDeleteAll (nodes_);
+    nodes_.clear ();
+    roots_.clear ();
+
+    // nodes are numbered in level order with the output plugins first
+    QMap<AbstractPlugin*, int> index;
+    foreach (OutputPlugin *o, outputs) {
+        Node *n = new Node;
+        n->plugin = o;
+        n->output = o;
+        n->profile = Profiler::ref ().getHistogram (QString ("plugin %1").arg (o->getName ()));
+        index.insert (o, nodes_.size ());
+        nodes_.push_back (n);
+    }
+    nofOutputs_ = nodes_.size ();
+
+    foreach (const QList<AbstractPlugin*> &level, levels) {
+        foreach (AbstractPlugin *p, level) {
+            Node *n = new Node;
+            n->plugin = p;
+            n->output = NULL;
+            n->profile = Profiler::ref ().getHistogram (QString ("plugin %1").arg (p->getName ()));
+            index.insert (p, nodes_.size ());
+            nodes_.push_back (n);
+        }
+    }
+
+    for (int i = 0; i < nodes_.size (); ++i) {
+        Node *n = nodes_.at (i);
+
+        foreach (PluginConnector *in, *n->plugin->getInputs ()) {
+            QMap<AbstractPlugin*, int>::const_iterator it = index.constFind (in->getConnectedPlugin ());
+            // edges to later nodes can only stem from a cyclic configuration, ignore them instead of deadlocking
+            if (it != index.constEnd () && it.value () < i && !n->predecessors.contains (it.value ())) {
+                n->predecessors.push_back (it.value ());
+                nodes_ [it.value ()]->successors.push_back (i);
+            }
+        }
+
+        foreach (PluginConnector *out, *n->plugin->getOutputs ()) {
+            if (!out->hasOtherSide ()) {
+                n->unconnected.push_back (out);
+                continue;
+            }
+            if (out->isQueued ())
+                continue;
+            // every reader of an unqueued output has to be done before it is overwritten
+            foreach (AbstractPlugin *reader, out->getConnectedPlugins ()) {
+                QMap<AbstractPlugin*, int>::const_iterator it = index.constFind (reader);
+                if (it != index.constEnd () && it.value () > i && !n->blockers.contains (it.value ())) {
+                    n->blockers.push_back (it.value ());
+                    nodes_ [it.value ()]->blocked.push_back (i);
+                }
+            }
+        }
+
+        if (n->predecessors.empty ())
+            roots_.push_back (i);
+    }
+}
+
+void PluginExecutor::submit (const std::vector<Event*> &evs)
+{
+    if (evs.empty ())
+        return;
+
+    uint32_t seq = submitted_;
+
+    // wait until the slot used by batch seq - depth is free
+    participate (seq - slots_.size () + 1);
+
+    Slot *sl = slots_.at (seq % slots_.size ());
+    sl->evs.assign (evs.begin (), evs.end ());
+    sl->first = events_;
+    sl->remaining = nodes_.size ();
+    sl->latches = nofOutputs_;
+    events_ += evs.size ();
+
+    if (nofOutputs_ == 0) {
+        QMutexLocker l (&mutex_);
+        for (std::vector<Event*>::const_iterator i = evs.begin (); i != evs.end (); ++i)
+            latched_.push_back (*i);
+    }
+
+    submitted_.ref ();
+
+    if (nodes_.empty ()) {
+        retired_.ref ();
+        return;
+    }
+
+    foreach (int r, roots_)
+        trySchedule (0, r);
+}
+
+void PluginExecutor::flush ()
+{
+    participate (submitted_);
+}
+
+Event *PluginExecutor::takeLatched ()
+{
+    QMutexLocker l (&mutex_);
+    if (latched_.empty ())
+        return NULL;
+    return latched_.takeFirst ();
+}
+
+bool PluginExecutor::isReady (int n) const
+{
+    const Node *node = nodes_.at (n);
+    uint32_t k = node->done;
+
+    if (!before (k, submitted_))
+        return false;
+
+    // all inputs have been produced
+    foreach (int p, node->predecessors)
+        if (!before (k, nodes_.at (p)->done))
+            return false;
+
+    // outputs without a queue have been consumed
+    foreach (int b, node->blockers)
+        if (before (nodes_.at (b)->done, k))
+            return false;
+
+    return true;
+}
+
+void PluginExecutor::trySchedule (int self, int n)
+{
+    Node *node = nodes_.at (n);
+    while (isReady (n)) {
+        // whoever holds the busy flag checks readiness again after releasing it
+        if (!node->busy.testAndSetOrdered (0, 1))
+            return;
+        if (isReady (n)) {
+            push (self, n);
+            return;
+        }
+        node->busy.fetchAndStoreOrdered (0);
+    }
+}
+
+void PluginExecutor::participate (uint32_t target)
+{
+    for (;;) {
+        if (!before (retired_, target))
+            return;
+
+        int task;
+        if (findWork (0, task)) {
+            execute (0, task);
+            continue;
+        }
+
+        QMutexLocker l (&mutex_);
+        if (!before (retired_, target))
+            return;
+        if (queued_ == 0) {
+            ++idle_;
+            cond_.wait (&mutex_);
+            --idle_;
+        }
+    }
+}
+
+void PluginExecutor::workerLoop (int self)
+{
+    for (;;) {
+        int task;
+        if (findWork (self, task)) {
+            execute (self, task);
+            continue;
+        }
+
+        QMutexLocker l (&mutex_);
+        if (stop_)
+            return;
+        if (queued_ == 0) {
+            ++idle_;
+            cond_.wait (&mutex_);
+            --idle_;
+        }
+    }
+}
+
+void PluginExecutor::push (int self, int task)
+{
+    WorkQueue *q = queues_.at (self);
+    q->lock.lock ();
+    q->tasks.push_back (task);
+    q->lock.unlock ();
+
+    // idle threads check queued_ while holding the mutex before they go to sleep
+    queued_.ref ();
+    QMutexLocker l (&mutex_);
+    if (idle_)
+        cond_.wakeOne ();
+}
+
+bool PluginExecutor::findWork (int self, int &task)
+{
+    if (queued_ == 0)
+        return false;
+
+    // own queue first, newest task (LIFO) to stay cache-warm
+    WorkQueue *own = queues_.at (self);
+    own->lock.lock ();
+    if (!own->tasks.empty ()) {
+        task = own->tasks.takeLast ();
+        own->lock.unlock ();
+        queued_.deref ();
+        return true;
+    }
+    own->lock.unlock ();
+
+    // steal the oldest task from another thread
+    for (int i = 1; i < queues_.size (); ++i) {
+        WorkQueue *victim = queues_.at ((self + i) % queues_.size ());
+        victim->lock.lock ();
+        if (!victim->tasks.empty ()) {
+            task = victim->tasks.takeFirst ();
+            victim->lock.unlock ();
+            queued_.deref ();
+            return true;
+        }
+        victim->lock.unlock ();
+    }
+
+    return false;
+}
+
+void PluginExecutor::execute (int self, int task)
+{
+    Node *n = nodes_.at (task);
+    uint32_t k = n->done;
+    Slot *sl = slots_.at (k % slots_.size ());
+    int count = sl->evs.size ();
+    uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+
+    if (n->output) {
+        for (int i = 0; i < count; ++i) {
+            PluginConnector::setCurrentEvent (sl->first + i);
+            n->output->latchData (sl->evs [i]);
+        }
+    } else {
+        // all data of the batch is visible to the plugin
+        PluginConnector::setCurrentEvent (sl->first + count - 1);
+        n->plugin->processBatch (count);
+    }
+
+    if (start)
+        n->profile->add (Profiler::now () - start);
+
+    // discard data nobody is going to read
+    foreach (PluginConnector *c, n->unconnected)
+        while (c->useData ())
+            ;
+
+    n->done.ref ();
+
+    if (n->output && !sl->latches.deref ()) {
+        QMutexLocker l (&mutex_);
+        for (int i = 0; i < count; ++i)
+            latched_.push_back (sl->evs [i]);
+    }
+
+    if (!sl->remaining.deref ()) {
+        retired_.ref ();
+        // wake the thread waiting in submit () or flush ()
+        QMutexLocker l (&mutex_);
+        cond_.wakeAll ();
+    }
+
+    n->busy.fetchAndStoreOrdered (0);
+
+    trySchedule (self, task);
+    foreach (int s, n->successors)
+        trySchedule (self, s);
+    foreach (int b, n->blocked)
+        trySchedule (self, b);
+}
@@ -0,0 +1,159 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLUGINEXECUTOR_H
+#define PLUGINEXECUTOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class AbstractPlugin;
+class OutputPlugin;
+class PluginConnector;
+class Event;
+class PluginExecutorWorker;
+class LatencyHistogram;
+
+/*! Runs the plugins in parallel, respecting the data dependencies between them.
+ *  The executor derives a dependency graph from the connector graph: A plugin depends on every plugin
+ *  one of its inputs is connected to. The output plugins form the roots of the graph; for them, the executor
+ *  latches the event data instead of calling AbstractPlugin::process. Latching includes decoding the raw data of modules
+ *  with split readout (see AbstractModule::decode), so demultiplexing runs on the pool as well, one module per thread.
+ *
+ *  Every event handed to #submit is processed by every plugin exactly once, and each plugin sees the events in the order
+ *  they were submitted. Events are submitted in batches. Each plugin handles a whole batch in one call to
+ *  AbstractPlugin::processBatch. Up to \c depth batches may be in flight at the same time. With a depth greater than one,
+ *  the plugins form a pipeline: A plugin may work on batch k while the plugins it feeds are still busy with earlier batches.
+ *  Data of the different events is kept apart by the queued connectors (see PluginConnector::setCurrentEvent).
+ *  A plugin writing to a connector without a queue only proceeds to the next event once the connected plugin is done with
+ *  the current one.
+ *
+ *  Ready plugins are executed on a fixed-size pool of threads. Every thread owns a work queue. Newly ready plugins
+ *  are pushed to the queue of the thread that made them ready, so data tends to stay in that core's cache. Idle threads
+ *  steal from the other end of the other threads' queues.
+ *
+ *  A single plugin is never executed by two threads at the same time, so plugins need not be thread-safe.
+ *  The thread calling #submit and #flush takes part in the processing.
+ */
+class PluginExecutor
+{
+public:
+    /*! Create an executor.
+     *  \param nofThreads total number of threads processing plugins, including the thread calling #submit.
+     *  Values smaller than 1 are treated as 1, which executes all plugins in the calling thread.
+     *  \param depth maximum number of batches in flight. 1 processes one batch after the other.
+     */
+    PluginExecutor (int nofThreads, int depth = 1);
+    ~PluginExecutor ();
+
+    /*! Set the plugins to be executed.
+     *  \param outputs the output plugins of all modules
+     *  \param levels plugins sorted into levels as created by the PluginThread.
+     *  \warning must not be called while events are in flight.
+     */
+    void setPlugins (const QList<OutputPlugin*> &outputs, const QList< QList<AbstractPlugin*> > &levels);
+
+    /*! Start processing a batch of events.
+     *  If \c depth batches are already in flight, help processing them until the oldest one is done.
+     */
+    void submit (const std::vector<Event*> &evs);
+
+    /*! Process all submitted events to completion. */
+    void flush ();
+
+    /*! Returns an event all output plugins have latched, or NULL if there is none.
+     *  The caller is responsible for returning the event to the EventBuffer.
+     */
+    Event *takeLatched ();
+
+    /*! Returns the number of threads processing plugins. */
+    int getThreadCount () const { return queues_.size (); }
+    /*! Returns the maximum number of batches in flight. */
+    int getDepth () const { return slots_.size (); }
+
+private:
+    struct Node {
+        AbstractPlugin *plugin;
+        OutputPlugin *output; // non-NULL for output plugins
+        QVector<int> predecessors;
+        QVector<int> successors;
+        QVector<int> blockers; // successors connected via an output that holds only one event
+        QVector<int> blocked;  // predecessors that have this node as a blocker
+        QList<PluginConnector*> unconnected;
+        LatencyHistogram *profile;
+        QAtomicInt done; // number of batches processed
+        QAtomicInt busy; // set while the node is queued or executing
+    };
+
+    struct Slot {
+        std::vector<Event*> evs;
+        uint32_t first;       // sequence number of the first event
+        QAtomicInt remaining; // nodes that still have to process the batch
+        QAtomicInt latches;   // output plugins that still have to latch the batch
+    };
+
+    struct WorkQueue {
+        QMutex lock;
+        QList<int> tasks;
+    };
+
+    static bool before (uint32_t a, uint32_t b) { return static_cast<int32_t> (a - b) < 0; }
+
+    bool isReady (int n) const;
+    void trySchedule (int self, int n);
+    void push (int self, int task);
+    bool findWork (int self, int &task);
+    void execute (int self, int task);
+    void participate (uint32_t target);
+    void workerLoop (int self);
+
+    friend class PluginExecutorWorker;
+
+private:
+    QVector<Node*> nodes_;
+    QVector<int> roots_;
+    int nofOutputs_;
+    QVector<Slot*> slots_;
+    QVector<WorkQueue*> queues_;
+    QList<PluginExecutorWorker*> workers_;
+
+    uint32_t events_; // number of events submitted
+    QAtomicInt submitted_;
+    QAtomicInt retired_;
+    QAtomicInt queued_;
+
+    QMutex mutex_;
+    QWaitCondition cond_;
+    QList<Event*> latched_;
+    int idle_;
+    bool stop_;
+
+private: // no copying
+    PluginExecutor (const PluginExecutor &);
+    PluginExecutor &operator= (const PluginExecutor &);
+};
+
+#endif // PLUGINEXECUTOR_H
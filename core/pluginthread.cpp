@@ -17,33 +17,42 @@ You should have received a copy of the GNU Lesser General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <QtConcurrentRun>
-#include <QFutureSynchronizer>
-
 #include "pluginthread.h"
+#include "pluginexecutor.h"
 #include "abstractmodule.h"
 #include "outputplugin.h"
 #include "runmanager.h"
 #include "eventbuffer.h"
-
-//#define GECKO_PROFILE_PLUGIN
-
-#ifdef GECKO_PROFILE_PLUGIN
-#include <time.h>
-static struct timespec starttime;
-static uint64_t timeinwait;
-static uint64_t timeForPlugin[40];
-#endif
+#include "threadscheduling.h"
+#include "profiler.h"
 
 PluginThread::PluginThread(PluginManager* _pmgr, ModuleManager* _mmgr)
-        : pmgr(_pmgr), mmgr(_mmgr), nofAcqsWaiting (0)
+        : pmgr(_pmgr), mmgr(_mmgr), nofAcqsWaiting (0), sleeping (0)
 {
     abort = false;
     moveToThread(this);
 
     createProcessList();
 
-    std::cout << "PluginThread initialized." << std::endl;
+    QList<OutputPlugin*> outputs;
+    foreach(AbstractModule* module, (*mmgr->list ()))
+        outputs.push_back (module->getOutputPlugin ());
+
+    executor = new PluginExecutor (RunManager::ref ().getPluginThreadCount (), RunManager::ref ().getPipelineDepth ());
+    executor->setPlugins (outputs, levelList);
+
+    batchSize = RunManager::ref ().getBatchSize ();
+    batchLatency = RunManager::ref ().getBatchLatency ();
+    // the run thread blocks once the event buffer is full, so never wait for more events than it can hold
+    wakeThreshold = qMin<int> (batchSize, RunManager::ref ().getEventBuffer ()->size ());
+    batch.reserve (batchSize);
+
+    queueWaitProfile = Profiler::ref ().getHistogram (tr ("event queue wait"));
+    fillProfile = Profiler::ref ().getHistogram (tr ("event buffer fill"), LatencyHistogram::Count);
+    idleProfile = Profiler::ref ().getHistogram (tr ("plugin thread idle"));
+
+    std::cout << "PluginThread initialized with " << executor->getThreadCount () << " processing threads, "
+              << executor->getDepth () << " batches in flight, up to " << batchSize << " events per batch." << std::endl;
 }
 
 void PluginThread::createProcessList()
@@ -51,8 +60,6 @@ void PluginThread::createProcessList()
     QMap<AbstractPlugin*, int> processList;
     int maxDepth;
 
-    unconnectedList.clear ();
-
     // Add output plugins to the list
     foreach(AbstractModule* module, (*mmgr->list ()))
     {
@@ -92,17 +99,13 @@ void PluginThread::addChildrenToProcessList(QMap<AbstractPlugin *, int> &process
             if(i.value() == level-1)
             {
                 maxDepth = level;
+                // an output may feed several plugins
                 foreach(PluginConnector* out, (*i.key()->getOutputs()))
                 {
-                    AbstractPlugin* p = out->getConnectedPlugin();
-                    if(p != NULL)
+                    foreach(AbstractPlugin* p, out->getConnectedPlugins())
                     {
                         processList.insert(p,level);
                     }
-                    else
-                    {
-                        unconnectedList.push_back(out);
-                    }
                 }
             }
             ++i;
@@ -123,15 +126,7 @@ PluginThread::~PluginThread()
         if(!finished) terminate();
     }
 
-#ifdef GECKO_PROFILE_PLUGIN
-    struct timespec et;
-    clock_gettime(CLOCK_MONOTONIC, &et);
-    uint64_t rt = (et.tv_sec - starttime.tv_sec) * 1000000000 + (et.tv_nsec - starttime.tv_nsec);
-    std::cout << "Runtime: " << (rt * 1e-9) <<" s, Waiting: " << (100.* timeinwait / rt) << "%" << std::endl;
-    for(int i = 0; i < 10; ++i) {
-        std::cout << "Time for plugin " << i << ": " << (100. * timeForPlugin[i] / rt) << "%" << std::endl;
-    }
-#endif
+    delete executor;
 
     std::cout << "PluginThread stopped." << std::endl;
 }
@@ -139,6 +134,9 @@ PluginThread::~PluginThread()
 void PluginThread::run()
 {
     std::cout << "PluginThread started." << std::endl;
+    foreach (QString problem, ThreadScheduling::applyToCurrentThread (RunManager::ref ().getPluginScheduling ()))
+        std::cout << "PluginThread: " << problem.toStdString () << std::endl;
+
     if(levelList.empty())
         std::cout << "No plugins connected." << std::endl;
 
@@ -150,19 +148,23 @@ void PluginThread::run()
         p->runStartingEvent ();
     }
 
-#ifdef GECKO_PROFILE_PLUGIN
-    clock_gettime(CLOCK_MONOTONIC, &starttime);
-    timeinwait = 0;
-    for (int i = 0; i < 10; ++i) {
-        timeForPlugin[i] = 0;
-    }
-#endif
-
     for(;;)
     {
         process();
         if(abort) break;
     }
+
+    // deliver what the run thread queued before it stopped, including the events held back by the Sample policy
+    while (nofAcqsWaiting > 0 && !RunManager::ref ().getEventBuffer ()->empty ())
+        process();
+
+    // finish the events still in flight
+    executor->flush ();
+    releaseLatchedEvents ();
+
+    foreach (AbstractPlugin *p, *PluginManager::ref().list()) {
+        p->runStoppingEvent ();
+    }
 }
 
 void PluginThread::stop()
@@ -186,82 +188,69 @@ void PluginThread::stop()
 void PluginThread::process()
 {
     //std::cout << " ### PluginThread processing. " << std::endl;
-    if(!!nofAcqsWaiting)
+    int pending = nofAcqsWaiting;
+    if(pending > 0)
     {
         //std::cout << ".... " << q.size() << " ";
-        nofAcqsWaiting.deref();
-
-        Event *ev = RunManager::ref ().getEventBuffer ()->dequeue ();
-
-        // pass data to the output plugins
-        QList<AbstractModule *> mods (*ModuleManager::ref ().list ());
-        foreach (AbstractModule *m, mods)
-            m->getOutputPlugin()->latchData (ev);
+        EventBuffer *evbuf = RunManager::ref ().getEventBuffer ();
+        if (Profiler::isEnabled ())
+            fillProfile->add (evbuf->level ());
+        int n = evbuf->dequeue (batch, qMin (pending, batchSize));
+        nofAcqsWaiting.fetchAndAddOrdered(-n);
+
+        if (Profiler::isEnabled ()) {
+            uint64_t now = Profiler::now ();
+            for (int i = 0; i < n; ++i)
+                if (batch [i]->getQueueTime ())
+                    queueWaitProfile->add (now - batch [i]->getQueueTime ());
+        }
 
-        execProcessList();
-        RunManager::ref ().getEventBuffer ()->releaseEvent (ev);
+        execProcessList(batch);
     }
     else
     {
+        // no new data, complete the events in flight before going to sleep
+        executor->flush ();
+        releaseLatchedEvents ();
+
         QMutexLocker l (&mutex);
-#ifdef GECKO_PROFILE_PLUGIN
-        struct timespec st, et;
-        clock_gettime (CLOCK_MONOTONIC, &st);
-#endif
-        cond.wait(&mutex);
-#ifdef GECKO_PROFILE_PLUGIN
-        clock_gettime (CLOCK_MONOTONIC, &et);
-        timeinwait += (et.tv_sec - st.tv_sec) * 1000000000 + (et.tv_nsec - st.tv_nsec);
-#endif
+        sleeping.fetchAndStoreOrdered (1);
+        if(nofAcqsWaiting >= wakeThreshold || abort)
+        {
+            sleeping.fetchAndStoreOrdered (0);
+            return;
+        }
+        uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+        // wait for a full batch, but at most for the batch latency
+        cond.wait(&mutex, batchLatency);
+        sleeping.fetchAndStoreOrdered (0);
+        if (start)
+            idleProfile->add (Profiler::now () - start);
     }
 }
 
-void PluginThread::execProcessList()
+void PluginThread::execProcessList(const std::vector<Event*> &evs)
 {
     //std::cout << "PluginThread::execProcessList" << std::endl;
-#ifdef GECKO_PROFILE_PLUGIN
-    int i_prof = 0;
-#endif
-    for (QList< QList<AbstractPlugin*> >::const_iterator i = levelList.begin ();
-         i != levelList.end ();
-         ++i)
-    {
+    // the output plugins latch the event data, then all plugins process it.
+    // Blocks only if the maximum number of batches is already in flight
+    executor->submit (evs);
 
-        if(false && i->size() > 1)
-        {
-            QFutureSynchronizer<void> fsync;
-            foreach(AbstractPlugin* p, *i)
-            {
-                fsync.addFuture(QtConcurrent::run(p, &AbstractPlugin::process));
-            }
-        }
-        else
-        {
-            foreach(AbstractPlugin* p, *i)
-            {
-#ifdef GECKO_PROFILE_PLUGIN
-                struct timespec st, et;
-                clock_gettime (CLOCK_MONOTONIC, &st);
-#endif
-                p->process();
-#ifdef GECKO_PROFILE_PLUGIN
-                clock_gettime (CLOCK_MONOTONIC, &et);
-                timeForPlugin[i_prof] += (et.tv_sec - st.tv_sec) * 1000000000 + (et.tv_nsec - st.tv_nsec);
-                ++i_prof;
-#endif
-            }
-        }
-    }
+    releaseLatchedEvents ();
+}
 
-    // Use all queues from unconnected plugins
-    foreach(PluginConnector* c, unconnectedList)
-    {
-        c->useData();
-    }
+void PluginThread::releaseLatchedEvents ()
+{
+    Event *ev;
+    while ((ev = executor->takeLatched ()) != NULL)
+        RunManager::ref ().getEventBuffer ()->releaseEvent (ev);
 }
 
-void PluginThread::acquisitionDone () {
-    nofAcqsWaiting.ref();
-    QMutexLocker locker (&mutex);
-    cond.wakeAll ();
+void PluginThread::eventsQueued (int n) {
+    // Only wake the plugin thread if it is sleeping and a full batch is ready.
+    // Otherwise it picks up the event by itself, after the current batch or the batch latency
+    if (nofAcqsWaiting.fetchAndAddOrdered (n) + n >= wakeThreshold && sleeping) {
+        QMutexLocker locker (&mutex);
+        cond.wakeAll ();
+    }
 }
@@ -37,6 +37,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "modulemanager.h"
 
+class PluginExecutor;
+class Event;
+class LatencyHistogram;
+
 /*! Thread for plugin processing.
  *  The plugin enumerates all configured plugins and sorts them into layers:
  *  Each plugin is assigned to the layer number of its highest-layer input connector, incremented by one.
@@ -59,8 +63,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *    "Layer 0" -> "Layer 1" -> "Layer 2" -> "Layer 3";
  *  }
  *  \enddot
- *  The thread then walks through each layer calling the AbstractPlugin::process function for each plugin.
- *  The process functions for plugins in the same layer might be called in parallel.
+ *  For each event, the thread calls the AbstractPlugin::process function of each plugin using a PluginExecutor.
+ *  A plugin is processed once all plugins it receives data from are done, so independent plugins
+ *  (eg. Plugin2 and Plugin3 above) are processed in parallel. Each plugin is only ever processed by one thread at a time.
+ *  If RunManager::getPipelineDepth is larger than one, several events are processed at once, eg. Plugin4 may work on
+ *  one event while Plugin1 is working on the next. Every plugin still receives the events in order.
+ *
+ *  Events are taken from the EventBuffer in batches of up to RunManager::getBatchSize events. The run thread only
+ *  wakes the plugin thread once a full batch is waiting; otherwise, the plugin thread picks up the waiting events
+ *  after at most RunManager::getBatchLatency milliseconds.
+ *  \sa PluginExecutor
  */
 class PluginThread : public QThread
 {
@@ -77,7 +89,7 @@ public:
 public slots:
     void stop();
     void process();
-    void acquisitionDone ();
+    void eventsQueued (int n);
 
 private:
     bool abort;
@@ -85,15 +97,25 @@ private:
     ModuleManager* mmgr;
     QMutex mutex;
     QAtomicInt nofAcqsWaiting;
+    QAtomicInt sleeping;
     QWaitCondition cond;
 
-    QList<PluginConnector*> unconnectedList;
+    int batchSize;
+    unsigned long batchLatency;
+    int wakeThreshold;
+    std::vector<Event*> batch;
+
+    LatencyHistogram *queueWaitProfile;
+    LatencyHistogram *fillProfile;
+    LatencyHistogram *idleProfile;
 
     QList< QList<AbstractPlugin*> > levelList;
+    PluginExecutor *executor;
 
     void createProcessList();
     void addChildrenToProcessList(QMap<AbstractPlugin*, int>& processList, int& maxDepth);
-    void execProcessList();
+    void execProcessList(const std::vector<Event*> &evs);
+    void releaseLatchedEvents();
 };
 
 #endif // PLUGINTHREAD_H
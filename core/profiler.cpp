@@ -0,0 +1,141 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "profiler.h"
+
+#include <time.h>
+#include <algorithm>
+
+QAtomicInt Profiler::Enabled_ (0);
+
+void LatencyHistogram::reset () {
+    for (int i = 0; i < NofBuckets; ++i)
+        __atomic_store_n (&Buckets_ [i], 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&Sum_, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&Max_, 0, __ATOMIC_RELAXED);
+}
+
+uint64_t LatencyHistogram::getCount () const {
+    uint64_t n = 0;
+    for (int i = 0; i < NofBuckets; ++i)
+        n += __atomic_load_n (&Buckets_ [i], __ATOMIC_RELAXED);
+    return n;
+}
+
+uint64_t LatencyHistogram::getQuantile (double q) const {
+    uint64_t counts [NofBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < NofBuckets; ++i)
+        total += (counts [i] = __atomic_load_n (&Buckets_ [i], __ATOMIC_RELAXED));
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t> (q * (total - 1));
+    uint64_t seen = 0;
+    for (int b = 0; b < NofBuckets; ++b) {
+        seen += counts [b];
+        if (seen > rank) {
+            uint64_t upper = b ? ((uint64_t) 1 << b) - 1 : 0;
+            return std::min (upper, getMax ());
+        }
+    }
+    return getMax ();
+}
+
+Profiler::Profiler ()
+    : Since_ (now ())
+{
+}
+
+Profiler &Profiler::ref () {
+    static Profiler inst;
+    return inst;
+}
+
+uint64_t Profiler::now () {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * UINT64_C (1000000000) + ts.tv_nsec + 1;
+}
+
+void Profiler::setEnabled (bool enabled) {
+    if (enabled && !isEnabled ())
+        reset ();
+    Enabled_ = enabled ? 1 : 0;
+}
+
+LatencyHistogram *Profiler::getHistogram (const QString &name, LatencyHistogram::Unit unit) {
+    QMutexLocker l (&Lock_);
+    QMap<QString, LatencyHistogram*>::const_iterator i = Histograms_.constFind (name);
+    if (i != Histograms_.constEnd ())
+        return i.value ();
+
+    LatencyHistogram *h = new LatencyHistogram (unit);
+    Histograms_.insert (name, h);
+    return h;
+}
+
+void Profiler::reset () {
+    QMutexLocker l (&Lock_);
+    foreach (LatencyHistogram *h, Histograms_)
+        h->reset ();
+    Since_ = now ();
+}
+
+static QString formatValue (uint64_t v, LatencyHistogram::Unit unit) {
+    if (unit == LatencyHistogram::Count)
+        return QString::number ((qulonglong) v);
+    if (v < 10000)
+        return QString ("%1 ns").arg ((qulonglong) v);
+    if (v < 10000000)
+        return QString ("%1 us").arg (v / 1e3, 0, 'f', 1);
+    return QString ("%1 ms").arg (v / 1e6, 0, 'f', 1);
+}
+
+QStringList Profiler::report () const {
+    QMutexLocker l (&Lock_);
+    double elapsed = now () - Since_;
+
+    QStringList lines;
+    lines << QString ("%1 %2 %3 %4 %5 %6 %7")
+             .arg ("", -32).arg ("count", 10).arg ("mean", 10).arg ("median", 10)
+             .arg ("99%", 10).arg ("max", 10).arg ("busy", 7);
+
+    for (QMap<QString, LatencyHistogram*>::const_iterator i = Histograms_.constBegin (); i != Histograms_.constEnd (); ++i) {
+        const LatencyHistogram *h = i.value ();
+        uint64_t n = h->getCount ();
+        if (n == 0)
+            continue;
+
+        LatencyHistogram::Unit u = h->getUnit ();
+        QString busy;
+        if (u == LatencyHistogram::Nanoseconds && elapsed > 0)
+            busy = QString ("%1%").arg (100. * h->getSum () / elapsed, 0, 'f', 1);
+
+        lines << QString ("%1 %2 %3 %4 %5 %6 %7")
+                 .arg (i.key ().left (32), -32)
+                 .arg ((qulonglong) n, 10)
+                 .arg (formatValue (h->getSum () / n, u), 10)
+                 .arg (formatValue (h->getQuantile (0.5), u), 10)
+                 .arg (formatValue (h->getQuantile (0.99), u), 10)
+                 .arg (formatValue (h->getMax (), u), 10)
+                 .arg (busy, 7);
+    }
+    return lines;
+}
@@ -0,0 +1,126 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/*! Histogram with logarithmic buckets for latencies and similar quantities.
+ *  Bucket 0 counts zeros, bucket b > 0 counts values in [2^(b-1), 2^b). Quantiles are therefore accurate to a factor
+ *  of two, which is plenty to tell a 10 us plugin from a 1 ms one, and adding a sample costs only a few atomic additions.
+ *  #add may be called from any number of threads concurrently without locking.
+ */
+class LatencyHistogram {
+public:
+    /*! Unit of the samples, used for formatting. */
+    enum Unit { Nanoseconds, Count };
+    enum { NofBuckets = 48 };
+
+    LatencyHistogram (Unit unit = Nanoseconds) : Unit_ (unit) { reset (); }
+
+    /*! Adds a sample. */
+    void add (uint64_t value) {
+        int b = value ? 64 - __builtin_clzll (value) : 0;
+        if (b >= NofBuckets)
+            b = NofBuckets - 1;
+        __atomic_fetch_add (&Buckets_ [b], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add (&Sum_, value, __ATOMIC_RELAXED);
+        uint64_t m = __atomic_load_n (&Max_, __ATOMIC_RELAXED);
+        while (value > m && !__atomic_compare_exchange_n (&Max_, &m, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+    }
+
+    /*! Discards all samples. Samples added concurrently may or may not survive. */
+    void reset ();
+
+    uint64_t getCount () const; /*!< Returns the number of samples. */
+    uint64_t getSum () const { return __atomic_load_n (&Sum_, __ATOMIC_RELAXED); } /*!< Returns the sum of all samples. */
+    uint64_t getMax () const { return __atomic_load_n (&Max_, __ATOMIC_RELAXED); } /*!< Returns the largest sample. */
+    /*! Returns an upper bound of the \c q quantile (0 <= q <= 1), eg. 0.99 for the 99th percentile. */
+    uint64_t getQuantile (double q) const;
+    Unit getUnit () const { return Unit_; }
+
+private:
+    uint64_t Buckets_ [NofBuckets];
+    uint64_t Sum_;
+    uint64_t Max_;
+    Unit Unit_;
+};
+
+/*! Registry of the run-time profiling histograms.
+ *  The readout and plugin threads record the time spent in each module's acquire function, in each plugin,
+ *  the time events wait in the EventBuffer and the buffer's fill level. Profiling can be switched on and off at any time.
+ *  When it is off, the instrumented code only checks #isEnabled.
+ *
+ *  Histograms are created on first use and never destroyed, so the threads look them up once before a run
+ *  and keep the pointers.
+ *  \code
+ *    LatencyHistogram *h = Profiler::ref ().getHistogram ("my stage");
+ *    ...
+ *    uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+ *    doWork ();
+ *    if (start) h->add (Profiler::now () - start);
+ *  \endcode
+ */
+class Profiler {
+public:
+    static Profiler &ref (); /*!< Return a reference to the singleton */
+
+    /*! Returns whether profiling is enabled. Cheap enough to be called for every event. */
+    static bool isEnabled () { return Enabled_ != 0; }
+    /*! Returns a monotonic time stamp in ns, never 0. */
+    static uint64_t now ();
+
+    /*! Enables or disables profiling. Enabling resets all histograms. */
+    void setEnabled (bool enabled);
+
+    /*! Returns the histogram with the given name, creating it if necessary. */
+    LatencyHistogram *getHistogram (const QString &name, LatencyHistogram::Unit unit = LatencyHistogram::Nanoseconds);
+
+    /*! Discards the samples of all histograms. */
+    void reset ();
+
+    /*! Returns a human-readable table with one line per non-empty histogram, preceded by a header line.
+     *  For timing histograms, the "busy" column is the total time as a share of the time since the last reset.
+     *  A plugin that is busy close to 100% limits the event rate.
+     */
+    QStringList report () const;
+
+private:
+    Profiler ();
+
+    static QAtomicInt Enabled_;
+
+    mutable QMutex Lock_;
+    QMap<QString, LatencyHistogram*> Histograms_;
+    uint64_t Since_;
+
+private: // no copying
+    Profiler (const Profiler &);
+    Profiler &operator= (const Profiler &);
+};
+
+#endif // PROFILER_H
@@ -100,10 +100,15 @@ void RemoteControlPanel::createUI () {
         remoteNofEventsEdit->setReadOnly(true);
         remoteEventsPerSecondEdit = new QLineEdit(0);
         remoteEventsPerSecondEdit->setReadOnly(true);
+        QLabel* lostEventsLabel = new QLabel(tr("Lost:"));
+        remoteLostEventsEdit = new QLineEdit(0);
+        remoteLostEventsEdit->setReadOnly(true);
         box2l->addWidget(nofEventsLabel,0,0,1,1);
         box2l->addWidget(eventsPerSecondLabel,1,0,1,1);
+        box2l->addWidget(lostEventsLabel,2,0,1,1);
         box2l->addWidget(remoteNofEventsEdit,0,1,1,1);
         box2l->addWidget(remoteEventsPerSecondEdit,1,1,1,1);
+        box2l->addWidget(remoteLostEventsEdit,2,1,1,1);
     box2->setLayout(box2l);
 
     remoteRunStartButton = new QPushButton(tr("Start Remote Run"));
@@ -138,6 +143,15 @@ void RemoteControlPanel::createUI () {
         box4l->addWidget(remoteNetEdit,1,1,1,1);
     box4->setLayout(box4l);
 
+    QGroupBox* box5 = new QGroupBox(tr("Remote Profile:"));
+        QGridLayout* box5l = new QGridLayout();
+        remoteProfileEdit = new QTextEdit();
+        remoteProfileEdit->setReadOnly(true);
+        remoteProfileEdit->setLineWrapMode(QTextEdit::NoWrap);
+        remoteProfileEdit->setFontFamily("monospace");
+        box5l->addWidget(remoteProfileEdit,0,0,1,1);
+    box5->setLayout(box5l);
+
     int row = 0;
     layout->addWidget(ipAddressLabel,       row,0,1,1);
     layout->addWidget(remoteIpAddressEdit,  row,1,1,2);
@@ -160,6 +174,8 @@ void RemoteControlPanel::createUI () {
     layout->addWidget(remoteRunStartButton, row,3,1,1);
     row++;
     layout->addWidget(box4,                 row,3,1,1);
+    row++;
+    layout->addWidget(box5,                 row,0,1,4);
 
     layout->setColumnStretch (0, 0);
     layout->setColumnStretch (1, 1);
@@ -241,9 +257,11 @@ void RemoteControlPanel::remoteUpdateComplete () {
     remoteStartTimeEdit->setDateTime (gs.starttime);
     remoteStopTimeEdit->setDateTime (gs.stoptime);
     remoteNofEventsEdit->setText (QString::number (gs.nofevents));
+    remoteLostEventsEdit->setText (QString::number (gs.lostevents));
     remoteEventsPerSecondEdit->setText (QString::number (gs.eventrate, 'f', 2));
     remoteRunInfoEdit->setText (gs.runinfo);
     remoteCpuEdit->setText (tr("%1 %%").arg (gs.cpuload));
+    remoteProfileEdit->setPlainText (gs.profile.isEmpty () ? tr ("Profiling disabled on remote") : gs.profile.join ("\n"));
 }
 
 void RemoteControlPanel::remoteConnected (QHostAddress controller) {
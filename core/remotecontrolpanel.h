@@ -65,11 +65,13 @@ private:
     QDateTimeEdit* remoteStopTimeEdit;
     QLineEdit* remoteNofEventsEdit;
     QLineEdit* remoteEventsPerSecondEdit;
+    QLineEdit* remoteLostEventsEdit;
     QCheckBox* remoteSingleEventModeBox;
     QComboBox* remoteIpAddressEdit;
     QLineEdit* remoteStateEdit;
     QLineEdit* remoteCpuEdit;
     QLineEdit* remoteNetEdit;
+    QTextEdit* remoteProfileEdit;
 
     QTimer* remoteUpdateTimer;
     GeckoRemote *geckoremote;
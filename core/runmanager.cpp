@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "runmanager.h"
 
 #include <QThreadPool>
+#include <QThread>
 #include <QTimer>
 #include <QDir>
 #include <QFile>
@@ -33,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "systeminfo.h"
 #include "eventbuffer.h"
 #include "outputplugin.h"
+#include "profiler.h"
 
 #include <stdexcept>
 #include <iostream>
@@ -51,11 +53,21 @@ RunManager &RunManager::ref () {
 
 RunManager::RunManager()
 : singleeventmode (false)
+, pipelinedepth (1)
+, pluginthreads (0)
+, batchsize (1)
+, batchlatency (10)
+, evbufsize (10)
+, evbufmemory (0)
+, overflowpolicy (EventBuffer::Block)
+, lockmemory (false)
+, interruptreadout (false)
 , running (false)
 , localRun (true)
 , runName ("/tmp")
 , evcnt (0)
 , lastevcnt (0)
+, pollsperevent (0)
 , mainwnd (NULL)
 , runthread (NULL)
 , pluginthread (NULL)
@@ -112,10 +124,36 @@ void RunManager::start (QString info) {
     evcnt = 0;
     lastevcnt = 0;
     evpersec = 0;
+    pollsperevent = 0;
+
+    if (evbufmemory > 0)
+        evbuf->setMemoryBudget ((size_t) evbufmemory << 20);
+    else if (evbuf->getMemoryBudget () || (int) evbuf->size () != evbufsize)
+        evbuf->setSize (evbufsize);
+
+    // all plugins are fed from the same buffer, so dropping events would thin the recorded data as well
+    EventBuffer::OverflowPolicy policy = EventBuffer::toOverflowPolicy (overflowpolicy);
+    if (policy != EventBuffer::Block) {
+        foreach (AbstractPlugin *p, *PluginManager::ref ().list ()) {
+            if (p->isRecording ()) {
+                std::cout << "RunManager: " << p->getName ().toStdString () << " records data, the event buffer blocks instead of using the "
+                          << EventBuffer::getOverflowPolicyName (policy).toStdString () << " policy" << std::endl;
+                policy = EventBuffer::Block;
+                break;
+            }
+        }
+    }
+    evbuf->setOverflowPolicy (policy);
+    evbuf->startRun ();
     writeRunStartFile (info);
 
+    if (lockmemory) {
+        foreach (QString problem, ThreadScheduling::lockMemory ())
+            std::cout << "RunManager: " << problem.toStdString () << std::endl;
+    }
+
     pluginthread = new PluginThread(PluginManager::ptr (), ModuleManager::ptr ());
-    connect (runthread, SIGNAL(acquisitionDone()), pluginthread, SLOT(acquisitionDone()), Qt::DirectConnection);
+    connect (runthread, SIGNAL(eventsQueued(int)), pluginthread, SLOT(eventsQueued(int)), Qt::DirectConnection);
     pluginthread->start(QThread::NormalPriority);
 
     runthread->start(QThread::TimeCriticalPriority);
@@ -135,8 +173,11 @@ void RunManager::stop (QString info) {
 
     runthread->stop ();
     runthread->wait (1000);
+    // no timeout: the plugins flush and close their output files before the thread finishes
     pluginthread->stop ();
-    pluginthread->wait (1000);
+    pluginthread->wait ();
+
+    evbuf->stopRun ();
 
     stopTime = QDateTime::currentDateTime ();
     writeRunStopFile (info);
@@ -159,6 +200,15 @@ void RunManager::stop (QString info) {
     while (!evbuf->empty())
         delete evbuf->dequeue ();
 
+    if (lockmemory)
+        ThreadScheduling::unlockMemory ();
+
+    if (Profiler::isEnabled ()) {
+        std::cout << "Profile of run " << runName.toStdString () << ":" << std::endl;
+        foreach (QString line, Profiler::ref ().report ())
+            std::cout << line.toStdString () << std::endl;
+    }
+
     // Release dead time
     foreach(AbstractInterface* iface, (*InterfaceManager::ref ().list ()))
     {
@@ -180,6 +230,40 @@ void RunManager::stop (QString info) {
     emit runStopped ();
 }
 
+QStringList RunManager::checkScheduling () const {
+    QStringList problems;
+    foreach (QString p, ThreadScheduling::check (readoutsched))
+        problems << tr ("Readout thread: %1").arg (p);
+    foreach (QString p, ThreadScheduling::check (pluginsched))
+        problems << tr ("Plugin thread: %1").arg (p);
+    if (readoutsched.cpu >= 0 && readoutsched.cpu == pluginsched.cpu)
+        problems << tr ("Readout and plugin thread are pinned to the same CPU");
+    if (lockmemory)
+        problems << ThreadScheduling::checkMemoryLock ();
+    return problems;
+}
+
+void RunManager::setOverflowPolicy (int policy) {
+    overflowpolicy = EventBuffer::toOverflowPolicy (policy);
+}
+
+int RunManager::getPluginThreadCount () const {
+    if (pluginthreads > 0)
+        return pluginthreads;
+
+    // leave the CPUs of the pinned threads to them
+    int count = QThread::idealThreadCount ();
+    if (readoutsched.cpu >= 0)
+        --count;
+    if (pluginsched.cpu >= 0 && pluginsched.cpu != readoutsched.cpu)
+        --count;
+    return count < 1 ? 1 : count;
+}
+
+unsigned RunManager::getLostEventCount () const {
+    return evbuf->getLostEvents ();
+}
+
 float RunManager::getEventRate () const {
     return (1000.0 * (evcnt - lastevcnt)) / updateTimer->interval ();
 }
@@ -192,6 +276,7 @@ void RunManager::sendUpdate () {
     evpersec = 0.9 * evpersec + 0.1 * (1000.0 * (newev - evcnt)) / updateTimer->interval ();
     lastevcnt = evcnt;
     evcnt = newev;
+    pollsperevent = newev ? (float) runthread->getNofPolls () / newev : 0;
 
     emit runUpdate(evpersec, newev);
 }
@@ -242,6 +327,15 @@ void RunManager::writeRunStartFile (QString info)
             << "# " "Run Name: " << runName << "\n"
             << "# " "Start Time: " << startTime.toString() << "\n"
             << "# " "Single event mode: " << singleeventmode << "\n"
+            << "# " "Pipeline depth: " << pipelinedepth << "\n"
+            << "# " "Plugin executor threads: " << getPluginThreadCount () << (pluginthreads > 0 ? "" : " (auto)") << "\n"
+            << "# " "Batch size: " << batchsize << "\n"
+            << "# " "Event buffer: " << (evbufmemory > 0 ? QString ("%1 MiB").arg (evbufmemory) : QString ("%1 events").arg (evbufsize))
+            << ", " << EventBuffer::getOverflowPolicyName (evbuf->getOverflowPolicy ()) << "\n"
+            << "# " "Readout thread: " << readoutsched.toString () << "\n"
+            << "# " "Plugin thread: " << pluginsched.toString () << "\n"
+            << "# " "Memory locked: " << lockmemory << "\n"
+            << "# " "Interrupt readout: " << interruptreadout << "\n"
             << "# " "Notes: " << "\n"
             << infolines.join ("\n") << "\n"
             ;
@@ -275,7 +369,16 @@ void RunManager::writeRunStopFile (QString info) {
             << "# " << "Stop Time: " << stopTime.toString() << "\n"
             << "# " << "Duration: " << startTime.secsTo(stopTime) << " s" << "\n"
             << "# " << "Number of recorded events: " << runthread->getNofEvents() << "\n"
-            << "# " "Notes: " << "\n"
+            << "# " << "Number of trigger polls: " << runthread->getNofPolls() << " (" << runthread->getNofPollSleeps() << " with sleep)" << "\n"
+            << "# " << "Number of events lost for the plugins: " << evbuf->getLostEvents () << "\n"
+            << "# " << "Number of events lost to unequal multi-event readouts: " << runthread->getNofMisalignedEvents () << "\n"
+            ;
+        // events the modules saw missing in their own data, eg. from event counter gaps
+        foreach (AbstractModule *m, *ModuleManager::ref ().list ()) {
+            if (m->getLostEvents ())
+                out << "# " << "Number of events lost by " << m->getName () << ": " << m->getLostEvents () << "\n";
+        }
+        out << "# " "Notes: " << "\n"
             << infolines.join ("\n") << "\n"
             ;
     }
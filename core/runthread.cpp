@@ -25,24 +25,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "runmanager.h"
 #include "abstractinterface.h"
 #include "eventbuffer.h"
+#include "threadscheduling.h"
+#include "profiler.h"
 
 #include <QCoreApplication>
-#include <sched.h>
+#include <QMap>
+#include <algorithm>
 #include <cstdio>
-#include <errno.h>
-#include <sys/syscall.h>
-#include <sys/types.h>
-#include <sys/resource.h>
-
-// #define GECKO_PROFILE_RUN
-
-#ifdef GECKO_PROFILE_RUN
-#include <time.h>
-static struct timespec starttime;
-static uint64_t timeinacq;
-static uint64_t timeinpoll;
-static uint64_t timeForModule[20];
-#endif
 
 RunThread::RunThread () {
 
@@ -58,7 +47,15 @@ RunThread::RunThread () {
     moveToThread(this);
 
     nofPolls = 0;
+    nofPollSleeps = 0;
+    lastAcquisition = 0;
+    meanInterval = 0;
     nofSuccessfulEvents = 0;
+    nofMisalignedEvents = 0;
+
+    spareEvent = NULL;
+    cycleProfile = NULL;
+    anyRawReadout = false;
 
     std::cout << "Run thread initialized." << std::endl;
 }
@@ -68,18 +65,7 @@ RunThread::~RunThread()
     bool finished = wait(5000);
     if(!finished) terminate();
 
-#ifdef GECKO_PROFILE_RUN
-    struct timespec et;
-    clock_gettime(CLOCK_MONOTONIC, &et);
-    uint64_t rt = (et.tv_sec - starttime.tv_sec) * 1000000000 + (et.tv_nsec - starttime.tv_nsec);
-    std::cout << "Runtime: " << (rt * 1e-9) <<" s, Acq%: " << (100.* timeinacq / rt) << ", Unsuccessful%: "
-              << (100. * (nofPolls - nofSuccessfulEvents) / nofPolls)
-              << " Polls per event: " << (1.*nofPolls/nofSuccessfulEvents)
-              << std::endl;
-    for(int i = 0; i < 10; ++i) {
-        std::cout << "Time for module " << i << ": " << (100. * timeForModule[i] / rt) << "%" << std::endl;
-    }
-#endif
+    delete spareEvent;
 
     std::cout << "Run thread stopped." << std::endl;
 }
@@ -87,60 +73,33 @@ RunThread::~RunThread()
 
 void RunThread::run()
 {
-/*    cpu_set_t cpuset;
-
-    CPU_ZERO(&cpuset);
-    CPU_SET(3, &cpuset);
-
-    pthread_setaffinity_np(pthread_self(),sizeof(cpuset),&cpuset);
-
-    // Scheduling magic
-    int cpu = sched_getcpu();
-    printf("cpu: %d\n",cpu);
-
-    __pid_t pid = getpid();
-    printf("pid: %d\n",(uint32_t)pid);
-
-    int scheduler = sched_getscheduler(pid);
-    printf("scheduler: %d\n",scheduler);
-
-    Qt::HANDLE threadId = this->thread()->currentThreadId();
-    printf("threadId: 0x%08x\n",(uint)threadId);
-
-    QThread* thisThread = this->thread()->currentThread();
-    printf("thisThread: 0x%8p\n",(unsigned int*)thisThread);
-
-    pid_t tid;
-    tid = syscall(SYS_gettid);
-    printf("tid: %d\n",(uint32_t)tid);
-
-    int threadScheduler = sched_getscheduler(tid);
-    printf("thread scheduler: %d\n",threadScheduler);
-
-    rlimit rl_nice;
-    getrlimit(RLIMIT_NICE,&rl_nice);
-    printf("rlimit nice: %d, %d\n",(int)rl_nice.rlim_cur,(int)rl_nice.rlim_max);
-    rlimit rl_prio;
-    getrlimit(RLIMIT_RTPRIO,&rl_prio);
-    printf("rlimit rtprio: %d, %d\n",(int)rl_prio.rlim_cur,(int)rl_prio.rlim_max);
-
-    struct sched_param old_param;
-    sched_getparam(tid,&old_param);
-    int old_priority = old_param.__sched_priority;
-    printf("old prio: %d\n",old_priority);
-*/
-    /*int new_priority = rl_nice.rlim_max;
-    int new_scheduler = SCHED_FIFO;
-    struct sched_param new_param;
-    new_param.__sched_priority = new_priority;
-    int stat = sched_setscheduler(tid,new_scheduler,&new_param);
-    if (stat == -1) perror("sched_setscheduler()");*/
+    foreach (QString problem, ThreadScheduling::applyToCurrentThread (RunManager::ref ().getReadoutScheduling ()))
+        std::cout << "Run thread: " << problem.toStdString () << std::endl;
 
     modules = *ModuleManager::ref ().list ();
     triggers = ModuleManager::ref ().getTriggers ().toList ();
-    mandatories = ModuleManager::ref ().getMandatorySlots ().toList ();
+    mandatories = EventSlotMask ();
+    foreach (const EventSlot *sl, ModuleManager::ref ().getMandatorySlots ())
+        mandatories.set (sl->getIndex ());
     createConnections();
 
+    rawReadout.clear ();
+    moduleSlots.clear ();
+    anyRawReadout = false;
+    foreach (AbstractModule *m, modules) {
+        EventSlotMask own;
+        foreach (const EventSlot *sl, m->getSlots ())
+            own.set (sl->getIndex ());
+        rawReadout.push_back (m->hasRawReadout ());
+        moduleSlots.push_back (own);
+        anyRawReadout |= rawReadout.back ();
+    }
+
+    moduleProfiles.clear ();
+    foreach (AbstractModule *m, modules)
+        moduleProfiles.push_back (Profiler::ref ().getHistogram (tr ("acquire %1").arg (m->getName ())));
+    cycleProfile = Profiler::ref ().getHistogram (tr ("readout cycle"));
+
     // Hold external trigger logic
     InterfaceManager::ptr ()->getMainInterface()->setOutput1(true);
 
@@ -151,6 +110,25 @@ void RunThread::run()
             std::cout << "Run Thread: " << m->getName ().toStdString () <<": Configure failed!" << std::endl;
     }
 
+    setupChains ();
+    setupStatusReads ();
+
+    // modules whose undecoded data may hold several events, see AbstractModule::eventLength
+    rawModules.clear ();
+    for (int i = 0; i < modules.size (); ++i)
+        if (rawReadout [i] || chainOf [i] >= 0)
+            rawModules.push_back (i);
+
+    // events split off multi-event data only carry the data of these modules
+    splitMandatories = EventSlotMask ();
+    foreach (int i, rawModules)
+        foreach (const EventSlot *sl, modules [i]->getSlots ())
+            if (mandatories.test (sl->getIndex ()))
+                splitMandatories.set (sl->getIndex ());
+
+    pending.fill (QVector<uint32_t> (), modules.size ());
+    pendingPos.fill (0, modules.size ());
+
     std::cout << "Run thread started." << std::endl;
 
     // Wait for reset to be done
@@ -158,30 +136,118 @@ void RunThread::run()
 
 
 
-#ifdef GECKO_PROFILE_RUN
-    clock_gettime (CLOCK_MONOTONIC, &starttime);
-    timeinacq = 0;
-    timeinpoll = 0;
-    for (int i = 0; i < 10; ++i) {
-        timeForModule[i] = 0;
-    }
-#endif
-
     // Allow external trigger logic
     InterfaceManager::ptr ()->getMainInterface()->setOutput1(false);
 
+    interruptBased = RunManager::ref ().isInterruptReadout ();
     if(interruptBased)
     {
-        exec();
+        interruptLoop();
     }
     else
     {
         pollLoop();
     }
 
+    drainReservoir();
+
     exit(0);
 }
 
+void RunThread::setupChains()
+{
+    chains.clear ();
+    chainOf.fill (-1, modules.size ());
+
+    QMap<uint8_t, int> index;
+    for (int i = 0; i < modules.size (); ++i) {
+        uint8_t addr = ModuleManager::ref ().getChain (modules [i]);
+        if (!addr) {
+            // clear chain settings left over from earlier runs
+            modules [i]->setChainPosition (0, AbstractModule::ChainNone);
+            continue;
+        }
+        if (!index.contains (addr)) {
+            ReadoutChain ch;
+            ch.addr = addr;
+            ch.profile = Profiler::ref ().getHistogram (tr ("acquire CBLT 0x%1").arg (addr, 2, 16, QChar ('0')));
+            index.insert (addr, chains.size ());
+            chains.push_back (ch);
+        }
+        chains [index.value (addr)].members.push_back (i);
+    }
+
+    int maxMembers = 0;
+    for (int c = 0; c < chains.size (); ++c) {
+        ReadoutChain &ch = chains [c];
+        int n = ch.members.size ();
+        bool ok = true;
+
+        if (n < 2) {
+            std::cout << "Run thread: CBLT chain 0x" << std::hex << (int) ch.addr << std::dec
+                      << " needs at least two modules, reading them out separately" << std::endl;
+            ok = false;
+        }
+
+        for (int j = 0; ok && j < n; ++j) {
+            AbstractModule *m = modules [ch.members.at (j)];
+            AbstractModule::ChainPosition pos = (j == 0) ? AbstractModule::ChainFirst
+                                              : (j == n - 1) ? AbstractModule::ChainLast
+                                              : AbstractModule::ChainMiddle;
+            if (m->setChainPosition (ch.addr, pos)) {
+                std::cout << "Run thread: " << m->getName ().toStdString ()
+                          << " does not support chained readout, reading out CBLT chain 0x" << std::hex << (int) ch.addr << std::dec
+                          << " separately" << std::endl;
+                ok = false;
+            }
+        }
+
+        if (!ok) {
+            foreach (int i, ch.members)
+                modules [i]->setChainPosition (0, AbstractModule::ChainNone);
+            ch.members.clear ();
+            continue;
+        }
+
+        foreach (int i, ch.members)
+            chainOf [i] = c;
+        anyRawReadout = true;
+        maxMembers = qMax (maxMembers, n);
+    }
+
+    chainBuffer.resize (maxMembers * ChainWordsPerModule);
+}
+
+void RunThread::setupStatusReads()
+{
+    buildStatusList (modules, &moduleStatus, &moduleStatusIndex);
+    buildStatusList (triggers, &triggerStatus, &triggerStatusIndex);
+}
+
+void RunThread::buildStatusList(const QList<AbstractModule*> &mods, QVector<VmeOp> *ops, QVector<int> *index)
+{
+    AbstractInterface *iface = InterfaceManager::ptr ()->getMainInterface ();
+
+    ops->clear ();
+    index->fill (-1, mods.size ());
+    for (int i = 0; i < mods.size (); ++i) {
+        if (mods [i]->getInterface () != iface)
+            continue;
+        int first = ops->size ();
+        if (mods [i]->appendStatusReads (ops) > 0)
+            (*index) [i] = first;
+    }
+}
+
+bool RunThread::moduleReady(int i)
+{
+    // the status read is trusted, a module that finishes converting later is read out in the next cycle
+    int s = moduleStatusIndex [i];
+    if (s >= 0)
+        return modules [i]->dataReadyFromStatus (moduleStatus.constData () + s);
+    return modules [i]->dataReady ();
+}
+
 void RunThread::createConnections()
 {
     QList<AbstractModule*>::iterator ch(triggers.begin());
@@ -197,32 +263,44 @@ bool RunThread::acquire(AbstractModule* _trg)
 {
     //std::cout << currentThreadId() << ": Run thread acquiring." << std::endl;
     InterfaceManager *imgr = InterfaceManager::ptr ();
-    Event *ev = RunManager::ref ().getEventBuffer ()->createEvent ();
+
+    Event *ev = takeEvent ();
 
     int modulesz = modules.size ();
 
     imgr->getMainInterface()->setOutput1(true); // VETO signal for DAQ readout
 
+    // status of all modules in one access list
+    if (!moduleStatus.isEmpty ())
+        imgr->getMainInterface()->executeList(moduleStatus.data (), moduleStatus.size ());
+
+    covered.clear ();
+
     for (int i = 0; i < modulesz; ++i)
     {
         AbstractModule* curM = modules [i];
 
+        if (chainOf [i] >= 0)
+            continue;
+
         //imgr->getMainInterface()->setOutput2(true);
-        if (curM == _trg || curM->dataReady ()) {
+        if (curM == _trg || moduleReady (i)) {
             //imgr->getMainInterface()->setOutput2(false);
 
-
-#ifdef GECKO_PROFILE_RUN
-            struct timespec st, et;
-            clock_gettime (CLOCK_MONOTONIC, &st);
-#endif
+            uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
             imgr->getMainInterface()->setOutput2(true); // VETO signal for DAQ readout
-            curM->acquire(ev);
+            if (rawReadout [i]) {
+                // decoding is left to the module's output plugin, see OutputPlugin::latchData
+                QVector<uint32_t> &raw = ev->storeRaw (curM);
+                curM->acquireRaw (&raw);
+                if (!raw.isEmpty ())
+                    covered.merge (moduleSlots [i]);
+            } else {
+                curM->acquire(ev);
+            }
             imgr->getMainInterface()->setOutput2(false); // VETO signal for DAQ readout
-#ifdef GECKO_PROFILE_RUN
-            clock_gettime (CLOCK_MONOTONIC, &et);
-            timeForModule[i] += (et.tv_sec - st.tv_sec) * 1000000000 + (et.tv_nsec - st.tv_nsec);
-#endif
+            if (start)
+                moduleProfiles [i]->add (Profiler::now () - start);
 //            if(curM->dataReady()) {
 //                std::cout << "RunThread:acquire: ERROR: module " << curM->getName().toStdString()
 //                          << " is still DRDY after acquisition" << std::endl;
@@ -230,18 +308,196 @@ bool RunThread::acquire(AbstractModule* _trg)
         }
     }
 
+    // one block transfer for all modules of a chain, if any of them has data
+    foreach (const ReadoutChain &ch, chains) {
+        foreach (int m, ch.members) {
+            if (modules [m] == _trg || moduleReady (m)) {
+                uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+                imgr->getMainInterface()->setOutput2(true); // VETO signal for DAQ readout
+                acquireChain (ev, ch);
+                imgr->getMainInterface()->setOutput2(false); // VETO signal for DAQ readout
+                if (start)
+                    ch.profile->add (Profiler::now () - start);
+                break;
+            }
+        }
+    }
+
     imgr->getMainInterface()->setOutput1(false); // Remove VETO signal for DAQ readout
 
-    if (QSet<const EventSlot*>::fromList (mandatories).subtract(ev->getOccupiedSlots ()).empty()) {
-        RunManager::ref ().getEventBuffer ()->queue (ev);
+    // modules with multi-event readout may have delivered several events at once
+    int events = splitEvents (ev);
+    if (!events) {
+        ev->clear ();
+        spareEvent = ev;
+        return false;
+    }
+    bool accepted = queueEvent (ev, mandatories);
+
+    // the data of the other modules was read once per cycle and stays with the first event
+    for (int k = 1; k < events; ++k) {
+        Event *next = takeEvent ();
+        takePendingEvent (next);
+        accepted |= queueEvent (next, splitMandatories);
+    }
+
+    if (accepted)
         emit acquisitionDone();
+    return accepted;
+}
+
+Event *RunThread::takeEvent()
+{
+    // Events rejected in the last cycle are reused directly, because the pool of
+    // unused events may only be refilled by the plugin thread.
+    Event *ev = spareEvent ? spareEvent : RunManager::ref ().getEventBuffer ()->createEvent ();
+    spareEvent = NULL;
+    return ev;
+}
+
+bool RunThread::queueEvent(Event *ev, const EventSlotMask &required)
+{
+    // raw data is assumed to fill all slots of its module
+    const EventSlotMask *occupied = &ev->getOccupiedSlots ();
+    if (anyRawReadout) {
+        covered.merge (*occupied);
+        occupied = &covered;
+    }
+
+    if (occupied->containsAll (required)) {
+        if (Profiler::isEnabled ())
+            ev->setQueueTime (Profiler::now ());
+        int queued = RunManager::ref ().getEventBuffer ()->queue (ev);
+        if (queued)
+            emit eventsQueued(queued);
+        count (&nofSuccessfulEvents);
         return true;
     } else {
-        RunManager::ref ().getEventBuffer ()->releaseEvent (ev);
+        ev->clear ();
+        spareEvent = ev;
         return false;
     }
 }
 
+int RunThread::nextEventLength(int i, const uint32_t *data, int left) const
+{
+    int len = modules [i]->eventLength (data, left);
+    return (len <= 0 || len > left) ? left : len;
+}
+
+int RunThread::splitEvents(Event *ev)
+{
+    int events = 1;
+    bool misaligned = false;
+    bool first = true;
+
+    foreach (int i, rawModules) {
+        pending [i].resize (0);
+        pendingPos [i] = 0;
+
+        const QVector<uint32_t> *raw = ev->getRaw (modules [i]);
+        if (!raw || raw->isEmpty ())
+            continue;
+
+        // events are combined by position, so all modules must have read the same triggers
+        int n = 0;
+        for (int pos = 0; pos < raw->size (); ++n)
+            pos += nextEventLength (i, raw->constData () + pos, raw->size () - pos);
+        misaligned |= (!first && n != events);
+        events = first ? n : qMax (events, n);
+        first = false;
+    }
+
+    if (misaligned) {
+        if (!nofMisalignedEvents)
+            std::cout << "Run thread: modules with multi-event readout delivered different numbers of events, "
+                      << "discarding the readout cycle" << std::endl;
+        __atomic_store_n (&nofMisalignedEvents, nofMisalignedEvents + events, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    if (events > 1) {
+        foreach (int i, rawModules) {
+            const QVector<uint32_t> *raw = ev->getRaw (modules [i]);
+            if (!raw || raw->isEmpty ())
+                continue;
+
+            // keep the first event, the others are handed out by takePendingEvent
+            int len = nextEventLength (i, raw->constData (), raw->size ());
+            QVector<uint32_t> &data = ev->storeRaw (modules [i]);
+            pending [i].resize (data.size () - len);
+            std::copy (data.constData () + len, data.constData () + data.size (), pending [i].data ());
+            data.resize (len);
+        }
+    }
+
+    return events;
+}
+
+void RunThread::takePendingEvent(Event *ev)
+{
+    covered.clear ();
+
+    foreach (int i, rawModules) {
+        int left = pending [i].size () - pendingPos [i];
+        if (left <= 0)
+            continue;
+
+        const uint32_t *data = pending [i].constData () + pendingPos [i];
+        int len = nextEventLength (i, data, left);
+
+        QVector<uint32_t> &raw = ev->storeRaw (modules [i]);
+        raw.resize (len);
+        std::copy (data, data + len, raw.data ());
+        covered.merge (moduleSlots [i]);
+
+        pendingPos [i] += len;
+    }
+}
+
+void RunThread::acquireChain(Event *ev, const ReadoutChain &ch)
+{
+    AbstractInterface *iface = modules [ch.members.first ()]->getInterface ();
+    uint32_t got = 0;
+
+    // the last module of the chain terminates the transfer with a bus error
+    int ret = iface->readA32MBLT64 (static_cast<uint32_t> (ch.addr) << 24, chainBuffer.data (), chainBuffer.size (), &got);
+    if (ret && got == 0) {
+        if (!iface->isBusError (ret))
+            std::cout << "Run thread: Error " << ret << " at CBLT from chain 0x" << std::hex << (int) ch.addr << std::dec << std::endl;
+        return;
+    }
+
+    // split the combined buffer into the blocks of the individual modules.
+    // Blocks arrive in chain order, so the search starts at the module that claimed the previous block.
+    const uint32_t *data = chainBuffer.constData ();
+    int n = ch.members.size ();
+    int next = 0;
+    int pos = 0;
+    while (pos < static_cast<int> (got)) {
+        int claimed = 0;
+        for (int k = 0; k < n && claimed <= 0; ++k) {
+            int j = (next + k) % n;
+            AbstractModule *m = modules [ch.members.at (j)];
+            claimed = m->claimChainedData (data + pos, got - pos);
+            if (claimed > 0) {
+                // decoding is left to the module's output plugin, see OutputPlugin::latchData
+                QVector<uint32_t> &raw = ev->storeRaw (m);
+                int sz = raw.size ();
+                raw.resize (sz + claimed);
+                std::copy (data + pos, data + pos + claimed, raw.data () + sz);
+                covered.merge (moduleSlots [ch.members.at (j)]);
+                next = j;
+            }
+        }
+        // filler words and data of unknown origin are skipped
+        pos += (claimed > 0) ? claimed : 1;
+    }
+
+    foreach (int m, ch.members)
+        modules [m]->chainedReadoutDone ();
+}
+
 void RunThread::stop()
 {
     mutex.lock();
@@ -252,27 +508,158 @@ void RunThread::stop()
     std::cout << "Run thread stopping." << std::endl;
 }
 
+void RunThread::interruptLoop()
+{
+    AbstractInterface *iface = InterfaceManager::ptr ()->getMainInterface ();
+
+    // the trigger modules by level and vector
+    QMap<int, AbstractModule*> irqTriggers;
+    uint8_t levels = 0;
+    foreach (AbstractModule *trg, triggers) {
+        uint8_t level, vector;
+        if (!trg->getIrq (&level, &vector) || trg->getInterface () != iface) {
+            std::cout << "Run thread: " << trg->getName ().toStdString () << " raises no interrupts, polling instead." << std::endl;
+            pollLoop ();
+            return;
+        }
+        irqTriggers.insert ((level << 8) | vector, trg);
+        levels |= 1 << level;
+    }
+
+    if (triggers.isEmpty ()) {
+        pollLoop ();
+        return;
+    }
+
+    if (iface->enableIrqs (levels)) {
+        std::cout << "Run thread: " << iface->getName ().toStdString () << " does not support interrupts, polling instead." << std::endl;
+        pollLoop ();
+        return;
+    }
+
+    while(!abort)
+    {
+        int level = 0;
+        uint8_t vector = 0;
+        int ret = iface->waitForIrq (IrqTimeout, &level, &vector);
+        if (ret < 0) {
+            std::cout << "Run thread: Waiting for interrupts failed (" << ret << "), polling instead." << std::endl;
+            iface->enableIrqs (0);
+            pollLoop ();
+            return;
+        }
+
+        AbstractModule *irqTrg = ret ? irqTriggers.value ((level << 8) | vector) : NULL;
+        if (irqTrg) {
+            uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+            acquire(irqTrg);
+            if (start)
+                cycleProfile->add (Profiler::now () - start);
+        } else {
+            // timeout or unknown vector: poll once, so lost interrupts and readout timeouts do not stall the run
+            count (&nofPolls);
+            foreach(AbstractModule* trg, triggers)
+            {
+                if(trg->dataReady())
+                {
+                    uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+                    acquire(trg);
+                    if (start)
+                        cycleProfile->add (Profiler::now () - start);
+                }
+            }
+            flushReservoir ();
+        }
+
+        if (ret)
+            iface->acknowledgeIrq (level);
+    }
+
+    iface->enableIrqs (0);
+}
+
 void RunThread::pollLoop()
 {
+    AbstractInterface *iface = InterfaceManager::ptr ()->getMainInterface ();
+
+    lastAcquisition = Profiler::now ();
+    meanInterval = PollYieldUs * 1000.;
+
     while(!abort)
     {
-        nofPolls++;
-        foreach(AbstractModule* trg, triggers)
+        count (&nofPolls);
+        if (!triggerStatus.isEmpty ())
+            iface->executeList (triggerStatus.data (), triggerStatus.size ());
+
+        bool acquired = false;
+        for (int t = 0; t < triggers.size (); ++t)
         {
-            if(trg->dataReady())
+            AbstractModule *trg = triggers [t];
+            // the status read above is outdated once a trigger has been acquired
+            int s = triggerStatusIndex [t];
+            bool ready = (s >= 0 && !acquired) ? trg->dataReadyFromStatus (triggerStatus.constData () + s)
+                                               : trg->dataReady ();
+            if(ready)
             {
-
-#ifdef GECKO_PROFILE_RUN
-                struct timespec st, et;
-                clock_gettime (CLOCK_MONOTONIC, &st);
-#endif
-                if (acquire(trg))
-                    nofSuccessfulEvents++;
-#ifdef GECKO_PROFILE_RUN
-                clock_gettime (CLOCK_MONOTONIC, &et);
-                timeinacq += (et.tv_sec - st.tv_sec) * 1000000000 + (et.tv_nsec - st.tv_nsec);
-#endif
+                uint64_t start = Profiler::isEnabled () ? Profiler::now () : 0;
+                acquire(trg);
+                if (start)
+                    cycleProfile->add (Profiler::now () - start);
+                acquired = true;
             }
         }
+
+        uint64_t now = Profiler::now ();
+        if (acquired) {
+            meanInterval = 0.9 * meanInterval + 0.1 * (now - lastAcquisition);
+            lastAcquisition = now;
+        } else {
+            flushReservoir ();
+            pollWait (now - lastAcquisition);
+        }
+    }
+}
+
+void RunThread::pollWait(uint64_t idle)
+{
+    // poll without pause while the next event is due according to the recent rate
+    uint64_t spin = 2 * static_cast<uint64_t> (meanInterval);
+    if (spin > PollSpinUs * 1000ULL)
+        spin = PollSpinUs * 1000ULL;
+    if (idle < spin)
+        return;
+
+    // let other threads run, but come back right away
+    if (idle < PollYieldUs * 1000ULL) {
+        yieldCurrentThread ();
+        return;
+    }
+
+    // low rate: sleep for a tenth of the mean interval
+    uint64_t us = static_cast<uint64_t> (meanInterval / 10000);
+    if (us < PollSleepMinUs)
+        us = PollSleepMinUs;
+    if (us > PollSleepMaxUs)
+        us = PollSleepMaxUs;
+    count (&nofPollSleeps);
+    usleep (us);
+}
+
+int RunThread::flushReservoir()
+{
+    int queued = RunManager::ref ().getEventBuffer ()->flushReservoir ();
+    if (queued)
+        emit eventsQueued(queued);
+    return queued;
+}
+
+void RunThread::drainReservoir()
+{
+    // the plugin thread keeps running until the run thread has finished, so the buffer still drains
+    EventBuffer *evbuf = RunManager::ref ().getEventBuffer ();
+    uint64_t deadline = Profiler::now () + ReservoirDrainMs * 1000000ULL;
+    while (evbuf->getReservoirLevel () != 0 && Profiler::now () < deadline) {
+        if (!flushReservoir ())
+            usleep (PollSleepMaxUs);
     }
 }
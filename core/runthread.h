@@ -28,9 +28,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMetaType>
 #include <QMessageBox>
 
+#include "eventbuffer.h"
+#include "abstractinterface.h"
+
 class QSettings;
 class AbstractModule;
-class EventSlot;
+class LatencyHistogram;
 
 /*! The RunThread waits for a AbstractPlugin::dataReady from the modules marked as triggers
  *  and acquires data for processing by the plugin thread.
@@ -48,7 +51,14 @@ public:
     void applySettings(QSettings*);
     void saveSettings(QSettings*);
 
-    uint64_t getNofEvents() {return nofSuccessfulEvents;}
+    // the counters are read from the GUI thread while the run thread updates them
+    uint64_t getNofEvents() {return __atomic_load_n (&nofSuccessfulEvents, __ATOMIC_RELAXED);}
+    /*! Returns the number of times the triggers have been polled for data. */
+    uint64_t getNofPolls() {return __atomic_load_n (&nofPolls, __ATOMIC_RELAXED);}
+    /*! Returns the number of times the poll loop went to sleep because no event was due. */
+    uint64_t getNofPollSleeps() {return __atomic_load_n (&nofPollSleeps, __ATOMIC_RELAXED);}
+    /*! Returns the number of events discarded because modules with multi-event readout delivered different numbers of events. */
+    uint64_t getNofMisalignedEvents() {return __atomic_load_n (&nofMisalignedEvents, __ATOMIC_RELAXED);}
 
 public slots:
     bool acquire(AbstractModule*);
@@ -56,12 +66,71 @@ public slots:
 
 signals:
     void acquisitionDone();
+    /*! Signalled when \c n events have become available in the EventBuffer. */
+    void eventsQueued(int n);
 
 protected:
     void run();
     void pollLoop();
+    /*! Waits for the VME interrupts of the triggers and acquires the module that raised it.
+     *  Falls back to #pollLoop if a trigger or the main interface does not support interrupts.
+     */
+    void interruptLoop();
 
 private:
+    struct ReadoutChain {
+        uint8_t addr;         // CBLT address
+        QVector<int> members; // indices into modules, in chain order
+        LatencyHistogram *profile;
+    };
+
+    void setupChains();
+    /*! Collects the status reads of the modules on the main interface, see AbstractModule::appendStatusReads. */
+    void setupStatusReads();
+    void buildStatusList(const QList<AbstractModule*> &mods, QVector<VmeOp> *ops, QVector<int> *index);
+    /*! Returns whether module \c i has data. Uses the status read at the start of the acquisition cycle if available. */
+    bool moduleReady(int i);
+    /*! Waits before the next poll. Spins, yields or sleeps depending on the time since the last acquisition
+     *  (\c idle, in ns) compared to the recent interval between acquisitions.
+     */
+    void pollWait(uint64_t idle);
+    /*! Queues events the EventBuffer held back with the Sample policy, see EventBuffer::flushReservoir.
+     *  Called while no trigger has data. Returns the number of events queued.
+     */
+    int flushReservoir();
+    /*! Hands the remaining held back events to the plugin thread at the end of the run, waiting at most ReservoirDrainMs. */
+    void drainReservoir();
+    void acquireChain(Event *ev, const ReadoutChain &ch);
+    /*! Increments one of the statistics counters. Only the run thread writes them, so no read-modify-write is needed. */
+    static void count(uint64_t *counter) { __atomic_store_n (counter, *counter + 1, __ATOMIC_RELAXED); }
+
+    Event *takeEvent();
+    /*! Queues the event if all \c required slots are filled. Otherwise the event is kept for the next cycle. */
+    bool queueEvent(Event *ev, const EventSlotMask &required);
+    /*! Returns the length of the first event in the \c left words of undecoded data of module \c i, see AbstractModule::eventLength. */
+    int nextEventLength(int i, const uint32_t *data, int left) const;
+    /*! Moves all but the first event of multi-event raw data out of \c ev. Returns the number of events in the cycle,
+     *  or 0 if the modules delivered different numbers of events. Such cycles are discarded and counted as misaligned.
+     */
+    int splitEvents(Event *ev);
+    /*! Fills \c ev with the next of the events moved out by #splitEvents.
+     *  Only the modules with multi-event data contribute to these events, see splitMandatories.
+     */
+    void takePendingEvent(Event *ev);
+
+    /*! size of the CBLT buffer per chain member, in 32 bit words */
+    static const int ChainWordsPerModule = 0x2000;
+    /*! time in ms after which the triggers are polled if no interrupt arrived */
+    static const int IrqTimeout = 100;
+    /*! longest time in us to poll without pause after an acquisition */
+    static const int PollSpinUs = 50;
+    /*! time in us after an acquisition from which on the poll loop sleeps between polls */
+    static const int PollYieldUs = 1000;
+    /*! range of the sleep between polls in us */
+    static const int PollSleepMinUs = 20;
+    static const int PollSleepMaxUs = 1000;
+    /*! longest time in ms to wait at the end of the run for room for the held back events */
+    static const int ReservoirDrainMs = 500;
 
     bool triggered;
     bool running;
@@ -72,11 +141,44 @@ private:
 
     uint64_t nofSuccessfulEvents;
     uint64_t nofPolls;
+    uint64_t nofPollSleeps;
+    uint64_t nofMisalignedEvents;
 
     QList<AbstractModule*> modules;
     QList<AbstractModule*> triggers;
-    QList<const EventSlot *> mandatories;
-
+    EventSlotMask mandatories;
+    EventSlotMask splitMandatories; // the mandatory slots of the modules in rawModules
+
+    // modules with split readout (see AbstractModule::hasRawReadout), parallel to modules
+    QVector<bool> rawReadout;
+    QVector<EventSlotMask> moduleSlots;
+    bool anyRawReadout;
+    EventSlotMask covered; // slots occupied or about to be filled by decoding in the current cycle
+
+    // chained block transfers, see ModuleManager::setChain
+    QVector<ReadoutChain> chains;
+    QVector<int> chainOf; // parallel to modules: index into chains, or -1
+    QVector<uint32_t> chainBuffer;
+
+    // multi-event readout, see AbstractModule::eventLength
+    QVector<int> rawModules; // modules with undecoded data, raw readout or chained
+    QVector< QVector<uint32_t> > pending; // parallel to modules: raw data of the events not yet queued
+    QVector<int> pendingPos;
+
+    // batched status reads, see AbstractModule::appendStatusReads
+    QVector<VmeOp> moduleStatus;
+    QVector<int> moduleStatusIndex;  // parallel to modules: first cycle in moduleStatus, or -1
+    QVector<VmeOp> triggerStatus;
+    QVector<int> triggerStatusIndex; // parallel to triggers
+
+    // adaptive polling, see pollWait
+    uint64_t lastAcquisition; // Profiler::now () after the last acquisition
+    double meanInterval;      // ns between acquisitions, decaying average
+
+    Event *spareEvent; // rejected event kept for the next acquisition cycle
+
+    QVector<LatencyHistogram*> moduleProfiles; // parallel to modules
+    LatencyHistogram *cycleProfile;
 
     QMutex mutex;
 };
@@ -24,11 +24,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "remotecontrolpanel.h"
 #include "outputplugin.h"
 #include "eventbuffer.h"
+#include "threadscheduling.h"
+#include "profiler.h"
 
 #include <QThreadPool>
 #include <QUdpSocket>
 #include <QNetworkInterface>
 #include <QCheckBox>
+#include <QSpinBox>
+#include <QComboBox>
+#include <QHBoxLayout>
 #include <QPushButton>
 #include <QTextEdit>
 #include <QCloseEvent>
@@ -108,6 +113,7 @@ void ScopeMainWindow::createUI()
     connect (RunManager::ptr (), SIGNAL(runUpdate(float,uint)), SLOT(updateRunPage(float,uint)));
 
     createRunSetupPage();
+    createThreadSetupPage();
     createRunControlPage();
     createRemoteControlPage();
 
@@ -576,11 +582,13 @@ void ScopeMainWindow::createRunSetupPage()
     QGroupBox* channelBox = new QGroupBox(tr("Channels"));
 
     triggerList = new QTreeWidget();
-    triggerList->setColumnCount(2);
+    triggerList->setColumnCount(3);
     QStringList headerLabels;
     headerLabels.append("Module");
     headerLabels.append("Channel");
+    headerLabels.append("CBLT");
     triggerList->setHeaderLabels(headerLabels);
+    triggerList->headerItem()->setToolTip(2, tr("Modules with the same CBLT address are read out with one chained block transfer, in module list order"));
     headerLabels.clear();
 
     channelList = new QTreeWidget();
@@ -606,12 +614,163 @@ void ScopeMainWindow::createRunSetupPage()
     connect (singleEventModeBox, SIGNAL(toggled(bool)), RunManager::ptr (), SLOT(setSingleEventMode(bool)));
     layout->addWidget (singleEventModeBox,2,0,1,1);
 
+    QWidget *pipelineBox = new QWidget;
+    QHBoxLayout *pipelineLayout = new QHBoxLayout;
+    pipelineDepthSpinner = new QSpinBox;
+    pipelineDepthSpinner->setRange (1, 8);
+    pipelineDepthSpinner->setToolTip (tr ("Number of event batches the plugins may process at the same time"));
+    connect (pipelineDepthSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setPipelineDepth(int)));
+    pluginThreadsSpinner = new QSpinBox;
+    pluginThreadsSpinner->setRange (0, 64);
+    pluginThreadsSpinner->setSpecialValueText (tr ("Auto"));
+    pluginThreadsSpinner->setToolTip (tr ("Number of threads the plugins are processed on.\n"
+                                         "Auto uses all CPUs except the ones the readout and plugin threads are pinned to."));
+    connect (pluginThreadsSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setPluginThreads(int)));
+    batchSizeSpinner = new QSpinBox;
+    batchSizeSpinner->setRange (1, 1024);
+    batchSizeSpinner->setToolTip (tr ("Maximum number of events handed to the plugins at once"));
+    connect (batchSizeSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setBatchSize(int)));
+    batchLatencySpinner = new QSpinBox;
+    batchLatencySpinner->setRange (1, 1000);
+    batchLatencySpinner->setSuffix (tr (" ms"));
+    batchLatencySpinner->setToolTip (tr ("Maximum time an event waits for its batch to fill up"));
+    connect (batchLatencySpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setBatchLatency(int)));
+    pipelineLayout->setContentsMargins (0, 0, 0, 0);
+    pipelineLayout->addWidget (new QLabel (tr ("Batches in flight:")));
+    pipelineLayout->addWidget (pipelineDepthSpinner);
+    pipelineLayout->addWidget (new QLabel (tr ("Threads:")));
+    pipelineLayout->addWidget (pluginThreadsSpinner);
+    pipelineLayout->addWidget (new QLabel (tr ("Batch size:")));
+    pipelineLayout->addWidget (batchSizeSpinner);
+    pipelineLayout->addWidget (new QLabel (tr ("Max. latency:")));
+    pipelineLayout->addWidget (batchLatencySpinner);
+    pipelineLayout->addStretch ();
+    pipelineBox->setLayout (pipelineLayout);
+    layout->addWidget (pipelineBox,3,0,1,1);
+
+    QWidget *evbufBox = new QWidget;
+    QHBoxLayout *evbufLayout = new QHBoxLayout;
+    overflowPolicyBox = new QComboBox;
+    overflowPolicyBox->addItems (QStringList () << tr ("Block readout") << tr ("Drop newest") << tr ("Drop oldest") << tr ("Sample"));
+    overflowPolicyBox->setToolTip (tr ("What happens to new events while the plugins are not keeping up.\n"
+                                      "Events are never dropped while a plugin records data, the readout blocks instead."));
+    connect (overflowPolicyBox, SIGNAL(currentIndexChanged(int)), RunManager::ptr (), SLOT(setOverflowPolicy(int)));
+    evbufSizeSpinner = new QSpinBox;
+    evbufSizeSpinner->setRange (1, EventBuffer::MaxBudgetEvents);
+    evbufSizeSpinner->setSuffix (tr (" events"));
+    connect (evbufSizeSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setEventBufferSize(int)));
+    evbufMemorySpinner = new QSpinBox;
+    evbufMemorySpinner->setRange (0, 65536);
+    evbufMemorySpinner->setSuffix (tr (" MiB"));
+    evbufMemorySpinner->setSpecialValueText (tr ("off"));
+    evbufMemorySpinner->setToolTip (tr ("Size the event buffer by memory instead of by event count"));
+    connect (evbufMemorySpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setEventBufferMemory(int)));
+    evbufLayout->setContentsMargins (0, 0, 0, 0);
+    evbufLayout->addWidget (new QLabel (tr ("Event buffer:")));
+    evbufLayout->addWidget (evbufSizeSpinner);
+    evbufLayout->addWidget (new QLabel (tr ("Memory budget:")));
+    evbufLayout->addWidget (evbufMemorySpinner);
+    evbufLayout->addWidget (new QLabel (tr ("When full:")));
+    evbufLayout->addWidget (overflowPolicyBox);
+    evbufLayout->addStretch ();
+    evbufBox->setLayout (evbufLayout);
+    layout->addWidget (evbufBox,4,0,1,1);
+
     runSetup->setLayout(layout);
     addRunPageToTree(runSetup);
 
     loadChannelList();
 }
 
+void ScopeMainWindow::createThreadSetupPage()
+{
+    QWidget* threadSetup = new QGroupBox(tr("Thread Setup"));
+    threadSetup->setAccessibleName(tr("Thread Setup"));
+
+    QGridLayout* layout = new QGridLayout();
+    QStringList policies;
+    policies << tr ("Normal") << tr ("SCHED_FIFO") << tr ("SCHED_RR");
+    int maxCpu = ThreadScheduling::getCpuCount () - 1;
+
+    readoutCpuSpinner = new QSpinBox;
+    readoutCpuSpinner->setRange (-1, maxCpu);
+    readoutCpuSpinner->setSpecialValueText (tr ("any"));
+    readoutPolicyBox = new QComboBox;
+    readoutPolicyBox->addItems (policies);
+    readoutPrioritySpinner = new QSpinBox;
+    readoutPrioritySpinner->setRange (1, 99);
+    connect (readoutCpuSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setReadoutCpu(int)));
+    connect (readoutPolicyBox, SIGNAL(currentIndexChanged(int)), RunManager::ptr (), SLOT(setReadoutPolicy(int)));
+    connect (readoutPrioritySpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setReadoutPriority(int)));
+
+    pluginCpuSpinner = new QSpinBox;
+    pluginCpuSpinner->setRange (-1, maxCpu);
+    pluginCpuSpinner->setSpecialValueText (tr ("any"));
+    pluginPolicyBox = new QComboBox;
+    pluginPolicyBox->addItems (policies);
+    pluginPrioritySpinner = new QSpinBox;
+    pluginPrioritySpinner->setRange (1, 99);
+    connect (pluginCpuSpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setPluginCpu(int)));
+    connect (pluginPolicyBox, SIGNAL(currentIndexChanged(int)), RunManager::ptr (), SLOT(setPluginPolicy(int)));
+    connect (pluginPrioritySpinner, SIGNAL(valueChanged(int)), RunManager::ptr (), SLOT(setPluginPriority(int)));
+
+    lockMemoryBox = new QCheckBox (tr ("Lock memory during runs (mlockall)"));
+    lockMemoryBox->setToolTip (tr ("Keeps the process memory in RAM, so the readout never waits for a page fault"));
+    connect (lockMemoryBox, SIGNAL(toggled(bool)), RunManager::ptr (), SLOT(setMemoryLockEnabled(bool)));
+
+    interruptReadoutBox = new QCheckBox (tr ("Wait for VME interrupts of the triggers instead of polling"));
+    interruptReadoutBox->setToolTip (tr ("Frees the CPU while there is no data. Requires triggers with an IRQ level set"));
+    connect (interruptReadoutBox, SIGNAL(toggled(bool)), RunManager::ptr (), SLOT(setInterruptReadout(bool)));
+
+    schedulingStatusLabel = new QLabel;
+    schedulingStatusLabel->setWordWrap (true);
+
+    // the run manager has been updated by the connections above when the status is rechecked
+    connect (readoutCpuSpinner, SIGNAL(valueChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (readoutPolicyBox, SIGNAL(currentIndexChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (readoutPrioritySpinner, SIGNAL(valueChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (pluginCpuSpinner, SIGNAL(valueChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (pluginPolicyBox, SIGNAL(currentIndexChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (pluginPrioritySpinner, SIGNAL(valueChanged(int)), SLOT(updateSchedulingStatus()));
+    connect (lockMemoryBox, SIGNAL(toggled(bool)), SLOT(updateSchedulingStatus()));
+
+    layout->addWidget (new QLabel (tr ("CPU")),          0,1,1,1);
+    layout->addWidget (new QLabel (tr ("Scheduling")),   0,2,1,1);
+    layout->addWidget (new QLabel (tr ("Priority")),     0,3,1,1);
+    layout->addWidget (new QLabel (tr ("Readout thread:")), 1,0,1,1);
+    layout->addWidget (readoutCpuSpinner,                1,1,1,1);
+    layout->addWidget (readoutPolicyBox,                 1,2,1,1);
+    layout->addWidget (readoutPrioritySpinner,           1,3,1,1);
+    layout->addWidget (new QLabel (tr ("Plugin thread:")), 2,0,1,1);
+    layout->addWidget (pluginCpuSpinner,                 2,1,1,1);
+    layout->addWidget (pluginPolicyBox,                  2,2,1,1);
+    layout->addWidget (pluginPrioritySpinner,            2,3,1,1);
+    layout->addWidget (lockMemoryBox,                    3,0,1,4);
+    layout->addWidget (interruptReadoutBox,              4,0,1,4);
+    layout->addWidget (schedulingStatusLabel,            5,0,1,4);
+    layout->setRowStretch (6, 1);
+
+    threadSetup->setLayout(layout);
+    addRunPageToTree(threadSetup);
+
+    loadThreadSetup();
+}
+
+void ScopeMainWindow::updateSchedulingStatus()
+{
+    const ThreadSchedulingConfig &ro = RunManager::ref ().getReadoutScheduling ();
+    const ThreadSchedulingConfig &pl = RunManager::ref ().getPluginScheduling ();
+    readoutPrioritySpinner->setEnabled (ro.policy != ThreadSchedulingConfig::Normal);
+    pluginPrioritySpinner->setEnabled (pl.policy != ThreadSchedulingConfig::Normal);
+
+    QStringList problems = RunManager::ref ().checkScheduling ();
+    if (problems.empty ()) {
+        schedulingStatusLabel->setText (tr ("Settings take effect at the next run start."));
+    } else {
+        schedulingStatusLabel->setText (QString ("<font color=\"red\">%1</font>").arg (problems.join ("<br>")));
+    }
+}
+
 void ScopeMainWindow::createRunControlPage()
 {
     QWidget* runControl = new QGroupBox(tr("Run Control"));
@@ -645,10 +804,22 @@ void ScopeMainWindow::createRunControlPage()
         nofEventsEdit->setReadOnly(true);
         eventsPerSecondEdit = new QLineEdit(0);
         eventsPerSecondEdit->setReadOnly(true);
+        QLabel* lostEventsLabel = new QLabel(tr("Lost:"));
+        lostEventsEdit = new QLineEdit(0);
+        lostEventsEdit->setReadOnly(true);
+        lostEventsEdit->setToolTip(tr("Events the plugins did not get to see because the event buffer was full"));
+        QLabel* pollsPerEventLabel = new QLabel(tr("Polls/ev:"));
+        pollsPerEventEdit = new QLineEdit(0);
+        pollsPerEventEdit->setReadOnly(true);
+        pollsPerEventEdit->setToolTip(tr("Times the triggers were polled for data per event"));
         box2l->addWidget(nofEventsLabel,0,0,1,1);
         box2l->addWidget(eventsPerSecondLabel,1,0,1,1);
+        box2l->addWidget(lostEventsLabel,2,0,1,1);
+        box2l->addWidget(pollsPerEventLabel,3,0,1,1);
         box2l->addWidget(nofEventsEdit,0,1,1,1);
         box2l->addWidget(eventsPerSecondEdit,1,1,1,1);
+        box2l->addWidget(lostEventsEdit,2,1,1,1);
+        box2l->addWidget(pollsPerEventEdit,3,1,1,1);
     box2->setLayout(box2l);
 
     runStartButton = new QPushButton(tr("Start Run"));
@@ -669,12 +840,32 @@ void ScopeMainWindow::createRunControlPage()
     layout->addWidget(runNameButton,    0,3,1,1);
     layout->addWidget(box1,             1,0,1,2);
     layout->addWidget(box2,             1,2,1,2);
+    QGroupBox* box4 = new QGroupBox(tr("Profile:"));
+        QGridLayout* box4l = new QGridLayout();
+        profilingBox = new QCheckBox(tr("Enable profiling"));
+        profilingBox->setToolTip(tr("Measure the time spent in each module and plugin while the run is active"));
+        QPushButton* profileResetButton = new QPushButton(tr("Reset"));
+        profileEdit = new QTextEdit();
+        profileEdit->setReadOnly(true);
+        profileEdit->setLineWrapMode(QTextEdit::NoWrap);
+        QFont profileFont("Monospace");
+        profileFont.setStyleHint(QFont::TypeWriter);
+        profileEdit->setFont(profileFont);
+        connect(profilingBox, SIGNAL(toggled(bool)), SLOT(setProfilingEnabled(bool)));
+        connect(profileResetButton, SIGNAL(clicked()), SLOT(resetProfile()));
+        box4l->addWidget(profilingBox,       0,0,1,1);
+        box4l->addWidget(profileResetButton, 0,1,1,1);
+        box4l->addWidget(profileEdit,        1,0,1,2);
+    box4->setLayout(box4l);
+
     layout->addWidget(box3,             2,0,1,3);
     layout->addWidget(runStartButton,   2,3,1,1);
+    layout->addWidget(box4,             3,0,1,4);
 
     runControl->setLayout(layout);
 
     addRunPageToTree(runControl);
+    updateProfile();
 }
 
 void ScopeMainWindow::createRemoteControlPage()
@@ -741,11 +932,24 @@ void ScopeMainWindow::treeViewClicked(const QModelIndex & idx, const QModelIndex
 
 void ScopeMainWindow::triggerListChanged(QTreeWidgetItem* item,int col)
 {
-    if (!item || col != 0)
+    if (!item || (col != 0 && col != 2))
         return;
 
     AbstractModule* mod = item->data(0,Qt::UserRole + 1).value<AbstractModule*> ();
-    ModuleManager::ref ().setTrigger (mod, item->checkState (0) == Qt::Checked);
+    if (col == 0) {
+        ModuleManager::ref ().setTrigger (mod, item->checkState (0) == Qt::Checked);
+        return;
+    }
+
+    bool ok;
+    uint addr = item->text (2).toUInt (&ok, 0);
+    if (!ok || addr > 0xFF)
+        addr = 0;
+    ModuleManager::ref ().setChain (mod, addr);
+
+    QString text = addr ? QString ("0x%1").arg (addr, 2, 16, QChar ('0')) : QString ();
+    if (item->text (2) != text)
+        item->setText (2, text);
 }
 
 void ScopeMainWindow::channelListChanged(QTreeWidgetItem* item, int col)
@@ -781,6 +985,9 @@ void ScopeMainWindow::loadChannelList()
         QTreeWidgetItem *trgIt = new QTreeWidgetItem (QStringList () << mod->getName ());
         trgIt->setData(0, Qt::UserRole + 1, QVariant::fromValue (mod));
         trgIt->setCheckState(0, ModuleManager::ref ().isTrigger (mod) ? Qt::Checked : Qt::Unchecked);
+        if (uint8_t addr = ModuleManager::ref ().getChain (mod))
+            trgIt->setText(2, QString ("0x%1").arg (addr, 2, 16, QChar ('0')));
+        trgIt->setFlags(trgIt->flags () | Qt::ItemIsEditable);
         trgItems.append (trgIt);
 
         foreach (const EventSlot *sl, mod->getSlots ()) {
@@ -795,17 +1002,67 @@ void ScopeMainWindow::loadChannelList()
     triggerList->addTopLevelItems(trgItems);
     channelList->addTopLevelItems(slItems);
     singleEventModeBox->setChecked (RunManager::ref ().isSingleEventMode ());
+    pipelineDepthSpinner->setValue (RunManager::ref ().getPipelineDepth ());
+    pluginThreadsSpinner->setValue (RunManager::ref ().getPluginThreads ());
+    batchSizeSpinner->setValue (RunManager::ref ().getBatchSize ());
+    batchLatencySpinner->setValue (RunManager::ref ().getBatchLatency ());
+    evbufSizeSpinner->setValue (RunManager::ref ().getEventBufferSize ());
+    evbufMemorySpinner->setValue (RunManager::ref ().getEventBufferMemory ());
+    overflowPolicyBox->setCurrentIndex (RunManager::ref ().getOverflowPolicy ());
+
+}
+
+void ScopeMainWindow::loadThreadSetup()
+{
+    // copy the settings first, every widget update writes back to the run manager
+    ThreadSchedulingConfig ro = RunManager::ref ().getReadoutScheduling ();
+    ThreadSchedulingConfig pl = RunManager::ref ().getPluginScheduling ();
+    bool lockmem = RunManager::ref ().isMemoryLockEnabled ();
+    bool irq = RunManager::ref ().isInterruptReadout ();
+    readoutCpuSpinner->setValue (ro.cpu);
+    readoutPolicyBox->setCurrentIndex (ro.policy);
+    readoutPrioritySpinner->setValue (ro.priority);
+    pluginCpuSpinner->setValue (pl.cpu);
+    pluginPolicyBox->setCurrentIndex (pl.policy);
+    pluginPrioritySpinner->setValue (pl.priority);
+    lockMemoryBox->setChecked (lockmem);
+    interruptReadoutBox->setChecked (irq);
+    updateSchedulingStatus ();
 }
 
 void ScopeMainWindow::updateRunPage(float evspersec, unsigned evs)
 {
     nofEventsEdit->setText(tr("%1").arg(evs));
     eventsPerSecondEdit->setText(tr("%1").arg(evspersec, 0, 'f', 1));
+    lostEventsEdit->setText(tr("%1").arg(RunManager::ref ().getLostEventCount ()));
+    pollsPerEventEdit->setText(tr("%1").arg(RunManager::ref ().getPollsPerEvent (), 0, 'f', 1));
+    updateProfile();
+}
+
+void ScopeMainWindow::setProfilingEnabled(bool enabled)
+{
+    Profiler::ref ().setEnabled (enabled);
+    updateProfile();
+}
+
+void ScopeMainWindow::resetProfile()
+{
+    Profiler::ref ().reset ();
+    updateProfile();
+}
+
+void ScopeMainWindow::updateProfile()
+{
+    if (Profiler::isEnabled ())
+        profileEdit->setPlainText (Profiler::ref ().report ().join ("\n"));
+    else
+        profileEdit->setPlainText (tr ("Profiling is disabled."));
 }
 
 void ScopeMainWindow::runStarted () {
     nofEventsEdit->setText ("0");
     eventsPerSecondEdit->setText ("0");
+    lostEventsEdit->setText ("0");
 
     runStartButton->disconnect ();
     connect (runStartButton, SIGNAL(clicked()), SLOT(stopAcquisition()));
@@ -868,6 +1125,7 @@ void ScopeMainWindow::applySettings()
     pmgr->applySettings(settings);
 
     loadChannelList();
+    loadThreadSetup();
 
     setWindowTitle("GECKO (" + fileName + ")");
 }
@@ -1062,6 +1320,21 @@ void ScopeMainWindow::saveConfig (QSettings *s) {
     s->beginGroup ("Configuration");
 
     s->setValue ("SingleEventMode", RunManager::ref ().isSingleEventMode ());
+    s->setValue ("PipelineDepth", RunManager::ref ().getPipelineDepth ());
+    s->setValue ("PluginThreads", RunManager::ref ().getPluginThreads ());
+    s->setValue ("BatchSize", RunManager::ref ().getBatchSize ());
+    s->setValue ("BatchLatency", RunManager::ref ().getBatchLatency ());
+    s->setValue ("EventBufferSize", RunManager::ref ().getEventBufferSize ());
+    s->setValue ("EventBufferMemory", RunManager::ref ().getEventBufferMemory ());
+    s->setValue ("OverflowPolicy", RunManager::ref ().getOverflowPolicy ());
+    s->setValue ("ReadoutCpu", RunManager::ref ().getReadoutScheduling ().cpu);
+    s->setValue ("ReadoutPolicy", RunManager::ref ().getReadoutScheduling ().policy);
+    s->setValue ("ReadoutPriority", RunManager::ref ().getReadoutScheduling ().priority);
+    s->setValue ("PluginCpu", RunManager::ref ().getPluginScheduling ().cpu);
+    s->setValue ("PluginPolicy", RunManager::ref ().getPluginScheduling ().policy);
+    s->setValue ("PluginPriority", RunManager::ref ().getPluginScheduling ().priority);
+    s->setValue ("LockMemory", RunManager::ref ().isMemoryLockEnabled ());
+    s->setValue ("InterruptReadout", RunManager::ref ().isInterruptReadout ());
     if (InterfaceManager::ref ().getMainInterface ())
         s->setValue ("MainInterface", InterfaceManager::ref().getMainInterface()->getName ());
 
@@ -1086,6 +1359,7 @@ void ScopeMainWindow::saveConfig (QSettings *s) {
             s->setValue ("iface", daq->getInterface()->getName ());
         s->setValue ("baddr", daq->getBaseAddress ());
         s->setValue ("trigger", ModuleManager::ref ().isTrigger (daq));
+        s->setValue ("cbltchain", ModuleManager::ref ().getChain (daq));
 
         if (daq->getOutputPlugin())
             roots.insert (daq->getOutputPlugin(), daq->getName ());
@@ -1142,6 +1416,21 @@ void ScopeMainWindow::loadConfig (QSettings *s) {
 
     s->beginGroup ("Configuration");
     RunManager::ref().setSingleEventMode (s->value ("SingleEventMode", false).toBool ());
+    RunManager::ref().setPipelineDepth (s->value ("PipelineDepth", 1).toInt ());
+    RunManager::ref().setPluginThreads (s->value ("PluginThreads", 0).toInt ());
+    RunManager::ref().setBatchSize (s->value ("BatchSize", 1).toInt ());
+    RunManager::ref().setBatchLatency (s->value ("BatchLatency", 10).toInt ());
+    RunManager::ref().setEventBufferSize (s->value ("EventBufferSize", 10).toInt ());
+    RunManager::ref().setEventBufferMemory (s->value ("EventBufferMemory", 0).toInt ());
+    RunManager::ref().setOverflowPolicy (s->value ("OverflowPolicy", EventBuffer::Block).toInt ());
+    RunManager::ref().setReadoutCpu (s->value ("ReadoutCpu", -1).toInt ());
+    RunManager::ref().setReadoutPolicy (s->value ("ReadoutPolicy", ThreadSchedulingConfig::Normal).toInt ());
+    RunManager::ref().setReadoutPriority (s->value ("ReadoutPriority", 50).toInt ());
+    RunManager::ref().setPluginCpu (s->value ("PluginCpu", -1).toInt ());
+    RunManager::ref().setPluginPolicy (s->value ("PluginPolicy", ThreadSchedulingConfig::Normal).toInt ());
+    RunManager::ref().setPluginPriority (s->value ("PluginPriority", 50).toInt ());
+    RunManager::ref().setMemoryLockEnabled (s->value ("LockMemory", false).toBool ());
+    RunManager::ref().setInterruptReadout (s->value ("InterruptReadout", false).toBool ());
     size = s->beginReadArray ("Interfaces");
     for (int i = 0; i < size; ++i) {
         s->setArrayIndex (i);
@@ -1183,6 +1472,7 @@ void ScopeMainWindow::loadConfig (QSettings *s) {
         }
         daq->setBaseAddress (s->value ("baddr").toUInt ());
         ModuleManager::ref ().setTrigger (daq, s->value ("trigger").toBool ());
+        ModuleManager::ref ().setChain (daq, s->value ("cbltchain", 0).toUInt ());
 
         if (daq->getOutputPlugin ())
             roots.insert (daq->getName (), daq->getOutputPlugin ());
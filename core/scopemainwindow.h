@@ -77,6 +77,7 @@ class QCheckBox;
 class QHostAddress;
 class QTextEdit;
 class QComboBox;
+class QSpinBox;
 
 class SystemInfo;
 class RemoteControlPanel;
@@ -100,11 +101,13 @@ protected:
     void createStatusBar();
 
     void createRunSetupPage();
+    void createThreadSetupPage();
     void createRunControlPage();
     void createRemoteControlPage();
     void createUdpSocket();
     void createTcpSocket();
     void loadChannelList();
+    void loadThreadSetup();
 
     QStandardItem *addTabToTree(QWidget* newTab);
     void addRunPageToTree(QWidget* newWidget);
@@ -155,6 +158,10 @@ public slots:
     void runStopping ();
     void runStopped ();
     void updateRunPage(float evspersec, unsigned evs);
+    void updateSchedulingStatus();
+    void setProfilingEnabled(bool);
+    void resetProfile();
+    void updateProfile();
 
     void addModuleToTree(AbstractModule* newModule);
     void addInterfaceToTree(AbstractInterface* newModule);
@@ -250,8 +257,30 @@ private:
     QDateTimeEdit* startTimeEdit;
     QDateTimeEdit* stopTimeEdit;
     QLineEdit* nofEventsEdit;
+    QLineEdit* lostEventsEdit;
+    QLineEdit* pollsPerEventEdit;
     QLineEdit* eventsPerSecondEdit;
     QCheckBox *singleEventModeBox;
+    QSpinBox *pipelineDepthSpinner;
+    QSpinBox *pluginThreadsSpinner;
+    QSpinBox *batchSizeSpinner;
+    QSpinBox *batchLatencySpinner;
+    QComboBox *overflowPolicyBox;
+    QSpinBox *evbufSizeSpinner;
+    QSpinBox *evbufMemorySpinner;
+    QCheckBox *profilingBox;
+    QTextEdit *profileEdit;
+
+    // Thread setup
+    QSpinBox *readoutCpuSpinner;
+    QComboBox *readoutPolicyBox;
+    QSpinBox *readoutPrioritySpinner;
+    QSpinBox *pluginCpuSpinner;
+    QComboBox *pluginPolicyBox;
+    QSpinBox *pluginPrioritySpinner;
+    QCheckBox *lockMemoryBox;
+    QCheckBox *interruptReadoutBox;
+    QLabel *schedulingStatusLabel;
 
     // Timers
     QTimer* oneSecondTimer;
@@ -0,0 +1,334 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPSCTHREADBUFFER_H
+#define SPSCTHREADBUFFER_H
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifndef GECKO_CACHELINE_SIZE
+#define GECKO_CACHELINE_SIZE 64
+#endif
+
+/*! Lock-free single-producer/single-consumer ring buffer.
+ *  The SpscThreadBuffer offers the same interface as ThreadBuffer, but requires that at any time only one thread
+ *  writes to the buffer and only one thread reads from it. Under this restriction, no locks are necessary:
+ *  The producer owns the head index, the consumer owns the tail index and each side only ever reads the index of the other.
+ *  Both indices live on separate cache lines to avoid false sharing between the two threads.
+ *
+ *  Elements are copied in at most two contiguous segments per call, so wrapped regions do not incur a per-element
+ *  wrap check. A side that has to wait (producer on a full buffer, consumer in #readAvailable) spins for a configurable
+ *  number of iterations and then sleeps on a futex until the other side signals progress.
+ *
+ *  As an exception to the single-consumer rule, the producer may take back the oldest element with #tryReclaim.
+ *  The consumer advances its index with a compare-and-swap, so either side gets the element but never both.
+ *
+ *  \note Calling #write from more than one thread or #read from more than one thread concurrently is undefined.
+ *  \sa ThreadBuffer
+ */
+template<class T>
+class SpscThreadBuffer
+{
+public:
+    /*! Create a SpscThreadBuffer.
+     *  \param size number of elements the buffer can hold. A size of 0 is raised to 1.
+     *  \param defaultValue the value that should be assigned to unused ringbuffer elements.
+     *  \param spinCount number of polling iterations before a waiting thread is put to sleep. 0 blocks immediately.
+     */
+    SpscThreadBuffer(uint32_t size, T defaultValue = T (), uint32_t spinCount = 1000);
+    ~SpscThreadBuffer();
+
+    /*! Write data to the buffer.
+     *  Writes \c len elements of data from the array pointed to by \c data to the buffer.
+     *  Blocks until all elements have been written.
+     *  \param data pointer to array containing the data.
+     *  \param len  length of array
+     */
+    uint32_t write(const T* data, uint32_t len);
+
+    /*! Write as many elements as currently fit into the buffer without waiting.
+     *  \returns the number of elements written.
+     */
+    uint32_t tryWrite(const T* data, uint32_t len);
+
+    /*! Waits until at least \c n elements can be written without blocking.
+     *  May only be called by the producer.
+     */
+    void waitForFree(uint32_t n);
+
+    /*! Takes the oldest element out of the buffer, from the producer side.
+     *  The consumer may be reading at the same time; it never gets an element reclaimed by the producer.
+     *  \param[out] out receives the element
+     *  \returns false if the buffer is empty or the consumer got the element first.
+     *  \note \c T should be trivially copyable, because the consumer may copy an element that is being reclaimed
+     *  before it notices and discards the copy.
+     */
+    bool tryReclaim(T &out);
+
+    /*! read data from the buffer.
+     *  Reads \c len elements from buffer and stores them to the vector \c data.
+     *  If less than \c len elements are available, nothing is read and 0 is returned. This call does not block.
+     *  \param[out] data storage for the elements read from the buffer, must hold at least \c len elements
+     *  \param len amount of data to read
+     */
+    uint32_t read(std::vector<T> & data, uint32_t len);
+
+    /*! read all available data from the buffer.
+     *  Waits at most 10 ms for data to become available and then reads everything there is.
+     */
+    uint32_t readAvailable(std::vector<T> & data);
+
+    /*! Returns the number of elements available for reading. */
+    uint32_t available() const;
+
+    /*! Returns the space left in the buffer */
+    uint32_t free () const;
+
+    /*! Return the buffer size. */
+    uint32_t getSize() const { return size; }
+
+    /*! Resets the buffer.
+     *  All elements in the buffer are discarded.
+     *  \warning Neither the producer nor the consumer may access the buffer while it is reset.
+     */
+    void reset();
+
+private:
+    static uint32_t loadAcquire (const volatile uint32_t *p) { return __atomic_load_n (p, __ATOMIC_ACQUIRE); }
+    static void storeRelease (volatile uint32_t *p, uint32_t v) { __atomic_store_n (p, v, __ATOMIC_RELEASE); }
+    static void storeSeqCst (volatile uint32_t *p, uint32_t v) { __atomic_store_n (p, v, __ATOMIC_SEQ_CST); }
+    static uint32_t loadSeqCst (const volatile uint32_t *p) { return __atomic_load_n (p, __ATOMIC_SEQ_CST); }
+    static bool casSeqCst (volatile uint32_t *p, uint32_t *expected, uint32_t v) {
+        return __atomic_compare_exchange_n (p, expected, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    static void futexWait (volatile uint32_t *addr, uint32_t expected, const struct timespec *timeout) {
+        syscall (SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+    }
+    static void futexWake (volatile uint32_t *addr) {
+        syscall (SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+
+    void copyIn (uint32_t pos, const T* data, uint32_t len);
+    void copyOut (uint32_t pos, T* data, uint32_t len);
+
+    /*! wait until the index at \c idx differs from \c seen, at most for \c timeout (NULL waits forever). */
+    void waitForChange (volatile uint32_t *idx, volatile uint32_t *waitflag, uint32_t seen, const struct timespec *timeout);
+
+private:
+    // Producer cache line: written by the producer, read by the consumer
+    volatile uint32_t head;
+    volatile uint32_t writerWaiting;
+    char padHead[GECKO_CACHELINE_SIZE - 2*sizeof(uint32_t)];
+
+    // Consumer cache line: written by the consumer (and the producer in #tryReclaim), read by the producer
+    volatile uint32_t tail;
+    volatile uint32_t readerWaiting;
+    char padTail[GECKO_CACHELINE_SIZE - 2*sizeof(uint32_t)];
+
+    T* buffer;
+    uint32_t size;
+    uint32_t spinCount;
+    T defval;
+
+private: // no copying
+    SpscThreadBuffer (const SpscThreadBuffer &);
+    SpscThreadBuffer &operator= (const SpscThreadBuffer &);
+};
+
+
+template<class T>
+SpscThreadBuffer<T>::SpscThreadBuffer(uint32_t _size, T defaultValue, uint32_t _spinCount)
+        : head (0), writerWaiting (0), tail (0), readerWaiting (0)
+        , size(std::max<uint32_t> (_size, 1)), spinCount (_spinCount), defval (defaultValue)
+{
+    buffer = new T[size];
+    std::fill (buffer, buffer + size, defval);
+}
+
+template<class T>
+SpscThreadBuffer<T>::~SpscThreadBuffer()
+{
+    delete [] buffer;
+    buffer = NULL;
+}
+
+template<class T>
+void SpscThreadBuffer<T>::reset()
+{
+    std::fill (buffer, buffer + size, defval);
+    storeSeqCst (&head, 0);
+    storeSeqCst (&tail, 0);
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::available() const
+{
+    // read tail first: head can only grow in between, so the result never exceeds size
+    uint32_t t = loadAcquire (&tail);
+    return loadAcquire (&head) - t;
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::free() const
+{
+    uint32_t h = loadAcquire (&head);
+    return size - (h - loadAcquire (&tail));
+}
+
+template<class T>
+void SpscThreadBuffer<T>::copyIn (uint32_t pos, const T* data, uint32_t len)
+{
+    uint32_t idx = pos % size;
+    uint32_t first = std::min (len, size - idx);
+    std::copy (data, data + first, buffer + idx);
+    std::copy (data + first, data + len, buffer);
+}
+
+template<class T>
+void SpscThreadBuffer<T>::copyOut (uint32_t pos, T* data, uint32_t len)
+{
+    uint32_t idx = pos % size;
+    uint32_t first = std::min (len, size - idx);
+    std::copy (buffer + idx, buffer + idx + first, data);
+    std::copy (buffer, buffer + (len - first), data + first);
+}
+
+template<class T>
+void SpscThreadBuffer<T>::waitForChange (volatile uint32_t *idx, volatile uint32_t *waitflag,
+                                         uint32_t seen, const struct timespec *timeout)
+{
+    for (uint32_t i = 0; i < spinCount; ++i) {
+        if (loadAcquire (idx) != seen)
+            return;
+        if ((i & 0x3f) == 0x3f)
+            sched_yield ();
+    }
+
+    // announce that we are about to sleep, then re-check to avoid missing a wakeup
+    storeSeqCst (waitflag, 1);
+    if (loadSeqCst (idx) == seen)
+        futexWait (idx, seen, timeout);
+    storeSeqCst (waitflag, 0);
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::tryWrite(const T* data, uint32_t len)
+{
+    uint32_t h = head; // only the producer writes head
+    uint32_t space = size - (h - loadAcquire (&tail));
+    uint32_t n = std::min (len, space);
+    if (n == 0)
+        return 0;
+
+    copyIn (h, data, n);
+    storeSeqCst (&head, h + n);
+    if (loadSeqCst (&readerWaiting))
+        futexWake (&head);
+
+    return n;
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::write(const T* data, uint32_t len)
+{
+    uint32_t dpos = 0;
+    while (dpos < len) {
+        // sample tail before trying: if the write fails, tail still has this value
+        uint32_t t = loadAcquire (&tail);
+        uint32_t n = tryWrite (data + dpos, len - dpos);
+        if (n == 0) {
+            // buffer full, wait for the consumer to make room
+            waitForChange (&tail, &writerWaiting, t, NULL);
+            continue;
+        }
+        dpos += n;
+    }
+    return dpos;
+}
+
+template<class T>
+void SpscThreadBuffer<T>::waitForFree(uint32_t n)
+{
+    for (;;) {
+        uint32_t t = loadAcquire (&tail);
+        if (size - (head - t) >= n)
+            return;
+        waitForChange (&tail, &writerWaiting, t, NULL);
+    }
+}
+
+template<class T>
+bool SpscThreadBuffer<T>::tryReclaim(T &out)
+{
+    uint32_t t = loadAcquire (&tail);
+    if (head == t)
+        return false;
+
+    // only the producer writes the elements, so the slot at t is stable until we write again
+    T val = buffer [t % size];
+    if (!casSeqCst (&tail, &t, t + 1))
+        return false;
+
+    out = val;
+    return true;
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::read(std::vector<T> & data, uint32_t len)
+{
+    if (len == 0)
+        return 0;
+
+    uint32_t t = loadAcquire (&tail);
+    do {
+        if (loadAcquire (&head) - t < len)
+            return 0;
+        copyOut (t, &data[0], len);
+        // the producer may have reclaimed elements in the meantime, then t is updated and we copy again
+    } while (!casSeqCst (&tail, &t, t + len));
+
+    if (loadSeqCst (&writerWaiting))
+        futexWake (&tail);
+
+    return len;
+}
+
+template<class T>
+uint32_t SpscThreadBuffer<T>::readAvailable(std::vector<T> & data)
+{
+    uint32_t t = loadAcquire (&tail);
+    if (loadAcquire (&head) == t) {
+        struct timespec timeout = { 0, 10000000 };
+        waitForChange (&head, &readerWaiting, t, &timeout);
+    }
+
+    uint32_t avail = available ();
+    data.resize (avail);
+    return read (data, avail);
+}
+
+#endif // SPSCTHREADBUFFER_H
@@ -0,0 +1,144 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "threadscheduling.h"
+
+#include <QThread>
+
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+static int toSchedPolicy (ThreadSchedulingConfig::Policy p) {
+    switch (p) {
+    case ThreadSchedulingConfig::Fifo: return SCHED_FIFO;
+    case ThreadSchedulingConfig::RoundRobin: return SCHED_RR;
+    default: return SCHED_OTHER;
+    }
+}
+
+static QString errorString (int err) {
+    return QString::fromLocal8Bit (strerror (err));
+}
+
+QString ThreadSchedulingConfig::toString () const {
+    QString s = cpu < 0 ? QString ("any CPU") : QString ("CPU %1").arg (cpu);
+    switch (policy) {
+    case Fifo: return s + QString (", SCHED_FIFO %1").arg (priority);
+    case RoundRobin: return s + QString (", SCHED_RR %1").arg (priority);
+    default: return s + ", normal scheduling";
+    }
+}
+
+int ThreadScheduling::getCpuCount () {
+    int n = QThread::idealThreadCount ();
+    return n < 1 ? 1 : n;
+}
+
+QStringList ThreadScheduling::check (const ThreadSchedulingConfig &cfg) {
+    QStringList problems;
+
+    if (cfg.cpu >= 0) {
+        cpu_set_t allowed;
+        CPU_ZERO (&allowed);
+        if (cfg.cpu >= getCpuCount () || cfg.cpu >= CPU_SETSIZE)
+            problems << QString ("CPU %1 does not exist, the system has %2 CPUs").arg (cfg.cpu).arg (getCpuCount ());
+        else if (sched_getaffinity (0, sizeof (allowed), &allowed) == 0 && !CPU_ISSET (cfg.cpu, &allowed))
+            problems << QString ("CPU %1 is not in the CPU set of the process").arg (cfg.cpu);
+    }
+
+    if (cfg.policy != ThreadSchedulingConfig::Normal) {
+        int pol = toSchedPolicy (cfg.policy);
+        if (cfg.priority < sched_get_priority_min (pol) || cfg.priority > sched_get_priority_max (pol))
+            problems << QString ("Priority %1 is out of range (%2 - %3)").arg (cfg.priority)
+                        .arg (sched_get_priority_min (pol)).arg (sched_get_priority_max (pol));
+
+        // root (or CAP_SYS_NICE, which we can not easily query) is not restricted by the limit
+        struct rlimit rl;
+        if (geteuid () != 0 && getrlimit (RLIMIT_RTPRIO, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY
+                && rl.rlim_cur < (rlim_t) cfg.priority)
+        {
+            problems << QString ("RLIMIT_RTPRIO is %1, real-time priority %2 will be refused. "
+                                 "Add an rtprio entry to /etc/security/limits.conf or run with CAP_SYS_NICE")
+                        .arg ((unsigned long) rl.rlim_cur).arg (cfg.priority);
+        }
+    }
+
+    return problems;
+}
+
+QStringList ThreadScheduling::applyToCurrentThread (const ThreadSchedulingConfig &cfg) {
+    QStringList problems;
+    pthread_t self = pthread_self ();
+
+    if (cfg.cpu >= 0 && cfg.cpu < CPU_SETSIZE) {
+        cpu_set_t cpuset;
+        CPU_ZERO (&cpuset);
+        CPU_SET (cfg.cpu, &cpuset);
+        int err = pthread_setaffinity_np (self, sizeof (cpuset), &cpuset);
+        if (err)
+            problems << QString ("Pinning to CPU %1 failed: %2").arg (cfg.cpu).arg (errorString (err));
+    }
+
+    if (cfg.policy != ThreadSchedulingConfig::Normal) {
+        struct sched_param param;
+        memset (&param, 0, sizeof (param));
+        param.sched_priority = cfg.priority;
+        int err = pthread_setschedparam (self, toSchedPolicy (cfg.policy), &param);
+        if (err) {
+            problems << QString ("Setting %1 failed: %2").arg (cfg.toString ()).arg (errorString (err));
+            // explain the most likely reason
+            if (err == EPERM)
+                problems << check (cfg);
+        }
+    }
+
+    return problems;
+}
+
+QStringList ThreadScheduling::checkMemoryLock () {
+    QStringList problems;
+    struct rlimit rl;
+    if (geteuid () != 0 && getrlimit (RLIMIT_MEMLOCK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+        problems << QString ("RLIMIT_MEMLOCK is %1 kB, locking memory will fail once the process grows beyond it. "
+                             "Add a memlock entry to /etc/security/limits.conf")
+                    .arg ((unsigned long) (rl.rlim_cur / 1024));
+    }
+    return problems;
+}
+
+QStringList ThreadScheduling::lockMemory () {
+    QStringList problems = checkMemoryLock ();
+
+    // with a limited amount of lockable memory, MCL_FUTURE would make allocations beyond the limit fail
+    int flags = problems.empty () ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT;
+    if (mlockall (flags) != 0)
+        problems << QString ("Locking memory failed: %1").arg (errorString (errno));
+    else if (!(flags & MCL_FUTURE))
+        problems << "Only the memory allocated so far has been locked";
+    return problems;
+}
+
+void ThreadScheduling::unlockMemory () {
+    munlockall ();
+}
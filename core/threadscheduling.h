@@ -0,0 +1,70 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef THREADSCHEDULING_H
+#define THREADSCHEDULING_H
+
+#include <QString>
+#include <QStringList>
+
+/*! Scheduling parameters for one of the acquisition threads.
+ *  The default leaves the thread to the operating system, like QThread does.
+ */
+struct ThreadSchedulingConfig {
+    enum Policy { Normal, Fifo, RoundRobin };
+
+    ThreadSchedulingConfig () : cpu (-1), policy (Normal), priority (50) {}
+
+    int cpu;         /*!< CPU to pin the thread to, -1 to let it run on any CPU */
+    Policy policy;   /*!< Normal scheduling or one of the real-time policies SCHED_FIFO and SCHED_RR */
+    int priority;    /*!< real-time priority (1 - 99), ignored for Normal scheduling */
+
+    /*! Converts an integer, eg. from a settings file, to a Policy. Invalid values yield Normal. */
+    static Policy toPolicy (int p) { return p == Fifo || p == RoundRobin ? static_cast<Policy> (p) : Normal; }
+
+    /*! Returns a short human-readable description, eg. "CPU 2, SCHED_FIFO 80" */
+    QString toString () const;
+};
+
+/*! Functions to apply ThreadSchedulingConfig settings and to check beforehand whether the system permits them.
+ *  Real-time scheduling needs either root privileges, CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO
+ *  (eg. an "rtprio" entry in /etc/security/limits.conf). Locking memory similarly depends on RLIMIT_MEMLOCK.
+ *  Failures are reported as messages rather than ignored, so the user learns why the settings do not take effect.
+ */
+namespace ThreadScheduling {
+    /*! Applies \c cfg to the calling thread.
+     *  \returns a list of problems encountered. The thread keeps running with whatever settings could be applied.
+     */
+    QStringList applyToCurrentThread (const ThreadSchedulingConfig &cfg);
+
+    /*! Checks whether \c cfg can be applied by this process without actually applying it. */
+    QStringList check (const ThreadSchedulingConfig &cfg);
+
+    /*! Locks all current and future memory pages of the process, so the acquisition never waits for a page fault. */
+    QStringList lockMemory ();
+    /*! Undoes #lockMemory. */
+    void unlockMemory ();
+    /*! Checks whether #lockMemory is likely to succeed. */
+    QStringList checkMemoryLock ();
+
+    /*! Returns the number of CPUs available for pinning. */
+    int getCpuCount ();
+}
+
+#endif // THREADSCHEDULING_H
@@ -17,7 +17,9 @@ LIBS += -g \
     -lgslcblas \
     #-lusb \
     -lboost_filesystem \
-    -lboost_system
+    -lboost_system \
+    -llz4 \
+    -lzstd
 INCLUDEPATH += include \
     #lib/sis3150_calls \
     lib/sis3100_calls \
@@ -31,6 +33,7 @@ SOURCES += core/baseplugin.cpp \
     core/outputplugin.cpp \
     core/plot2d.cpp \
     core/pluginconnector.cpp \
+    core/pluginexecutor.cpp \
     core/pluginmanager.cpp \
     core/pluginthread.cpp \
     core/remotecontrolpanel.cpp \
@@ -38,9 +41,19 @@ SOURCES += core/baseplugin.cpp \
     core/runthread.cpp \
     core/scopemainwindow.cpp \
     core/threadbuffer.cpp \
+    core/threadscheduling.cpp \
+    core/profiler.cpp \
+    core/filewriter.cpp \
+    core/filewriterui.cpp \
+    core/blockcodec.cpp \
+    core/datafilereader.cpp \
+    core/eventindex.cpp \
     core/viewport.cpp \
     interface/sis3100module.cpp \
     interface/sis3100ui.cpp \
+    interface/simvmedevice.cpp \
+    interface/simvmemodule.cpp \
+    interface/simvmeui.cpp \
     #interface/sis3150module.cpp \
     #interface/sis3150ui.cpp \
     module/caen1290dmx.cpp \
@@ -101,12 +114,21 @@ SOURCES += core/baseplugin.cpp \
     module/mesytecMadc32dmx.cpp
 HEADERS += core/addeditdlgs.h \
     core/geckoremote.h \
+    core/pluginexecutor.h \
     core/pluginthread.h \
     core/remotecontrolpanel.h \
     core/runthread.h \
     core/scopemainwindow.h \
+    core/spscthreadbuffer.h \
     core/systeminfo.h \
     core/threadbuffer.h \
+    core/threadscheduling.h \
+    core/profiler.h \
+    core/filewriter.h \
+    core/filewriterui.h \
+    core/blockcodec.h \
+    core/datafilereader.h \
+    core/eventindex.h \
     include/abstractinterface.h \
     include/abstractmodule.h \
     include/abstractplugin.h \
@@ -125,6 +147,7 @@ HEADERS += core/addeditdlgs.h \
     include/pluginconnector.h \
     include/pluginconnectorplain.h \
     include/pluginconnectorqueued.h \
+    include/pluginconnectortyped.h \
     include/pluginmanager.h \
     include/runmanager.h \
     include/samdsp.h \
@@ -132,6 +155,9 @@ HEADERS += core/addeditdlgs.h \
     include/viewport.h \
     interface/sis3100module.h \
     interface/sis3100ui.h \
+    interface/simvmedevice.h \
+    interface/simvmemodule.h \
+    interface/simvmeui.h \
     #interface/sis3150module.h \
     #interface/sis3150ui.h \
     module/caen1290dmx.h \
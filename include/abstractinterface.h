@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ABSTRACTINTERFACE_H
 
 #include <stdint.h>
+#include <cstddef>
 
 #include <QObject>
 #include <QString>
@@ -28,6 +29,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 class BaseUI;
 class QSettings;
 
+/*! A single cycle of a VME access list, see AbstractInterface::executeList. */
+struct VmeOp {
+    enum Type { ReadD16, ReadD32, WriteD16, WriteD32 };
+
+    Type type;
+    uint32_t addr;
+    uint32_t data;  /*!< the value to write, or the value read */
+    int error;      /*!< result of the cycle, 0 on success */
+
+    static VmeOp read16 (uint32_t addr) { return make (ReadD16, addr, 0); }
+    static VmeOp read32 (uint32_t addr) { return make (ReadD32, addr, 0); }
+    static VmeOp write16 (uint32_t addr, uint16_t data) { return make (WriteD16, addr, data); }
+    static VmeOp write32 (uint32_t addr, uint32_t data) { return make (WriteD32, addr, data); }
+
+private:
+    static VmeOp make (Type t, uint32_t addr, uint32_t data) {
+        VmeOp op;
+        op.type = t;
+        op.addr = addr;
+        op.data = data;
+        op.error = 0;
+        return op;
+    }
+};
+
 /*! Abstract base class for all VME interfaces.
  * To implement a new interface please derive from BaseInterface which already handles ids, names and types. */
 class AbstractInterface : public QObject {
@@ -114,6 +140,31 @@ public:
     /*! write a 16-bit word to the specified address. */
     virtual int writeA32D16(const uint32_t addr, const uint16_t data) = 0;
 
+    /*! Perform a list of single cycles in the given order.
+     *  All cycles are attempted, even if one of them fails. The values read are stored in the \c data members,
+     *  the result of each cycle in the \c error members. Interfaces that support it send the whole list to the
+     *  controller at once, which saves the round trip of every single cycle. Such interfaces may only know the
+     *  error of the list as a whole and then report it for every cycle.
+     *  Returns 0 if all cycles succeeded, otherwise the error of the first cycle that failed.
+     */
+    virtual int executeList(VmeOp* ops, size_t n) = 0;
+
+    /*! Enable the VME interrupt levels in \c levelMask (bit n for level n) and disable all others.
+     *  A mask of 0 disables all interrupts. Returns non-zero if the interface cannot wait for interrupts.
+     *  \sa waitForIrq
+     */
+    virtual int enableIrqs(uint8_t levelMask) = 0;
+
+    /*! Wait at most \c timeout ms for one of the enabled interrupts.
+     *  If one arrives, an interrupt acknowledge cycle is performed and the level and the status/ID vector
+     *  returned by the module are stored. The level stays blocked until #acknowledgeIrq is called.
+     *  Returns 1 if an interrupt was received, 0 on timeout and a negative value on errors.
+     */
+    virtual int waitForIrq(int timeout, int *level, uint8_t *vector) = 0;
+
+    /*! Re-enable the given interrupt level after the interrupt has been handled. */
+    virtual int acknowledgeIrq(int level) = 0;
+
     /*! Return whether the given error code is a bus error or not. */
     virtual bool isBusError (int err) const = 0;
 
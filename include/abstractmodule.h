@@ -26,8 +26,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 class QSettings;
 template<typename T> class QList;
+template<typename T> class QVector;
 
 class AbstractInterface;
+struct VmeOp;
 class BaseUI;
 class EventSlot;
 class OutputPlugin;
@@ -49,6 +51,14 @@ class AbstractModule : public QObject
 {
     Q_OBJECT
 public:
+    /*! Position of a module within a chained block transfer (CBLT), see #setChainPosition. */
+    enum ChainPosition {
+        ChainNone,   /*!< not part of a chain, read out on its own */
+        ChainFirst,  /*!< first module of the chain, opens the transfer */
+        ChainMiddle, /*!< intermediate module, passes the token on */
+        ChainLast    /*!< last module of the chain, terminates the transfer with a bus error */
+    };
+
     virtual ~AbstractModule() {}
 
     /*! Return the module's id, as assigned by the module manager. */
@@ -95,11 +105,74 @@ public:
      */
     virtual int acquire(Event *ev) = 0;
 
+    /*! Return whether the module splits its readout into #acquireRaw and #decode.
+     *  In that case, the RunThread only calls #acquireRaw, and the data is decoded later on the plugin threads,
+     *  which keeps demultiplexing out of the readout dead time. Evaluated once at the start of a run.
+     */
+    virtual bool hasRawReadout() const = 0;
+
+    /*! Transfer the data from the vme module into \c raw without decoding it.
+     *  Only called from the RunThread if #hasRawReadout returns true. \c raw is empty when passed in, but keeps the
+     *  capacity of earlier events. Leave it empty if there is no data.
+     */
+    virtual int acquireRaw(QVector<uint32_t> *raw) = 0;
+
+    /*! Decode data transferred by #acquireRaw into the event.
+     *  Called from a plugin thread, in event order and never concurrently for the same module.
+     *  The RunThread may be inside #acquireRaw for a later event at the same time, so decoding must only use state
+     *  that #acquireRaw does not modify.
+     */
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw) = 0;
+
+    /*! Return the number of leading words of \c data that make up the first event.
+     *  \c data holds undecoded data as returned by #acquireRaw. Modules that let several events collect in the hardware
+     *  buffer (multi-event readout) use this to have the RunThread put each of the events into an Event of its own.
+     *  The data the other modules delivered in the same readout cycle only goes into the first of these events, so the
+     *  others only need the mandatory slots of modules with multi-event data.
+     *  Events are combined by their position in the data, so all modules with multi-event data in a cycle have to deliver
+     *  the same number of events. Otherwise the whole cycle is discarded and counted as lost.
+     *  Return \c len if all of the data belongs to one event.
+     */
+    virtual int eventLength(const uint32_t *data, int len) const = 0;
+
+    /*! Configure the VME module as member of a chained block transfer with the given CBLT address (A31..A24).
+     *  Called by the RunThread after #configure for all modules assigned to a chain (see ModuleManager::setChain).
+     *  The RunThread then reads the whole chain with one block transfer and hands each module the data claimed via
+     *  #claimChainedData to #decode. #acquire and #acquireRaw are not called for chained modules.
+     *  \returns 0 on success, non-zero if the module does not support chained readout.
+     */
+    virtual int setChainPosition(uint8_t cbltAddr, ChainPosition pos) = 0;
+
+    /*! Return the number of leading words of \c data that stem from this module, or 0 if \c data does not start
+     *  with one of its data blocks. Used to split the buffer of a chained block transfer, so the implementation should
+     *  check the module's own geographical address or module id in the header words.
+     */
+    virtual int claimChainedData(const uint32_t *data, int len) const = 0;
+
+    /*! Called by the RunThread after each block transfer of the module's chain, eg. to re-arm the readout logic. */
+    virtual int chainedReadoutDone() = 0;
+
     /*! Return whether data is available for retrieval.
      *  This function is called repeatedly from the RunThread to determine whether new data is available.
      */
     virtual bool dataReady() = 0;
 
+    /*! Append the status reads that #dataReady starts with to \c ops and return their number.
+     *  The RunThread executes the status reads of all modules on one interface as a single access list
+     *  (see AbstractInterface::executeList) and then calls #dataReadyFromStatus instead of #dataReady.
+     *  Return 0 if the module does not support this. Evaluated once at the start of a run.
+     */
+    virtual int appendStatusReads(QVector<VmeOp> *ops) const = 0;
+
+    /*! Same as #dataReady, but use the results of the cycles appended by #appendStatusReads instead of reading them. */
+    virtual bool dataReadyFromStatus(const VmeOp *status) = 0;
+
+    /*! Return whether the module requests a VME interrupt when data is ready, and with which level and status/ID vector.
+     *  If all triggers do, the RunThread waits for their interrupts instead of polling #dataReady
+     *  (see RunManager::setInterruptReadout). Evaluated once at the start of a run, after #configure.
+     */
+    virtual bool getIrq(uint8_t *level, uint8_t *vector) const = 0;
+
     /*! Perform a soft reset on the device
      *  \sa #configure()
      */
@@ -110,6 +183,11 @@ public:
      */
     virtual void runStartingEvent() = 0;
 
+    /*! Return the number of events the module found missing in its data since the start of the run,
+     *  eg. from gaps in an event counter. Read when the run has stopped and written to the run's statistics.
+     */
+    virtual uint32_t getLostEvents() const = 0;
+
     /*! Configure the device using the information supplied by #applySettings.
      *  Implementors should use the local configuration data structures to initialise the vme module.
      */
@@ -77,6 +77,11 @@ public:
     /*! Make the plugin process an event. */
     virtual void process() = 0;
 
+    /*! Make the plugin process a batch of \c nofEvents events.
+     *  The data of all events in the batch is available on the inputs.
+     */
+    virtual void processBatch(int nofEvents) = 0;
+
     /*! Add a connector to the plugin. */
     virtual void addConnector(PluginConnector*) = 0;
 
@@ -94,6 +99,14 @@ public:
     /*! perform actions prior to starting a run, eg. clearing statistics, resetting spectra... */
     virtual void runStartingEvent () = 0;
 
+    /*! perform actions after the last event of a run has been processed, eg. closing files */
+    virtual void runStoppingEvent () = 0;
+
+    /*! Return whether the plugin records the data it receives, eg. to a file.
+     *  Lossy overflow policies of the EventBuffer are not used while a recording plugin exists, see RunManager::start.
+     */
+    virtual bool isRecording () const = 0;
+
     /*! Make the plugin initialise its UI. */
     virtual void createUI() = 0;
 
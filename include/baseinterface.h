@@ -37,6 +37,39 @@ public:
     QString getTypeName () const { return type_; }
     BaseUI *getUI () const { return ui_; }
 
+    /*! Executes the list with single cycles. Interfaces with a list mode should override this. */
+    int executeList (VmeOp *ops, size_t n) {
+        int ret = 0;
+        for (size_t i = 0; i < n; ++i) {
+            VmeOp &op = ops [i];
+            switch (op.type) {
+            case VmeOp::ReadD16: {
+                uint16_t d = 0;
+                op.error = readA32D16 (op.addr, &d);
+                op.data = d;
+                break;
+            }
+            case VmeOp::ReadD32:
+                op.error = readA32D32 (op.addr, &op.data);
+                break;
+            case VmeOp::WriteD16:
+                op.error = writeA32D16 (op.addr, op.data);
+                break;
+            case VmeOp::WriteD32:
+                op.error = writeA32D32 (op.addr, op.data);
+                break;
+            }
+            if (op.error && !ret)
+                ret = op.error;
+        }
+        return ret;
+    }
+
+    /*! Interfaces without interrupt support only accept disabling all interrupts. */
+    int enableIrqs (uint8_t levelMask) { return levelMask ? -1 : 0; }
+    int waitForIrq (int, int *, uint8_t *) { return -1; }
+    int acknowledgeIrq (int) { return -1; }
+
 protected:
     void setName (QString newName) { name_ = newName; }
     void setTypeName (QString newType) { type_ = newType; }
@@ -101,6 +101,18 @@ public:
     OutputPlugin* getOutputPlugin () const { return output; }
 
     virtual void runStartingEvent () {}
+    virtual uint32_t getLostEvents () const { return 0; }
+
+    virtual bool hasRawReadout () const { return false; }
+    virtual int acquireRaw (QVector<uint32_t> *) { return -1; }
+    virtual int decode (Event *, const QVector<uint32_t> &) { return -1; }
+    virtual int eventLength (const uint32_t *, int len) const { return len; }
+    virtual int setChainPosition (uint8_t, ChainPosition) { return -1; }
+    virtual int claimChainedData (const uint32_t *, int) const { return 0; }
+    virtual int chainedReadoutDone () { return 0; }
+    virtual bool getIrq (uint8_t *, uint8_t *) const { return false; }
+    virtual int appendStatusReads (QVector<VmeOp> *) const { return 0; }
+    virtual bool dataReadyFromStatus (const VmeOp *) { return dataReady (); }
 
 public slots:
     virtual void prepareForNextAcquisition () {}
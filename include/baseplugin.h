@@ -122,6 +122,14 @@ public:
      */
     void runStartingEvent ();
 
+    /*! perform actions after the last event of a run has been processed.
+     *  The default implementation does nothing.
+     */
+    void runStoppingEvent () {}
+
+    /*! The default implementation returns false. */
+    virtual bool isRecording () const { return false; }
+
     void setNumberOfMandatoryInputs(int _n) {
         nofMandatoryInputs = _n;
     }
@@ -133,6 +141,20 @@ public slots:
      */
     virtual void process();
 
+    /*! Process a batch of events.
+     *  The default implementation calls #process once for each event in the batch.
+     *  Plugins with a high per-call overhead (eg. updating a display) may override this function
+     *  to consume the data of all events at once:
+     *  \code
+     *    while (inputs->at (0)->dataAvailable ()) {
+     *        // accumulate inputs->at (0)->getData ()
+     *        inputs->at (0)->useData ();
+     *    }
+     *    // publish the result once
+     *  \endcode
+     */
+    virtual void processBatch(int nofEvents);
+
     /*! the plugin's work function.
      *  Implementors should get their input data from the input connectors via PluginConnector::getData:
      *  \code
@@ -21,53 +21,169 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EVENTBUFFER_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
 #include <QMap>
 #include <QList>
-#include <QSet>
+#include <QVector>
 #include <QVariant>
+#include <QAtomicInt>
 
 #include "pluginconnector.h"
 
 class EventSlot;
 class Event;
 class AbstractModule;
-template<typename T> class ThreadBuffer;
+template<typename T> class SpscThreadBuffer;
+
+/*! Capacity plan for the payload cells of pooled events.
+ *  During the first #WarmupEvents events of a run, the arena records the largest vector payload seen in each slot,
+ *  including data the output plugins have already swapped out of the event (see Event::swapData).
+ *  Every event returned to the pool gets at least that much storage reserved in its cells. Demultiplexers filling
+ *  the cells in place (see Event::store) therefore do not allocate once the run is warmed up.
+ *  This does not hold for cells whose storage is still shared when the event is returned, eg. because a consumer
+ *  kept the QVariant returned by Event::get. Such a cell gets a new allocation of the reserved size.
+ *  \note The arena is only used by the consumer of the EventBuffer, so it needs no locking.
+ */
+class EventPayloadArena {
+public:
+    enum { WarmupEvents = 16 };
+
+    EventPayloadArena () : RawWords_ (0), Warmup_ (0) {}
+
+    /*! Forgets the recorded sizes and starts a new warm-up phase. */
+    void restart ();
+    /*! Returns whether the arena is still recording payload sizes. */
+    bool isWarmingUp () const { return Warmup_ > 0; }
+    /*! Records the payload sizes of \c ev. Returns true if this event completed the warm-up. */
+    bool record (const Event *ev);
+    /*! Reserves storage in the payload cells of \c ev according to the recorded sizes. */
+    void prepare (Event *ev) const;
+    /*! Returns the estimated memory footprint of a prepared event with \c cells payload cells, in bytes.
+     *  Includes the undecoded data of modules with split readout, which stays in the event until it is released.
+     */
+    size_t getEventBytes (int cells) const;
+
+private:
+    std::vector<int> Uint32Sizes_;
+    std::vector<int> DoubleSizes_;
+    int RawWords_; // largest undecoded data of all modules together, see Event::storeRaw
+    int Warmup_;
+};
 
 class EventBuffer {
 public:
+    /*! What #queue does with an event if the buffer is full. */
+    enum OverflowPolicy {
+        Block,      /*!< wait until the consumer makes room. Nothing is lost, but the readout stalls */
+        DropNewest, /*!< discard the new event */
+        DropOldest, /*!< discard the oldest event in the buffer to make room for the new one */
+        Sample      /*!< keep a uniform random sample of the events arriving while the buffer is full, see #queue */
+    };
+
+    /*! Upper limit on the number of events if the buffer is sized by memory. */
+    enum { MaxBudgetEvents = 65536 };
+
     /*! Construct an event buffer containing at most \c size events */
     EventBuffer (size_t size);
     ~EventBuffer ();
 
     bool empty () const; /*!< Returns whether the event buffer is empty. */
     bool full () const; /*!< Returns whether the event buffer is full. */
-    size_t size () const; /*!< Returns the maximum size of the event buffer. */
+    size_t size () const; /*!< Returns the maximum number of events in the buffer. */
     size_t level () const; /*!< Returns the current number of events in the buffer. */
 
     /*! Changes the size of the underlying queue to contain \c newsz elements.
         This function should never be called while the buffer is in use (eg. during a run) because
         all data in the buffer will be lost and and undefined behaviour could occur if the buffer is accessed
         while its size is changed.
+        Any memory budget set with #setMemoryBudget is dropped.
         \param newsz the new size of the event buffer.
      */
     void setSize (size_t newsz);
 
+    /*! Sizes the buffer by memory instead of by event count.
+        The number of events is chosen such that the events in the buffer and in the pool of unused events
+        together take about \c bytes of memory. The event size is estimated by the EventPayloadArena at the end of its
+        warm-up phase. Until then, the buffer holds at most EventPayloadArena::WarmupEvents events. The number of events is
+        never larger than #MaxBudgetEvents.
+        \warning Same restrictions as #setSize.
+     */
+    void setMemoryBudget (size_t bytes);
+    /*! Returns the memory budget set with #setMemoryBudget, or 0 if the buffer is sized by event count. */
+    size_t getMemoryBudget () const { return MemoryBudget_; }
+
+    /*! Sets the overflow policy. Must not be called while a run is active. */
+    void setOverflowPolicy (OverflowPolicy p) { Policy_ = p; }
+    /*! Returns the overflow policy. */
+    OverflowPolicy getOverflowPolicy () const { return Policy_; }
+    /*! Returns the overflow policy for the integer \c p, falling back to Block for invalid values. */
+    static OverflowPolicy toOverflowPolicy (int p);
+    /*! Returns a human-readable name of the overflow policy. */
+    static QString getOverflowPolicyName (OverflowPolicy p);
+
+    /*! Returns the number of events lost for the consumer since the start of the run.
+        Only the DropNewest, DropOldest and Sample policies lose events. May be called from any thread.
+     */
+    unsigned getLostEvents () const { return Lost_; }
+
     /*! Create a new event. The object has to be returned via #releaseEvent when it is not used anymore. */
     Event* createEvent ();
 
-    /*! Releases an event object obtained via #createEvent. The object is scheduled for reuse. */
+    /*! Releases an event object obtained via #createEvent. The object is scheduled for reuse.
+        \note The pool of unused events is a single-producer queue. Only the consumer of the buffer (the thread calling #dequeue)
+        may release events while a run is active.
+     */
     void releaseEvent (Event *);
 
+    /*! Prepares the buffer for a new run.
+        The payload arena starts a new warm-up phase. Once it is over, the pool of unused events is filled with
+        events that have their payload storage preallocated. See EventPayloadArena.
+        \warning must not be called while a run is active.
+     */
+    void startRun ();
+
+    /*! Finishes the run. Events still held back by the Sample policy are discarded and counted as lost.
+        The producer should hand them to the consumer with #flushReservoir before it stops.
+        \warning must only be called after the producer and the consumer have stopped.
+     */
+    void stopRun ();
+
     /*! Queues an event in the buffer. The buffer takes ownership of the event.
-        This call is synchronous. It waits until there is enough room inside the buffer to queue the event.
+        If the buffer is full, the outcome depends on the overflow policy. With Block, the call waits until there is enough room
+        inside the buffer to queue the event. The other policies never wait. Discarded events are reused by #createEvent.
+
+        With the Sample policy, events arriving at a full buffer are offered to a reservoir holding up to half the buffer size.
+        Once the reservoir is full, each new event replaces a random reservoir entry with a probability that keeps every event
+        of the overflow period equally likely to survive. The reservoir is queued in arrival order as soon as there is room,
+        either by the next call to #queue or by #flushReservoir.
+        \note Only one thread (the RunThread) may queue events and call #createEvent while a run is active.
+        \returns the net number of events added to the buffer: 1 normally, 0 if the event was dropped, held back or replaced
+        the oldest event, and more than 1 if held back events were queued along with it.
+     */
+    int queue (Event *ev);
+
+    /*! Queues as many of the events held back by the Sample policy as the buffer has room for, oldest first.
+        The producer calls this while no new events arrive, so the reservoir does not wait for the next trigger.
+        \note Only the thread queueing events may call this function.
+        \returns the number of events queued
      */
-    bool queue (Event *ev);
+    int flushReservoir ();
+    /*! Returns the number of events held back by the Sample policy. Same restriction as #flushReservoir. */
+    size_t getReservoirLevel () const { return Reservoir_.size (); }
 
     /*! Returns the first event in the buffer. The caller takes ownership of the event object.
         This call is non-blocking. The function will return immediately if no data is available.
      */
     Event* dequeue ();
 
+    /*! Removes up to \c max events from the buffer and stores them in \c evs. The caller takes ownership of the events.
+        This call is non-blocking.
+        \returns the number of events dequeued
+     */
+    size_t dequeue (std::vector<Event*> &evs, size_t max);
+
     // EventSlot management
     /*! Register an event slot with the event buffer.
         Data may only be sent through and retrieved from the event buffer through an event slot.
@@ -88,50 +204,280 @@ public:
     /*! Deletes the given slot. */
     void destroyEventSlot (EventSlot* slot);
 
+    /*! Returns the number of slot indices handed out so far. All slot indices are smaller than this number. */
+    int getSlotCount () const { return SlotCount_; }
+
+private:
+    void fillPool ();
+    void recycle (Event *ev);
+    int queueOverflow (Event *ev);
+
 private:
     typedef QList<EventSlot*> SlotSet;
     typedef QMap< const AbstractModule*, SlotSet* > SlotMap;
     SlotMap Slots_;
+    int SlotCount_;
+
+    SpscThreadBuffer<Event*>* Buffer_;
+    SpscThreadBuffer<Event*>* UnusedQ_;
+    EventPayloadArena Arena_;
+
+    OverflowPolicy Policy_;
+    size_t MemoryBudget_;
+    QAtomicInt Limit_; // current maximum number of queued events, at most the size of Buffer_
+    QAtomicInt Lost_;
 
-    ThreadBuffer<Event*>* Buffer_;
-    ThreadBuffer<Event*>* UnusedQ_;
+    // owned by the producer
+    std::vector<Event*> Spare_; // discarded events, reused by createEvent
+    std::vector< std::pair<uint64_t, Event*> > Reservoir_; // held back events with their arrival number
+    uint64_t Arrivals_;
+    uint64_t Offered_; // events offered to the reservoir since it was last empty
+    uint64_t Rng_;
 };
 
+/*! Bit set with one bit per EventSlot index. */
+class EventSlotMask {
+public:
+    /*! Sets the bit for slot index \c idx, growing the mask if necessary.
+     *  Setting bits in a mask that has been #reserve d for the index is atomic, so several threads may set bits concurrently.
+     */
+    void set (int idx) {
+        if ((size_t) (idx >> 6) >= Words_.size ())
+            Words_.resize ((idx >> 6) + 1, 0);
+        __atomic_fetch_or (&Words_ [idx >> 6], bit (idx), __ATOMIC_RELAXED);
+    }
+    /*! Makes room for slot indices smaller than \c count, so #set does not have to grow the mask. */
+    void reserve (int count) {
+        if ((size_t) ((count + 63) >> 6) > Words_.size ())
+            Words_.resize ((count + 63) >> 6, 0);
+    }
+    /*! Clears the bit for slot index \c idx. */
+    void reset (int idx) {
+        if ((size_t) (idx >> 6) < Words_.size ())
+            Words_ [idx >> 6] &= ~bit (idx);
+    }
+    /*! Returns whether the bit for slot index \c idx is set. */
+    bool test (int idx) const {
+        return (size_t) (idx >> 6) < Words_.size () && (Words_ [idx >> 6] & bit (idx));
+    }
+    /*! Clears all bits. */
+    void clear () { std::fill (Words_.begin (), Words_.end (), 0); }
+    /*! Sets all bits that are set in \c other. */
+    void merge (const EventSlotMask &other) {
+        if (other.Words_.size () > Words_.size ())
+            Words_.resize (other.Words_.size (), 0);
+        for (size_t i = 0; i < other.Words_.size (); ++i)
+            Words_ [i] |= other.Words_ [i];
+    }
+
+    /*! Returns whether all bits set in \c other are also set in this mask. */
+    bool containsAll (const EventSlotMask &other) const {
+        for (size_t i = 0; i < other.Words_.size (); ++i) {
+            uint64_t mine = i < Words_.size () ? Words_ [i] : 0;
+            if (other.Words_ [i] & ~mine)
+                return false;
+        }
+        return true;
+    }
+
+    /*! Returns the first set bit with an index of at least \c from, or -1 if there is none.
+     *  Use it to iterate over all set bits:
+     *  \code for (int i = m.next (0); i >= 0; i = m.next (i + 1)) ... \endcode
+     */
+    int next (int from) const {
+        size_t w = from >> 6;
+        if (w >= Words_.size ())
+            return -1;
+        uint64_t cur = Words_ [w] & (~(uint64_t) 0 << (from & 63));
+        while (!cur) {
+            if (++w >= Words_.size ())
+                return -1;
+            cur = Words_ [w];
+        }
+        return (w << 6) + __builtin_ctzll (cur);
+    }
+
+private:
+    static uint64_t bit (int idx) { return (uint64_t) 1 << (idx & 63); }
+    std::vector<uint64_t> Words_;
+};
+
+/*! Storage for the data of one EventSlot inside an Event.
+ *  Only the member matching the slot's PluginConnector::DataType is used.
+ */
+struct EventPayload {
+    EventPayload () : Uint32_ (0), Double_ (0), LatchedUint32_ (0), LatchedDouble_ (0) {}
+
+    uint32_t Uint32_;
+    double Double_;
+    QVector<uint32_t> VectorUint32_;
+    QVector<double> VectorDouble_;
+    // length of the vector data handed over by Event::swapData, for the EventPayloadArena
+    int LatchedUint32_;
+    int LatchedDouble_;
+
+    uint32_t &ref (uint32_t *) { return Uint32_; }
+    double &ref (double *) { return Double_; }
+    QVector<uint32_t> &ref (QVector<uint32_t> *) { return VectorUint32_; }
+    QVector<double> &ref (QVector<double> *) { return VectorDouble_; }
+
+    const uint32_t &ref (uint32_t *) const { return Uint32_; }
+    const double &ref (double *) const { return Double_; }
+    const QVector<uint32_t> &ref (QVector<uint32_t> *) const { return VectorUint32_; }
+    const QVector<double> &ref (QVector<double> *) const { return VectorDouble_; }
+
+    int &latched (QVector<uint32_t> *) { return LatchedUint32_; }
+    int &latched (QVector<double> *) { return LatchedDouble_; }
+};
+
+/*! Data collected from all modules during one acquisition cycle.
+ *  The data is stored in an array of typed payload cells, indexed by the dense index assigned to
+ *  each EventSlot by EventBuffer::registerSlot. A bit mask keeps track of the occupied cells.
+ */
 class Event {
 public:
     Event (EventBuffer *buffer);
     ~Event ();
 
+    /*! Stores \c data for the given slot. The data is converted to the slot's data type. Null data clears the slot. */
     void put (const EventSlot *, QVariant data);
+    /*! Returns the data stored for the given slot, or a null QVariant if the slot is not occupied.
+     *  Vector data is shared with the event. Keeping the QVariant beyond the processing of the event costs an
+     *  allocation when the event is recycled (see #clear), so release it as soon as possible.
+     */
     QVariant get (const EventSlot *) const;
+
+    /*! Stores \c data for the given slot without converting it to a QVariant.
+     *  \c T has to match the slot's data type (see TypeToDataType).
+     */
+    template<typename T> void putData (const EventSlot *slot, const T &data);
+
+    /*! Returns the data stored for the given slot without converting it to a QVariant.
+     *  The result is only meaningful if #isOccupied returns true for the slot.
+     */
+    template<typename T> const T &getData (const EventSlot *slot) const;
+
+    /*! Returns the storage for the data of the given slot and marks the slot as occupied.
+     *  Demultiplexers fill the returned object in place. If the slot was not occupied yet, vector storage is empty but keeps
+     *  the capacity reserved by the EventPayloadArena, so filling it does not allocate.
+     *  \c T has to match the slot's data type (see TypeToDataType).
+     */
+    template<typename T> T &store (const EventSlot *slot);
+
+    /*! Replaces the data of a vector-valued slot with a copy of the \c len elements at \c data.
+     *  Unlike #putData, the event's own storage is reused instead of being shared with the source.
+     */
+    template<typename E> void copyData (const EventSlot *slot, const E *data, int len);
+
+    /*! Exchanges the data of a vector-valued slot with \c buf, which usually is an empty buffer with some capacity.
+     *  The length of the data handed over is kept until #clear, so the EventPayloadArena still sees it.
+     */
+    template<typename E> void swapData (const EventSlot *slot, QVector<E> &buf);
+
+    /*! Returns whether data has been stored for the given slot. */
+    bool isOccupied (const EventSlot *slot) const;
+
+    /*! Discards all data. Storage of vector-valued slots is kept for the next use of the event.
+     *  Storage still shared with a copy held elsewhere (eg. a QVariant returned by #get) is left to that copy instead
+     *  of being detached, which would copy the old data. The EventPayloadArena then allocates new storage for the cell.
+     */
     void clear ();
 
-    QSet<const EventSlot *> getOccupiedSlots () const;
+    /*! Records the time the event was queued in the EventBuffer, in Profiler::now units. 0 means not recorded. */
+    void setQueueTime (uint64_t t) { QueueTime_ = t; }
+    /*! Returns the time set with #setQueueTime. */
+    uint64_t getQueueTime () const { return QueueTime_; }
+
+    /*! Returns a mask of all slots holding data, indexed by EventSlot::getIndex. */
+    const EventSlotMask &getOccupiedSlots () const { return Occupied_; }
+
+    /*! Returns empty storage for the undecoded data of module \c m, see AbstractModule::acquireRaw.
+     *  The storage keeps the capacity it had in earlier uses of the event. Once raw data is stored, the payload cells
+     *  of all registered slots exist, so the modules may decode their data into the event concurrently.
+     */
+    QVector<uint32_t> &storeRaw (const AbstractModule *m);
+    /*! Returns the undecoded data of module \c m, or NULL if the module did not store any. */
+    const QVector<uint32_t> *getRaw (const AbstractModule *m) const;
 
     EventBuffer *getBuffer () const;
 
 private:
-    typedef QMap<const EventSlot *, QVariant > DataMap;
-    DataMap Data_;
+    EventPayload &cell (int idx);
+
+    friend class EventPayloadArena;
+
+private:
+    struct RawData {
+        const AbstractModule *Module_;
+        bool Valid_;
+        QVector<uint32_t> Data_;
+    };
+
+    QVector<EventPayload> Cells_;
+    EventSlotMask Occupied_;
+    std::vector<RawData> Raw_; // one entry per module that ever stored raw data in this event
     EventBuffer* EvBuf_;
+    uint64_t QueueTime_;
 };
 
 class EventSlot {
 public:
-    EventSlot (const AbstractModule* owner, QString name, PluginConnector::DataType dtype)
+    EventSlot (const AbstractModule* owner, QString name, PluginConnector::DataType dtype, int index)
     : Owner_ (owner)
     , Name_ (name)
     , Dtype_ (dtype)
+    , Index_ (index)
     {}
 
     const AbstractModule* getOwner () const { return Owner_; }
     QString getName () const { return Name_; }
     PluginConnector::DataType getDataType () const { return Dtype_; }
+    /*! Returns the dense index assigned to the slot by EventBuffer::registerSlot. */
+    int getIndex () const { return Index_; }
 
 private:
     const AbstractModule *Owner_;
     QString Name_;
     PluginConnector::DataType Dtype_;
+    int Index_;
 };
 
+template<typename T>
+void Event::putData (const EventSlot *slot, const T &data) {
+    int idx = slot->getIndex ();
+    cell (idx).ref (static_cast<T*> (NULL)) = data;
+    Occupied_.set (idx);
+}
+
+template<typename T>
+const T &Event::getData (const EventSlot *slot) const {
+    static const T empty = T ();
+    int idx = slot->getIndex ();
+    if (idx >= Cells_.size ())
+        return empty;
+    return Cells_.at (idx).ref (static_cast<T*> (NULL));
+}
+
+template<typename T>
+T &Event::store (const EventSlot *slot) {
+    int idx = slot->getIndex ();
+    Occupied_.set (idx);
+    return cell (idx).ref (static_cast<T*> (NULL));
+}
+
+template<typename E>
+void Event::copyData (const EventSlot *slot, const E *data, int len) {
+    QVector<E> &v = store< QVector<E> > (slot);
+    v.resize (len);
+    std::copy (data, data + len, v.begin ());
+}
+
+template<typename E>
+void Event::swapData (const EventSlot *slot, QVector<E> &buf) {
+    EventPayload &p = cell (slot->getIndex ());
+    QVector<E> &v = p.ref (static_cast<QVector<E>*> (NULL));
+    p.latched (static_cast<QVector<E>*> (NULL)) = v.size ();
+    qSwap (v, buf);
+}
+
 #endif // EVENTBUFFER_H
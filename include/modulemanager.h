@@ -108,6 +108,14 @@ public:
     /*! returns a set of all modules that act as triggers. */
     const QSet<AbstractModule*>& getTriggers () const { return triggers; }
 
+    /*! Assigns the given module to the chained block transfer (CBLT) readout with the given 8 bit CBLT address.
+     *  All modules with the same address are read out with one block transfer. The chain follows the order of the module list,
+     *  which has to match the order of the modules in the crate. An address of 0 removes the module from its chain.
+     */
+    void setChain (AbstractModule* mod, uint8_t cbltAddr) { if (cbltAddr) chains.insert (mod, cbltAddr); else chains.remove (mod); }
+    /*! Returns the CBLT address of the chain the module belongs to, or 0 if it is read out on its own. */
+    uint8_t getChain (AbstractModule* mod) const { return chains.value (mod, 0); }
+
     void setMainWindow (ScopeMainWindow *mw) { mainWindow = mw; }
     ScopeMainWindow *getMainWindow() const { return mainWindow; }
 
@@ -128,6 +136,7 @@ private:
     list_type* items;
     QMap<QString, ModuleTypeDesc> registry;
     QSet<AbstractModule*> triggers;
+    QMap<AbstractModule*, uint8_t> chains;
     QSet<const EventSlot*> mandatoryslots;
 
 private: // no copying
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMetaType>
 #include <QVariant>
 #include <QVector>
+#include <QList>
 
 class AbstractPlugin;
 
@@ -36,6 +37,10 @@ namespace ScopeCommon
 /*! A source or sink for data transferred between plugins.
  *  All data handling is performed by output connectors. Input connectors only
  *  pass commands to the output they are connected to.
+ *
+ *  An input is connected to at most one output, but an output may feed any number of inputs.
+ *  All inputs connected to an output read the same data item, without copies. The output keeps track of #useData separately
+ *  for each of them and discards an item once every connected input has used it.
  */
 class PluginConnector
 {
@@ -55,35 +60,45 @@ public:
     AbstractPlugin* getPlugin() const { return plugin; }
     /*! Returns the connector name. */
     QString getName() const { return name; }
-    /*! Returns the name of the plugin which this connector is connected to. */
+    /*! Returns the name of the plugin which this connector is connected to.
+     *  For outputs connected to several inputs, this is the plugin of the first input.
+     */
     QString getConnectedPluginName() const;
-    /*! Returns the plugin which this connector is connected to. */
+    /*! Returns the plugin which this connector is connected to. For outputs, the plugin of the first connected input. */
     AbstractPlugin* getConnectedPlugin() const;
-    /*! Returns the name of the connector which this connector is connected to. */
+    /*! Returns the name of the connector which this connector is connected to. For outputs, the first connected input. */
     QString getOthersideName() const;
     /*! Returns whether the connector is connected or disconnected. */
     bool hasOtherSide() const;
+    /*! Returns all connectors this connector is connected to. Inputs have at most one connection. */
+    const QList<PluginConnector*> &getConnections() const { return others; }
+    /*! Returns the plugins of all connectors this connector is connected to. A plugin may appear more than once. */
+    QList<AbstractPlugin*> getConnectedPlugins() const;
 
-    /*! Connects the connector to the specified connector. Only one input may be connected to an output and DataTypes must match.
+    /*! Connects the connector to the specified connector and DataTypes must match.
+     *  An output may be connected to several inputs. Connecting an input that is already connected does nothing.
      *  \throws std::invalid_argument when trying to connect two inputs or outputs or if the DataTypes do not match
      */
     void connectTo(PluginConnector* _otherSide);
 
-    /*! Disconnects the connector. */
+    /*! Disconnects the connector from all connectors it is connected to. */
     void disconnect();
 
-    /*! Push data into the connector. The data becomes visible on the input connector connected to this connector.
+    /*! Removes the connection between this connector and \c _otherSide, if there is one. */
+    void disconnect(PluginConnector* _otherSide);
+
+    /*! Push data into the connector. The data becomes visible on all input connectors connected to this connector.
      *  \note This function may only be called for output connectors
      */
     virtual void setData(QVariant) = 0;
 
     /*! Get data data from the connector.
-     *  \note This function may only be called for input connectors
+     *  On an output connector, returns the oldest item not yet used by all connected inputs.
      */
     virtual QVariant getData() = 0;
 
     /*! Tell the connector that the data retrieved by getData has been used and may now be discarded.
-     *  \note This function may only be called for input connectors
+     *  On an output connector, the oldest item is discarded for all connected inputs.
      */
     virtual bool useData() = 0;
 
@@ -93,14 +108,58 @@ public:
     /*! Release all data queued inside the connector. */
     virtual void reset() = 0;
 
+    /*! Returns whether the connector can hold the data of several events at once.
+     *  Plugins producing data for a connector that can not are only processed once the connected plugin
+     *  has processed the previous event.
+     */
+    virtual bool isQueued() const { return false; }
+
+    /*! Set the sequence number of the event processed by the calling thread.
+     *  When several events are processed at once, queued connectors tag their data with the sequence number
+     *  of the event it was produced for and only show data of events the reading thread has already reached.
+     *  \sa PluginExecutor
+     */
+    static void setCurrentEvent (uint32_t seq);
+    /*! Returns whether data produced for event \c seq is visible to the calling thread.
+     *  Threads that never set an event number see all data.
+     */
+    static bool isEventVisible (uint32_t seq);
+    /*! Returns the sequence number of the event processed by the calling thread. */
+    static uint32_t currentEvent ();
+
 protected:
-    /*! Returns the connector connected to this one. */
-    PluginConnector* getOtherSide() { return otherSide; }
+    /*! Returns the connector connected to this one. For outputs, the first connected input. */
+    PluginConnector* getOtherSide() { return others.empty () ? NULL : others.first (); }
+
+    /*! Returns the index of this input among the inputs connected to its output, or -1 if it is not connected. */
+    int getConsumerIndex() const { return consumerIdx; }
+
+    // Output side of the data interface, used by the connected inputs.
+    // consumer is the index of the reading input (see getConsumerIndex), -1 acts on behalf of all of them.
+    /*! Returns the oldest item not yet used by \c consumer. */
+    virtual QVariant getDataFor(int consumer) = 0;
+    /*! Marks the oldest item not yet used by \c consumer as used. */
+    virtual bool useDataFor(int consumer) = 0;
+    /*! Returns the number of items \c consumer has not used yet. */
+    virtual int dataAvailableFor(int consumer) = 0;
+    /*! Called on outputs after a new input has been appended to the connections. */
+    virtual void consumerAdded() {}
+    /*! Called on outputs after the input with index \c idx has been removed from the connections. */
+    virtual void consumerRemoved(int idx) { Q_UNUSED (idx); }
+
+    // Input side helpers: forward to the connected output on behalf of this input
+    QVariant sourceData() { return others.empty () ? QVariant () : others.first ()->getDataFor (consumerIdx); }
+    bool useSourceData() { return others.empty () ? false : others.first ()->useDataFor (consumerIdx); }
+    int sourceDataAvailable() { return others.empty () ? 0 : others.first ()->dataAvailableFor (consumerIdx); }
+
+private:
+    void renumberConsumers();
 
 private:
     AbstractPlugin* plugin;
     ScopeCommon::ConnectorType type;
-    PluginConnector* otherSide;
+    QList<PluginConnector*> others;
+    int consumerIdx;
     QString name;
     DataType dtype;
 };
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 /*! A simple plugin connector that performs no buffering at all.
  *  Use this connector type for input connectors because it has the smallest memory footprint.
+ *  As an output, it holds a single item that every connected input may use once.
  */
 class PluginConnectorPlain : public PluginConnector {
 public:
@@ -39,40 +40,65 @@ public:
         assert (getType () == ScopeCommon::out);
         data_ = d;
         valid_ = !data_.isNull ();
+        pending_.fill (valid_);
     }
 
     QVariant getData () {
         if (getType() == ScopeCommon::in)
-            return hasOtherSide () ? getOtherSide ()->getData () : QVariant ();
+            return sourceData ();
         else
-            return valid_ ? data_ : QVariant ();
+            return getDataFor (-1);
     }
 
     bool useData () {
-        if (getType () == ScopeCommon::in && hasOtherSide())
-            return getOtherSide ()->useData ();
-        else {
-            bool ret = valid_;
-            valid_ = false;
-            return ret;
-        }
+        if (getType () == ScopeCommon::in)
+            return useSourceData ();
+        else
+            return useDataFor (-1);
     }
 
     int dataAvailable () {
         if (getType () == ScopeCommon::in)
-            return hasOtherSide () ? getOtherSide ()->dataAvailable() : 0;
+            return sourceDataAvailable ();
         else
-            return valid_ ? 1 : 0;
+            return dataAvailableFor (-1);
     }
 
     void reset () {
         data_.clear();
         valid_ = false;
+        pending_.fill (false);
+    }
+
+protected:
+    QVariant getDataFor (int consumer) {
+        return isPending (consumer) ? data_ : QVariant ();
+    }
+
+    bool useDataFor (int consumer) {
+        bool ret = isPending (consumer);
+        if (consumer < 0)
+            pending_.fill (false);
+        else if (ret)
+            pending_ [consumer] = false;
+        valid_ = (consumer >= 0 && pending_.contains (true));
+        return ret;
     }
 
+    int dataAvailableFor (int consumer) {
+        return isPending (consumer) ? 1 : 0;
+    }
+
+    void consumerAdded () { pending_.push_back (false); }
+    void consumerRemoved (int idx) { pending_.remove (idx); }
+
+private:
+    bool isPending (int consumer) const { return consumer < 0 ? valid_ : valid_ && pending_.at (consumer); }
+
 private:
     QVariant data_;
     bool valid_;
+    QVector<bool> pending_; // per connected input: item not used yet
 };
 
 #endif // PLUGINCONNECTORPLAIN_H
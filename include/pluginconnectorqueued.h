@@ -22,14 +22,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "pluginconnector.h"
 #include <QQueue>
+#include <QPair>
+#include <QMutex>
 #include <iostream>
+#include <algorithm>
 
 #include <cassert>
 
 class BasePlugin;
 
 /*! A plugin connector that uses QQueue to queue outgoing data.
- *
+ *  Each item is tagged with the sequence number of the event it belongs to, and the input side only sees items of
+ *  events the reading thread has already reached. The queue is protected by a mutex, so the producing and the consuming
+ *  plugin may be processed concurrently on different events.
+ *  Every connected input has its own read position. Items are dequeued once all inputs have used them.
  */
 template<typename T>
 class PluginConnectorQueued : public PluginConnector
@@ -46,74 +52,110 @@ public:
 
     void setData (QVariant _data) {
         assert(getType() == ScopeCommon::out);
-        q.enqueue(_data);
+        QMutexLocker l (&qlock);
+        q.enqueue(Item (currentEvent (), _data));
     }
 
-    // may only be called from input connectors
     QVariant getData()
     {
         if(getType() == ScopeCommon::in)
-        {
-            if(hasOtherSide()) return getOtherSide()->getData();
-            else return QVariant ();
-        }
+            return sourceData();
         else
-        {
-            if(!q.empty()) return q.head();
-            else return QVariant ();
-        }
+            return getDataFor(-1);
     }
 
     bool useData()
     {
         if(getType() == ScopeCommon::in)
-        {
-            if(hasOtherSide()) return getOtherSide()->useData();
-            else return false;
-        }
+            return useSourceData();
         else
-        {
-            if(!q.empty())
-            {
-                //printf("%s dequeueing 1 element, %d remaining\n",getName().c_str(),q.size());
-                q.dequeue();
-                return true;
-            }
-            else
-            {
-                return false;
-            }
-        }
+            return useDataFor(-1);
     }
 
     int dataAvailable()
     {
         if(getType() == ScopeCommon::in)
-        {
-            if(hasOtherSide())
-            {
-                return getOtherSide()->dataAvailable();
-            }
-            else
-            {
-                return 0;
-            }
-        }
+            return sourceDataAvailable();
         else
-        {
-            //std::cout << getName() << "PluginConnector Data available: " << q.size() << std::endl;
-            return q.size();
-        }
+            return dataAvailableFor(-1);
     }
 
     void reset()
     {
         //std::cout << getName().toStdString() << "PluginConnector reset " << std::endl;
+        QMutexLocker l (&qlock);
         q.clear();
+        read.fill(0);
+    }
+
+    bool isQueued() const { return true; }
+
+protected:
+    QVariant getDataFor(int consumer)
+    {
+        QMutexLocker l (&qlock);
+        int pos = position(consumer);
+        if(pos < q.size() && isEventVisible (q.at(pos).first)) return q.at(pos).second;
+        else return QVariant ();
+    }
+
+    bool useDataFor(int consumer)
+    {
+        QMutexLocker l (&qlock);
+        int pos = position(consumer);
+        if(pos >= q.size() || !isEventVisible (q.at(pos).first))
+            return false;
+
+        if(consumer < 0)
+        {
+            // drop the head for everyone
+            q.dequeue();
+            for(int i = 0; i < read.size(); ++i)
+                if(read.at(i) > 0) --read[i];
+            return true;
+        }
+
+        ++read[consumer];
+        // dequeue the items all inputs are done with
+        while(!q.empty() && *std::min_element(read.constBegin(), read.constEnd()) > 0)
+        {
+            q.dequeue();
+            for(int i = 0; i < read.size(); ++i) --read[i];
+        }
+        return true;
+    }
+
+    int dataAvailableFor(int consumer)
+    {
+        //std::cout << getName() << "PluginConnector Data available: " << q.size() << std::endl;
+        QMutexLocker l (&qlock);
+        int pos = position(consumer);
+        int n = 0;
+        while (pos + n < q.size () && isEventVisible (q.at (pos + n).first))
+            ++n;
+        return n;
+    }
+
+    void consumerAdded()
+    {
+        QMutexLocker l (&qlock);
+        read.push_back(0);
     }
 
+    void consumerRemoved(int idx)
+    {
+        QMutexLocker l (&qlock);
+        read.remove(idx);
+    }
+
+private:
+    int position(int consumer) const { return consumer < 0 ? 0 : read.at(consumer); }
+
 protected:
-    QQueue< QVariant > q;
+    typedef QPair<uint32_t, QVariant> Item;
+    QQueue< Item > q;
+    QVector<int> read; // per connected input: number of queued items it has already used
+    QMutex qlock;
 };
 
 typedef PluginConnectorQueued< QVector<uint32_t> > PluginConnectorQVUint;
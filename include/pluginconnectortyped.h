@@ -0,0 +1,280 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLUGINCONNECTORTYPED_H
+#define PLUGINCONNECTORTYPED_H
+
+#include "pluginconnector.h"
+
+#include <QMutex>
+
+#include <algorithm>
+#include <cassert>
+
+/*! Empty a connector buffer that has been consumed, so it can be reused.
+ *  Vectors that are not shared keep their allocated storage. Vectors still shared with someone who kept
+ *  a copy (eg. a histogram plugin handing out its spectrum) are dropped, so the other owner does not
+ *  have to detach on its next modification.
+ */
+template<typename T> inline void releaseConnectorBuffer (T &buf) { buf = T (); }
+template<typename E> inline void releaseConnectorBuffer (QVector<E> &buf) {
+    if (buf.isDetached ()) {
+        buf.reserve (buf.size ());
+        buf.resize (0);
+    } else {
+        buf = QVector<E> ();
+    }
+}
+
+/*! A queued plugin connector with a typed, copy-free interface.
+ *  Output connectors own a ring of buffers. A plugin fills the next buffer in place via #produce,
+ *  and the connected input reads it via #peek without any copy or QVariant boxing.
+ *  Buffers released with #useData are handed out again by later calls to #produce, so vector data keeps its capacity
+ *  and steady-state processing does not allocate.
+ *
+ *  The QVariant interface of PluginConnector is still implemented, so typed connectors can be connected to
+ *  plain and queued connectors of the same DataType. An input connected to an untyped output unboxes the data once per #peek.
+ *
+ *  Like PluginConnectorQueued, items are tagged with their event sequence number and the ring is protected by a mutex,
+ *  so producer and consumer may work on different events at the same time. Buffers never move in memory once allocated.
+ *
+ *  An output connected to several inputs hands the same buffer to all of them. Each input has its own read position,
+ *  and a buffer is only recycled once every input has released it, so fanning out data costs no copies.
+ *
+ *  \code
+ *    // in userProcess ()
+ *    const QVector<double> &in = input->peek ();
+ *    QVector<double> &out = output->produce ();
+ *    out.resize (in.size ());
+ *    ...
+ *  \endcode
+ *  \note References obtained from #peek are only valid until the next call to #useData on the owning output connector.
+ */
+template<typename T>
+class PluginConnectorTyped : public PluginConnector
+{
+public:
+    PluginConnectorTyped(AbstractPlugin* _plugin, ScopeCommon::ConnectorType _type, QString _name)
+        : PluginConnector (_plugin, _type, _name, TypeToDataType<T>::data_type)
+        , first_ (0)
+        , count_ (0)
+        , sourceSide_ (NULL)
+        , source_ (NULL)
+    {
+        allocate (4);
+    }
+
+    ~PluginConnectorTyped () {
+        qDeleteAll (ring_);
+    }
+
+    /*! Return an empty buffer for the next output item.
+     *  The buffer is queued right away and becomes visible on the connected input.
+     *  \note This function may only be called for output connectors
+     */
+    T &produce () {
+        assert (getType () == ScopeCommon::out);
+        QMutexLocker l (&lock_);
+        if (count_ == ring_.size ())
+            grow ();
+        int idx = (first_ + count_) % ring_.size ();
+        seq_ [idx] = currentEvent ();
+        ++count_;
+        return *ring_.at (idx);
+    }
+
+    /*! Return the oldest queued item without copying it.
+     *  Returns a default-constructed object if no data is available.
+     */
+    const T &peek () {
+        if (getType () == ScopeCommon::in) {
+            if (!hasOtherSide ())
+                return empty ();
+            PluginConnectorTyped<T> *src = typedSource ();
+            if (src)
+                return src->peekFor (getConsumerIndex ());
+            // untyped output: unbox the QVariant
+            cache_ = sourceData ().template value<T> ();
+            return cache_;
+        }
+        return peekFor (-1);
+    }
+
+    // QVariant compatibility interface
+    void setData (QVariant _data) {
+        assert (getType () == ScopeCommon::out);
+        produce () = _data.value<T> ();
+    }
+
+    QVariant getData () {
+        if (getType () == ScopeCommon::in)
+            return sourceData ();
+        return getDataFor (-1);
+    }
+
+    bool useData () {
+        if (getType () == ScopeCommon::in)
+            return useSourceData ();
+        return useDataFor (-1);
+    }
+
+    int dataAvailable () {
+        if (getType () == ScopeCommon::in)
+            return sourceDataAvailable ();
+        return dataAvailableFor (-1);
+    }
+
+    void reset () {
+        QMutexLocker l (&lock_);
+        qDeleteAll (ring_);
+        ring_.clear ();
+        seq_.clear ();
+        allocate (4);
+        first_ = 0;
+        count_ = 0;
+        read_.fill (0);
+        cache_ = T ();
+    }
+
+    bool isQueued () const { return true; }
+
+protected:
+    QVariant getDataFor (int consumer) {
+        QMutexLocker l (&lock_);
+        int pos = position (consumer);
+        return visible (pos) ? QVariant::fromValue (*ring_.at ((first_ + pos) % ring_.size ())) : QVariant ();
+    }
+
+    bool useDataFor (int consumer) {
+        QMutexLocker l (&lock_);
+        if (!visible (position (consumer)))
+            return false;
+
+        if (consumer < 0) {
+            // drop the oldest item for everyone
+            pop ();
+            for (int i = 0; i < read_.size (); ++i)
+                if (read_.at (i) > 0)
+                    --read_ [i];
+            return true;
+        }
+
+        ++read_ [consumer];
+        // recycle the buffers all inputs are done with
+        while (count_ && *std::min_element (read_.constBegin (), read_.constEnd ()) > 0) {
+            pop ();
+            for (int i = 0; i < read_.size (); ++i)
+                --read_ [i];
+        }
+        return true;
+    }
+
+    int dataAvailableFor (int consumer) {
+        QMutexLocker l (&lock_);
+        int pos = position (consumer);
+        int n = 0;
+        while (pos + n < count_ && isEventVisible (seq_.at ((first_ + pos + n) % ring_.size ())))
+            ++n;
+        return n;
+    }
+
+    void consumerAdded () {
+        QMutexLocker l (&lock_);
+        read_.push_back (0);
+    }
+
+    void consumerRemoved (int idx) {
+        QMutexLocker l (&lock_);
+        read_.remove (idx);
+    }
+
+private:
+    static const T &empty () {
+        static const T e = T ();
+        return e;
+    }
+
+    const T &peekFor (int consumer) {
+        QMutexLocker l (&lock_);
+        int pos = position (consumer);
+        return visible (pos) ? *ring_.at ((first_ + pos) % ring_.size ()) : empty ();
+    }
+
+    int position (int consumer) const { return consumer < 0 ? 0 : read_.at (consumer); }
+
+    /*! whether the item \c pos places after the oldest one exists and is visible to the calling thread */
+    bool visible (int pos) const { return pos < count_ && isEventVisible (seq_.at ((first_ + pos) % ring_.size ())); }
+
+    void pop () {
+        releaseConnectorBuffer (*ring_ [first_]);
+        first_ = (first_ + 1) % ring_.size ();
+        --count_;
+    }
+
+    void allocate (int n) {
+        while (ring_.size () < n) {
+            ring_.push_back (new T);
+            seq_.push_back (0);
+        }
+    }
+
+    /*! double the ring size, keeping queued items in order. The buffers themselves stay in place. */
+    void grow () {
+        int size = ring_.size ();
+        QVector<T*> r (size);
+        QVector<uint32_t> s (size);
+        for (int i = 0; i < size; ++i) {
+            r [i] = ring_.at ((first_ + i) % size);
+            s [i] = seq_.at ((first_ + i) % size);
+        }
+        ring_ = r;
+        seq_ = s;
+        first_ = 0;
+        allocate (2 * size);
+    }
+
+    PluginConnectorTyped<T> *typedSource () {
+        if (getOtherSide () != sourceSide_) {
+            sourceSide_ = getOtherSide ();
+            source_ = dynamic_cast<PluginConnectorTyped<T>*> (sourceSide_);
+        }
+        return source_;
+    }
+
+private:
+    QVector<T*> ring_;
+    QVector<uint32_t> seq_;
+    int first_;
+    int count_;
+    QVector<int> read_; // per connected input: number of queued items it has already used
+    T cache_;
+    QMutex lock_;
+
+    PluginConnector *sourceSide_;
+    PluginConnectorTyped<T> *source_;
+
+private: // no copying
+    PluginConnectorTyped (const PluginConnectorTyped &);
+    PluginConnectorTyped &operator= (const PluginConnectorTyped &);
+};
+
+typedef PluginConnectorTyped< QVector<uint32_t> > PluginConnectorTypedQVUint;
+typedef PluginConnectorTyped< QVector<double> > PluginConnectorTypedQVDouble;
+
+#endif // PLUGINCONNECTORTYPED_H
@@ -27,6 +27,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDateTime>
 #include <QBitArray>
 
+#include "threadscheduling.h"
+
 class RunThread;
 class PluginThread;
 class QTimer;
@@ -51,6 +53,17 @@ class RunManager : public QObject
     enum State{StateRunning,StateRemoteControlled};
 
     bool singleeventmode;
+    int pipelinedepth;
+    int pluginthreads;
+    int batchsize;
+    int batchlatency;
+    int evbufsize;
+    int evbufmemory;
+    int overflowpolicy;
+    ThreadSchedulingConfig readoutsched;
+    ThreadSchedulingConfig pluginsched;
+    bool lockmemory;
+    bool interruptreadout;
     bool running;
 
     /*! If true, then the run is done on the local machine,
@@ -64,6 +77,7 @@ class RunManager : public QObject
     unsigned evcnt;
     unsigned lastevcnt;
     float evpersec;
+    float pollsperevent;
     unsigned evprocessedcnt;
 
     ScopeMainWindow *mainwnd;
@@ -103,11 +117,56 @@ public:
     unsigned getEventCount () const {return evcnt;}
     /*! Returns the current event rate. */
     float getEventRate () const;
+    /*! Returns the number of times the triggers were polled per event during this run. */
+    float getPollsPerEvent () const {return pollsperevent;}
     /*! Returns whether single event mode is active.
      *  In single event mode, only the first event on each module is processed in each acquisition round.
      *  The remaining events are discarded.
      */
     bool isSingleEventMode () const { return singleeventmode; }
+    /*! Returns the maximum number of event batches the plugins may process at the same time.
+     *  With more than one batch in flight, the plugin chain works like a pipeline. Takes effect at the next run start.
+     *  \sa PluginExecutor
+     */
+    int getPipelineDepth () const { return pipelinedepth; }
+    /*! Returns the configured number of plugin executor threads, 0 for automatic. Takes effect at the next run start. */
+    int getPluginThreads () const { return pluginthreads; }
+    /*! Returns the number of plugin executor threads used for the next run.
+     *  In automatic mode this is the number of CPUs, minus the CPUs the readout and plugin threads are pinned to.
+     */
+    int getPluginThreadCount () const;
+    /*! Returns the maximum number of events handed to the plugins at once. Takes effect at the next run start. */
+    int getBatchSize () const { return batchsize; }
+    /*! Returns the maximum time in ms an event waits for its batch to fill up. Takes effect at the next run start. */
+    int getBatchLatency () const { return batchlatency; }
+    /*! Returns the number of events the event buffer holds. Used if no memory budget is set.
+     *  Takes effect at the next run start.
+     */
+    int getEventBufferSize () const { return evbufsize; }
+    /*! Returns the memory budget of the event buffer in MiB, 0 if the buffer is sized by event count.
+     *  Takes effect at the next run start. \sa EventBuffer::setMemoryBudget
+     */
+    int getEventBufferMemory () const { return evbufmemory; }
+    /*! Returns what happens to events if the event buffer is full, see EventBuffer::OverflowPolicy.
+     *  Takes effect at the next run start. Lossy policies are replaced by EventBuffer::Block while a plugin records data.
+     */
+    int getOverflowPolicy () const { return overflowpolicy; }
+    /*! Returns the number of events the plugins did not get to see because the event buffer was full. */
+    unsigned getLostEventCount () const;
+    /*! Returns the CPU affinity and scheduling policy of the readout thread. Takes effect at the next run start.
+     *  \sa ThreadScheduling
+     */
+    const ThreadSchedulingConfig &getReadoutScheduling () const { return readoutsched; }
+    /*! Returns the CPU affinity and scheduling policy of the plugin thread. Takes effect at the next run start. */
+    const ThreadSchedulingConfig &getPluginScheduling () const { return pluginsched; }
+    /*! Returns whether the process memory is locked into RAM during runs. */
+    bool isMemoryLockEnabled () const { return lockmemory; }
+    /*! Returns whether the readout thread waits for VME interrupts of the triggers instead of polling them. */
+    bool isInterruptReadout () const { return interruptreadout; }
+    /*! Returns the problems that keep the current thread scheduling settings from being applied.
+     *  An empty list means the settings are expected to work.
+     */
+    QStringList checkScheduling () const;
     /*! Returns a pointer to a SystemInfo object for reading the current cpu/net load. */
     const SystemInfo *getSystemInfo () const {return sysinfo;}
     /*! Returns a pointer to the global event buffer. */
@@ -135,6 +194,38 @@ public slots:
     void setRunName(QString newValue);
     /*! Activates single event mode, where only the first event of each acquisition cycle is kept */
     void setSingleEventMode (bool sem) { singleeventmode = sem; }
+    /*! Sets the maximum number of batches in flight in the plugin chain */
+    void setPipelineDepth (int depth) { pipelinedepth = depth < 1 ? 1 : depth; }
+    /*! Sets the number of plugin executor threads, 0 chooses it from the CPUs left by the pinned threads */
+    void setPluginThreads (int count) { pluginthreads = count < 0 ? 0 : count; }
+    /*! Sets the maximum number of events per batch */
+    void setBatchSize (int size) { batchsize = size < 1 ? 1 : size; }
+    /*! Sets the maximum batch latency in ms */
+    void setBatchLatency (int ms) { batchlatency = ms < 1 ? 1 : ms; }
+    /*! Sets the number of events the event buffer holds */
+    void setEventBufferSize (int size) { evbufsize = size < 1 ? 1 : size; }
+    /*! Sets the memory budget of the event buffer in MiB, 0 sizes the buffer by event count */
+    void setEventBufferMemory (int mib) { evbufmemory = mib < 0 ? 0 : mib; }
+    /*! Sets the overflow policy of the event buffer, see EventBuffer::OverflowPolicy */
+    void setOverflowPolicy (int policy);
+    /*! Pins the readout thread to the given CPU, -1 lets it run on any CPU */
+    void setReadoutCpu (int cpu) { readoutsched.cpu = cpu < -1 ? -1 : cpu; }
+    /*! Sets the scheduling policy of the readout thread, see ThreadSchedulingConfig::Policy */
+    void setReadoutPolicy (int policy) { readoutsched.policy = ThreadSchedulingConfig::toPolicy (policy); }
+    /*! Sets the real-time priority of the readout thread */
+    void setReadoutPriority (int prio) { readoutsched.priority = prio; }
+    /*! Pins the plugin thread to the given CPU, -1 lets it run on any CPU */
+    void setPluginCpu (int cpu) { pluginsched.cpu = cpu < -1 ? -1 : cpu; }
+    /*! Sets the scheduling policy of the plugin thread, see ThreadSchedulingConfig::Policy */
+    void setPluginPolicy (int policy) { pluginsched.policy = ThreadSchedulingConfig::toPolicy (policy); }
+    /*! Sets the real-time priority of the plugin thread */
+    void setPluginPriority (int prio) { pluginsched.priority = prio; }
+    /*! Locks the process memory into RAM while a run is active, avoiding page faults in the readout path */
+    void setMemoryLockEnabled (bool lock) { lockmemory = lock; }
+    /*! Lets the readout thread wait for VME interrupts of the triggers. Falls back to polling if any of the triggers
+     *  or the main interface does not support interrupts, see AbstractModule::getIrq. Takes effect at the next run start.
+     */
+    void setInterruptReadout (bool irq) { interruptreadout = irq; }
     /*! Activate local or remote mode */
     void setLocalMode (bool lm) { localRun = lm; }
     void setRemoteMode (bool lm) { localRun = !lm; }
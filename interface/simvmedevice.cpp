@@ -0,0 +1,1384 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "simvmedevice.h"
+#include "../module/caen_v792.h"
+#include "../module/caen_v785.h"
+#include "../module/caen_v1290.h"
+#include "../module/caen_v820.h"
+#include "../module/mesytec_madc_32_v2.h"
+#include "../module/sis3302.h"
+#include "../module/sis3350.h"
+
+#include <algorithm>
+#include <cmath>
+
+static uint64_t splitmix (uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void SimVmeRandom::setSeed (uint64_t seed)
+{
+    state_ = splitmix (seed);
+    if (state_ == 0)
+        state_ = 1;
+    haveSpare_ = false;
+}
+
+uint64_t SimVmeRandom::next ()
+{
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 0x2545F4914F6CDD1DULL;
+}
+
+double SimVmeRandom::gauss ()
+{
+    if (haveSpare_) {
+        haveSpare_ = false;
+        return spare_;
+    }
+
+    // polar Box-Muller method
+    double u, v, s;
+    do {
+        u = 2 * uniform () - 1;
+        v = 2 * uniform () - 1;
+        s = u*u + v*v;
+    } while (s >= 1 || s == 0);
+
+    double f = std::sqrt (-2 * std::log (s) / s);
+    spare_ = v * f;
+    haveSpare_ = true;
+    return u * f;
+}
+
+double SimVmeRandom::exponential (double mean)
+{
+    return -mean * std::log (1 - uniform ());
+}
+
+uint64_t SimVmeRandom::hash (uint64_t a, uint64_t b, uint64_t c, uint64_t d)
+{
+    return splitmix (splitmix (splitmix (splitmix (a) ^ b) ^ c) ^ d);
+}
+
+SimVmeDevice::SimVmeDevice (const QString &type, uint32_t baseAddr, uint32_t windowSize, int slot, uint64_t seed)
+    : rng_ (seed)
+    , slot_ (slot)
+    , seed_ (seed)
+    , accepted_ (0)
+    , lost_ (0)
+    , now_ (0)
+    , type_ (type)
+    , busyUntil_ (0)
+    , base_ (baseAddr)
+    , size_ (windowSize)
+{
+}
+
+SimVmeDevice *SimVmeDevice::create (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+{
+    // every device gets its own stream, so adding a module does not change the data of the others
+    uint64_t s = SimVmeRandom::hash (seed, baseAddr);
+
+    if (type == "caen785")
+        return new SimCaenAdc (type, SimCaenAdc::V785, baseAddr, slot, s);
+    if (type == "caen792")
+        return new SimCaenAdc (type, SimCaenAdc::V792, baseAddr, slot, s);
+    if (type == "caen775")
+        return new SimCaenAdc (type, SimCaenAdc::V775, baseAddr, slot, s);
+    if (type == "caen965")
+        return new SimCaenAdc (type, SimCaenAdc::V965, baseAddr, slot, s);
+    if (type == "caen1290a" || type == "caen1290n" || type == "caen1190a" || type == "caen1190b")
+        return new SimCaen1290 (type, baseAddr, slot, s);
+    if (type == "caen820")
+        return new SimCaen820 (type, baseAddr, slot, s);
+    if (type == "mesytecMadc32")
+        return new SimMadc32 (type, baseAddr, slot, s);
+    if (type == "sis3302_standard")
+        return new SimSis3302 (type, baseAddr, slot, s);
+    if (type == "sis3350")
+        return new SimSis3350 (type, baseAddr, slot, s);
+
+    return NULL;
+}
+
+void SimVmeDevice::reset ()
+{
+    regs_.clear ();
+    busyUntil_ = 0;
+}
+
+void SimVmeDevice::handleTrigger (uint64_t time, uint32_t conversion)
+{
+    if (time < busyUntil_) {
+        ++lost_;
+        return;
+    }
+
+    uint64_t before = accepted_;
+    trigger (time);
+    if (accepted_ != before)
+        busyUntil_ = time + conversion;
+}
+
+int SimVmeDevice::read16 (uint32_t offset, uint16_t *data)
+{
+    *data = reg (offset) & 0xFFFF;
+    return 0;
+}
+
+int SimVmeDevice::read32 (uint32_t offset, uint32_t *data)
+{
+    *data = reg (offset);
+    return 0;
+}
+
+int SimVmeDevice::write16 (uint32_t offset, uint16_t data)
+{
+    regs_ [offset] = data;
+    return 0;
+}
+
+int SimVmeDevice::write32 (uint32_t offset, uint32_t data)
+{
+    regs_ [offset] = data;
+    return 0;
+}
+
+int SimVmeDevice::readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo)
+{
+    *got = 0;
+    while (*got < n) {
+        int ret = read32 (offset, buf + *got);
+        if (ret)
+            return ret;
+        ++*got;
+        if (!fifo)
+            offset += 4;
+    }
+    return 0;
+}
+
+double SimVmeDevice::amplitude (SimVmeRandom &rng, int ch, double range)
+{
+    // channels differ slightly in gain, like a real detector array
+    double gain = 1.0 + 0.02 * ((ch % 8) - 3.5) / 3.5;
+    double u = rng.uniform ();
+    double x;
+
+    if (u < 0.25)
+        x = 0.30 + 0.006 * rng.gauss ();
+    else if (u < 0.40)
+        x = 0.62 + 0.008 * rng.gauss ();
+    else
+        x = rng.exponential (0.12);
+
+    x *= gain * range;
+    return x < 0 ? 0 : x;
+}
+
+SimVmeTrace::SimVmeTrace (uint64_t seed, double baseline, double range, double noise, uint32_t maxValue)
+    : seed_ (seed)
+    , baseline_ (baseline)
+    , range_ (range)
+    , noise_ (noise)
+    , maxValue_ (maxValue)
+    , cacheEv_ (0xFFFFFFFF)
+    , cacheCh_ (-1)
+    , cacheAmp_ (0)
+{
+}
+
+uint32_t SimVmeTrace::sample (uint32_t ev, int ch, uint32_t pos, uint32_t length) const
+{
+    if (ev != cacheEv_ || ch != cacheCh_) {
+        SimVmeRandom r (SimVmeRandom::hash (seed_, ev, ch));
+        cacheAmp_ = SimVmeDevice::amplitude (r, ch, range_);
+        cacheEv_ = ev;
+        cacheCh_ = ch;
+    }
+
+    double v = baseline_;
+    uint32_t start = length / 4;
+    if (pos >= start) {
+        double dt = pos - start;
+        v += cacheAmp_ * (std::exp (-dt / 200.) - std::exp (-dt / 5.));
+    }
+
+    // sum of four uniform values is close enough to a gaussian
+    uint64_t h = SimVmeRandom::hash (seed_, ev, ch, pos);
+    double sum = (h & 0xFFFF) + ((h >> 16) & 0xFFFF) + ((h >> 32) & 0xFFFF) + (h >> 48);
+    v += noise_ * (sum - 131070.) / 37837.;
+
+    if (v < 0)
+        return 0;
+    if (v > maxValue_)
+        return maxValue_;
+    return static_cast<uint32_t> (v + 0.5);
+}
+
+SimCaenAdc::SimCaenAdc (const QString &type, Model model, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x10000, slot, seed)
+    , model_ (model)
+{
+    reset ();
+}
+
+void SimCaenAdc::reset ()
+{
+    SimVmeDevice::reset ();
+    meb_.clear ();
+    events_ = 0;
+    evcnt_ = 0;
+    bitset1_ = 0;
+    bitset2_ = 0;
+
+    static const uint16_t boardIds [] = { 0x311, 0x318, 0x307, 0x3C5 };
+    regs_ [CAEN792_GEO_ADDR] = slot_ & 0x1F;
+    regs_ [CAEN792_FIRMWARE] = 0x0905;
+    regs_ [CAEN792_ROM_OUIMSB] = 0x00;
+    regs_ [CAEN792_ROM_OUI] = 0x40;
+    regs_ [CAEN792_ROM_OUILSB] = 0xE6;
+    regs_ [CAEN792_ROM_BOARDIDMSB] = 0x00;
+    regs_ [CAEN792_ROM_BOARDID] = boardIds [model_] >> 8;
+    regs_ [CAEN792_ROM_BOARDIDLSB] = boardIds [model_] & 0xFF;
+}
+
+int SimCaenAdc::read16 (uint32_t offset, uint16_t *data)
+{
+    bool full = events_ >= CAEN792_MEB_EVENTS;
+
+    switch (offset) {
+    case CAEN792_STAT1:
+        *data = (events_ ? (1 << CAEN792_S1_DREADY) | (1 << CAEN792_S1_GDREADY) : 0) |
+                (full ? (1 << CAEN792_S1_BUSY) | (1 << CAEN792_S1_GBUSY) : 0);
+        return 0;
+    case CAEN792_STAT2:
+        *data = (events_ ? 0 : (1 << CAEN792_S2_BUFEMPTY)) | (full ? (1 << CAEN792_S2_BUFFULL) : 0);
+        return 0;
+    case CAEN792_EVCNT_L:
+        *data = evcnt_ & 0xFFFF;
+        return 0;
+    case CAEN792_EVCNT_H:
+        *data = (evcnt_ >> 16) & 0xFF;
+        return 0;
+    case CAEN792_BIT_SET1:
+    case CAEN792_BIT_CLR1:
+        *data = bitset1_;
+        return 0;
+    case CAEN792_BIT_SET2:
+    case CAEN792_BIT_CLR2:
+        *data = bitset2_;
+        return 0;
+    default:
+        return SimVmeDevice::read16 (offset, data);
+    }
+}
+
+int SimCaenAdc::read32 (uint32_t offset, uint32_t *data)
+{
+    if (offset >= 0x800) {
+        uint16_t d;
+        int ret = read16 (offset, &d);
+        *data = d;
+        return ret;
+    }
+
+    if (takeWord (data))
+        return 0;
+    if (reg (CAEN792_CONTROL1) & (1 << CAEN792_C1_BERREN))
+        return SIMVME_BUS_ERROR;
+    *data = ((reg (CAEN792_GEO_ADDR) & 0x1F) << 27) | (0x6 << 24);
+    return 0;
+}
+
+int SimCaenAdc::write16 (uint32_t offset, uint16_t data)
+{
+    // the V785 has the event counter reset where the others have the test event register
+    uint32_t evcntReset = (model_ == V785) ? CAEN785_EVCNT_RST : CAEN792_EVCNT_RST;
+    if (offset == evcntReset) {
+        evcnt_ = 0;
+        return 0;
+    }
+
+    switch (offset) {
+    case CAEN792_BIT_SET1:
+        if (data & (1 << CAEN792_B1_SOFTRST))
+            reset ();
+        bitset1_ |= data;
+        return 0;
+    case CAEN792_BIT_CLR1:
+        bitset1_ &= ~data;
+        return 0;
+    case CAEN792_BIT_SET2:
+        bitset2_ |= data;
+        if (data & (1 << CAEN792_B2_CLRDATA)) {
+            meb_.clear ();
+            events_ = 0;
+        }
+        return 0;
+    case CAEN792_BIT_CLR2:
+        bitset2_ &= ~data;
+        return 0;
+    default:
+        return SimVmeDevice::write16 (offset, data);
+    }
+}
+
+int SimCaenAdc::readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo)
+{
+    if (offset >= 0x800)
+        return SimVmeDevice::readBlock (offset, buf, n, got, fifo);
+
+    // the whole transfer goes to the output buffer, whatever the address increment
+    bool blkend = reg (CAEN792_CONTROL1) & (1 << CAEN792_C1_BLKEND);
+    bool berr = reg (CAEN792_CONTROL1) & (1 << CAEN792_C1_BERREN);
+    uint32_t invalid = ((reg (CAEN792_GEO_ADDR) & 0x1F) << 27) | (0x6 << 24);
+    bool done = false;
+
+    *got = 0;
+    while (*got < n) {
+        uint32_t w;
+        if (done || !takeWord (&w)) {
+            if (berr)
+                return SIMVME_BUS_ERROR;
+            w = invalid;
+        } else if (blkend && ((w >> 24) & 0x7) == 0x4) {
+            done = true;
+        }
+        buf [(*got)++] = w;
+    }
+    return 0;
+}
+
+int SimCaenAdc::chainAddress () const
+{
+    return (reg (CAEN792_CBLT_CTRL) & 0x3) ? static_cast<int> (reg (CAEN792_CBLT_ADDR) & 0xFF) : -1;
+}
+
+uint32_t SimCaenAdc::readChained (uint32_t *buf, uint32_t n)
+{
+    bool blkend = reg (CAEN792_CONTROL1) & (1 << CAEN792_C1_BLKEND);
+    uint32_t cnt = 0;
+
+    // only complete events are transferred
+    while (events_ > 0) {
+        uint32_t len = 0;
+        while (((meb_ [len] >> 24) & 0x7) != 0x4)
+            ++len;
+        ++len;
+        if (cnt + len > n)
+            break;
+        for (uint32_t i = 0; i < len; ++i)
+            takeWord (buf + cnt++);
+        if (blkend)
+            break;
+    }
+    return cnt;
+}
+
+bool SimCaenAdc::takeWord (uint32_t *w)
+{
+    if (meb_.empty ())
+        return false;
+    *w = meb_.front ();
+    meb_.pop_front ();
+    if (((*w >> 24) & 0x7) == 0x4)
+        --events_;
+    return true;
+}
+
+uint32_t SimCaenAdc::channelValue (int ch)
+{
+    bool hit = rng_.uniform () < 0.5;
+    double v;
+
+    switch (model_) {
+    case V775:
+        if (!hit)
+            return 0;
+        v = 1800 + 40 * (ch % 16) + 5 * rng_.gauss ();
+        break;
+    case V785:
+        v = 15 + 2 * rng_.gauss ();
+        if (hit)
+            v += amplitude (rng_, ch, 3800);
+        break;
+    case V965: // value of the low range (high gain)
+        v = 90 + 1.5 * rng_.gauss ();
+        if (hit)
+            v += amplitude (rng_, ch, 8 * 3600);
+        break;
+    case V792:
+    default:
+        v = 90 + 1.5 * rng_.gauss ();
+        if (hit)
+            v += amplitude (rng_, ch, 3600);
+        break;
+    }
+
+    return v < 0 ? 0 : static_cast<uint32_t> (v);
+}
+
+bool SimCaenAdc::suppressed (int ch, uint32_t value) const
+{
+    uint32_t thr = reg (CAEN792_THRESHOLDS + 2 * ch);
+    if (thr & (1 << CAEN792_THRESH_KILL))
+        return true;
+
+    uint32_t step = (bitset2_ & (1 << CAEN792_B2_STEPTH)) ? 2 : 16;
+    if (value < (thr & 0xFF) * step && !(bitset2_ & (1 << CAEN792_B2_UNDIS)))
+        return true;
+    if (value > 0xFFF && !(bitset2_ & (1 << CAEN792_B2_OVDIS)))
+        return true;
+    return false;
+}
+
+void SimCaenAdc::trigger (uint64_t)
+{
+    if ((bitset1_ & (1 << CAEN792_B1_SOFTRST)) || (bitset2_ & (1 << CAEN792_B2_OFFLINE)))
+        return;
+
+    if (events_ >= CAEN792_MEB_EVENTS) {
+        ++lost_;
+        if (bitset2_ & (1 << CAEN792_B2_ALLTRG))
+            evcnt_ = (evcnt_ + 1) & 0xFFFFFF;
+        return;
+    }
+
+    uint32_t geo = reg (CAEN792_GEO_ADDR) & 0x1F;
+    uint32_t crate = reg (CAEN792_CRATE_SEL) & 0xFF;
+    uint32_t step = (bitset2_ & (1 << CAEN792_B2_STEPTH)) ? 2 : 16;
+    uint32_t data [32];
+    int count = 0;
+
+    uint32_t low = 0;
+    for (int i = 0; i < 32; ++i) {
+        uint32_t v, chbits;
+        if (model_ == V965) {
+            // two words per input: high range (bit 16 clear) and low range with eight times the gain
+            int input = i >> 1;
+            if (!(i & 1)) {
+                low = channelValue (input);
+                v = 90 + (low > 90 ? (low - 90) / 8 : 0);
+            } else {
+                v = low;
+            }
+            chbits = (input << 17) | ((i & 1) << 16);
+        } else {
+            v = channelValue (i);
+            chbits = i << 16;
+        }
+        if (suppressed (i, v))
+            continue;
+
+        uint32_t under = v < (reg (CAEN792_THRESHOLDS + 2 * i) & 0xFF) * step;
+        uint32_t over = v > 0xFFF;
+        data [count++] = (geo << 27) | chbits | (under << 13) | (over << 12) | (over ? 0xFFF : v);
+    }
+
+    evcnt_ = (evcnt_ + 1) & 0xFFFFFF;
+    ++accepted_;
+
+    if (count == 0 && !(bitset2_ & (1 << CAEN792_B2_EMPTYEN)))
+        return;
+
+    meb_.push_back ((geo << 27) | (0x2 << 24) | (crate << 16) | (count << 8));
+    for (int i = 0; i < count; ++i)
+        meb_.push_back (data [i]);
+    meb_.push_back ((geo << 27) | (0x4 << 24) | ((evcnt_ - 1) & 0xFFFFFF));
+    ++events_;
+}
+
+bool SimCaenAdc::irqPending (int *level, uint8_t *vector)
+{
+    int threshold = reg (CAEN792_EV_TRG) & 0x1F;
+    *level = reg (CAEN792_IRQ_LVL) & 0x7;
+    *vector = reg (CAEN792_IRQ_VEC) & 0xFF;
+    return *level && threshold && events_ >= threshold;
+}
+
+SimMadc32::SimMadc32 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x10000, slot, seed)
+{
+    reset ();
+}
+
+void SimMadc32::reset ()
+{
+    SimVmeDevice::reset ();
+    fifo_.clear ();
+    evcnt_ = 0;
+    running_ = false;
+    blocked_ = false;
+    cbltEnabled_ = false;
+    irqAcked_ = false;
+
+    regs_ [MADC32V2_MODULE_ID] = 0xFF;
+    regs_ [MADC32V2_FIRMWARE_REVISION] = MADC32V2_2_EXPECTED_FIRMWARE;
+    regs_ [MADC32V2_DATA_LENGTH_FORMAT] = 2;
+    regs_ [MADC32V2_ADC_RESOLUTION] = 2;
+}
+
+uint16_t SimMadc32::bufferDataLength () const
+{
+    uint32_t words = fifo_.size ();
+    switch (reg (MADC32V2_DATA_LENGTH_FORMAT) & 0x3) {
+    case 0: return words * 4;
+    case 1: return words * 2;
+    case 3: return words / 2;
+    default: return words;
+    }
+}
+
+int SimMadc32::read16 (uint32_t offset, uint16_t *data)
+{
+    uint64_t ts = now_ * 2 / 125; // 16 MHz timestamp counter
+
+    switch (offset) {
+    case MADC32V2_BUFFER_DATA_LENGTH:
+        *data = bufferDataLength ();
+        return 0;
+    case MADC32V2_DATA_READY:
+        *data = fifo_.empty () ? 0 : 1;
+        return 0;
+    case MADC32V2_EVENT_COUNTER_LOW:
+        *data = evcnt_ & 0xFFFF;
+        return 0;
+    case MADC32V2_EVENT_COUNTER_HIGH:
+        *data = (evcnt_ >> 16) & 0xFFFF;
+        return 0;
+    case MADC32V2_TIMESTAMP_CNT_L:
+        *data = ts & 0xFFFF;
+        return 0;
+    case MADC32V2_TIMESTAMP_CNT_H:
+        *data = (ts >> 16) & 0xFFFF;
+        return 0;
+    default:
+        return SimVmeDevice::read16 (offset, data);
+    }
+}
+
+int SimMadc32::read32 (uint32_t offset, uint32_t *data)
+{
+    if (offset >= MADC32V2_THRESHOLD_MEM) {
+        uint16_t d;
+        int ret = read16 (offset, &d);
+        *data = d;
+        return ret;
+    }
+
+    if (fifo_.empty ())
+        return SIMVME_BUS_ERROR;
+    *data = fifo_.front ();
+    fifo_.pop_front ();
+    return 0;
+}
+
+int SimMadc32::write16 (uint32_t offset, uint16_t data)
+{
+    switch (offset) {
+    case MADC32V2_SOFT_RESET:
+        reset ();
+        return 0;
+    case MADC32V2_START_ACQUISITION:
+        running_ = data & 1;
+        return 0;
+    case MADC32V2_READOUT_RESET:
+        blocked_ = false;
+        irqAcked_ = false;
+        return 0;
+    case MADC32V2_FIFO_RESET:
+        fifo_.clear ();
+        blocked_ = false;
+        irqAcked_ = false;
+        return 0;
+    case MADC32V2_CBLT_MCST_CTRL:
+        if (data & (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_CBLT))
+            cbltEnabled_ = true;
+        if (data & (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_CBLT))
+            cbltEnabled_ = false;
+        return 0;
+    case MADC32V2_RESET_COUNTER_AB:
+        if (data & 1)
+            evcnt_ = 0;
+        return 0;
+    default:
+        return SimVmeDevice::write16 (offset, data);
+    }
+}
+
+int SimMadc32::readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo)
+{
+    if (offset >= MADC32V2_THRESHOLD_MEM)
+        return SimVmeDevice::readBlock (offset, buf, n, got, fifo);
+
+    // the FIFO is mapped to the whole data window, so the address increment does not matter
+    *got = 0;
+    while (*got < n) {
+        if (fifo_.empty ())
+            return SIMVME_BUS_ERROR;
+        buf [(*got)++] = fifo_.front ();
+        fifo_.pop_front ();
+    }
+    return 0;
+}
+
+bool SimMadc32::irqPending (int *level, uint8_t *vector)
+{
+    *level = reg (MADC32V2_IRQ_LEVEL) & 0x7;
+    *vector = reg (MADC32V2_IRQ_VECTOR) & 0xFF;
+    return *level && !irqAcked_ && fifo_.size () > reg (MADC32V2_IRQ_THRESHOLD);
+}
+
+int SimMadc32::chainAddress () const
+{
+    return cbltEnabled_ ? static_cast<int> (reg (MADC32V2_CBLT_ADDRESS) & 0xFF) : -1;
+}
+
+uint32_t SimMadc32::readChained (uint32_t *buf, uint32_t n)
+{
+    uint32_t cnt = 0;
+
+    // only complete events are transferred, fill words are passed on one by one
+    while (!fifo_.empty ()) {
+        uint32_t w = fifo_.front ();
+        uint32_t len = ((w >> MADC32V2_OFF_DATA_SIG) == 0x1) ? (w & 0xFFF) + 1 : 1;
+        if (cnt + len > n)
+            break;
+        for (uint32_t i = 0; i < len; ++i) {
+            buf [cnt++] = fifo_.front ();
+            fifo_.pop_front ();
+        }
+    }
+    return cnt;
+}
+
+void SimMadc32::trigger (uint64_t time)
+{
+    if (!running_)
+        return;
+
+    bool single = (reg (MADC32V2_MULTIEVENT_MODE) & 0x3) == 0;
+    if (single && blocked_) {
+        ++lost_;
+        return;
+    }
+
+    uint32_t modid = reg (MADC32V2_MODULE_ID) & 0xFF;
+    if (modid == 0xFF)
+        modid = (getBaseAddress () >> 24) & 0xFF;
+    uint32_t res = reg (MADC32V2_ADC_RESOLUTION) & 0x7;
+    uint32_t range = (res == 0) ? 2048 : (res <= 2) ? 4096 : 8192;
+
+    uint32_t data [MADC32V2_LEN_EVENT_MAX + 1];
+    int count = 1;
+    for (int ch = 0; ch < MADC32V2_NUM_CHANNELS; ++ch) {
+        uint32_t thr = reg (MADC32V2_THRESHOLD_MEM + 2 * ch) & 0x1FFF;
+        if (thr == MADC32V2_VAL_THRESHOLD_SWITCH_OFF || rng_.uniform () >= 0.3)
+            continue;
+        uint32_t v = static_cast<uint32_t> (amplitude (rng_, ch, 0.9 * range));
+        if (v < thr)
+            continue;
+        uint32_t over = v >= range;
+        data [count++] = (0x20 << 21) | (ch << 16) | (over << 14) | (over ? range - 1 : v);
+    }
+
+    uint32_t marker = (reg (MADC32V2_MARKING_TYPE) & 0x3) == 1 ? time * 2 / 125 : evcnt_;
+    data [0] = (0x1 << 30) | (modid << 16) | (res << 12) | count;
+    data [count++] = (0x3 << 30) | (marker & 0x3FFFFFFF);
+
+    // in 64 bit mode, events are padded to an even number of words
+    if ((reg (MADC32V2_DATA_LENGTH_FORMAT) & 0x3) == 3 && (count & 1))
+        data [count++] = 0;
+
+    if (fifo_.size () + count > MADC32V2_LEN_BUFFER_MAX) {
+        ++lost_;
+        return;
+    }
+
+    fifo_.insert (fifo_.end (), data, data + count);
+    ++evcnt_;
+    ++accepted_;
+    if (single)
+        blocked_ = true;
+}
+
+SimCaen1290::SimCaen1290 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x10000, slot, seed)
+{
+    // board id as checked by Caen1290Module::isCorrectModule: version | board number << 16
+    if (type == "caen1290n") {
+        channels_ = 16;
+        hires_ = true;
+        boardId_ = 2ULL | (0x0AULL << 16) | (0x05ULL << 32);
+    } else if (type == "caen1190a") {
+        channels_ = 128;
+        hires_ = false;
+        boardId_ = 0ULL | (0xA6ULL << 16) | (0x04ULL << 32);
+    } else if (type == "caen1190b") {
+        channels_ = 64;
+        hires_ = false;
+        boardId_ = 1ULL | (0xA6ULL << 16) | (0x04ULL << 32);
+    } else {
+        channels_ = 32;
+        hires_ = true;
+        boardId_ = 0ULL | (0x0AULL << 16) | (0x05ULL << 32);
+    }
+    reset ();
+}
+
+void SimCaen1290::reset ()
+{
+    SimVmeDevice::reset ();
+    meb_.clear ();
+    evcnt_ = 0;
+    events_ = 0;
+
+    regs_ [CAEN1290_GEO_ADDR] = slot_ & 0x1F;
+    regs_ [CAEN1290_CROM_BASE + 0x2C] = 0xE6;
+    regs_ [CAEN1290_CROM_BASE + 0x28] = 0x40;
+    regs_ [CAEN1290_CROM_BASE + 0x24] = 0x00;
+    regs_ [CAEN1290_CROM_BASE + 0x30] = boardId_ & 0xFFFF;
+    regs_ [CAEN1290_CROM_BASE + 0x3C] = (boardId_ >> 16) & 0xFFFF;
+    regs_ [CAEN1290_CROM_BASE + 0x38] = (boardId_ >> 32) & 0xFFFF;
+    regs_ [CAEN1290_CROM_BASE + 0x34] = (boardId_ >> 48) & 0xFFFF;
+}
+
+int SimCaen1290::read16 (uint32_t offset, uint16_t *data)
+{
+    switch (offset) {
+    case CAEN1290_STATUS:
+        *data = (events_ ? (1 << CAEN1290_STA_DREADY) : 0) |
+                (meb_.size () >= 32768 ? (1 << CAEN1290_STA_FULL) : 0) |
+                (hires_ ? 0 : (1 << CAEN1290_STA_RES_0));
+        return 0;
+    case CAEN1290_MICRO_HS:
+        *data = (1 << CAEN1290_MCH_WRITE_OK) | (1 << CAEN1290_MCH_READ_OK);
+        return 0;
+    case CAEN1290_EVSTOR:
+        *data = events_;
+        return 0;
+    default:
+        return SimVmeDevice::read16 (offset, data);
+    }
+}
+
+int SimCaen1290::read32 (uint32_t offset, uint32_t *data)
+{
+    if (offset == CAEN1290_EVCNT) {
+        *data = evcnt_;
+        return 0;
+    }
+
+    if (offset >= CAEN1290_CONTROL) {
+        uint16_t d;
+        int ret = read16 (offset, &d);
+        *data = d;
+        return ret;
+    }
+
+    if (takeWord (data))
+        return 0;
+    if (reg (CAEN1290_CONTROL) & (1 << CAEN1290_CTL_BERREN))
+        return SIMVME_BUS_ERROR;
+    *data = 0x18 << 27;
+    return 0;
+}
+
+int SimCaen1290::write16 (uint32_t offset, uint16_t data)
+{
+    switch (offset) {
+    case CAEN1290_RESET:
+        reset ();
+        return 0;
+    case CAEN1290_SCLR:
+        meb_.clear ();
+        events_ = 0;
+        evcnt_ = 0;
+        return 0;
+    case CAEN1290_SEVRESET:
+        evcnt_ = 0;
+        return 0;
+    case CAEN1290_STRIG:
+        trigger (now_);
+        return 0;
+    case CAEN1290_MICRO: // opcodes are accepted and ignored
+        return 0;
+    default:
+        return SimVmeDevice::write16 (offset, data);
+    }
+}
+
+int SimCaen1290::readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo)
+{
+    if (offset >= CAEN1290_CONTROL)
+        return SimVmeDevice::readBlock (offset, buf, n, got, fifo);
+
+    bool berr = reg (CAEN1290_CONTROL) & (1 << CAEN1290_CTL_BERREN);
+    uint32_t maxEvents = reg (CAEN1290_BLT_EVNR) & 0xFF;
+    uint32_t nofEvents = 0;
+
+    *got = 0;
+    while (*got < n) {
+        uint32_t w;
+        if ((maxEvents && nofEvents == maxEvents) || !takeWord (&w)) {
+            if (berr)
+                return SIMVME_BUS_ERROR;
+            w = 0x18 << 27;
+        } else if (((w >> 27) & 0x1F) == 0x10) {
+            ++nofEvents;
+        }
+        buf [(*got)++] = w;
+    }
+    return 0;
+}
+
+bool SimCaen1290::takeWord (uint32_t *w)
+{
+    if (meb_.empty ())
+        return false;
+    *w = meb_.front ();
+    meb_.pop_front ();
+    if (((*w >> 27) & 0x1F) == 0x10)
+        --events_;
+    return true;
+}
+
+void SimCaen1290::trigger (uint64_t)
+{
+    if (meb_.size () + 2 * channels_ + 2 > 32768) {
+        ++lost_;
+        return;
+    }
+
+    uint32_t geo = reg (CAEN1290_GEO_ADDR) & 0x1F;
+    int chShift = hires_ ? 21 : 19;
+    uint32_t mask = (1 << chShift) - 1;
+    uint32_t count = 2;
+
+    meb_.push_back ((0x08 << 27) | ((evcnt_ & 0x3FFFFF) << 5) | geo);
+    for (int ch = 0; ch < channels_; ++ch) {
+        if (rng_.uniform () >= 0.1)
+            continue;
+        int hits = rng_.uniform () < 0.8 ? 1 : 2;
+        for (int h = 0; h < hits; ++h) {
+            double t = 20000 + 200 * ch + 5000 * h + 40 * rng_.gauss ();
+            if (!hires_)
+                t /= 4;
+            meb_.push_back ((ch << chShift) | (static_cast<uint32_t> (t) & mask));
+            ++count;
+        }
+    }
+    meb_.push_back ((0x10 << 27) | ((count & 0xFFFF) << 5) | geo);
+
+    ++evcnt_;
+    ++events_;
+    ++accepted_;
+}
+
+SimCaen820::SimCaen820 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x10000, slot, seed)
+{
+    reset ();
+}
+
+void SimCaen820::reset ()
+{
+    SimVmeDevice::reset ();
+    meb_.clear ();
+    evlen_.clear ();
+    readPos_ = 0;
+    trgcnt_ = 0;
+    std::fill (counters_, counters_ + 32, 0);
+    std::fill (fraction_, fraction_ + 32, 0.);
+    lastTime_ = now_;
+
+    regs_ [CAEN820_GEO] = slot_ & 0x1F;
+    regs_ [CAEN820_FIRMWARE] = 0x0101;
+}
+
+void SimCaen820::update (uint64_t time)
+{
+    SimVmeDevice::update (time);
+    if (time <= lastTime_)
+        return;
+
+    // channel n counts at n+1 kHz
+    double dt = (time - lastTime_) * 1e-9;
+    lastTime_ = time;
+    for (int ch = 0; ch < 32; ++ch) {
+        double mean = (ch + 1) * 1000. * dt;
+        double x = fraction_ [ch];
+        if (mean < 20) {
+            double l = std::exp (-mean);
+            double p = rng_.uniform ();
+            while (p > l) {
+                x += 1;
+                p *= rng_.uniform ();
+            }
+        } else {
+            x += mean + std::sqrt (mean) * rng_.gauss ();
+            if (x < 0)
+                x = 0;
+        }
+        uint32_t n = static_cast<uint32_t> (x);
+        fraction_ [ch] = x - n;
+        counters_ [ch] += n;
+    }
+}
+
+int SimCaen820::read16 (uint32_t offset, uint16_t *data)
+{
+    switch (offset) {
+    case CAEN820_STATUS:
+        *data = (evlen_.empty () ? 0 : (1 << CAEN820_STA_DREADY)) |
+                (meb_.size () + 33 > 32768 ? (1 << CAEN820_STA_FULL) : 0);
+        return 0;
+    case CAEN820_MEB_EV_NUM:
+        *data = evlen_.size ();
+        return 0;
+    default:
+        return SimVmeDevice::read16 (offset, data);
+    }
+}
+
+int SimCaen820::read32 (uint32_t offset, uint32_t *data)
+{
+    if (offset >= CAEN820_CTR00 && offset <= CAEN820_CTR31) {
+        *data = counters_ [(offset - CAEN820_CTR00) / 4];
+        return 0;
+    }
+    if (offset == CAEN820_TRIG_CNT) {
+        *data = trgcnt_;
+        return 0;
+    }
+    if (offset >= CAEN820_CTR00)
+        return SimVmeDevice::read32 (offset, data);
+
+    if (takeWord (data))
+        return 0;
+    if (reg (CAEN820_CONTROL) & (1 << CAEN820_CTL_BERREN))
+        return SIMVME_BUS_ERROR;
+    *data = 0;
+    return 0;
+}
+
+int SimCaen820::write16 (uint32_t offset, uint16_t data)
+{
+    switch (offset) {
+    case CAEN820_CTL_BS:
+        regs_ [CAEN820_CONTROL] = reg (CAEN820_CONTROL) | data;
+        return 0;
+    case CAEN820_CTL_BC:
+        regs_ [CAEN820_CONTROL] = reg (CAEN820_CONTROL) & ~data;
+        return 0;
+    case CAEN820_SRESET:
+        reset ();
+        return 0;
+    case CAEN820_SCLR:
+        meb_.clear ();
+        evlen_.clear ();
+        readPos_ = 0;
+        trgcnt_ = 0;
+        std::fill (counters_, counters_ + 32, 0);
+        return 0;
+    case CAEN820_STRIG:
+        trigger (now_);
+        return 0;
+    default:
+        return SimVmeDevice::write16 (offset, data);
+    }
+}
+
+int SimCaen820::readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo)
+{
+    if (offset >= CAEN820_CTR00)
+        return SimVmeDevice::readBlock (offset, buf, n, got, fifo);
+
+    bool berr = reg (CAEN820_CONTROL) & (1 << CAEN820_CTL_BERREN);
+
+    *got = 0;
+    while (*got < n) {
+        uint32_t w;
+        if (!takeWord (&w)) {
+            if (berr)
+                return SIMVME_BUS_ERROR;
+            w = 0;
+        }
+        buf [(*got)++] = w;
+    }
+    return 0;
+}
+
+bool SimCaen820::takeWord (uint32_t *w)
+{
+    if (meb_.empty ())
+        return false;
+    *w = meb_.front ();
+    meb_.pop_front ();
+    if (++readPos_ >= evlen_.front ()) {
+        evlen_.pop_front ();
+        readPos_ = 0;
+    }
+    return true;
+}
+
+void SimCaen820::trigger (uint64_t time)
+{
+    uint32_t ctl = reg (CAEN820_CONTROL);
+    if ((ctl & 0x3) == 0)
+        return;
+    if (meb_.size () + 33 > 32768) {
+        ++lost_;
+        return;
+    }
+
+    update (time);
+
+    uint32_t enabled = reg (CAEN820_CH_EN);
+    uint32_t nofChannels = 0;
+    for (int ch = 0; ch < 32; ++ch)
+        if (enabled & (1 << ch))
+            ++nofChannels;
+
+    int len = nofChannels;
+    if (ctl & (1 << CAEN820_CTL_HDREN)) {
+        uint32_t geo = reg (CAEN820_GEO) & 0x1F;
+        meb_.push_back ((geo << 27) | (1 << 26) | (nofChannels << 18) | (trgcnt_ & 0xFFFF));
+        ++len;
+    }
+    for (int ch = 0; ch < 32; ++ch) {
+        if (!(enabled & (1 << ch)))
+            continue;
+        if (ctl & (1 << CAEN820_CTL_DFMT))
+            meb_.push_back ((ch << 27) | (counters_ [ch] & 0x3FFFFFF));
+        else
+            meb_.push_back (counters_ [ch]);
+    }
+    if (len)
+        evlen_.push_back (len);
+
+    if (ctl & (1 << CAEN820_CTL_AUTORST))
+        std::fill (counters_, counters_ + 32, 0);
+
+    ++trgcnt_;
+    ++accepted_;
+}
+
+// wrap sizes of the SIS3302 event configuration, in samples
+static const uint32_t sis3302WrapSizes [16] = {
+    0x1000000, 0x400000, 0x100000, 0x40000, 0x10000, 0x4000, 0x1000, 0x400,
+    512, 256, 128, 64, 64, 64, 64, 64
+};
+
+SimSis3302::SimSis3302 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x08000000, slot, seed)
+    , trace_ (seed, 8000, 40000, 4, 0xFFFF)
+{
+    reset ();
+}
+
+void SimSis3302::reset ()
+{
+    SimVmeDevice::reset ();
+    acqctrl_ = 0;
+    armed_ = false;
+    sampling_ = false;
+    evcnt_ = 0;
+    timestamps_.clear ();
+    tsOffset_ = now_;
+
+    regs_ [SIS3302_MODID] = 0x33021205;
+}
+
+uint32_t SimSis3302::eventStride () const
+{
+    uint32_t cfg = reg (SIS3302_EVENT_CONFIG_ALL_ADC);
+    if (cfg & EVENT_CONF_ENABLE_WRAP_PAGE_MODE)
+        return sis3302WrapSizes [cfg & 0xF];
+    return (reg (SIS3302_SAMPLE_LENGTH_ALL_ADC) & 0xFFFFFC) + 4;
+}
+
+uint32_t SimSis3302::stopOffset (uint32_t ev) const
+{
+    // in wrap mode the trigger stops the sampling anywhere in the page
+    if (!(reg (SIS3302_EVENT_CONFIG_ALL_ADC) & EVENT_CONF_ENABLE_WRAP_PAGE_MODE))
+        return 0;
+    return (SimVmeRandom::hash (seed_, ev) % eventStride ()) & ~0x3U;
+}
+
+uint32_t SimSis3302::sample (int ch, uint32_t addr) const
+{
+    uint32_t stride = eventStride ();
+    uint32_t ev = addr / stride;
+    if (ev >= evcnt_)
+        return 0;
+
+    // the oldest sample of a wrapped event is found at the stop address
+    uint32_t pos = (addr % stride + stride - stopOffset (ev)) % stride;
+    return std::min (trace_.sample (ev, ch, pos, stride) + 100 * ch, 0xFFFFU);
+}
+
+int SimSis3302::read32 (uint32_t offset, uint32_t *data)
+{
+    if (offset == SIS3302_ACQUISITION_CONTROL) {
+        *data = acqctrl_ | (armed_ ? 0x10000 : 0) | (sampling_ ? 0x20000 : 0);
+        return 0;
+    }
+    if (offset == SIS3302_ACTUAL_EVENT_COUNTER) {
+        *data = evcnt_;
+        return 0;
+    }
+    if (offset == SIS3302_DAC_CONTROL_STATUS) {
+        *data = reg (offset) & ~0x8000; // never busy
+        return 0;
+    }
+
+    if (offset >= SIS3302_TIMESTAMP_DIRECTORY && offset < SIS3302_TIMESTAMP_DIRECTORY + 0x1000) {
+        uint32_t idx = (offset - SIS3302_TIMESTAMP_DIRECTORY) / 4;
+        uint64_t ts = (idx / 2 < static_cast<uint32_t> (timestamps_.size ())) ? timestamps_.at (idx / 2) : 0;
+        *data = (idx & 1) ? (ts & 0xFFFFFFFF) : ((ts >> 32) & 0xFFFF);
+        return 0;
+    }
+
+    if (offset >= SIS3302_ACTUAL_SAMPLE_ADDRESS_ADC1 && offset < SIS3302_ADC1_OFFSET) {
+        uint32_t rel = (offset - SIS3302_ACTUAL_SAMPLE_ADDRESS_ADC1) % SIS3302_NEXT_ADC_OFFSET;
+        if (rel == 0 || rel == 4) {
+            *data = evcnt_ * eventStride ();
+            return 0;
+        }
+        // event directories: 512 entries per ADC
+        uint32_t dir = (offset - SIS3302_EVENT_DIRECTORY_ADC1) % SIS3302_NEXT_ADC_OFFSET;
+        if (offset >= SIS3302_EVENT_DIRECTORY_ADC1 && dir < 0x10000 && dir % 0x8000 < 0x800) {
+            uint32_t ev = (dir % 0x8000) / 4;
+            *data = 0;
+            if (ev < evcnt_) {
+                bool wrap = reg (SIS3302_EVENT_CONFIG_ALL_ADC) & EVENT_CONF_ENABLE_WRAP_PAGE_MODE;
+                *data = ((ev * eventStride () + stopOffset (ev)) & 0x1FFFFFF) | (wrap ? (1 << 28) : 0) | (1 << 29);
+            }
+            return 0;
+        }
+    }
+
+    if (offset >= SIS3302_ADC1_OFFSET) {
+        int ch = (offset - SIS3302_ADC1_OFFSET) / SIS3302_NEXT_ADC_OFFSET;
+        uint32_t addr = (reg (SIS3302_ADC_MEMORY_PAGE_REGISTER) & 0x7) * 0x400000
+                      + (offset & (SIS3302_NEXT_ADC_OFFSET - 1)) / 2;
+        *data = (sample (ch, addr) << 16) | sample (ch, addr + 1);
+        return 0;
+    }
+
+    return SimVmeDevice::read32 (offset, data);
+}
+
+int SimSis3302::write32 (uint32_t offset, uint32_t data)
+{
+    switch (offset) {
+    case SIS3302_ACQUISITION_CONTROL: // J/K register: the upper half clears the bits
+        acqctrl_ = (acqctrl_ | (data & 0xFFFF)) & ~(data >> 16);
+        return 0;
+    case SIS3302_KEY_RESET:
+        reset ();
+        return 0;
+    case SIS3302_KEY_ARM:
+        armed_ = true;
+        sampling_ = acqctrl_ & SIS3302_ACQ_ENABLE_AUTOSTART;
+        evcnt_ = 0;
+        timestamps_.clear ();
+        return 0;
+    case SIS3302_KEY_DISARM:
+        armed_ = false;
+        sampling_ = false;
+        return 0;
+    case SIS3302_KEY_START:
+        sampling_ = armed_;
+        return 0;
+    case SIS3302_KEY_STOP:
+        if (sampling_)
+            trigger (now_);
+        return 0;
+    case SIS3302_KEY_TIMESTAMP_CLEAR:
+        tsOffset_ = now_;
+        return 0;
+    case SIS3302_KEY_RESET_DDR2_LOGIC:
+        return 0;
+    default:
+        return SimVmeDevice::write32 (offset, data);
+    }
+}
+
+void SimSis3302::trigger (uint64_t time)
+{
+    if (!armed_ || !sampling_) {
+        ++lost_;
+        return;
+    }
+
+    timestamps_.push_back (time > tsOffset_ ? (time - tsOffset_) / 10 : 0); // 100 MHz clock
+    ++evcnt_;
+    ++accepted_;
+
+    uint32_t maxEvents = reg (SIS3302_MAX_NOF_EVENT) & 0xFFFFF;
+    if (!(acqctrl_ & SIS3302_ACQ_ENABLE_MULTIEVENT) || evcnt_ >= maxEvents) {
+        armed_ = false;
+        sampling_ = false;
+    } else {
+        sampling_ = acqctrl_ & SIS3302_ACQ_ENABLE_AUTOSTART;
+    }
+}
+
+SimSis3350::SimSis3350 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed)
+    : SimVmeDevice (type, baseAddr, 0x08000000, slot, seed)
+    , trace_ (seed, 400, 3000, 1.5, 0xFFF)
+{
+    reset ();
+}
+
+void SimSis3350::reset ()
+{
+    SimVmeDevice::reset ();
+    acqctrl_ = 0;
+    armed_ = false;
+    endAddress_ = false;
+    evcnt_ = 0;
+    timestamps_.clear ();
+    tsOffset_ = now_;
+
+    regs_ [SIS3350_MODID] = 0x33501404;
+}
+
+uint32_t SimSis3350::sampleLength () const
+{
+    // modes 2 to 5 are the direct memory modes
+    uint32_t len = ((acqctrl_ & 0x7) >= 2) ? reg (SIS3350_DIRECT_MEMORY_SAMPLE_LENGTH)
+                                           : reg (SIS3350_RINGBUFFER_SAMPLE_LENGTH_ALL_ADC);
+    len &= 0x07FFFFF8;
+    return len ? len : 8;
+}
+
+uint32_t SimSis3350::memoryWord (int ch, uint32_t word) const
+{
+    uint32_t len = sampleLength ();
+    uint32_t evlen = len / 2 + 4;
+    uint32_t ev = word / evlen;
+    if (ev >= evcnt_)
+        return 0;
+
+    uint64_t ts = timestamps_.at (ev);
+    uint32_t w = word % evlen;
+    switch (w) {
+    case 0: return (((ts >> 36) & 0xFFF) << 16) | ((ts >> 24) & 0xFFF);
+    case 1: return (((ts >> 12) & 0xFFF) << 16) | (ts & 0xFFF);
+    case 2: return ((ev & 0xF) << 20) | ((len >> 24) & 0xFFF);
+    case 3: return (((len >> 12) & 0xFFF) << 16) | (len & 0xFFF);
+    default:
+        break;
+    }
+
+    uint32_t s = 2 * (w - 4);
+    uint32_t s0 = std::min (trace_.sample (ev, ch, s, len) + 20 * ch, 0xFFFU);
+    uint32_t s1 = std::min (trace_.sample (ev, ch, s + 1, len) + 20 * ch, 0xFFFU);
+    return s0 | (s1 << 16);
+}
+
+int SimSis3350::read32 (uint32_t offset, uint32_t *data)
+{
+    switch (offset) {
+    case SIS3350_ACQUISITION_CONTROL:
+        *data = acqctrl_ | (armed_ ? SIS3350_ACQ_STATUS_ARMED_FLAG : 0)
+                         | (endAddress_ ? SIS3350_ACQ_STATUS_END_ADDRESS_FLAG : 0);
+        return 0;
+    case SIS3350_MULTIEVENT_EVENT_COUNTER:
+        *data = evcnt_;
+        return 0;
+    case SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC1:
+    case SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC2:
+    case SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC3:
+    case SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC4:
+        *data = evcnt_ * (sampleLength () + 8);
+        return 0;
+    default:
+        break;
+    }
+
+    if (offset >= SIS3350_ADC1_OFFSET) {
+        int ch = (offset - SIS3350_ADC1_OFFSET) / SIS3350_NEXT_ADC_OFFSET;
+        uint32_t word = (reg (SIS3350_ADC_MEMORY_PAGE_REGISTER) & 0xF) * 0x400000
+                      + (offset & (SIS3350_NEXT_ADC_OFFSET - 1)) / 4;
+        *data = memoryWord (ch, word);
+        return 0;
+    }
+
+    return SimVmeDevice::read32 (offset, data);
+}
+
+int SimSis3350::write32 (uint32_t offset, uint32_t data)
+{
+    switch (offset) {
+    case SIS3350_ACQUISITION_CONTROL: // J/K register: the upper half clears the bits
+        acqctrl_ = (acqctrl_ | (data & 0xFFFF)) & ~(data >> 16);
+        return 0;
+    case SIS3350_KEY_RESET:
+        reset ();
+        return 0;
+    case SIS3350_KEY_ARM:
+        armed_ = true;
+        endAddress_ = false;
+        evcnt_ = 0;
+        timestamps_.clear ();
+        return 0;
+    case SIS3350_KEY_DISARM:
+        armed_ = false;
+        return 0;
+    case SIS3350_KEY_TRIGGER:
+        trigger (now_);
+        return 0;
+    case SIS3350_KEY_TIMESTAMP_CLR:
+        tsOffset_ = now_;
+        return 0;
+    default:
+        return SimVmeDevice::write32 (offset, data);
+    }
+}
+
+void SimSis3350::trigger (uint64_t time)
+{
+    if (!armed_) {
+        ++lost_;
+        return;
+    }
+
+    timestamps_.push_back (time > tsOffset_ ? (time - tsOffset_) / 2 : 0); // 500 MHz clock
+    ++evcnt_;
+    ++accepted_;
+
+    uint32_t maxEvents = reg (SIS3350_MULTIEVENT_MAX_NOF_EVENTS);
+    if (!(acqctrl_ & SIS3350_ACQ_ENABLE_MULTIEVENT) || evcnt_ >= maxEvents) {
+        armed_ = false;
+        endAddress_ = true;
+    }
+}
@@ -0,0 +1,377 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIMVMEDEVICE_H
+#define SIMVMEDEVICE_H
+
+#include <stdint.h>
+#include <deque>
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+/*! Error code of a simulated bus error. Same value as the SIS3100 driver uses. */
+#define SIMVME_BUS_ERROR 0x211
+
+/*! Small, fast and seedable random number generator (xorshift64*) used by the simulated VME devices.
+ *  The generator is deterministic, so a given seed reproduces the same data in every run.
+ */
+class SimVmeRandom
+{
+public:
+    explicit SimVmeRandom (uint64_t seed = 1) { setSeed (seed); }
+
+    void setSeed (uint64_t seed);
+    uint64_t next ();
+    /*! uniformly distributed in [0,1) */
+    double uniform () { return (next () >> 11) * (1.0 / 9007199254740992.0); }
+    /*! normally distributed with mean 0 and sigma 1 */
+    double gauss ();
+    /*! exponentially distributed with the given mean */
+    double exponential (double mean);
+
+    /*! Stateless hash of up to four values. Used to generate data that is addressed randomly (digitizer memories). */
+    static uint64_t hash (uint64_t a, uint64_t b = 0, uint64_t c = 0, uint64_t d = 0);
+
+private:
+    uint64_t state_;
+    bool haveSpare_;
+    double spare_;
+};
+
+/*! Base class of all simulated VME modules.
+ *  A device occupies an address window starting at its base address. Accesses inside the window are passed to the
+ *  device with the offset relative to the base address. The default implementation is a plain register file:
+ *  Writes store the value, reads return the last value written (0 if there was none).
+ *  Subclasses override the accessors for registers with side effects, eg. a data buffer or key registers.
+ *
+ *  Triggers are generated by the SimVmeModule and passed to every device via #trigger. A device accepts a trigger
+ *  if it is ready, otherwise the trigger is lost (the module is busy). The counts are available for deadtime studies.
+ *
+ *  All accessors return 0 on success and SIMVME_BUS_ERROR if the module would terminate the cycle with a bus error.
+ */
+class SimVmeDevice
+{
+public:
+    SimVmeDevice (const QString &type, uint32_t baseAddr, uint32_t windowSize, int slot, uint64_t seed);
+    virtual ~SimVmeDevice () {}
+
+    /*! Create a device model for the given module type name (as registered with the ModuleRegistrar).
+     *  Returns NULL if there is no model for this type.
+     */
+    static SimVmeDevice *create (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    const QString &getTypeName () const { return type_; }
+    uint32_t getBaseAddress () const { return base_; }
+    bool contains (uint32_t addr) const { return addr - base_ < size_; }
+
+    /*! Bring the device into its power-up state. */
+    virtual void reset ();
+
+    /*! Pass a trigger to the device. Triggers arriving within \c conversion ns after an accepted trigger are lost,
+     *  all others are handed to #trigger.
+     */
+    void handleTrigger (uint64_t time, uint32_t conversion);
+
+    /*! Called before every access with the current time in ns, eg. for free running counters. */
+    virtual void update (uint64_t time) { now_ = time; }
+
+    virtual int read16 (uint32_t offset, uint16_t *data);
+    virtual int read32 (uint32_t offset, uint32_t *data);
+    virtual int write16 (uint32_t offset, uint16_t data);
+    virtual int write32 (uint32_t offset, uint32_t data);
+
+    /*! Read \c n words. With \c fifo, all words are read from \c offset, otherwise the offset is incremented after
+     *  each word. The default implementation performs single reads and stops at the first bus error.
+     */
+    virtual int readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo);
+
+    /*! Returns the CBLT address (A31..A24) if the device takes part in a chained block transfer, -1 otherwise. */
+    virtual int chainAddress () const { return -1; }
+    /*! Hand the data of this device to a chained block transfer. Returns the number of words written to \c buf. */
+    virtual uint32_t readChained (uint32_t *, uint32_t) { return 0; }
+
+    /*! Returns whether the device requests a VME interrupt, and with which level and status/ID vector. */
+    virtual bool irqPending (int *, uint8_t *) { return false; }
+    /*! Called when an interrupt acknowledge cycle has read the vector of this device. */
+    virtual void irqAcknowledge () {}
+
+    uint64_t getAcceptedTriggers () const { return accepted_; }
+    uint64_t getLostTriggers () const { return lost_; }
+
+    /*! Pulse height following a typical gamma spectrum: two peaks on an exponential background. */
+    static double amplitude (SimVmeRandom &rng, int ch, double range);
+
+protected:
+    /*! Called for every trigger the device is not busy for. \c time is the trigger time in ns.
+     *  Implementations increment #accepted_ or #lost_.
+     */
+    virtual void trigger (uint64_t time) = 0;
+
+    uint32_t reg (uint32_t offset) const { return regs_.value (offset); }
+
+protected:
+    QMap<uint32_t, uint32_t> regs_;
+    SimVmeRandom rng_;
+    int slot_;
+    uint64_t seed_;
+    uint64_t accepted_;
+    uint64_t lost_;
+    uint64_t now_;
+
+private:
+    QString type_;
+    uint64_t busyUntil_;
+    uint32_t base_;
+    uint32_t size_;
+};
+
+/*! Digitizer traces computed on access: a baseline with noise and one pulse per event and channel.
+ *  Every sample only depends on the seed, the event, the channel and the position in the trace,
+ *  so the models need not store their sample memories.
+ */
+class SimVmeTrace
+{
+public:
+    SimVmeTrace (uint64_t seed, double baseline, double range, double noise, uint32_t maxValue);
+
+    /*! Sample \c pos of the trace with \c length samples. The pulse starts after the first quarter of the trace. */
+    uint32_t sample (uint32_t ev, int ch, uint32_t pos, uint32_t length) const;
+
+private:
+    uint64_t seed_;
+    double baseline_;
+    double range_;
+    double noise_;
+    uint32_t maxValue_;
+
+    // pulse height of the last trace accessed
+    mutable uint32_t cacheEv_;
+    mutable int cacheCh_;
+    mutable double cacheAmp_;
+};
+
+/*! CAEN V785 peak sensing ADC, V792 QDC, V775 TDC and V965 dual range QDC.
+ *  The multi event buffer holds 32 events. A full buffer keeps the module busy and further triggers are lost.
+ *  Reading an empty buffer causes a bus error if enabled in control register 1, otherwise it returns invalid data words.
+ *  The interrupt is requested while the buffer holds at least as many events as set in the event trigger register.
+ */
+class SimCaenAdc : public SimVmeDevice
+{
+public:
+    enum Model { V785, V792, V775, V965 };
+
+    SimCaenAdc (const QString &type, Model model, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read16 (uint32_t offset, uint16_t *data);
+    int read32 (uint32_t offset, uint32_t *data);
+    int write16 (uint32_t offset, uint16_t data);
+    int readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo);
+
+    int chainAddress () const;
+    uint32_t readChained (uint32_t *buf, uint32_t n);
+
+    bool irqPending (int *level, uint8_t *vector);
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    bool takeWord (uint32_t *w);
+    uint32_t channelValue (int ch);
+    bool suppressed (int ch, uint32_t value) const;
+
+private:
+    Model model_;
+    std::deque<uint32_t> meb_;
+    int events_;      // events in the buffer
+    uint32_t evcnt_;  // 24 bit event counter
+    uint16_t bitset1_;
+    uint16_t bitset2_;
+};
+
+/*! Mesytec MADC-32 with the 8k words data FIFO.
+ *  In single event mode the module accepts no trigger between an event and the following readout reset.
+ *  In the multi event modes triggers are accepted as long as the event fits into the FIFO.
+ *  The interrupt is released on acknowledge and requested again after the next readout reset.
+ */
+class SimMadc32 : public SimVmeDevice
+{
+public:
+    SimMadc32 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read16 (uint32_t offset, uint16_t *data);
+    int read32 (uint32_t offset, uint32_t *data);
+    int write16 (uint32_t offset, uint16_t data);
+    int readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo);
+
+    int chainAddress () const;
+    uint32_t readChained (uint32_t *buf, uint32_t n);
+
+    bool irqPending (int *level, uint8_t *vector);
+    void irqAcknowledge () { irqAcked_ = true; }
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    uint16_t bufferDataLength () const;
+
+private:
+    std::deque<uint32_t> fifo_;
+    uint32_t evcnt_;     // 30 bit event counter
+    bool running_;
+    bool blocked_;       // single event mode: waiting for the readout reset
+    bool cbltEnabled_;
+    bool irqAcked_;      // waiting for the readout reset
+};
+
+/*! CAEN V1290A/N and V1190A/B multi-hit TDCs.
+ *  The micro controller handshake always reports ready, opcodes are accepted and ignored.
+ */
+class SimCaen1290 : public SimVmeDevice
+{
+public:
+    SimCaen1290 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read16 (uint32_t offset, uint16_t *data);
+    int read32 (uint32_t offset, uint32_t *data);
+    int write16 (uint32_t offset, uint16_t data);
+    int readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo);
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    bool takeWord (uint32_t *w);
+
+private:
+    std::deque<uint32_t> meb_;
+    uint32_t evcnt_;
+    int events_;
+    int channels_;
+    bool hires_;
+    uint64_t boardId_;
+};
+
+/*! CAEN V820 32 channel latching scaler. Counters integrate a channel dependent rate between triggers;
+ *  in trigger mode every trigger latches the enabled counters into the multi event buffer.
+ */
+class SimCaen820 : public SimVmeDevice
+{
+public:
+    SimCaen820 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read16 (uint32_t offset, uint16_t *data);
+    int read32 (uint32_t offset, uint32_t *data);
+    int write16 (uint32_t offset, uint16_t data);
+    int readBlock (uint32_t offset, uint32_t *buf, uint32_t n, uint32_t *got, bool fifo);
+
+    void update (uint64_t time);
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    bool takeWord (uint32_t *w);
+
+private:
+    std::deque<uint32_t> meb_;
+    std::deque<int> evlen_; // length of the stored events
+    int readPos_;           // words already read from the oldest event
+    uint32_t trgcnt_;
+    uint32_t counters_ [32];
+    double fraction_ [32];  // counts not yet registered
+    uint64_t lastTime_;
+};
+
+/*! Struck SIS3302 8 channel 16 bit digitizer (standard firmware).
+ *  The sample memory is not stored: every word is computed from the seed, the event number and the position,
+ *  so memories of any size can be read back consistently. Triggers stop the sampling of the current event
+ *  while the module is armed and sampling.
+ */
+class SimSis3302 : public SimVmeDevice
+{
+public:
+    SimSis3302 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read32 (uint32_t offset, uint32_t *data);
+    int write32 (uint32_t offset, uint32_t data);
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    uint32_t eventStride () const;
+    uint32_t stopOffset (uint32_t ev) const;
+    uint32_t sample (int ch, uint32_t addr) const;
+
+private:
+    SimVmeTrace trace_;
+    uint32_t acqctrl_;
+    bool armed_;
+    bool sampling_;
+    uint32_t evcnt_;
+    QVector<uint64_t> timestamps_;
+    uint64_t tsOffset_;
+};
+
+/*! Struck SIS3350 4 channel 12 bit digitizer in ring buffer and direct memory start modes.
+ *  Events are stored in the sample memory as 4 header words followed by the samples. Like the SIS3302 model,
+ *  the samples are computed on access.
+ */
+class SimSis3350 : public SimVmeDevice
+{
+public:
+    SimSis3350 (const QString &type, uint32_t baseAddr, int slot, uint64_t seed);
+
+    void reset ();
+
+    int read32 (uint32_t offset, uint32_t *data);
+    int write32 (uint32_t offset, uint32_t data);
+
+protected:
+    void trigger (uint64_t time);
+
+private:
+    uint32_t sampleLength () const;
+    uint32_t memoryWord (int ch, uint32_t word) const;
+
+private:
+    SimVmeTrace trace_;
+    uint32_t acqctrl_;
+    bool armed_;
+    bool endAddress_;
+    uint32_t evcnt_;
+    QVector<uint64_t> timestamps_;
+    uint64_t tsOffset_;
+};
+
+#endif // SIMVMEDEVICE_H
@@ -0,0 +1,488 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "simvmemodule.h"
+#include "simvmeui.h"
+#include "interfacemanager.h"
+#include "modulemanager.h"
+#include "abstractmodule.h"
+#include "confmap.h"
+#include "profiler.h"
+
+#include <QSettings>
+#include <iostream>
+#include <time.h>
+
+static InterfaceRegistrar registrar ("simvme", SimVmeModule::create);
+
+SimVmeModule::SimVmeModule (int _id, QString _name)
+    : BaseInterface (_id, _name)
+    , last_ (NULL)
+    , open_ (false)
+    , veto1_ (false)
+    , veto2_ (false)
+    , t0_ (Profiler::now ())
+    , nextTrigger_ (0)
+    , irqLevels_ (0)
+    , irqBlocked_ (0)
+{
+    setUI (new SimVmeUI (this));
+    std::cout << "Instantiated simulated VME interface" << std::endl;
+}
+
+SimVmeModule::~SimVmeModule ()
+{
+    if (isOpen ())
+        close ();
+    clearCrate ();
+}
+
+typedef ConfMap::confmap_t<SimVmeConfig> confmap_t;
+static const confmap_t confmap [] = {
+    confmap_t ("seed", &SimVmeConfig::seed),
+    confmap_t ("trigger_rate", &SimVmeConfig::trigger_rate),
+    confmap_t ("conversion_ns", &SimVmeConfig::conversion_ns),
+    confmap_t ("simulate_latency", &SimVmeConfig::simulate_latency),
+    confmap_t ("single_cycle_ns", &SimVmeConfig::single_cycle_ns),
+    confmap_t ("list_cycle_ns", &SimVmeConfig::list_cycle_ns),
+    confmap_t ("block_setup_ns", &SimVmeConfig::block_setup_ns),
+    confmap_t ("dma32_word_ns", &SimVmeConfig::dma32_word_ns),
+    confmap_t ("blt32_word_ns", &SimVmeConfig::blt32_word_ns),
+    confmap_t ("mblt64_word_ns", &SimVmeConfig::mblt64_word_ns),
+    confmap_t ("twoe_word_ns", &SimVmeConfig::twoe_word_ns)
+};
+
+void SimVmeModule::applySettings (QSettings *s)
+{
+    std::cout << "Applying settings for " << getName ().toStdString () << "... ";
+    s->beginGroup (getName ());
+    ConfMap::apply (s, &conf_, confmap);
+    s->endGroup ();
+
+    getUI ()->applySettings ();
+    std::cout << "done" << std::endl;
+}
+
+void SimVmeModule::saveSettings (QSettings *s)
+{
+    std::cout << "Saving settings for " << getName ().toStdString () << "... ";
+    s->beginGroup (getName ());
+    ConfMap::save (s, &conf_, confmap);
+    s->endGroup ();
+    std::cout << "done" << std::endl;
+}
+
+int SimVmeModule::open ()
+{
+    SimVmeUI* ui = dynamic_cast<SimVmeUI*> (getUI ());
+    QMutexLocker l (&lock_);
+
+    // start from a clean crate, so every run with the same seed produces the same data
+    clearCrate ();
+    triggerRng_.setSeed (conf_.seed);
+    t0_ = Profiler::now ();
+    nextTrigger_ = 0;
+    veto1_ = veto2_ = false;
+    irqLevels_ = irqBlocked_ = 0;
+
+    buildCrate (true);
+    open_ = true;
+
+    ui->outputText (tr ("simulated crate with %1 modules, trigger rate %2 Hz\n").arg (devices_.size ()).arg (conf_.trigger_rate));
+    foreach (SimVmeDevice *d, devices_)
+        ui->outputText (tr ("  %1 at 0x%2\n").arg (d->getTypeName ()).arg (d->getBaseAddress (), 8, 16, QChar ('0')));
+    return 0;
+}
+
+int SimVmeModule::close ()
+{
+    SimVmeUI* ui = dynamic_cast<SimVmeUI*> (getUI ());
+    QMutexLocker l (&lock_);
+
+    clearCrate ();
+    open_ = false;
+    ui->outputText ("closed simulated crate\n");
+    return 0;
+}
+
+int SimVmeModule::setOutput1 (bool enable)
+{
+    QMutexLocker l (&lock_);
+    advance (elapsed ());
+    veto1_ = enable;
+    return 0;
+}
+
+int SimVmeModule::setOutput2 (bool enable)
+{
+    QMutexLocker l (&lock_);
+    advance (elapsed ());
+    veto2_ = enable;
+    return 0;
+}
+
+int SimVmeModule::readA32D32 (const uint32_t addr, uint32_t* data)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start;
+    SimVmeDevice *dev = access (addr, &start);
+    int ret = dev ? dev->read32 (addr - dev->getBaseAddress (), data) : SIMVME_BUS_ERROR;
+    ++stats_.cycles;
+    spend (start, conf_.single_cycle_ns);
+    return ret;
+}
+
+int SimVmeModule::readA32D16 (const uint32_t addr, uint16_t* data)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start;
+    SimVmeDevice *dev = access (addr, &start);
+    int ret = dev ? dev->read16 (addr - dev->getBaseAddress (), data) : SIMVME_BUS_ERROR;
+    ++stats_.cycles;
+    spend (start, conf_.single_cycle_ns);
+    return ret;
+}
+
+int SimVmeModule::writeA32D32 (const uint32_t addr, const uint32_t data)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start;
+    SimVmeDevice *dev = access (addr, &start);
+    int ret = dev ? dev->write32 (addr - dev->getBaseAddress (), data) : SIMVME_BUS_ERROR;
+    ++stats_.cycles;
+    spend (start, conf_.single_cycle_ns);
+    return ret;
+}
+
+int SimVmeModule::writeA32D16 (const uint32_t addr, const uint16_t data)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start;
+    SimVmeDevice *dev = access (addr, &start);
+    int ret = dev ? dev->write16 (addr - dev->getBaseAddress (), data) : SIMVME_BUS_ERROR;
+    ++stats_.cycles;
+    spend (start, conf_.single_cycle_ns);
+    return ret;
+}
+
+int SimVmeModule::executeList (VmeOp* ops, size_t n)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start = elapsed ();
+    int ret = 0;
+
+    advance (start);
+    for (size_t i = 0; i < n; ++i) {
+        VmeOp &op = ops [i];
+        SimVmeDevice *dev = findDevice (op.addr);
+        if (!dev) {
+            op.error = SIMVME_BUS_ERROR;
+        } else {
+            uint32_t offset = op.addr - dev->getBaseAddress ();
+            dev->update (start);
+            switch (op.type) {
+            case VmeOp::ReadD16: {
+                uint16_t d = 0;
+                op.error = dev->read16 (offset, &d);
+                op.data = d;
+                break;
+            }
+            case VmeOp::ReadD32:
+                op.error = dev->read32 (offset, &op.data);
+                break;
+            case VmeOp::WriteD16:
+                op.error = dev->write16 (offset, op.data);
+                break;
+            case VmeOp::WriteD32:
+                op.error = dev->write32 (offset, op.data);
+                break;
+            }
+        }
+        if (op.error && !ret)
+            ret = op.error;
+    }
+
+    // only the first cycle waits for the full round trip, the others follow in the pipeline
+    stats_.cycles += n;
+    if (n)
+        spend (start, conf_.single_cycle_ns + static_cast<uint64_t> (conf_.list_cycle_ns) * (n - 1));
+    return ret;
+}
+
+int SimVmeModule::readA32DMA32 (const uint32_t addr, uint32_t* dma_buffer,
+                                uint32_t request_nof_words, uint32_t* got_nof_words)
+{
+    return blockRead (Dma32, addr, dma_buffer, request_nof_words, got_nof_words);
+}
+
+int SimVmeModule::readA32FIFO (const uint32_t addr, uint32_t* dma_buffer,
+                               uint32_t request_nof_words, uint32_t* got_nof_words)
+{
+    return blockRead (Fifo, addr, dma_buffer, request_nof_words, got_nof_words);
+}
+
+int SimVmeModule::readA32BLT32 (const uint32_t addr, uint32_t* dma_buffer,
+                                uint32_t request_nof_words, uint32_t* got_nof_words)
+{
+    return blockRead (Blt32, addr, dma_buffer, request_nof_words, got_nof_words);
+}
+
+int SimVmeModule::readA32MBLT64 (const uint32_t addr, uint32_t* dma_buffer,
+                                 uint32_t request_nof_words, uint32_t* got_nof_words)
+{
+    return blockRead (Mblt64, addr, dma_buffer, request_nof_words, got_nof_words);
+}
+
+int SimVmeModule::readA322E (const uint32_t addr, uint32_t* dma_buffer,
+                             uint32_t request_nof_words, uint32_t* got_nof_words)
+{
+    return blockRead (TwoE, addr, dma_buffer, request_nof_words, got_nof_words);
+}
+
+int SimVmeModule::enableIrqs (uint8_t levelMask)
+{
+    QMutexLocker l (&lock_);
+    irqLevels_ = levelMask & 0xFE;
+    irqBlocked_ = 0;
+    return 0;
+}
+
+int SimVmeModule::waitForIrq (int timeout, int *level, uint8_t *vector)
+{
+    uint64_t deadline = elapsed () + static_cast<uint64_t> (timeout) * 1000000;
+
+    for (;;) {
+        {
+            QMutexLocker l (&lock_);
+            uint64_t start = elapsed ();
+            advance (start);
+
+            // the highest pending level wins the acknowledge cycle
+            SimVmeDevice *src = NULL;
+            int srcLevel = 0;
+            uint8_t srcVector = 0;
+            foreach (SimVmeDevice *d, devices_) {
+                int lvl;
+                uint8_t vec;
+                if (d->irqPending (&lvl, &vec) && lvl > srcLevel && (irqLevels_ & ~irqBlocked_ & (1 << lvl))) {
+                    src = d;
+                    srcLevel = lvl;
+                    srcVector = vec;
+                }
+            }
+
+            if (src) {
+                src->irqAcknowledge ();
+                irqBlocked_ |= 1 << srcLevel;
+                ++stats_.interrupts;
+                ++stats_.cycles;
+                spend (start, conf_.single_cycle_ns);
+                *level = srcLevel;
+                *vector = srcVector;
+                return 1;
+            }
+            if (start >= deadline)
+                return 0;
+        }
+
+        // sleep like a process waiting for the driver, but wake up often enough to see the next trigger in time
+        struct timespec ts = { 0, 20000 };
+        nanosleep (&ts, NULL);
+    }
+}
+
+int SimVmeModule::acknowledgeIrq (int level)
+{
+    QMutexLocker l (&lock_);
+    irqBlocked_ &= ~(1 << level);
+    return 0;
+}
+
+SimVmeStatistics SimVmeModule::getStatistics () const
+{
+    QMutexLocker l (&lock_);
+    return stats_;
+}
+
+void SimVmeModule::resetStatistics ()
+{
+    QMutexLocker l (&lock_);
+    stats_ = SimVmeStatistics ();
+}
+
+QStringList SimVmeModule::getDeviceStatistics () const
+{
+    QMutexLocker l (&lock_);
+    QStringList lines;
+    foreach (SimVmeDevice *d, devices_)
+        lines << tr ("%1 at 0x%2: %3 triggers accepted, %4 lost")
+                 .arg (d->getTypeName ())
+                 .arg (d->getBaseAddress (), 8, 16, QChar ('0'))
+                 .arg (d->getAcceptedTriggers ())
+                 .arg (d->getLostTriggers ());
+    return lines;
+}
+
+uint64_t SimVmeModule::elapsed () const
+{
+    return Profiler::now () - t0_;
+}
+
+void SimVmeModule::advance (uint64_t now)
+{
+    if (conf_.trigger_rate <= 0) {
+        nextTrigger_ = now;
+        return;
+    }
+
+    // do not replay an arbitrarily long backlog, eg. after the interface sat idle between runs
+    if (now > nextTrigger_ + 1000000000ULL)
+        nextTrigger_ = now - 1000000000ULL;
+
+    double mean = 1e9 / conf_.trigger_rate;
+    while (nextTrigger_ <= now) {
+        if (veto1_ || veto2_) {
+            ++stats_.vetoed;
+        } else {
+            ++stats_.triggers;
+            foreach (SimVmeDevice *d, devices_)
+                d->handleTrigger (nextTrigger_, conf_.conversion_ns);
+        }
+        nextTrigger_ += static_cast<uint64_t> (triggerRng_.exponential (mean)) + 1;
+    }
+}
+
+SimVmeDevice *SimVmeModule::findDevice (uint32_t addr)
+{
+    if (last_ && last_->contains (addr))
+        return last_;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        foreach (SimVmeDevice *d, devices_) {
+            if (d->contains (addr)) {
+                last_ = d;
+                return d;
+            }
+        }
+        // the module may have been added after the crate was built
+        if (pass == 0)
+            buildCrate (false);
+    }
+    return NULL;
+}
+
+void SimVmeModule::buildCrate (bool verbose)
+{
+    uint64_t now = elapsed ();
+
+    foreach (AbstractModule *m, *ModuleManager::ref ().list ()) {
+        if (m->getInterface () != this)
+            continue;
+
+        bool present = false;
+        foreach (SimVmeDevice *d, devices_)
+            if (d->getBaseAddress () == m->getBaseAddress () && d->getTypeName () == m->getTypeName ())
+                present = true;
+        if (present)
+            continue;
+
+        // slots are counted from 2, slot 1 holds the controller
+        SimVmeDevice *d = SimVmeDevice::create (m->getTypeName (), m->getBaseAddress (), devices_.size () + 2, conf_.seed);
+        if (!d) {
+            if (verbose)
+                std::cout << "SimVme: no model for module " << m->getName ().toStdString ()
+                          << " of type " << m->getTypeName ().toStdString () << std::endl;
+            continue;
+        }
+        d->update (now);
+        devices_.push_back (d);
+    }
+}
+
+void SimVmeModule::clearCrate ()
+{
+    qDeleteAll (devices_);
+    devices_.clear ();
+    last_ = NULL;
+}
+
+SimVmeDevice *SimVmeModule::access (uint32_t addr, uint64_t *start)
+{
+    *start = elapsed ();
+    advance (*start);
+
+    SimVmeDevice *dev = findDevice (addr);
+    if (dev)
+        dev->update (*start);
+    return dev;
+}
+
+int SimVmeModule::blockRead (TransferMode mode, uint32_t addr, uint32_t *buf, uint32_t n, uint32_t *got)
+{
+    QMutexLocker l (&lock_);
+    uint64_t start;
+    int ret;
+
+    *got = 0;
+    SimVmeDevice *dev = access (addr, &start);
+    if (dev)
+        ret = dev->readBlock (addr - dev->getBaseAddress (), buf, n, got, mode == Fifo);
+    else
+        ret = chainRead (addr >> 24, buf, n, got);
+
+    uint32_t wordNs = conf_.dma32_word_ns;
+    switch (mode) {
+    case Blt32:  wordNs = conf_.blt32_word_ns; break;
+    case Mblt64: wordNs = conf_.mblt64_word_ns; break;
+    case TwoE:   wordNs = conf_.twoe_word_ns; break;
+    default: break;
+    }
+
+    ++stats_.blockTransfers;
+    stats_.words += *got;
+    spend (start, conf_.block_setup_ns + static_cast<uint64_t> (wordNs) * *got);
+    return ret;
+}
+
+int SimVmeModule::chainRead (int cbltAddr, uint32_t *buf, uint32_t n, uint32_t *got)
+{
+    uint64_t now = elapsed ();
+
+    // the modules answer in crate order, the last one terminates the transfer with a bus error
+    foreach (SimVmeDevice *d, devices_) {
+        if (d->chainAddress () != cbltAddr)
+            continue;
+        d->update (now);
+        *got += d->readChained (buf + *got, n - *got);
+        if (*got == n)
+            return 0;
+    }
+    return SIMVME_BUS_ERROR;
+}
+
+void SimVmeModule::spend (uint64_t start, uint64_t ns)
+{
+    stats_.busTimeNs += ns;
+    if (!conf_.simulate_latency)
+        return;
+
+    uint64_t until = t0_ + start + ns;
+    while (Profiler::now () < until)
+        ;
+}
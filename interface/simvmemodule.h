@@ -0,0 +1,174 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIMVMEMODULE_H
+#define SIMVMEMODULE_H
+
+#include "baseinterface.h"
+#include "simvmedevice.h"
+
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+
+struct SimVmeConfig {
+    uint32_t seed;
+    double trigger_rate;        // Hz, Poisson distributed
+    uint32_t conversion_ns;     // module dead time after an accepted trigger
+    bool simulate_latency;
+    uint32_t single_cycle_ns;   // D16/D32 single cycle
+    uint32_t list_cycle_ns;     // every further cycle of an access list
+    uint32_t block_setup_ns;    // DMA setup of a block transfer
+    uint32_t dma32_word_ns;     // per 32 bit word
+    uint32_t blt32_word_ns;
+    uint32_t mblt64_word_ns;
+    uint32_t twoe_word_ns;
+
+    SimVmeConfig ()
+    : seed (1)
+    , trigger_rate (1000.)
+    , conversion_ns (6000)
+    , simulate_latency (true)
+    , single_cycle_ns (1000)
+    , list_cycle_ns (250)
+    , block_setup_ns (8000)
+    , dma32_word_ns (600)
+    , blt32_word_ns (100)
+    , mblt64_word_ns (50)
+    , twoe_word_ns (25)
+    {}
+};
+
+struct SimVmeStatistics {
+    uint64_t cycles;         // single cycles
+    uint64_t blockTransfers;
+    uint64_t words;          // 32 bit words transferred in block transfers
+    uint64_t busTimeNs;      // simulated bus occupancy
+    uint64_t triggers;       // triggers passed to the modules
+    uint64_t vetoed;         // triggers suppressed by the veto outputs
+    uint64_t interrupts;     // interrupts acknowledged
+
+    SimVmeStatistics ()
+    : cycles (0)
+    , blockTransfers (0)
+    , words (0)
+    , busTimeNs (0)
+    , triggers (0)
+    , vetoed (0)
+    , interrupts (0)
+    {}
+};
+
+class SimVmeUI;
+
+/*! Software VME crate for testing and benchmarking the readout without hardware.
+ *  The crate holds a register model (see SimVmeDevice) for every module that uses this interface.
+ *  The models are created when the interface is opened or when an address is accessed that no model covers yet.
+ *
+ *  Triggers are generated with a configurable rate and distributed to all modules. While output 1 or output 2 is set,
+ *  triggers are vetoed, just like the trigger logic attached to the NIM outputs of the SIS3100.
+ *
+ *  Every access takes the configured time on the simulated bus. With simulate_latency, accesses busy-wait
+ *  until that time has passed, so readout throughput and dead time can be measured as with a real crate.
+ *
+ *  Devices with an interrupt level configured request interrupts like the real modules (see SimVmeDevice::irqPending),
+ *  so interrupt driven readout can be tested as well.
+ */
+class SimVmeModule : public BaseInterface
+{
+    Q_OBJECT
+
+private:
+    SimVmeModule (int _id, QString _name = "Simulated VME");
+
+public:
+    ~SimVmeModule ();
+
+    // Factory method
+    static AbstractInterface *create (int id, const QString &name) {
+        return new SimVmeModule (id, name);
+    }
+
+    void applySettings (QSettings *);
+    void saveSettings (QSettings *);
+
+    bool isOpen () const { return open_; }
+    int open ();
+    int close ();
+
+    int setOutput1 (bool);
+    int setOutput2 (bool);
+
+    // VME access
+    int readA32D32 (const uint32_t addr, uint32_t* data);
+    int readA32D16 (const uint32_t addr, uint16_t* data);
+    int readA32DMA32 (const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
+    int readA32FIFO (const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
+    int readA32BLT32 (const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
+    int readA32MBLT64 (const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
+    int readA322E (const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
+    int writeA32D32 (const uint32_t addr, const uint32_t data);
+    int writeA32D16 (const uint32_t addr, const uint16_t data);
+    int executeList (VmeOp* ops, size_t n);
+
+    int enableIrqs (uint8_t levelMask);
+    int waitForIrq (int timeout, int *level, uint8_t *vector);
+    int acknowledgeIrq (int level);
+
+    bool isBusError (int err) const { return err == SIMVME_BUS_ERROR; }
+
+    SimVmeStatistics getStatistics () const;
+    void resetStatistics ();
+    /*! Returns one line per simulated module with its accepted and lost triggers. */
+    QStringList getDeviceStatistics () const;
+
+private:
+    enum TransferMode { Dma32, Fifo, Blt32, Mblt64, TwoE };
+
+    uint64_t elapsed () const;
+    void advance (uint64_t now);
+    SimVmeDevice *findDevice (uint32_t addr);
+    void buildCrate (bool verbose);
+    void clearCrate ();
+    SimVmeDevice *access (uint32_t addr, uint64_t *start);
+    int blockRead (TransferMode mode, uint32_t addr, uint32_t *buf, uint32_t n, uint32_t *got);
+    int chainRead (int cbltAddr, uint32_t *buf, uint32_t n, uint32_t *got);
+    void spend (uint64_t start, uint64_t ns);
+
+    friend class SimVmeUI;
+
+private:
+    SimVmeConfig conf_;
+    SimVmeStatistics stats_;
+
+    QList<SimVmeDevice*> devices_;
+    SimVmeDevice *last_;  // device of the last access, checked first
+    SimVmeRandom triggerRng_;
+
+    mutable QMutex lock_;
+    bool open_;
+    bool veto1_;
+    bool veto2_;
+    uint64_t t0_;
+    uint64_t nextTrigger_; // ns since t0_
+    uint8_t irqLevels_;    // enabled interrupt levels
+    uint8_t irqBlocked_;   // levels waiting for acknowledgeIrq
+};
+
+#endif // SIMVMEMODULE_H
@@ -0,0 +1,287 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "simvmeui.h"
+
+#include <QGridLayout>
+#include <QTabWidget>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+#include <QSpinBox>
+#include <QGroupBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QTextEdit>
+#include <QTimer>
+
+#include <climits>
+
+SimVmeUI::SimVmeUI (SimVmeModule *m)
+: module_ (m)
+, statTimer (new QTimer (this))
+{
+    createUI ();
+    applySettings ();
+
+    statTimer->setInterval (1000);
+    connect (statTimer, SIGNAL(timeout()), SLOT(updateStatistics()));
+}
+
+static QSpinBox *nsSpinBox () {
+    QSpinBox *sb = new QSpinBox ();
+    sb->setMinimum (0);
+    sb->setMaximum (INT_MAX);
+    sb->setSuffix (QObject::tr (" ns"));
+    sb->setAccelerated (true);
+    return sb;
+}
+
+void SimVmeUI::createUI () {
+    QGroupBox *settingsbox = new QGroupBox (tr ("%1 Settings").arg (module_->getName ()));
+    QTabWidget *tabs = new QTabWidget (settingsbox);
+
+    {
+        QWidget *devicepane = new QWidget ();
+        QGridLayout *l = new QGridLayout (devicepane);
+
+        btnOpenClose = new QPushButton (tr ("Open"));
+        l->addWidget (btnOpenClose, 0, 0, 1, 1);
+
+        statusViewTextEdit = new QTextEdit ();
+        statusViewTextEdit->setReadOnly (true);
+        l->addWidget (statusViewTextEdit, 1, 0, 1, 2);
+        l->setColumnStretch (1, 1);
+
+        connect (btnOpenClose, SIGNAL(clicked()), SLOT(openCloseButtonClicked()));
+        tabs->addTab (devicepane, tr ("Device"));
+    }
+
+    {
+        QWidget *settingspane = new QWidget ();
+        QGridLayout *l = new QGridLayout (settingspane);
+        int row = 0;
+
+        sbSeed = new QSpinBox ();
+        sbSeed->setMinimum (0);
+        sbSeed->setMaximum (INT_MAX);
+        l->addWidget (new QLabel (tr ("Random seed:")), row, 0, 1, 1);
+        l->addWidget (sbSeed, row++, 1, 1, 1);
+
+        sbTriggerRate = new QDoubleSpinBox ();
+        sbTriggerRate->setMinimum (0);
+        sbTriggerRate->setMaximum (1e7);
+        sbTriggerRate->setDecimals (1);
+        sbTriggerRate->setSuffix (tr (" Hz"));
+        sbTriggerRate->setAccelerated (true);
+        l->addWidget (new QLabel (tr ("Trigger rate:")), row, 0, 1, 1);
+        l->addWidget (sbTriggerRate, row++, 1, 1, 1);
+
+        sbConversion = nsSpinBox ();
+        l->addWidget (new QLabel (tr ("Conversion time:")), row, 0, 1, 1);
+        l->addWidget (sbConversion, row++, 1, 1, 1);
+
+        QGroupBox *grp = new QGroupBox (tr ("Bus timing"));
+        QGridLayout *grpl = new QGridLayout (grp);
+        int grow = 0;
+
+        boxSimulateLatency = new QCheckBox (tr ("Simulate transfer latency"));
+        grpl->addWidget (boxSimulateLatency, grow++, 0, 1, 2);
+
+        sbSingleCycle = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("Single cycle:")), grow, 0, 1, 1);
+        grpl->addWidget (sbSingleCycle, grow++, 1, 1, 1);
+
+        sbListCycle = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("Access list, per cycle:")), grow, 0, 1, 1);
+        grpl->addWidget (sbListCycle, grow++, 1, 1, 1);
+
+        sbBlockSetup = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("Block transfer setup:")), grow, 0, 1, 1);
+        grpl->addWidget (sbBlockSetup, grow++, 1, 1, 1);
+
+        sbDma32Word = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("DMA D32 / FIFO per word:")), grow, 0, 1, 1);
+        grpl->addWidget (sbDma32Word, grow++, 1, 1, 1);
+
+        sbBlt32Word = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("BLT32 per word:")), grow, 0, 1, 1);
+        grpl->addWidget (sbBlt32Word, grow++, 1, 1, 1);
+
+        sbMblt64Word = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("MBLT64 per word:")), grow, 0, 1, 1);
+        grpl->addWidget (sbMblt64Word, grow++, 1, 1, 1);
+
+        sbTwoEWord = nsSpinBox ();
+        grpl->addWidget (new QLabel (tr ("2eVME per word:")), grow, 0, 1, 1);
+        grpl->addWidget (sbTwoEWord, grow++, 1, 1, 1);
+
+        l->addWidget (grp, row++, 0, 1, 2);
+        l->setRowStretch (row, 1);
+
+        connect (sbSeed, SIGNAL(valueChanged(int)), SLOT(updateSeed(int)));
+        connect (sbTriggerRate, SIGNAL(valueChanged(double)), SLOT(updateTriggerRate(double)));
+        connect (sbConversion, SIGNAL(valueChanged(int)), SLOT(updateConversion(int)));
+        connect (boxSimulateLatency, SIGNAL(toggled(bool)), SLOT(updateSimulateLatency(bool)));
+        connect (sbSingleCycle, SIGNAL(valueChanged(int)), SLOT(updateSingleCycle(int)));
+        connect (sbListCycle, SIGNAL(valueChanged(int)), SLOT(updateListCycle(int)));
+        connect (sbBlockSetup, SIGNAL(valueChanged(int)), SLOT(updateBlockSetup(int)));
+        connect (sbDma32Word, SIGNAL(valueChanged(int)), SLOT(updateDma32Word(int)));
+        connect (sbBlt32Word, SIGNAL(valueChanged(int)), SLOT(updateBlt32Word(int)));
+        connect (sbMblt64Word, SIGNAL(valueChanged(int)), SLOT(updateMblt64Word(int)));
+        connect (sbTwoEWord, SIGNAL(valueChanged(int)), SLOT(updateTwoEWord(int)));
+        tabs->addTab (settingspane, tr ("Settings"));
+    }
+
+    {
+        QWidget *statpane = new QWidget ();
+        QGridLayout *l = new QGridLayout (statpane);
+        l->setColumnStretch (1, 1);
+        int row = 0;
+
+        QLabel **labels [] = { &lblCycles, &lblBlockTransfers, &lblWords, &lblBusTime, &lblTriggers, &lblVetoed,
+                               &lblInterrupts };
+        QString names [] = { tr ("Single cycles:"), tr ("Block transfers:"), tr ("Words transferred:"),
+                             tr ("Bus time:"), tr ("Triggers:"), tr ("Triggers vetoed:"), tr ("Interrupts:") };
+        for (int i = 0; i < 7; ++i) {
+            QLabel *lbl = new QLabel (tr ("0"));
+            lbl->setFrameStyle (QFrame::Panel | QFrame::Sunken);
+            lbl->setAlignment (Qt::AlignRight);
+            l->addWidget (new QLabel (names [i]), row, 0, 1, 1);
+            l->addWidget (lbl, row++, 1, 1, 1);
+            *labels [i] = lbl;
+        }
+
+        devicesTextEdit = new QTextEdit ();
+        devicesTextEdit->setReadOnly (true);
+        l->addWidget (devicesTextEdit, row++, 0, 1, 2);
+
+        btnStatReset = new QPushButton (tr ("Reset Statistics"));
+        l->addWidget (btnStatReset, row++, 0, 1, 2);
+
+        connect (btnStatReset, SIGNAL(clicked()), SLOT(resetStatistics()));
+        tabs->addTab (statpane, tr ("Statistics"));
+    }
+
+    (new QGridLayout (settingsbox))->addWidget (tabs, 0, 0, 1, 1);
+    (new QGridLayout (this))->addWidget (settingsbox, 0, 0, 1, 1);
+}
+
+void SimVmeUI::applySettings () {
+    sbSeed->setValue (module_->conf_.seed);
+    sbTriggerRate->setValue (module_->conf_.trigger_rate);
+    sbConversion->setValue (module_->conf_.conversion_ns);
+    boxSimulateLatency->setChecked (module_->conf_.simulate_latency);
+    sbSingleCycle->setValue (module_->conf_.single_cycle_ns);
+    sbListCycle->setValue (module_->conf_.list_cycle_ns);
+    sbBlockSetup->setValue (module_->conf_.block_setup_ns);
+    sbDma32Word->setValue (module_->conf_.dma32_word_ns);
+    sbBlt32Word->setValue (module_->conf_.blt32_word_ns);
+    sbMblt64Word->setValue (module_->conf_.mblt64_word_ns);
+    sbTwoEWord->setValue (module_->conf_.twoe_word_ns);
+}
+
+void SimVmeUI::outputText (QString text) {
+    statusViewTextEdit->textCursor ().movePosition (QTextCursor::End);
+    statusViewTextEdit->insertPlainText (text);
+    statusViewTextEdit->ensureCursorVisible ();
+}
+
+void SimVmeUI::openCloseButtonClicked () {
+    if (!module_->isOpen ()) {
+        module_->open ();
+        moduleOpened ();
+    } else {
+        module_->close ();
+        moduleClosed ();
+    }
+}
+
+void SimVmeUI::moduleOpened () {
+    btnOpenClose->setText (tr ("Close"));
+    statTimer->start ();
+    updateStatistics ();
+}
+
+void SimVmeUI::moduleClosed () {
+    btnOpenClose->setText (tr ("Open"));
+    statTimer->stop ();
+}
+
+void SimVmeUI::updateSeed (int seed) {
+    module_->conf_.seed = seed;
+}
+
+void SimVmeUI::updateTriggerRate (double rate) {
+    module_->conf_.trigger_rate = rate;
+}
+
+void SimVmeUI::updateConversion (int ns) {
+    module_->conf_.conversion_ns = ns;
+}
+
+void SimVmeUI::updateSimulateLatency (bool enable) {
+    module_->conf_.simulate_latency = enable;
+}
+
+void SimVmeUI::updateSingleCycle (int ns) {
+    module_->conf_.single_cycle_ns = ns;
+}
+
+void SimVmeUI::updateListCycle (int ns) {
+    module_->conf_.list_cycle_ns = ns;
+}
+
+void SimVmeUI::updateBlockSetup (int ns) {
+    module_->conf_.block_setup_ns = ns;
+}
+
+void SimVmeUI::updateDma32Word (int ns) {
+    module_->conf_.dma32_word_ns = ns;
+}
+
+void SimVmeUI::updateBlt32Word (int ns) {
+    module_->conf_.blt32_word_ns = ns;
+}
+
+void SimVmeUI::updateMblt64Word (int ns) {
+    module_->conf_.mblt64_word_ns = ns;
+}
+
+void SimVmeUI::updateTwoEWord (int ns) {
+    module_->conf_.twoe_word_ns = ns;
+}
+
+void SimVmeUI::updateStatistics () {
+    SimVmeStatistics st = module_->getStatistics ();
+
+    lblCycles->setText (tr ("%1").arg (st.cycles));
+    lblBlockTransfers->setText (tr ("%1").arg (st.blockTransfers));
+    lblWords->setText (tr ("%1").arg (st.words));
+    lblBusTime->setText (tr ("%1 ms").arg (st.busTimeNs / 1e6, 0, 'f', 1));
+    lblTriggers->setText (tr ("%1").arg (st.triggers));
+    lblVetoed->setText (tr ("%1").arg (st.vetoed));
+    lblInterrupts->setText (tr ("%1").arg (st.interrupts));
+
+    devicesTextEdit->setPlainText (module_->getDeviceStatistics ().join ("\n"));
+}
+
+void SimVmeUI::resetStatistics () {
+    module_->resetStatistics ();
+    updateStatistics ();
+}
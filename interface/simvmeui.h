@@ -0,0 +1,100 @@
+/*
+Copyright 2011 Bastian Loeher, Roland Wirth
+
+This file is part of GECKO.
+
+GECKO is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GECKO is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIMVMEUI_H
+#define SIMVMEUI_H
+
+#include "simvmemodule.h"
+#include "baseui.h"
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QSpinBox;
+class QLabel;
+class QPushButton;
+class QTextEdit;
+class QTimer;
+
+class SimVmeUI : public BaseUI
+{
+    Q_OBJECT
+public:
+    explicit SimVmeUI (SimVmeModule *m);
+
+    void createUI ();
+    void applySettings ();
+
+public slots:
+    void outputText (QString);
+
+private:
+    void moduleOpened ();
+    void moduleClosed ();
+
+    friend class SimVmeModule;
+
+private slots:
+    void openCloseButtonClicked ();
+
+    void updateSeed (int);
+    void updateTriggerRate (double);
+    void updateConversion (int);
+    void updateSimulateLatency (bool);
+    void updateSingleCycle (int);
+    void updateListCycle (int);
+    void updateBlockSetup (int);
+    void updateDma32Word (int);
+    void updateBlt32Word (int);
+    void updateMblt64Word (int);
+    void updateTwoEWord (int);
+
+    void updateStatistics ();
+    void resetStatistics ();
+
+private:
+    SimVmeModule *module_;
+
+    QSpinBox *sbSeed;
+    QDoubleSpinBox *sbTriggerRate;
+    QSpinBox *sbConversion;
+    QCheckBox *boxSimulateLatency;
+    QSpinBox *sbSingleCycle;
+    QSpinBox *sbListCycle;
+    QSpinBox *sbBlockSetup;
+    QSpinBox *sbDma32Word;
+    QSpinBox *sbBlt32Word;
+    QSpinBox *sbMblt64Word;
+    QSpinBox *sbTwoEWord;
+
+    QPushButton *btnOpenClose;
+    QTextEdit *statusViewTextEdit;
+
+    QLabel *lblCycles;
+    QLabel *lblBlockTransfers;
+    QLabel *lblWords;
+    QLabel *lblBusTime;
+    QLabel *lblTriggers;
+    QLabel *lblVetoed;
+    QLabel *lblInterrupts;
+    QTextEdit *devicesTextEdit;
+    QPushButton *btnStatReset;
+    QTimer *statTimer;
+};
+
+#endif // SIMVMEUI_H
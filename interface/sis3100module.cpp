@@ -19,8 +19,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "sis3100module.h"
 #include "interfacemanager.h"
+#include "header/dev/pci/sis1100_var.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <sys/select.h>
 #include <iostream>
+#include <vector>
 
 static InterfaceRegistrar registrar ("sis3100", Sis3100Module::create);
 
@@ -30,6 +36,8 @@ Sis3100Module::Sis3100Module(int _id, QString _name)
     , name (getName ())
 {
     deviceOpen = false;
+    irqLevels = 0;
+    pipeUnsupported = false;
 
     devicePath = tr("/dev/sis1100_00remote");
     controlPath = tr("/dev/sis1100_00ctrl");
@@ -73,8 +81,9 @@ int Sis3100Module::open()
 
     }
 
-    // Set disable VME IRQ
+    // Set disable VME IRQ, they are enabled through the driver when a run waits for interrupts (see enableIrqs)
     s3100_control_write(m_device,SIS3104_IRQ,(1 << 16));
+    irqLevels = 0;
 
     // Read Type/Version
     uint32_t opt_vme_type_version = 0;
@@ -110,6 +119,7 @@ int Sis3100Module::close()
     Sis3100UI* ui = dynamic_cast<Sis3100UI*>(getUI());
     ui->outputText("closed SIS1100/3104\n");
     deviceOpen = false;
+    irqLevels = 0;
     return 0;
 }
 
@@ -183,6 +193,144 @@ int Sis3100Module::readA322E(const uint32_t addr, uint32_t* dma_buffer,
     return sis3100_vme_A32_2EVME_read(m_device, addr, dma_buffer, request_nof_words, got_nof_words);
 }
 
+int Sis3100Module::executeList(VmeOp* ops, size_t n)
+{
+    std::vector<sis1100_pipelist> list;
+    std::vector<u_int32_t> results;
+    int ret = 0;
+
+    // a single cycle does not pay off the pipeline setup
+    if (n == 1 || pipeUnsupported) return BaseInterface::executeList(ops, n);
+
+    // The list is sent to the SIS3100 in pipeline mode: all cycles are started without waiting for the previous one
+    // to complete. The read data comes back in one block. The driver reports a single error for the whole pipeline.
+    for (size_t first = 0; first < n; first += SIS3100_PIPE_MAX_CYCLES) {
+        size_t count = std::min (n - first, static_cast<size_t> (SIS3100_PIPE_MAX_CYCLES));
+        size_t reads = 0;
+
+        list.resize (count);
+        for (size_t i = 0; i < count; ++i) {
+            const VmeOp &op = ops [first + i];
+            bool d16 = (op.type == VmeOp::ReadD16 || op.type == VmeOp::WriteD16);
+            bool write = (op.type == VmeOp::WriteD16 || op.type == VmeOp::WriteD32);
+            uint32_t lane = d16 ? (op.addr & 2) * 8 : 0;
+            uint32_t be = d16 ? (0x3 << (op.addr & 2)) : 0xf;
+
+            // head: byte enables, remote space 1 (VME) and the write flag
+            list [i].head = (be << 24) | 0x00010000 | (write ? 0x400 : 0);
+            list [i].am = 0x9;
+            list [i].addr = op.addr;
+            list [i].data = write ? (op.data << lane) : 0;
+            if (!write)
+                ++reads;
+        }
+        results.resize (reads + 1);
+
+        struct sis1100_pipe pipe;
+        pipe.num = count;
+        pipe.list = &list [0];
+        pipe.data = &results [0];
+        pipe.error = 0;
+
+        if (ioctl (m_device, SIS1100_PIPE, &pipe) < 0) {
+            int err = errno;
+
+            // other errors may come after part of the pipeline ran, so the cycles must not be repeated
+            if (err != ENOTTY && err != EINVAL) {
+                for (size_t i = first; i < n; ++i)
+                    ops [i].error = err;
+                return ret ? ret : err;
+            }
+
+            // drivers without pipeline support get the lists one cycle at a time from now on
+            std::cout << "Sis3100: no pipelined access lists in the driver, executing them cycle by cycle" << std::endl;
+            pipeUnsupported = true;
+            err = BaseInterface::executeList (ops + first, n - first);
+            return ret ? ret : err;
+        }
+
+        size_t r = 0;
+        for (size_t i = 0; i < count; ++i) {
+            VmeOp &op = ops [first + i];
+            op.error = pipe.error;
+            if (op.type == VmeOp::ReadD16)
+                op.data = (results [r++] >> ((op.addr & 2) * 8)) & 0xffff;
+            else if (op.type == VmeOp::ReadD32)
+                op.data = results [r++];
+        }
+        if (pipe.error && !ret)
+            ret = pipe.error;
+    }
+    return ret;
+}
+
+int Sis3100Module::enableIrqs(uint8_t levelMask)
+{
+    struct sis1100_irq_ctl ctl;
+    uint32_t levels = levelMask & SIS3100_VME_IRQS;
+
+    // disable the levels that are not requested
+    ctl.irq_mask = SIS3100_VME_IRQS & ~levels;
+    ctl.signal = 0;
+    if (ioctl(m_device, SIS1100_IRQ_CTL, &ctl) < 0) return -1;
+    irqLevels = 0;
+
+    if (!levels) return 0;
+
+    // no signal, the pending interrupts make the device selectable instead (see waitForIrq)
+    ctl.irq_mask = levels;
+    ctl.signal = -1;
+    if (ioctl(m_device, SIS1100_IRQ_CTL, &ctl) < 0) return -1;
+    irqLevels = levels;
+    return 0;
+}
+
+int Sis3100Module::waitForIrq(int timeout, int *level, uint8_t *vector)
+{
+    if (!irqLevels) return -1;
+
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(m_device, &fds);
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    int ret = select(m_device + 1, &fds, NULL, NULL, &tv);
+    if (ret < 0) return errno == EINTR ? 0 : -1;
+    if (ret == 0) return 0;
+
+    struct sis1100_irq_get get;
+    get.irq_mask = irqLevels;
+    if (ioctl(m_device, SIS1100_IRQ_GET, &get) < 0) return -1;
+
+    uint32_t pending = get.irqs & irqLevels;
+    if (!pending) return 0;
+
+    // serve the highest level first, like the VME bus does
+    int l = 7;
+    while (!(pending & (1 << l))) --l;
+
+    u_int8_t vec = 0;
+    if (sis3100_vme_IACK_D8_read(m_device, l, &vec) != 0) {
+        // the request was withdrawn before the acknowledge cycle
+        acknowledgeIrq(l);
+        return 0;
+    }
+
+    *level = l;
+    *vector = vec;
+    return 1;
+}
+
+int Sis3100Module::acknowledgeIrq(int level)
+{
+    struct sis1100_irq_ack ack;
+    ack.irq_mask = (1 << level) & irqLevels;
+    if (ioctl(m_device, SIS1100_IRQ_ACK, &ack) < 0) return -1;
+    return 0;
+}
+
 int Sis3100Module::acquire()
 {
     return -1;
@@ -61,6 +61,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define vme_long_timer        (3<<12)
 #define vme_berr_timer        (3<<14)
 #define vme_system_controller (1<<16)
+/* maximum number of cycles sent to the controller in one pipeline */
+#define SIS3100_PIPE_MAX_CYCLES 256
 
 
 class QSettings;
@@ -75,6 +77,8 @@ protected:
     int m_device;
     int c_device;
     bool deviceOpen;
+    uint32_t irqLevels; // enabled VME interrupt levels, see enableIrqs
+    bool pipeUnsupported; // the driver rejected SIS1100_PIPE, see executeList
     void out(QString);
     QString devicePath;
     QString controlPath;
@@ -112,6 +116,12 @@ public:
     int readA322E(const uint32_t addr, uint32_t* dma_buffer, uint32_t request_nof_words, uint32_t* got_nof_words);
     int writeA32D32(const uint32_t addr, const uint32_t data);
     int writeA32D16(const uint32_t addr, const uint16_t data);
+    int executeList(VmeOp* ops, size_t n);
+
+    // VME interrupts
+    int enableIrqs(uint8_t levelMask);
+    int waitForIrq(int timeout, int *level, uint8_t *vector);
+    int acknowledgeIrq(int level);
 
     bool isBusError (int err) const { return err == 0x211; }
 
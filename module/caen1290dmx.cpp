@@ -33,8 +33,8 @@ Caen1290Demux::Caen1290Demux (const QVector<EventSlot*> &evslots, int channels,
     evbuf_.resize (chans_);
 }
 
-bool Caen1290Demux::processData (Event *ev, const std::vector<uint32_t> &data, bool singleev) {
-    for (std::vector<uint32_t>::const_iterator i = data.begin (); i != data.end (); ++i) {
+bool Caen1290Demux::processData (Event *ev, const uint32_t *data, int len, bool singleev) {
+    for (const uint32_t *i = data; i != data + len; ++i) {
         uint32_t tag = (*i >> 27) & 0x1F;
 
         switch (tag) {
@@ -94,7 +94,7 @@ void Caen1290Demux::processEvent (uint32_t ev) {
 
 bool Caen1290Demux::endEvent (Event *ev) {
     for (int i = 0; i < chans_; ++i) {
-        ev->put (evslots_.at (i), QVariant::fromValue (evbuf_ [i]));
+        ev->copyData (evslots_.at (i), evbuf_ [i].constData (), evbuf_ [i].size ());
     }
     status_ = Start;
 
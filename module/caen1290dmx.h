@@ -32,7 +32,7 @@ class Caen1290Demux
 public:
     Caen1290Demux (const QVector<EventSlot*> &evslots, int channels, bool hires);
 
-    bool processData (Event *ev, const std::vector<uint32_t> &data, bool singleev);
+    bool processData (Event *ev, const uint32_t *data, int len, bool singleev);
 
 private:
     void startEvent (uint32_t info);
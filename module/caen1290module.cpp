@@ -103,37 +103,61 @@ bool Caen1290Module::dataReady () {
     return (status & (1 << CAEN1290_STA_DREADY)) != 0;
 }
 
+int Caen1290Module::appendStatusReads (QVector<VmeOp> *ops) const {
+    ops->push_back (VmeOp::read16 (conf_->base_addr + CAEN1290_STATUS));
+    return 1;
+}
+
+bool Caen1290Module::dataReadyFromStatus (const VmeOp *status) {
+    if (status [0].error) {
+        std::cout << "Error " << status [0].error << " at CAEN1290_STATUS" << std::endl;
+        return false;
+    }
+
+    return (status [0].data & (1 << CAEN1290_STA_DREADY)) != 0;
+}
+
 int Caen1290Module::acquire (Event *ev) {
+    QVector<uint32_t> raw;
+    int ret = acquireRaw (&raw);
+    decode (ev, raw);
+    return ret;
+}
+
+int Caen1290Module::acquireRaw (QVector<uint32_t> *raw) {
     AbstractInterface *iface = getInterface ();
-    std::vector<uint32_t> data;
     const uint32_t len = 0xFFC;
-    uint32_t buf [len];
-    uint32_t got = 0;
+    bool singleev = RunManager::ref().isSingleEventMode();
     int ret = 0;
 
     while (true) {
-        got = 0;
+        // transfer straight into the raw buffer
+        int pos = raw->size ();
+        raw->resize (pos + len);
+        uint32_t *buf = raw->data () + pos;
+        uint32_t got = 0;
+
         // only fatal if no data has been read (at least for sis modules)
-        if ((ret = iface->readA32MBLT64 (conf_->base_addr + CAEN1290_MEB, &buf [0], len, &got)) && got == 0) {
+        if ((ret = iface->readA32MBLT64 (conf_->base_addr + CAEN1290_MEB, buf, len, &got)) && got == 0) {
+            raw->resize (pos);
             std::cout << "Error " << ret << " at MBLT from CAEN1290_MEB" << std::endl;
             return ret;
         }
 
         for (uint32_t i = 0; i < got; ++i) {
-            if (((buf [i] >> 27) & 0x1F) == 0x18) { // filler detected
+            uint32_t tag = (buf [i] >> 27) & 0x1F;
+            if (tag == 0x18) { // filler detected
                 got = i;
                 break;
             }
+            if (singleev && tag == 0x10) { // global trailer: keep only the first event
+                raw->resize (pos + i + 1);
+                softClear (); // discard the rest of the events
+                return 0;
+            }
         }
 
-        data.assign (buf, buf + got);
-
-        // check whether we are in single event mode and the demux plugin just completed an event
-        bool go_on = dmx_.processData (ev, data, RunManager::ref().isSingleEventMode());
-        if (!go_on) {
-            softClear (); // discard the rest of the events
-            return 0;
-        }
+        raw->resize (pos + got);
 
         if (len != got)
             break;
@@ -142,6 +166,11 @@ int Caen1290Module::acquire (Event *ev) {
     return ret;
 }
 
+int Caen1290Module::decode (Event *ev, const QVector<uint32_t> &raw) {
+    dmx_.processData (ev, raw.constData (), raw.size (), RunManager::ref().isSingleEventMode());
+    return 0;
+}
+
 int Caen1290Module::configure () {
     AbstractInterface *iface = getInterface ();
     uint32_t baddr = conf_->base_addr;
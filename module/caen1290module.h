@@ -73,7 +73,12 @@ public:
 
     virtual void setChannels();
     virtual int acquire(Event *ev);
+    virtual bool hasRawReadout() const { return true; }
+    virtual int acquireRaw(QVector<uint32_t> *raw);
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw);
     virtual bool dataReady();
+    virtual int appendStatusReads(QVector<VmeOp> *ops) const;
+    virtual bool dataReadyFromStatus(const VmeOp *status);
     virtual int reset();
     virtual int configure();
     virtual void setBaseAddress (uint32_t baddr);
@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "modulemanager.h"
 #include "runmanager.h"
 
+#include <vector>
+
 static ModuleRegistrar registrar ("caen785", Caen785Module::create);
 
 Caen785Module::Caen785Module(int _id, QString _name)
@@ -31,6 +33,9 @@ Caen785Module::Caen785Module(int _id, QString _name)
     createOutputPlugin();
 
     evcntr = 0;
+    geo = 0;
+    drainedEvents = 0;
+    lastDrain.start();
     status1 = 0;
     status2 = 0;
 
@@ -110,6 +115,7 @@ int Caen785Module::counterReset()
     data = 0x0;
     ret = iface->writeA32D16(addr,data);
     if(ret != 0) printf("Error %d at CAEN785_EVCNT_RST\n",ret);
+    drainedEvents = 0;
 
     return ret;
 }
@@ -128,12 +134,18 @@ int Caen785Module::configure()
     ret = iface->writeA32D16(addr,data);
     if(ret != 0) printf("Error %d at CAEN785_CRATE_SEL\n",ret);
 
-    // set channel thresholds and kill bits
-    for (int i = 0; i < 32; ++i) {
-        ret = iface->writeA32D16 (conf.base_addr + CAEN785_THRESHOLDS + 2*i,
-                                  conf.thresholds [i]
-                                  | (conf.killChannel [i] ? (1 << 8) : 0));
-        if (ret) printf ("Error %d at CAEN785_THRESHOLDS[%d]\n", ret, i);
+    // set channel thresholds and kill bits with one access list
+    std::vector<VmeOp> ops;
+    for (int i = 0; i < 32; ++i)
+        ops.push_back (VmeOp::write16 (conf.base_addr + CAEN785_THRESHOLDS + 2*i,
+                                       conf.thresholds [i]
+                                       | (conf.killChannel [i] ? (1 << 8) : 0)));
+    ret = iface->executeList (&ops [0], ops.size ());
+    for (int i = 0; ret && i < 32; ++i) {
+        if (ops [i].error) {
+            printf ("Error %d at CAEN785_THRESHOLDS[%d]\n", ops [i].error, i);
+            break;
+        }
     }
 
     ret = counterReset();
@@ -162,6 +174,22 @@ int Caen785Module::configure()
     ret = iface->writeA32D16(addr,data);
     if(ret != 0) printf("Error %d at CAEN785_CONTROL1",ret);
 
+    // Interrupt generation
+    addr = conf.base_addr + CAEN785_IRQ_LVL;
+    data = 0x0 | (conf.irq_level & 7);
+    ret = iface->writeA32D16(addr,data);
+    if(ret != 0) printf("Error %d at CAEN785_IRQ_LVL\n",ret);
+
+    addr = conf.base_addr + CAEN785_IRQ_VEC;
+    data = 0x0 | conf.irq_vector;
+    ret = iface->writeA32D16(addr,data);
+    if(ret != 0) printf("Error %d at CAEN785_IRQ_VEC\n",ret);
+
+    addr = conf.base_addr + CAEN785_EV_TRG;
+    data = 0x0 | conf.nof_events;
+    ret = iface->writeA32D16(addr,data);
+    if(ret != 0) printf("Error %d at CAEN785_EV_TRG\n",ret);
+
     addr = conf.base_addr + CAEN785_BIT_SET2;
     data = 0x0;
     if(conf.memTestModeEnabled) {
@@ -235,37 +263,28 @@ int Caen785Module::readStatus2()
 
 int Caen785Module::readStatus()
 {
+    static const char *names[] = { "BIT_SET1", "BIT_SET2", "STAT1", "STAT2", "EVCNT_H", "EVCNT_L" };
     AbstractInterface *iface = getInterface ();
-    int ret = 0;
-
-    uint32_t addr;
-    uint16_t data;
-
-    addr = conf.base_addr + CAEN785_BIT_SET1;
-    ret = iface->readA32D16(addr,&bit1);
-    if(ret != 0) printf("Error %d at CAEN785_BIT_SET1 read\n",ret);
-    addr = conf.base_addr + CAEN785_BIT_SET2;
-    ret = iface->readA32D16(addr,&bit2);
-    if(ret != 0) printf("Error %d at CAEN785_BIT_SET2 read\n",ret);
-
-    ret = readStatus1();
-    ret = readStatus2();
-
-    addr = conf.base_addr + CAEN785_EVCNT_H;
-    ret = iface->readA32D16(addr,&data);
-    if(ret != 0) printf("Error %d at CAEN785_EVCNT_H read\n",ret);
-    evcntr = 0x0 | (data << 16);
-    addr = conf.base_addr + CAEN785_EVCNT_L;
-    ret = iface->readA32D16(addr,&data);
-    if(ret != 0) printf("Error %d at CAEN785_EVCNT_L read\n",ret);
-    evcntr |= data;
-
-//    printf("bit1 %08x\n",bit1);
-//    printf("bit2 %08x\n",bit2);
-//    printf("status1 %08x\n",status1);
-//    printf("status2 %08x\n",status2);
-//    printf("CAEN785_EVCNT_H %08x\n",data);
-//    printf("CAEN785_EVCNT_L %08x\n",data);
+    VmeOp ops[] = {
+        VmeOp::read16(conf.base_addr + CAEN785_BIT_SET1),
+        VmeOp::read16(conf.base_addr + CAEN785_BIT_SET2),
+        VmeOp::read16(conf.base_addr + CAEN785_STAT1),
+        VmeOp::read16(conf.base_addr + CAEN785_STAT2),
+        VmeOp::read16(conf.base_addr + CAEN785_EVCNT_H),
+        VmeOp::read16(conf.base_addr + CAEN785_EVCNT_L)
+    };
+
+    // one access list instead of six single cycles
+    int ret = iface->executeList(ops, 6);
+    for(int i = 0; i < 6; ++i)
+        if(ops[i].error != 0) printf("Error %d at CAEN785_%s read\n",ops[i].error,names[i]);
+
+    bit1 = ops[0].data;
+    bit2 = ops[1].data;
+    status1 = ops[2].data;
+    status2 = ops[3].data;
+    evcntr = 0x0 | (ops[4].data << 16);
+    evcntr |= ops[5].data;
 
     return ret;
 }
@@ -273,7 +292,44 @@ int Caen785Module::readStatus()
 bool Caen785Module::dataReady()
 {
     readStatus1();
-    return (status1 & 0x1);
+    return bufferReady();
+}
+
+int Caen785Module::appendStatusReads(QVector<VmeOp> *ops) const
+{
+    ops->push_back(VmeOp::read16(conf.base_addr + CAEN785_STAT1));
+    return 1;
+}
+
+bool Caen785Module::dataReadyFromStatus(const VmeOp *status)
+{
+    if(status[0].error != 0) printf("Error %d at CAEN785_STAT1 read\n",status[0].error);
+    status1 = status[0].data;
+    return bufferReady();
+}
+
+bool Caen785Module::bufferReady()
+{
+    if(!conf.multi_event_mode || !(status1 & 0x1))
+        return (status1 & 0x1);
+
+    // let events collect in the buffer until the threshold or the timeout is reached
+    if(lastDrain.elapsed() >= (int)conf.multi_event_timeout)
+        return true;
+
+    // buffer state and event counter in one access list
+    VmeOp ops[] = {
+        VmeOp::read16(conf.base_addr + CAEN785_STAT2),
+        VmeOp::read16(conf.base_addr + CAEN785_EVCNT_L)
+    };
+    int ret = getInterface()->executeList(ops, 2);
+    if(ret != 0) printf("Error %d at CAEN785_STAT2/EVCNT_L read\n",ret);
+    status2 = ops[0].data;
+    if(status2 & (1 << CAEN785_S2_BUFFULL))
+        return true;
+
+    uint16_t cnt = ops[1].data;
+    return (uint16_t)(cnt - drainedEvents) >= conf.multi_event_threshold;
 }
 
 int Caen785Module::singleShot()
@@ -331,6 +387,89 @@ int Caen785Module::writeToBuffer(Event *ev, uint32_t nofWords)
     return 0;
 }
 
+int Caen785Module::acquireRaw(QVector<uint32_t> *raw)
+{
+    AbstractInterface *iface = getInterface ();
+    uint32_t nofRead = 0;
+    int ret;
+
+    // drain the whole buffer, the transfer ends with a bus error after the last event
+    raw->resize(CAEN785_MEB_EVENTS * 34);
+    ret = iface->readA32MBLT64(conf.base_addr + CAEN785_MEB,raw->data(),raw->size(),&nofRead);
+    if(!nofRead && ret && !iface->isBusError(ret))
+    {
+        printf("Error %d at CAEN785_MEB readA32MBLT64\n",ret);fflush(stdout);
+        raw->resize(0);
+        return -1;
+    }
+
+    // without bus errors, the buffer reads as invalid data words after the last event
+    const uint32_t *buf = raw->constData();
+    uint32_t len = 0;
+    while(len < nofRead && ((buf[len] >> 24) & 0x7) != 0x6)
+        len++;
+
+    // remember the counter of the last event read, see dataReady
+    for(int i = len - 1; i >= 0; --i)
+    {
+        if(((buf[i] >> 24) & 0x7) == 0x4)
+        {
+            drainedEvents = (buf[i] & 0xffff) + 1;
+            break;
+        }
+    }
+
+    raw->resize(len);
+    lastDrain.start();
+    return len;
+}
+
+int Caen785Module::eventLength(const uint32_t *data, int len) const
+{
+    return conf.multi_event_mode ? CaenADCDemux::blockLength (data, len) : len;
+}
+
+int Caen785Module::decode(Event *ev, const QVector<uint32_t> &raw)
+{
+    // the data has already been removed from the module, so there is no need to reset it
+    dmx.processData (ev, raw.constData (), raw.size (), RunManager::ref ().isSingleEventMode ());
+    return 0;
+}
+
+int Caen785Module::setChainPosition(uint8_t cbltAddr, ChainPosition pos)
+{
+    AbstractInterface *iface = getInterface ();
+    int ret = 0;
+    uint16_t ctrl = 0;
+
+    if(!iface || !iface->isOpen()) return 1;
+
+    switch(pos) {
+    case ChainFirst:  ctrl = CAEN785_CBLT_FIRST;  break;
+    case ChainMiddle: ctrl = CAEN785_CBLT_MIDDLE; break;
+    case ChainLast:   ctrl = CAEN785_CBLT_LAST;   break;
+    default:          ctrl = 0;
+    }
+
+    // the chained data is split by the GEO address in the data words
+    ret = iface->readA32D16(conf.base_addr + CAEN785_GEO_ADDR,&geo);
+    if(ret != 0) printf("Error %d at CAEN785_GEO_ADDR\n",ret);
+    geo &= 0x1f;
+
+    ret = iface->writeA32D16(conf.base_addr + CAEN785_CBLT_ADDR,cbltAddr);
+    if(ret != 0) printf("Error %d at CAEN785_CBLT_ADDR\n",ret);
+
+    ret = iface->writeA32D16(conf.base_addr + CAEN785_CBLT_CTRL,ctrl);
+    if(ret != 0) printf("Error %d at CAEN785_CBLT_CTRL\n",ret);
+
+    return ret;
+}
+
+int Caen785Module::claimChainedData(const uint32_t *data, int len) const
+{
+    return CaenADCDemux::claimBlock (data, len, geo);
+}
+
 int Caen785Module::acquireSingleEvent()
 {
     AbstractInterface *iface = getInterface ();
@@ -420,6 +559,9 @@ void Caen785Module::applySettings(QSettings* settings)
     set = "nof_events";    if(settings->contains(set)) conf.nof_events = settings->value(set).toInt(&ok);
     set = "pollcount";    if(settings->contains(set)) conf.pollcount = settings->value(set).toInt(&ok);
     set = "slide_constant";    if(settings->contains(set)) conf.slide_constant = settings->value(set).toInt(&ok);
+    set = "multi_event_mode";    if(settings->contains(set)) conf.multi_event_mode = settings->value(set).toBool();
+    set = "multi_event_threshold";    if(settings->contains(set)) conf.multi_event_threshold = settings->value(set).toInt(&ok);
+    set = "multi_event_timeout";    if(settings->contains(set)) conf.multi_event_timeout = settings->value(set).toInt(&ok);
 
     for(unsigned int i = 0; i < 32; i++)
     {
@@ -468,6 +610,9 @@ void Caen785Module::saveSettings(QSettings* settings)
         settings->setValue("nof_events",conf.nof_events);
         settings->setValue("pollcount",conf.pollcount);
         settings->setValue("slide_constant",conf.slide_constant);
+        settings->setValue("multi_event_mode",conf.multi_event_mode);
+        settings->setValue("multi_event_threshold",conf.multi_event_threshold);
+        settings->setValue("multi_event_timeout",conf.multi_event_timeout);
 
         for(unsigned int i = 0; i < 32; i++)
         {
@@ -532,7 +677,7 @@ The last group contains parameters for fine-grained control over the mode of ope
 The thresholds tab controls the threshold for each channel. If thresholds are enabled in the Settings tab, only channels exceeding their threshold will be recorded in the data set sent back from the VME module. It is also possible to completely remove any channel from all data sets.
 
 \subsection irq IRQ Tab
-This tab is for testing purposes only and will disappear in future versions. Use at your own risk.
+The IRQ tab controls the conditions on which VME interrupt requests are generated. With interrupt readout enabled in the thread setup, a trigger module with a non-zero IRQ level is read out when its interrupt arrives instead of being polled.
 
 \subsection info Info Tab
 The Info tab displays a readout of the VME module ROM containing information about the firmware the VME module is currently executing.
@@ -66,6 +66,11 @@ public:
 
     unsigned int pollcount;
 
+    // multi event readout
+    bool multi_event_mode;
+    uint8_t multi_event_threshold;      // events to collect before draining the buffer
+    unsigned int multi_event_timeout;   // ms after which the buffer is drained anyway
+
     Caen785config ()
     : base_addr (0), irq_level (0), irq_vector (0), cratenumber (0), nof_events (0), slide_constant (0)
     , block_end (false), berr_enable (true), program_reset (false), align64 (false), memTestModeEnabled (false)
@@ -73,6 +78,7 @@ public:
     , zeroSuppressionThr (false), autoIncrementEnabled (true), emptyEventWriteEnabled (false)
     , slideSubEnabled (false), alwaysIncrementEventCounter (true)
     , pollcount (0)
+    , multi_event_mode (false), multi_event_threshold (16), multi_event_timeout (10)
     {
         for (int i = 0; i < 32; ++i) {
             thresholds [i] = 0;
@@ -96,6 +102,7 @@ public:
     uint16_t status1;
     uint16_t status2;
     uint16_t firmware;
+    uint16_t geo;
     uint32_t evcntr;
     uint32_t data[34];
 
@@ -117,7 +124,20 @@ public:
     bool pollTrigger();
 
     virtual bool dataReady();
+    virtual int appendStatusReads(QVector<VmeOp> *ops) const;
+    virtual bool dataReadyFromStatus(const VmeOp *status);
     virtual int acquire(Event *);
+    virtual bool hasRawReadout() const { return conf.multi_event_mode; }
+    virtual int acquireRaw(QVector<uint32_t> *raw);
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw);
+    virtual int eventLength(const uint32_t *data, int len) const;
+    virtual int setChainPosition(uint8_t cbltAddr, ChainPosition pos);
+    virtual int claimChainedData(const uint32_t *data, int len) const;
+    virtual bool getIrq(uint8_t *level, uint8_t *vector) const {
+        *level = conf.irq_level & 7;
+        *vector = conf.irq_vector;
+        return *level != 0;
+    }
     virtual int reset() {
         counterReset();
         dataReset();
@@ -142,8 +162,14 @@ public:
         return new Caen785Module (id, name);
     }
 private:
+    bool bufferReady(); // rest of dataReady, after status 1 has been read
+
     QVector<EventSlot*> evslots;
     CaenADCDemux dmx;
+
+    // multi event readout
+    uint16_t drainedEvents; // event counter after the last event read, lower 16 bits
+    QTime lastDrain;
 };
 
 #endif // CAEN785_H
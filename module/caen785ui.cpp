@@ -225,12 +225,36 @@ QWidget* Caen785UI::createInterruptControls()
     nofEventSpinner->setMaximum(512);
     nofEventSpinner->setValue(module->conf.nof_events);
 
+    multiEventBox = new QCheckBox(tr("Multi event readout"));
+    multiEventBox->setToolTip(tr("Let events collect in the module and read them with one block transfer"));
+    multiEventBox->setChecked(module->conf.multi_event_mode);
+
+    QLabel *multiEventThresholdLabel = new QLabel(tr("Events per transfer:"));
+    multiEventThresholdSpinner = new QSpinBox();
+    multiEventThresholdSpinner->setRange(1,CAEN785_MEB_EVENTS);
+    multiEventThresholdSpinner->setValue(module->conf.multi_event_threshold);
+
+    QLabel *multiEventTimeoutLabel = new QLabel(tr("Transfer timeout:"));
+    multiEventTimeoutSpinner = new QSpinBox();
+    multiEventTimeoutSpinner->setRange(0,10000);
+    multiEventTimeoutSpinner->setSuffix(tr(" ms"));
+    multiEventTimeoutSpinner->setValue(module->conf.multi_event_timeout);
+
+    connect(multiEventBox,SIGNAL(toggled(bool)),this,SLOT(multiEventChanged()));
+    connect(multiEventThresholdSpinner,SIGNAL(valueChanged(int)),this,SLOT(multiEventChanged()));
+    connect(multiEventTimeoutSpinner,SIGNAL(valueChanged(int)),this,SLOT(multiEventChanged()));
+
     l->addWidget(irqLevelLabel,0,0,1,1);
     l->addWidget(irqLevelSpinner,0,1,1,1);
     l->addWidget(irqVectorLabel,1,0,1,1);
     l->addWidget(irqVectorEdit,1,1,1,1);
     l->addWidget(nofEventLabel,2,0,1,1);
     l->addWidget(nofEventSpinner,2,1,1,1);
+    l->addWidget(multiEventBox,3,0,1,2);
+    l->addWidget(multiEventThresholdLabel,4,0,1,1);
+    l->addWidget(multiEventThresholdSpinner,4,1,1,1);
+    l->addWidget(multiEventTimeoutLabel,5,0,1,1);
+    l->addWidget(multiEventTimeoutSpinner,5,1,1,1);
 
     box->setLayout(l);
     return box;
@@ -442,6 +466,14 @@ void Caen785UI::nofEventsChanged()
     module->conf.nof_events = nofEventSpinner->value();
 }
 
+void Caen785UI::multiEventChanged()
+{
+    if (blockSlots) return;
+    module->conf.multi_event_mode      = multiEventBox->isChecked();
+    module->conf.multi_event_threshold = multiEventThresholdSpinner->value();
+    module->conf.multi_event_timeout   = multiEventTimeoutSpinner->value();
+}
+
 void Caen785UI::irqLevelChanged()
 {
     module->conf.irq_level = irqLevelSpinner->value();
@@ -476,6 +508,9 @@ void Caen785UI::applySettings()
     slidingScaleSpinner->setValue(module->conf.slide_constant);
     irqLevelSpinner->setValue(module->conf.irq_level);
     nofEventSpinner->setValue(module->conf.nof_events);
+    multiEventBox->setChecked(module->conf.multi_event_mode);
+    multiEventThresholdSpinner->setValue(module->conf.multi_event_threshold);
+    multiEventTimeoutSpinner->setValue(module->conf.multi_event_timeout);
     slidingScaleSpinner->setValue(module->conf.slide_constant);
 
     for(int ch = 0; ch < 32; ++ch) {
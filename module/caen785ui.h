@@ -69,6 +69,7 @@ public slots:
     void settings2Changed();
     void crateNoChanged();
     void slideConstChanged();
+    void multiEventChanged();
 
 protected:
     Caen785Module* module;
@@ -105,6 +106,10 @@ protected:
 
     QSpinBox* nofTestConversionBox;
 
+    QCheckBox* multiEventBox;
+    QSpinBox* multiEventThresholdSpinner;
+    QSpinBox* multiEventTimeoutSpinner;
+
     QSpinBox* thresholdSpinner[32];
     QCheckBox* killChannelBox[32];
 
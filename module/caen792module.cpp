@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 using namespace std;
 static ModuleRegistrar reg1 ("caen792", Caen792Module::createQdc);
@@ -38,10 +39,13 @@ Caen792Module::Caen792Module (int i, const QString &n, bool _isqdc)
     , bitset2 (0)
     , status1 (0)
     , status2 (0)
+    , geo     (0)
     , evcnt   (0)
+    , drainedEvents (0)
     , dmx_    (evslots_, this)
 {
     conf_.pollcount = 100000;
+    lastDrain.start ();
     setChannels ();
     createOutputPlugin();
 
@@ -71,12 +75,18 @@ int Caen792Module::configure () {
     ret = iface->writeA32D16 (baddr + CAEN792_CRATE_SEL, conf_.cratenumber);
     if (ret) printf ("Error %d at CAEN792_CRATE_SEL\n", ret);
 
-    // set channel thresholds and kill bits
-    for (int i = 0; i < CAEN_V792_NOF_CHANNELS; ++i) {
-        ret = iface->writeA32D16 (baddr + CAEN792_THRESHOLDS + 2*i,
-                                  conf_.thresholds [i]
-                                  | (conf_.killChannel [i] ? (1 << 8) : 0));
-        if (ret) printf ("Error %d at CAEN792_THRESHOLDS[%d]\n", ret, i);
+    // set channel thresholds and kill bits with one access list
+    std::vector<VmeOp> ops;
+    for (int i = 0; i < CAEN_V792_NOF_CHANNELS; ++i)
+        ops.push_back (VmeOp::write16 (baddr + CAEN792_THRESHOLDS + 2*i,
+                                       conf_.thresholds [i]
+                                       | (conf_.killChannel [i] ? (1 << 8) : 0)));
+    ret = iface->executeList (&ops [0], ops.size ());
+    for (int i = 0; ret && i < CAEN_V792_NOF_CHANNELS; ++i) {
+        if (ops [i].error) {
+            printf ("Error %d at CAEN792_THRESHOLDS[%d]\n", ops [i].error, i);
+            break;
+        }
     }
 
     ret = iface->writeA32D16 (baddr + CAEN792_CONTROL1,
@@ -135,6 +145,7 @@ int Caen792Module::configure () {
 }
 
 int Caen792Module::counterReset () {
+    drainedEvents = 0;
     return getInterface ()->writeA32D16 (conf_.base_addr + CAEN792_EVCNT_RST, 0x00);
 }
 
@@ -178,30 +189,29 @@ uint16_t Caen792Module::getInfo () const {
 }
 
 int Caen792Module::readStatus () {
-    AbstractInterface *iface = getInterface ();
-    int ret;
-    uint16_t data;
-
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_BIT_SET1, &bitset1);
-    if (ret)
-            printf ("Error %d at CAEN792_BIT_SET1\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_BIT_SET2, &bitset2);
-    if (ret)
-            printf ("Error %d at CAEN792_BIT_SET2\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_STAT1, &status1);
-    if (ret)
-            printf ("Error %d at CAEN792_STAT1\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_STAT2, &status2);
-    if (ret)
-            printf ("Error %d at CAEN792_STAT2\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_EVCNT_L, &data);
-    if (ret)
-            printf ("Error %d at CAEN792_EVCNT_L\n", ret);
-    evcnt = data;
-    ret = iface->readA32D16 (conf_.base_addr + CAEN792_EVCNT_H, &data);
-    if (ret)
-        printf ("Error %d at CAEN792_EVCNT_H\n", ret);
-    evcnt |= (data << 16);
+    static const char *names [] = { "BIT_SET1", "BIT_SET2", "STAT1", "STAT2", "EVCNT_L", "EVCNT_H" };
+    uint32_t baddr = conf_.base_addr;
+    VmeOp ops [] = {
+        VmeOp::read16 (baddr + CAEN792_BIT_SET1),
+        VmeOp::read16 (baddr + CAEN792_BIT_SET2),
+        VmeOp::read16 (baddr + CAEN792_STAT1),
+        VmeOp::read16 (baddr + CAEN792_STAT2),
+        VmeOp::read16 (baddr + CAEN792_EVCNT_L),
+        VmeOp::read16 (baddr + CAEN792_EVCNT_H)
+    };
+
+    // one access list instead of six single cycles
+    getInterface ()->executeList (ops, 6);
+    for (int i = 0; i < 6; ++i)
+        if (ops [i].error)
+            printf ("Error %d at CAEN792_%s\n", ops [i].error, names [i]);
+
+    bitset1 = ops [0].data;
+    bitset2 = ops [1].data;
+    status1 = ops [2].data;
+    status2 = ops [3].data;
+    evcnt = ops [4].data;
+    evcnt |= (ops [5].data << 16);
     return 0;
 }
 
@@ -211,7 +221,46 @@ bool Caen792Module::dataReady () {
     if (ret)
         printf ("Error %d at CAEN792_STAT1 (data ready)\n", ret);
 
-    return (status1 & (1 << CAEN792_S1_DREADY)) != 0;
+    return bufferReady ();
+}
+
+int Caen792Module::appendStatusReads (QVector<VmeOp> *ops) const {
+    ops->push_back (VmeOp::read16 (conf_.base_addr + CAEN792_STAT1));
+    return 1;
+}
+
+bool Caen792Module::dataReadyFromStatus (const VmeOp *status) {
+    if (status [0].error)
+        printf ("Error %d at CAEN792_STAT1 (data ready)\n", status [0].error);
+    status1 = status [0].data;
+
+    return bufferReady ();
+}
+
+bool Caen792Module::bufferReady () {
+    int ret;
+
+    if (!conf_.multi_event_mode || (status1 & (1 << CAEN792_S1_DREADY)) == 0)
+        return (status1 & (1 << CAEN792_S1_DREADY)) != 0;
+
+    // let events collect in the buffer until the threshold or the timeout is reached
+    if (lastDrain.elapsed () >= (int) conf_.multi_event_timeout)
+        return true;
+
+    // buffer state and event counter in one access list
+    VmeOp ops [] = {
+        VmeOp::read16 (conf_.base_addr + CAEN792_STAT2),
+        VmeOp::read16 (conf_.base_addr + CAEN792_EVCNT_L)
+    };
+    ret = getInterface ()->executeList (ops, 2);
+    if (ret)
+        printf ("Error %d at CAEN792_STAT2/EVCNT_L (data ready)\n", ret);
+    status2 = ops [0].data;
+    if (status2 & (1 << CAEN792_S2_BUFFULL))
+        return true;
+
+    uint16_t cnt = ops [1].data;
+    return (uint16_t) (cnt - drainedEvents) >= conf_.multi_event_threshold;
 }
 
 int Caen792Module::acquire (Event* ev) {
@@ -231,6 +280,80 @@ void Caen792Module::writeToBuffer(Event *ev)
         dataReset ();
 }
 
+int Caen792Module::acquireRaw (QVector<uint32_t> *raw) {
+    AbstractInterface *iface = getInterface ();
+    uint32_t got = 0;
+
+    // drain the whole buffer, the transfer ends with a bus error after the last event
+    raw->resize (CAEN792_MEB_EVENTS * CAEN_V792_MAX_NOF_WORDS);
+    int ret = iface->readA32MBLT64 (conf_.base_addr + CAEN792_MEB, raw->data (), raw->size (), &got);
+    if (!got && ret && !iface->isBusError (ret)) {
+        printf ("Error %d at CAEN792_MEB\n", ret);
+        raw->resize (0);
+        return ret;
+    }
+
+    // without bus errors, the buffer reads as invalid data words after the last event
+    const uint32_t *buf = raw->constData ();
+    uint32_t len = 0;
+    while (len < got && ((buf [len] >> 24) & 0x7) != 0x6)
+        ++len;
+
+    // remember the counter of the last event read, see dataReady
+    for (int i = len - 1; i >= 0; --i) {
+        if (((buf [i] >> 24) & 0x7) == 0x4) {
+            drainedEvents = (buf [i] & 0xffff) + 1;
+            break;
+        }
+    }
+
+    raw->resize (len);
+    lastDrain.start ();
+    return 0;
+}
+
+int Caen792Module::eventLength (const uint32_t *data, int len) const {
+    return conf_.multi_event_mode ? CaenADCDemux::blockLength (data, len) : len;
+}
+
+int Caen792Module::decode (Event *ev, const QVector<uint32_t> &raw) {
+    // the data has already been removed from the module, so there is no need to reset it
+    dmx_.processData (ev, raw.constData (), raw.size (), RunManager::ref ().isSingleEventMode ());
+    return 0;
+}
+
+int Caen792Module::setChainPosition (uint8_t cbltAddr, ChainPosition pos) {
+    AbstractInterface *iface = getInterface ();
+    uint16_t ctrl = 0;
+    int ret;
+
+    if (!iface || !iface->isOpen ()) return 1;
+
+    switch (pos) {
+    case ChainFirst:  ctrl = CAEN792_CBLT_FIRST;  break;
+    case ChainMiddle: ctrl = CAEN792_CBLT_MIDDLE; break;
+    case ChainLast:   ctrl = CAEN792_CBLT_LAST;   break;
+    default:          ctrl = 0;
+    }
+
+    // the chained data is split by the GEO address in the data words
+    ret = iface->readA32D16 (conf_.base_addr + CAEN792_GEO_ADDR, &geo);
+    if (ret) printf ("Error %d at CAEN792_GEO_ADDR\n", ret);
+    geo &= 0x1f;
+
+    ret = iface->writeA32D16 (conf_.base_addr + CAEN792_CBLT_ADDR, cbltAddr);
+    if (ret) printf ("Error %d at CAEN792_CBLT_ADDR\n", ret);
+
+    ret = iface->writeA32D16 (conf_.base_addr + CAEN792_CBLT_CTRL, ctrl);
+    if (ret) printf ("Error %d at CAEN792_CBLT_CTRL\n", ret);
+
+    return ret;
+}
+
+int Caen792Module::claimChainedData (const uint32_t *data, int len) const {
+    return CaenADCDemux::claimBlock (data, len, geo);
+}
+
 int Caen792Module::acquireSingle (uint32_t *data, uint32_t *rd) {
     *rd = 0;
     //int ret = getInterface ()->readA32MBLT64 (conf_.base_addr + CAEN792_MEB, data, 34, rd);
@@ -289,7 +412,10 @@ static const confmap_t confmap [] = {
     confmap_t ("zeroSuppressionEnabled", &Caen792ModuleConfig::zeroSuppressionEnabled),
     confmap_t ("zeroSuppressionThr", &Caen792ModuleConfig::zeroSuppressionThr),
     confmap_t ("tdc_stop_mode", &Caen792ModuleConfig::stop_mode),
-    confmap_t ("tdc_fsr", &Caen792ModuleConfig::fsr)
+    confmap_t ("tdc_fsr", &Caen792ModuleConfig::fsr),
+    confmap_t ("multi_event_mode", &Caen792ModuleConfig::multi_event_mode),
+    confmap_t ("multi_event_threshold", &Caen792ModuleConfig::multi_event_threshold),
+    confmap_t ("multi_event_timeout", &Caen792ModuleConfig::multi_event_timeout)
 };
 
 void Caen792Module::applySettings (QSettings *settings) {
@@ -393,7 +519,7 @@ See the manual for further details
 \li <b> Sliding constant</b> sets the value that is added to the ADC inputs when the sliding scale is disabled.
 
 \subsection irq IRQ
-The IRQ panel controls the conditions on which VME interrupt requests are generated. IRQs are not yet used in data readout.
+The IRQ panel controls the conditions on which VME interrupt requests are generated. With interrupt readout enabled in the thread setup, a trigger module with a non-zero IRQ level is read out when its interrupt arrives instead of being polled.
 
 \subsection info Info
 The Info panel provides some basic information about the firmware that runs on the module.
@@ -444,7 +570,7 @@ See the manual for further details
 \li <b> Sliding constant</b> sets the value that is added to the ADC inputs when the sliding scale is disabled.
 
 \subsection irq IRQ
-The IRQ panel controls the conditions on which VME interrupt requests are generated. IRQs are not yet used in data readout.
+The IRQ panel controls the conditions on which VME interrupt requests are generated. With interrupt readout enabled in the thread setup, a trigger module with a non-zero IRQ level is read out when its interrupt arrives instead of being polled.
 
 \subsection info Info
 The Info panel provides some basic information about the firmware that runs on the module.
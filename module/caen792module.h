@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef CAEN792MODULE_H
 #define CAEN792MODULE_H
 
+#include <QTime>
+
 #include "basemodule.h"
 #include "baseplugin.h"
 #include "caenadcdmx.h"
@@ -67,6 +69,11 @@ struct Caen792ModuleConfig {
 
     unsigned int pollcount;
 
+    // multi event readout
+    bool multi_event_mode;
+    uint8_t multi_event_threshold;      // events to collect before draining the buffer
+    unsigned int multi_event_timeout;   // ms after which the buffer is drained anyway
+
     Caen792ModuleConfig ()
     : irq_level (0), irq_vector (0), ev_trg (0)
     , cratenumber (0), fastclear (0), i_ped (180), slideconst (0)
@@ -77,6 +84,7 @@ struct Caen792ModuleConfig {
     , autoIncrementEnabled (true), emptyEventWriteEnabled (false), slideSubEnabled (false)
     , alwaysIncrementEventCounter (false)
     , pollcount (10000)
+    , multi_event_mode (false), multi_event_threshold (16), multi_event_timeout (10)
     {
         for (int i = 0; i < CAEN_V792_NOF_CHANNELS; ++i) {
             killChannel [i] = false;
@@ -106,7 +114,20 @@ public:
 
     virtual void setChannels ();
     virtual int acquire (Event* ev);
+    virtual bool hasRawReadout () const { return conf_.multi_event_mode; }
+    virtual int acquireRaw (QVector<uint32_t> *raw);
+    virtual int decode (Event *ev, const QVector<uint32_t> &raw);
+    virtual int eventLength (const uint32_t *data, int len) const;
+    virtual int setChainPosition (uint8_t cbltAddr, ChainPosition pos);
+    virtual int claimChainedData (const uint32_t *data, int len) const;
     virtual bool dataReady ();
+    virtual int appendStatusReads (QVector<VmeOp> *ops) const;
+    virtual bool dataReadyFromStatus (const VmeOp *status);
+    virtual bool getIrq (uint8_t *level, uint8_t *vector) const {
+        *level = conf_.irq_level & 7;
+        *vector = conf_.irq_vector;
+        return *level != 0;
+    }
     virtual int reset ();
     virtual int configure ();
 
@@ -138,6 +159,9 @@ public slots:
     void singleShot (uint32_t *data, uint32_t *rd);
     virtual void prepareForNextAcquisition () {}
 
+private:
+    bool bufferReady (); // rest of dataReady, after status 1 has been read
+
 private:
     Caen792ModuleConfig conf_;
     bool isqdc;
@@ -147,10 +171,15 @@ private:
     uint16_t bitset2;
     uint16_t status1;
     uint16_t status2;
+    uint16_t geo;
     uint32_t evcnt;
     uint32_t data [CAEN_V792_MAX_NOF_WORDS];
     uint32_t rd;
 
+    // multi event readout
+    uint16_t drainedEvents; // event counter after the last event read, lower 16 bits
+    QTime lastDrain;
+
     CaenADCDemux dmx_;
     QVector<EventSlot*> evslots_;
 };
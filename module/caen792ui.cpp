@@ -267,12 +267,36 @@ QWidget* Caen792UI::createInterruptControls()
     nofEventSpinner->setMaximum(512);
     nofEventSpinner->setValue(module->getConfig ()->ev_trg);
 
+    multiEventBox = new QCheckBox(tr("Multi event readout"));
+    multiEventBox->setToolTip(tr("Let events collect in the module and read them with one block transfer"));
+    multiEventBox->setChecked(module->getConfig ()->multi_event_mode);
+
+    QLabel *multiEventThresholdLabel = new QLabel(tr("Events per transfer:"));
+    multiEventThresholdSpinner = new QSpinBox();
+    multiEventThresholdSpinner->setRange(1,CAEN792_MEB_EVENTS);
+    multiEventThresholdSpinner->setValue(module->getConfig ()->multi_event_threshold);
+
+    QLabel *multiEventTimeoutLabel = new QLabel(tr("Transfer timeout:"));
+    multiEventTimeoutSpinner = new QSpinBox();
+    multiEventTimeoutSpinner->setRange(0,10000);
+    multiEventTimeoutSpinner->setSuffix(tr(" ms"));
+    multiEventTimeoutSpinner->setValue(module->getConfig ()->multi_event_timeout);
+
+    connect(multiEventBox,SIGNAL(toggled(bool)),this,SLOT(multiEventChanged()));
+    connect(multiEventThresholdSpinner,SIGNAL(valueChanged(int)),this,SLOT(multiEventChanged()));
+    connect(multiEventTimeoutSpinner,SIGNAL(valueChanged(int)),this,SLOT(multiEventChanged()));
+
     l->addWidget(irqLevelLabel,0,0,1,1);
     l->addWidget(irqLevelSpinner,0,1,1,1);
     l->addWidget(irqVectorLabel,1,0,1,1);
     l->addWidget(irqVectorEdit,1,1,1,1);
     l->addWidget(nofEventLabel,2,0,1,1);
     l->addWidget(nofEventSpinner,2,1,1,1);
+    l->addWidget(multiEventBox,3,0,1,2);
+    l->addWidget(multiEventThresholdLabel,4,0,1,1);
+    l->addWidget(multiEventThresholdSpinner,4,1,1,1);
+    l->addWidget(multiEventTimeoutLabel,5,0,1,1);
+    l->addWidget(multiEventTimeoutSpinner,5,1,1,1);
 
     box->setLayout(l);
     return box;
@@ -464,6 +488,14 @@ void Caen792UI::crateNoChanged()
     module->getConfig ()->cratenumber = crateNumberSpinner->value();
 }
 
+void Caen792UI::multiEventChanged()
+{
+    if (blockSlots) return;
+    module->getConfig ()->multi_event_mode      = multiEventBox->isChecked();
+    module->getConfig ()->multi_event_threshold = multiEventThresholdSpinner->value();
+    module->getConfig ()->multi_event_timeout   = multiEventTimeoutSpinner->value();
+}
+
 void Caen792UI::nofEventsChanged()
 {
     module->getConfig ()->ev_trg = nofEventSpinner->value();
@@ -531,6 +563,9 @@ void Caen792UI::applySettings()
     slideconstSpinner->setValue(module->getConfig ()->slideconst);
     irqLevelSpinner->setValue(module->getConfig ()->irq_level);
     nofEventSpinner->setValue(module->getConfig ()->ev_trg);
+    multiEventBox->setChecked(module->getConfig ()->multi_event_mode);
+    multiEventThresholdSpinner->setValue(module->getConfig ()->multi_event_threshold);
+    multiEventTimeoutSpinner->setValue(module->getConfig ()->multi_event_timeout);
 
     for(int ch = 0; ch < 32; ++ch) {
         //printf("Settings value: ch:%d, val:%d, kill:%d\n",ch,
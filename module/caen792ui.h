@@ -70,6 +70,7 @@ public slots:
 	void ipedChanged();
 	void fclrChanged();
         void slideconstChanged();
+        void multiEventChanged();
 
 private:
 	Caen792Module* module;
@@ -112,6 +113,10 @@ private:
 
 	QSpinBox* nofTestConversionBox;
 
+	QCheckBox* multiEventBox;
+	QSpinBox* multiEventThresholdSpinner;
+	QSpinBox* multiEventTimeoutSpinner;
+
 	QPushButton* dataResetButton;
 	QPushButton* evcntResetButton;
 	QPushButton* softResetButton;
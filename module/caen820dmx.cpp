@@ -79,7 +79,7 @@ bool Caen820Demux::processData (Event *ev, const uint32_t *data, int len) {
         }
 
         if(enable_per_channel_output) {
-            ev->put (evslots_.at (i), QVariant::fromValue (QVector<uint32_t> () << *data));
+            ev->copyData (evslots_.at (i), data, 1);
         }
         if(enable_raw_output) {
             rawData[rawCnt++] = (*data);
@@ -89,7 +89,7 @@ bool Caen820Demux::processData (Event *ev, const uint32_t *data, int len) {
     }
 
     if(enable_raw_output) {
-        ev->put(evslots_.last(), QVariant::fromValue(rawData));
+        ev->copyData (evslots_.last (), rawData.constData (), rawData.size ());
     }
 
     return true;
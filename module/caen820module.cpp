@@ -98,6 +98,20 @@ bool Caen820Module::dataReady () {
     return (stat & (1 << CAEN820_STA_DREADY)) != 0;
 }
 
+int Caen820Module::appendStatusReads (QVector<VmeOp> *ops) const {
+    ops->push_back (VmeOp::read16 (conf_.baddr + CAEN820_STATUS));
+    return 1;
+}
+
+bool Caen820Module::dataReadyFromStatus (const VmeOp *status) {
+    if (status [0].error) {
+        std::cout << "Error " << status [0].error << " at CAEN820_STATUS" << std::endl;
+        return false;
+    }
+
+    return (status [0].data & (1 << CAEN820_STA_DREADY)) != 0;
+}
+
 int Caen820Module::reset () {
     int err = 0;
     AbstractInterface *iface = getInterface ();
@@ -58,6 +58,8 @@ public:
     void setChannels ();
     int acquire (Event *ev);
     bool dataReady ();
+    int appendStatusReads (QVector<VmeOp> *ops) const;
+    bool dataReadyFromStatus (const VmeOp *status);
     int reset ();
     int configure ();
     void setBaseAddress (uint32_t baddr);
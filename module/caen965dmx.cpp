@@ -79,7 +79,7 @@ void Caen965Demux::runStartingEvent() {
     printf("Caen965Demux::runStartingEvent: enable_per_channel_output %d\n",enable_per_channel_output);
 }
 
-bool Caen965Demux::processData (Event* ev, uint32_t *data, uint32_t len, bool singleev)
+bool Caen965Demux::processData (Event* ev, const uint32_t *data, uint32_t len, bool singleev)
 {
     //std::cout << "DemuxCaen965Plugin Processing" << std::endl;
     it = data;
@@ -186,10 +186,7 @@ bool Caen965Demux::finishEvent(Event *ev)
         for (std::map<uint8_t,uint16_t>::const_iterator i = chData.begin (); i != chData.end (); ++i) {
             // Publish event data
             if (owner->getOutputPlugin ()->isSlotConnected (evslots.at (i->first))) {
-                const EventSlot* sl = evslots.at (i->first);
-                QVector<uint32_t> v = ev->get (sl).value< QVector<uint32_t> > ();
-                v << i->second;
-                ev->put (evslots.at (i->first), QVariant::fromValue (v));
+                ev->store< QVector<uint32_t> > (evslots.at (i->first)) << i->second;
             }
         }
 
@@ -201,7 +198,7 @@ bool Caen965Demux::finishEvent(Event *ev)
 
     if(enable_raw_output){
         rawData[rawCnt++] = (*it);
-        ev->put(evslots.last(), QVariant::fromValue(rawData));
+        ev->copyData (evslots.last (), rawData.constData (), rawData.size ());
     }
 
     return true;
@@ -71,7 +71,7 @@ private:
     const QVector<EventSlot*>& evslots;
     const AbstractModule *owner;
 
-    uint32_t* it;
+    const uint32_t* it;
 
     void startNewEvent();
     void continueEvent();
@@ -84,7 +84,7 @@ public:
                  uint chans = CAEN_V965_NOF_CHANNELS,
                  uint bits = CAEN_V965_NOF_BITS);
 
-    bool processData (Event *ev, uint32_t* data, uint32_t len, bool singleev);
+    bool processData (Event *ev, const uint32_t* data, uint32_t len, bool singleev);
     void runStartingEvent();
 };
 
@@ -20,12 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "caen965module.h"
 #include "caen_v965.h"
 #include "caen965ui.h"
+#include "caenadcdmx.h"
 #include "modulemanager.h"
 #include "runmanager.h"
 #include "confmap.h"
 
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 using namespace std;
 static ModuleRegistrar reg1 ("caen965", Caen965Module::create);
@@ -37,6 +39,7 @@ Caen965Module::Caen965Module (int i, const QString &n)
     , bitset2 (0)
     , status1 (0)
     , status2 (0)
+    , geo     (0)
     , evcnt   (0)
     , dmx_    (evslots_, this)
 {
@@ -74,12 +77,18 @@ int Caen965Module::configure () {
     ret = iface->writeA32D16(baddr + CAEN965_GEO_ADDR, 0x00);
     if (ret) printf ("Error %d at CAEN965_GEO_ADDR", ret);
 
-    // set channel thresholds and kill bits
-    for (int i = 0; i < 32; ++i) {
-        ret = iface->writeA32D16 (baddr + CAEN965_THRESHOLDS + 2*i,
-                                  conf_.thresholds [i]
-                                  | (conf_.killChannel [i] ? (1 << CAEN965_THRESH_KILL) : 0));
-        if (ret) printf ("Error %d at CAEN965_THRESHOLDS[%d]\n", ret, i);
+    // set channel thresholds and kill bits with one access list
+    std::vector<VmeOp> ops;
+    for (int i = 0; i < 32; ++i)
+        ops.push_back (VmeOp::write16 (baddr + CAEN965_THRESHOLDS + 2*i,
+                                       conf_.thresholds [i]
+                                       | (conf_.killChannel [i] ? (1 << CAEN965_THRESH_KILL) : 0)));
+    ret = iface->executeList (&ops [0], ops.size ());
+    for (int i = 0; ret && i < 32; ++i) {
+        if (ops [i].error) {
+            printf ("Error %d at CAEN965_THRESHOLDS[%d]\n", ops [i].error, i);
+            break;
+        }
     }
 
     ret = iface->writeA32D16 (baddr + CAEN965_CONTROL1,
@@ -171,30 +180,29 @@ uint16_t Caen965Module::getInfo () const {
 }
 
 int Caen965Module::readStatus () {
-    AbstractInterface *iface = getInterface ();
-    int ret;
-    uint16_t data;
-
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_BIT_SET1, &bitset1);
-    if (ret)
-            printf ("Error %d at CAEN965_BIT_SET1\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_BIT_SET2, &bitset2);
-    if (ret)
-            printf ("Error %d at CAEN965_BIT_SET2\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_STAT1, &status1);
-    if (ret)
-            printf ("Error %d at CAEN965_STAT1\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_STAT2, &status2);
-    if (ret)
-            printf ("Error %d at CAEN965_STAT2\n", ret);
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_EVCNT_L, &data);
-    if (ret)
-            printf ("Error %d at CAEN965_EVCNT_L\n", ret);
-    evcnt = data;
-    ret = iface->readA32D16 (conf_.base_addr + CAEN965_EVCNT_H, &data);
-    if (ret)
-        printf ("Error %d at CAEN965_EVCNT_H\n", ret);
-    evcnt |= (((uint32_t)(data) & 0x000000ff) << 16);
+    static const char *names [] = { "BIT_SET1", "BIT_SET2", "STAT1", "STAT2", "EVCNT_L", "EVCNT_H" };
+    uint32_t baddr = conf_.base_addr;
+    VmeOp ops [] = {
+        VmeOp::read16 (baddr + CAEN965_BIT_SET1),
+        VmeOp::read16 (baddr + CAEN965_BIT_SET2),
+        VmeOp::read16 (baddr + CAEN965_STAT1),
+        VmeOp::read16 (baddr + CAEN965_STAT2),
+        VmeOp::read16 (baddr + CAEN965_EVCNT_L),
+        VmeOp::read16 (baddr + CAEN965_EVCNT_H)
+    };
+
+    // one access list instead of six single cycles
+    getInterface ()->executeList (ops, 6);
+    for (int i = 0; i < 6; ++i)
+        if (ops [i].error)
+            printf ("Error %d at CAEN965_%s\n", ops [i].error, names [i]);
+
+    bitset1 = ops [0].data;
+    bitset2 = ops [1].data;
+    status1 = ops [2].data;
+    status2 = ops [3].data;
+    evcnt = ops [4].data;
+    evcnt |= (((uint32_t)(ops [5].data) & 0x000000ff) << 16);
     return 0;
 }
 
@@ -207,6 +215,19 @@ bool Caen965Module::dataReady () {
     return (status1 & (1 << CAEN965_S1_DREADY)) != 0;
 }
 
+int Caen965Module::appendStatusReads (QVector<VmeOp> *ops) const {
+    ops->push_back (VmeOp::read16 (conf_.base_addr + CAEN965_STAT1));
+    return 1;
+}
+
+bool Caen965Module::dataReadyFromStatus (const VmeOp *status) {
+    if (status [0].error)
+        printf ("Error %d at CAEN965_STAT1\n", status [0].error);
+    status1 = status [0].data;
+
+    return (status1 & (1 << CAEN965_S1_DREADY)) != 0;
+}
+
 int Caen965Module::acquire (Event* ev) {
     int ret;
 
@@ -228,6 +249,44 @@ void Caen965Module::writeToBuffer(Event *ev)
         dataReset ();
 }
 
+int Caen965Module::decode (Event *ev, const QVector<uint32_t> &raw) {
+    // the data has already been removed from the module, so there is no need to reset it
+    dmx_.processData (ev, raw.constData (), raw.size (), RunManager::ref ().isSingleEventMode ());
+    return 0;
+}
+
+int Caen965Module::setChainPosition (uint8_t cbltAddr, ChainPosition pos) {
+    AbstractInterface *iface = getInterface ();
+    uint16_t ctrl = 0;
+    int ret;
+
+    if (!iface || !iface->isOpen ()) return 1;
+
+    switch (pos) {
+    case ChainFirst:  ctrl = CAEN965_CBLT_FIRST;  break;
+    case ChainMiddle: ctrl = CAEN965_CBLT_MIDDLE; break;
+    case ChainLast:   ctrl = CAEN965_CBLT_LAST;   break;
+    default:          ctrl = 0;
+    }
+
+    // the chained data is split by the GEO address in the data words
+    ret = iface->readA32D16 (conf_.base_addr + CAEN965_GEO_ADDR, &geo);
+    if (ret) printf ("Error %d at CAEN965_GEO_ADDR\n", ret);
+    geo &= 0x1f;
+
+    ret = iface->writeA32D16 (conf_.base_addr + CAEN965_CBLT_ADDR, cbltAddr);
+    if (ret) printf ("Error %d at CAEN965_CBLT_ADDR\n", ret);
+
+    ret = iface->writeA32D16 (conf_.base_addr + CAEN965_CBLT_CTRL, ctrl);
+    if (ret) printf ("Error %d at CAEN965_CBLT_CTRL\n", ret);
+
+    return ret;
+}
+
+int Caen965Module::claimChainedData (const uint32_t *data, int len) const {
+    return CaenADCDemux::claimBlock (data, len, geo);
+}
+
 int Caen965Module::acquireSingle (uint32_t *data, uint32_t *rd) {
     *rd = 0;
 
@@ -376,7 +435,7 @@ See the manual for further details
 \li <b> Sliding constant</b> sets the value that is added to the ADC inputs when the sliding scale is disabled.
 
 \subsection irq IRQ
-The IRQ panel controls the conditions on which VME interrupt requests are generated. IRQs are not yet used in data readout.
+The IRQ panel controls the conditions on which VME interrupt requests are generated. With interrupt readout enabled in the thread setup, a trigger module with a non-zero IRQ level is read out when its interrupt arrives instead of being polled.
 
 \subsection info Info
 The Info panel provides some basic information about the firmware that runs on the module.
@@ -103,7 +103,17 @@ public:
 
     virtual void setChannels ();
     virtual int acquire (Event* ev);
+    virtual int decode (Event *ev, const QVector<uint32_t> &raw);
+    virtual int setChainPosition (uint8_t cbltAddr, ChainPosition pos);
+    virtual int claimChainedData (const uint32_t *data, int len) const;
     virtual bool dataReady ();
+    virtual int appendStatusReads (QVector<VmeOp> *ops) const;
+    virtual bool dataReadyFromStatus (const VmeOp *status);
+    virtual bool getIrq (uint8_t *level, uint8_t *vector) const {
+        *level = conf_.irq_level & 7;
+        *vector = conf_.irq_vector;
+        return *level != 0;
+    }
     virtual int reset ();
     virtual int configure ();
 
@@ -141,6 +151,7 @@ private:
     uint16_t bitset2;
     uint16_t status1;
     uint16_t status2;
+    uint16_t geo;
     uint32_t evcnt;
     uint32_t data [CAEN_V965_MAX_NOF_WORDS];
     uint32_t rd;
@@ -117,6 +117,8 @@ uint16_t thr[32];	// rw:	Thresholds		0x1080
 // Registers
 #define CAEN785_MEB         0x0000
 #define CAEN785_FIRMWARE    0x1000
+#define CAEN785_GEO_ADDR    0x1002
+#define CAEN785_CBLT_ADDR   0x1004
 #define CAEN785_BIT_SET1    0x1006
 #define CAEN785_BIT_CLR1    0x1008
 #define CAEN785_IRQ_LVL     0x100A
@@ -126,6 +128,7 @@ uint16_t thr[32];	// rw:	Thresholds		0x1080
 #define CAEN785_ADER_HIGH   0x1012
 #define CAEN785_ADER_LOW    0x1014
 #define CAEN785_SINGLE_RST  0x1016
+#define CAEN785_CBLT_CTRL   0x101A
 #define CAEN785_EV_TRG      0x1020
 #define CAEN785_STAT2       0x1022
 #define CAEN785_EVCNT_L     0x1024
@@ -141,6 +144,14 @@ uint16_t thr[32];	// rw:	Thresholds		0x1080
 #define CAEN785_SLIDE_CONST 0x106A
 #define CAEN785_THRESHOLDS  0x1080
 
+#define CAEN785_MEB_EVENTS  32 // events the multi event buffer can hold
+#define CAEN785_S2_BUFFULL  2
+
+// CBLT control register values
+#define CAEN785_CBLT_LAST   0x1
+#define CAEN785_CBLT_FIRST  0x2
+#define CAEN785_CBLT_MIDDLE 0x3
+
 // ROM defines
 #define CAEN785_ROM_OUIMSB     0x8026
 #define CAEN785_ROM_OUI        0x802a
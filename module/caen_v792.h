@@ -109,6 +109,12 @@ typedef struct {
 #define CAEN792_B1_SELADDR	4
 #define CAEN792_B1_SOFTRST	7
 
+#define CAEN792_MEB_EVENTS	32 // events the multi event buffer can hold
+
+#define CAEN792_CBLT_LAST	0x1
+#define CAEN792_CBLT_FIRST	0x2
+#define CAEN792_CBLT_MIDDLE	0x3
+
 #define CAEN792_S1_DREADY	0
 #define CAEN792_S1_GDREADY	1
 #define CAEN792_S1_BUSY		2
@@ -106,6 +106,10 @@ typedef struct {
 #define CAEN965_B1_SELADDR	4
 #define CAEN965_B1_SOFTRST	7
 
+#define CAEN965_CBLT_LAST	0x1
+#define CAEN965_CBLT_FIRST	0x2
+#define CAEN965_CBLT_MIDDLE	0x3
+
 #define CAEN965_S1_DREADY	0
 #define CAEN965_S1_GDREADY	1
 #define CAEN965_S1_BUSY		2
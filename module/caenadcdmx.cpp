@@ -75,7 +75,7 @@ void CaenADCDemux::runStartingEvent() {
     printf("CaenADCDemux::runStartingEvent: enable_per_channel_output %d\n",enable_per_channel_output);
 }
 
-bool CaenADCDemux::processData (Event* ev, uint32_t *data, uint32_t len, bool singleev)
+bool CaenADCDemux::processData (Event* ev, const uint32_t *data, uint32_t len, bool singleev)
 {
     //std::cout << "DemuxCaenADCPlugin Processing" << std::endl;
     it = data;
@@ -130,6 +130,32 @@ bool CaenADCDemux::processData (Event* ev, uint32_t *data, uint32_t len, bool si
     return true;
 }
 
+int CaenADCDemux::blockLength (const uint32_t *data, int len)
+{
+    if (len < 1 || ((data [0] >> 24) & 0x7) != 0x2)
+        return 0;
+
+    // every word carries the GEO address in bits 27..31
+    uint8_t geo = data [0] >> 27;
+    int n = 1;
+    while (n < len && (data [n] >> 27) == geo) {
+        uint8_t type = ((data [n] >> 24) & 0x7);
+        if (type == 0x2) // next header without end of block
+            break;
+        ++n;
+        if (type == 0x4)
+            break;
+    }
+    return n;
+}
+
+int CaenADCDemux::claimBlock (const uint32_t *data, int len, uint8_t geo)
+{
+    if (len < 1 || (data [0] >> 27) != geo)
+        return 0;
+    return blockLength (data, len);
+}
+
 void CaenADCDemux::startNewEvent()
 {
     //    std::cout << "DemuxCaenADCPlugin: Start" << std::endl;
@@ -188,17 +214,14 @@ bool CaenADCDemux::finishEvent(Event *ev)
         for (std::map<uint8_t,uint16_t>::const_iterator i = chData.begin (); i != chData.end (); ++i) {
             // Publish event data
             if (owner->getOutputPlugin ()->isSlotConnected (evslots.at (i->first))) {
-                const EventSlot* sl = evslots.at (i->first);
-                QVector<uint32_t> v = ev->get (sl).value< QVector<uint32_t> > ();
-                v << i->second;
-                ev->put (evslots.at (i->first), QVariant::fromValue (v));
+                ev->store< QVector<uint32_t> > (evslots.at (i->first)) << i->second;
             }
         }
     }
 
     if(enable_raw_output){
         rawData[rawCnt++] = (*it);
-        ev->put(evslots.last(), QVariant::fromValue(rawData));
+        ev->copyData (evslots.last (), rawData.constData (), rawData.size ());
     }
 
     return true;
@@ -61,7 +61,7 @@ private:
     const QVector<EventSlot*>& evslots;
     const AbstractModule *owner;
 
-    uint32_t* it;
+    const uint32_t* it;
 
     void startNewEvent();
     void continueEvent();
@@ -74,8 +74,19 @@ public:
                  uint chans = CAEN_V792_V775_NOF_CHANNELS,
                  uint bits = CAEN_V792_V775_NOF_BITS);
 
-    bool processData (Event *ev, uint32_t* data, uint32_t len, bool singleev);
+    bool processData (Event *ev, const uint32_t* data, uint32_t len, bool singleev);
     void runStartingEvent();
+
+    /*! Returns the length of the event block (header to end of block) at the start of \c data,
+     *  or 0 if \c data does not start with a header.
+     *  Works for all CAEN boards with the V785 data format, see AbstractModule::eventLength.
+     */
+    static int blockLength (const uint32_t *data, int len);
+
+    /*! Like #blockLength, but only for blocks of the board with GEO address \c geo.
+     *  \sa AbstractModule::claimChainedData
+     */
+    static int claimBlock (const uint32_t *data, int len, uint8_t geo);
 };
 
 #endif // DEMUXCAENADCPLUGIN_H
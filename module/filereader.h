@@ -7,6 +7,8 @@
 #define FILEREADER_NUM_CHANNELS 4
 #define FILEREADER_NUM_BITS 8
 
-#define FILEREADER_TEMP_MAX_SIZE 10000
+// Replay
+#define FILEREADER_NUM_OUTPUTS 8                 // inputs of an EventBuilder file, channels of a SIS3302 file
+#define FILEREADER_MAX_READ_BYTES (16*1024*1024) // data handed to the run thread per acquisition
 
 #endif // FILEREADER_H
@@ -21,210 +21,207 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eventbuffer.h"
 #include "abstractmodule.h"
 #include "outputplugin.h"
+
+#include <QtEndian>
+
+#include <cstdio>
 #include <iostream>
 
-FileReaderDemux::FileReaderDemux(const QVector<EventSlot*>& _evslots,
-                           const AbstractModule* own,
-                           uint chans, uint bits)
-    : inEvent (false)
-    , cnt (0)
-    , enable_raw_output(false)
-    , enable_per_channel_output(false)
-    , nofChannels (chans)
-    , nofChannelsInEvent(0)
-    , nofBits (bits)
-    , evslots (_evslots)
+static const uint32_t Sis3302Header = 0x33021410;
+static const uint32_t Sis3350Marker = 0xBBBB3000;
+
+// Returns the first channel after prev in mask, 32 if there is none
+static int nextChannel (uint32_t mask, int prev)
+{
+    for (int ch = prev + 1; ch < 32; ++ch)
+        if (mask & (1u << ch))
+            return ch;
+    return 32;
+}
+
+FileReaderDemux::FileReaderDemux(const QVector<EventSlot*>& _evslots, const AbstractModule* own)
+    : evslots (_evslots)
     , owner (own)
+    , enable_raw_output (false)
+    , raw_done (false)
 {
-    // if (nofChannels == 0) {
-    //     nofChannels = MADC32V2_NUM_CHANNELS;
-    //     std::cout << "FileReaderDemux: nofChannels invalid. Setting to 32" << std::endl;
-    // }
-    // 
-    // if (nofBits == 0) {
-    //     nofBits = MADC32V2_NUM_BITS;
-    //     std::cout << "FileReaderDemux: nofBits invalid. Setting to 12" << std::endl;
-    // }
-    // 
-    // rawData.resize(MADC32V2_LEN_EVENT_MAX);
-    // enable_ch.resize(MADC32V2_NUM_CHANNELS);
-
-    rawData.resize(FILEREADER_TEMP_MAX_SIZE);
-    enable_ch.resize(nofChannels);
+    enable_ch.fill (false, FILEREADER_NUM_OUTPUTS + 1);
     std::cout << "Instantiated FileReaderDemux" << std::endl;
 }
 
 void FileReaderDemux::runStartingEvent() {
-    if (owner->getOutputPlugin ()->isSlotConnected (evslots.last())) {
-        enable_raw_output = true;
-    } else {
-        enable_raw_output = false;
-    }
-    
+    enable_raw_output = owner->getOutputPlugin ()->isSlotConnected (evslots.last());
+
+    // data outputs and the meta output
     int cnt = 0;
-    // for(int ch = 0; ch < MADC32V2_NUM_CHANNELS; ++ch) {
-    for(int ch = 0; ch < FILEREADER_NUM_CHANNELS; ++ch) {
-        if (owner->getOutputPlugin ()->isSlotConnected (evslots.at(ch))) {
-            enable_per_channel_output = true;
-            enable_ch[ch] = true;
-            cnt++;
-        } else {
-            enable_ch[ch] = false;
-        }
+    for(int ch = 0; ch < enable_ch.size (); ++ch) {
+        enable_ch[ch] = owner->getOutputPlugin ()->isSlotConnected (evslots.at(ch));
+        if(enable_ch[ch]) cnt++;
     }
-    if(cnt == 0) enable_per_channel_output = false;
 
     printf("FileReaderDemux::runStartingEvent: enable_raw_output %d\n",enable_raw_output);
-    printf("FileReaderDemux::runStartingEvent: enable_per_channel_output %d\n",enable_per_channel_output);
+    printf("FileReaderDemux::runStartingEvent: %d outputs connected\n",cnt);
 }
 
-//bool FileReaderDemux::processData (Event* ev, uint32_t *data, uint32_t len, bool singleev)
-bool FileReaderDemux::processData (Event* ev, QFile *file, uint32_t len, bool singleev)
+FileReaderDemux::Format FileReaderDemux::detectFormat (const uchar *prefix)
 {
-    std::cout << "DemuxFileReaderPlugin Processing" << std::endl;
-
-//    short *bytedata = new short[len]
-//    int length_read = file->read(bytedata, 2*len);
-    short a;
-    int length_read;
-    for(int i=0; i<len; i++) {
-        length_read = file->read((char *)&a, sizeof(a));
-        if(length_read > 0) {
-            rawData[i] = (double)(-(a>>8));
-        } else {
-            // TODO: throw an error
-        }
-    }
-    ev->put(evslots.last(), QVariant::fromValue(rawData));
-    // it = data;
-    // 
-    // while(it != (data+len))
-    // {
-    //     //printf("0x%08x\n",*it);
-    // 
-    //     id = 0x0 | (((*it) >> MADC32V2_OFF_DATA_SIG) & MADC32V2_MSK_DATA_SIG);
-    // 
-    //     if(id == MADC32V2_SIG_HEADER)
-    //     {
-    //         if(!inEvent) startNewEvent();
-    //         else {
-    //             std::cout << "Already in event!" << std::endl;
-    //         }
-    //     }
-    //     else if(id == MADC32V2_SIG_DATA)
-    //     {
-    //         if(inEvent) continueEvent();
-    //         else std::cout << "Not in event!" << std::endl;
-    //     }
-    //     else if(id == MADC32V2_SIG_END || id == MADC32V2_SIG_END_BERR)
-    //     {
-    //         if(inEvent) {
-    //             bool go_on = finishEvent(ev);
-    // 
-    //             if (singleev || ! go_on)
-    //                 return false;
-    //         }
-    //         else std::cout << "Not in event!" << std::endl;
-    //     }
-    //     else
-    //     {
-    //         std::cout << "Unknown data word " << std::hex << (*it) << std::endl;
-    //     }
-    // 
-    //     it++;
-    // }
-    return true;
+    if (qFromLittleEndian<quint16> (prefix) == 0xFEED)
+        return EventBuilder;
+
+    uint32_t first = qFromLittleEndian<quint32> (prefix);
+    if (first == Sis3302Header)
+        return Sis3302;
+    if (first == Sis3350Marker)
+        return Sis3350;
+    return Unknown;
 }
 
-void FileReaderDemux::startNewEvent()
+const char *FileReaderDemux::formatName (Format format)
 {
-    std::cout << "DemuxFileReaderPlugin::startNewEvent" << std::endl;
-    // inEvent = true;
-    // 
-    // header.data = (*it);
-    // 
-    // if(enable_per_channel_output) {
-    //     cnt = 0;
-    //     chData.clear ();
-    // }
-    // 
-    // if(enable_raw_output) {
-    //     rawData.fill(0);
-    //     rawCnt = 0;
-    //     rawData[rawCnt++] = (*it);
-    // }
-    // 
-    // //printHeader();
+    switch (format) {
+    case EventBuilder: return "EventBuilder";
+    case Sis3302: return "SIS3302 raw";
+    case Sis3350: return "SIS3350 raw";
+    default: return "unknown";
+    }
 }
 
-void FileReaderDemux::continueEvent()
+uint32_t FileReaderDemux::headerSize (Format format, const uchar *prefix)
 {
-    // if(enable_raw_output) {
-    //     rawData[rawCnt++] = (*it);
-    // }
-    // 
-    // if(enable_per_channel_output) {
-    //     madc32_data_t data;
-    //     data.data = (*it);
-    //     if(data.bits.sub_signature == MADC32V2_SIG_DATA_EVENT) {
-    //         if(data.bits.channel < nofChannels) {
-    //             if(data.bits.value < (1 << nofBits) && !data.bits.out_of_range) {
-    //                 chData.insert(std::make_pair(data.bits.channel,data.bits.value));
-    //             }
-    //         } else {
-    //             std::cout << "DemuxFileReader: got invalid channel number " << std::dec << (int)data.bits.channel << std::endl;
-    //         }
-    //     } else if (data.bits.sub_signature == MADC32V2_SIG_DATA_DUMMY) {
-    //         // Do nothing
-    //     } else if (data.bits.sub_signature == MADC32V2_SIG_DATA_TIME) {
-    //         madc32_extended_timestamp_t time;
-    //         time.data = (*it);
-    //         std::cout << "DemuxFileReader: Found extended timestamp: "
-    //                   << std::dec << (uint32_t) time.bits.timestamp << std::endl;
-    //     } else {
-    //         std::cout << "DemuxFileReader: No valid sub signature in word: "
-    //                   << std::hex << (uint32_t) data.data << std::endl;
-    //     }
-    //     cnt++;
-    // }
+    if (detectFormat (prefix) != format)
+        return 0;
+
+    switch (format) {
+    case EventBuilder: {
+        uint16_t headerLength = qFromLittleEndian<quint16> (prefix + 2);
+        return headerLength >= 2 ? headerLength * 4 : 0;
+    }
+    case Sis3302: {
+        uint32_t headerLength = qFromLittleEndian<quint32> (prefix + 4);
+        return headerLength >= 4 && headerLength <= 4 + 8 ? headerLength * 4 : 0;
+    }
+    case Sis3350:
+        return 8 * 4;
+    default:
+        return 0;
+    }
 }
 
-bool FileReaderDemux::finishEvent(Event *ev)
+int64_t FileReaderDemux::eventSize (Format format, const uchar *header)
 {
-    // inEvent = false;
-    // 
-    // if(enable_per_channel_output) {
-    //     trailer.data = (*it);
-    //     eventCounter = trailer.bits.trigger_counter;
-    //     //printEob();
-    // 
-    //     for (std::map<uint8_t,uint16_t>::const_iterator i = chData.begin (); i != chData.end (); ++i) {
-    //         // Publish event data
-    //         if (owner->getOutputPlugin ()->isSlotConnected (evslots.at (i->first))) {
-    //             const EventSlot* sl = evslots.at (i->first);
-    //             QVector<uint32_t> v = ev->get (sl).value< QVector<uint32_t> > ();
-    //             v << i->second;
-    //             ev->put (evslots.at (i->first), QVariant::fromValue (v));
-    //         }
-    //     }
-    // }
-    // 
-    // if(enable_raw_output){
-    //     rawData[rawCnt++] = (*it);
-    //     ev->put(evslots.last(), QVariant::fromValue(rawData));
-    // }
+    uint64_t size = 0;
+
+    switch (format) {
+    case EventBuilder: {
+        uint32_t nofInputs = qFromLittleEndian<quint16> (header + 2) - 2;
+        uint64_t words = 2 + 2 * nofInputs; // header, lengths and separators
+        for (uint32_t i = 0; i < nofInputs; ++i)
+            words += qFromLittleEndian<quint32> (header + 8 + 4 * i);
+        size = words * 4;
+        break;
+    }
+    case Sis3302: {
+        uint32_t headerLength = qFromLittleEndian<quint32> (header + 4);
+        uint32_t totalLength = qFromLittleEndian<quint32> (header + 12);
+        uint64_t samples = 0;
+        for (uint32_t i = 4; i < headerLength; ++i)
+            samples += qFromLittleEndian<quint32> (header + 4 * i);
+        if (totalLength < headerLength || totalLength - headerLength != samples)
+            return -1;
+        size = headerLength * 4 + samples * 2;
+        break;
+    }
+    case Sis3350: {
+        uint32_t length = qFromLittleEndian<quint32> (header + 4); // meta words and samples
+        if (length < 8)
+            return -1;
+        size = 8 * 4 + static_cast<uint64_t> (length - 8) * 2;
+        break;
+    }
+    default:
+        return -1;
+    }
 
-    return true;
+    // more than 1 GiB is no event but garbage
+    return size <= (1 << 30) ? static_cast<int64_t> (size) : -1;
 }
 
-void FileReaderDemux::printHeader()
+bool FileReaderDemux::processEvent (Event *ev, Format format, const uchar *data, size_t len)
 {
-    // printf("nof words %u, resolution %u, module id %u, output format %u\n",
-    //        header.bits.data_length,header.bits.adc_resolution,
-    //        header.bits.module_id,header.bits.output_format);fflush(stdout);
+    const uchar *it = data;
+    const uchar *end = data + len;
+    int ch = -1;
+    raw_done = false;
+
+    switch (format) {
+    case EventBuilder: {
+        uint32_t nofInputs = qFromLittleEndian<quint16> (data + 2) - 2;
+        uint32_t chMask = qFromLittleEndian<quint32> (data + 4);
+        it += 4 * (2 + nofInputs);
+        for (uint32_t i = 0; i < nofInputs; ++i) {
+            uint32_t n = qFromLittleEndian<quint32> (data + 8 + 4 * i);
+            if (4 * (static_cast<uint64_t> (n) + 1) > static_cast<uint64_t> (end - it))
+                return false;
+            ch = nextChannel (chMask, ch);
+            if (ch < FILEREADER_NUM_OUTPUTS)
+                publish<quint32> (ev, ch, it, n);
+            it += 4 * (n + 1); // data and separator
+        }
+        break;
+    }
+    case Sis3302: {
+        uint32_t headerLength = qFromLittleEndian<quint32> (data + 4);
+        uint32_t chMask = qFromLittleEndian<quint32> (data + 8);
+        it += 4 * headerLength;
+        for (uint32_t i = 4; i < headerLength; ++i) {
+            uint32_t n = qFromLittleEndian<quint32> (data + 4 * i);
+            if (2 * static_cast<uint64_t> (n) > static_cast<uint64_t> (end - it))
+                return false;
+            ch = nextChannel (chMask, ch);
+            if (ch < FILEREADER_NUM_OUTPUTS)
+                publish<quint16> (ev, ch, it, n);
+            it += 2 * n;
+        }
+        break;
+    }
+    case Sis3350: {
+        publish<quint32> (ev, FILEREADER_NUM_OUTPUTS, data, 8); // meta output
+        uint32_t traceLength = qFromLittleEndian<quint32> (data + 16);
+        uint32_t chMask = qFromLittleEndian<quint32> (data + 20);
+        uint32_t left = (len - 8 * 4) / 2;
+        it += 8 * 4;
+        // RawWriteSis3350Plugin saves a single trace, although the mask lists all channels
+        while (left > 0) {
+            uint32_t n = traceLength ? qMin (traceLength, left) : left;
+            ch = nextChannel (chMask, ch);
+            if (ch < FILEREADER_NUM_OUTPUTS)
+                publish<quint16> (ev, ch, it, n);
+            it += 2 * n;
+            left -= n;
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
 }
 
-void FileReaderDemux::printEob()
+// Converts n little endian values of type T at data for the output
+template<typename T> void FileReaderDemux::publish (Event *ev, int output, const uchar *data, uint32_t n)
 {
-    printf("event counter %u, channels %d, module id %u\n",eventCounter,cnt,header.bits.module_id);fflush(stdout);
+    if (output < enable_ch.size () && enable_ch [output]) {
+        QVector<uint32_t> &v = ev->store< QVector<uint32_t> > (evslots.at (output));
+        v.resize (n);
+        for (uint32_t i = 0; i < n; ++i)
+            v [i] = qFromLittleEndian<T> (data + sizeof (T) * i);
+    }
+
+    if (enable_raw_output && !raw_done && output < FILEREADER_NUM_OUTPUTS) {
+        QVector<double> &raw = ev->store< QVector<double> > (evslots.last ());
+        raw.resize (n);
+        for (uint32_t i = 0; i < n; ++i)
+            raw [i] = qFromLittleEndian<T> (data + sizeof (T) * i);
+        raw_done = true;
+    }
 }
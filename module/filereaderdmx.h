@@ -20,65 +20,60 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef FILEREADERPLUGIN_H
 #define FILEREADERPLUGIN_H
 
-#include <algorithm>
-#include <map>
-#include <cstdio>
+#include <cstddef>
 #include <stdint.h>
-#include "mesytec_madc_32_v2.h"
 #include "filereader.h"
 
 #include <QVector>
-#include <QFile>
 
 class Event;
 class EventSlot;
 class AbstractModule;
-template <typename T> class QVector;
 
+/*! Decodes the events of data files for the FileReaderModule.
+ *  Three formats are understood, all little endian:
+ *  \li EventBuilder: the events written by EventBuilderPlugin, see EventIndex. Input \c i goes to output \c i.
+ *  \li SIS3302: the events written by RawWriteSis3302v1410Plugin, a header of 4 + n words
+ *      (0x33021410, header length, channel mask, total length), the sample count of each of the n channels with data
+ *      and then their 16 bit samples. Channel \c i goes to output \c i.
+ *  \li SIS3350: the events written by RawWriteSis3350Plugin and RawWriteSis3350PluginV2, the 8 meta words of the
+ *      SIS3350 demultiplexer followed by the 16 bit samples of the channels in the channel mask (meta word 5),
+ *      each as long as the trace (meta word 4). The meta words go to the meta output.
+ *
+ *  All formats start with a fixed prefix that gives the length of the header, which in turn gives the length of
+ *  the event, see #headerSize and #eventSize. The raw output carries the first channel with data as doubles.
+ */
 class FileReaderDemux
 {
-private:
-    bool inEvent;
-    int cnt;
-
-    bool enable_raw_output;
-    bool enable_per_channel_output;
-
-    uint8_t nofChannels;
-    uint8_t nofChannelsInEvent;
-    uint8_t nofBits;
-    uint8_t crateNumber;
-    uint32_t eventCounter;
-    uint8_t id;
+public:
+    enum Format { Unknown, EventBuilder, Sis3302, Sis3350 };
+    enum { PrefixSize = 8 };
+
+    /*! The slots are the FILEREADER_NUM_OUTPUTS data outputs, the meta output and the raw output, in this order. */
+    FileReaderDemux(const QVector<EventSlot*>& _evslots, const AbstractModule* op);
+
+    /*! Returns the format of the event starting with the \c PrefixSize bytes at \c prefix. */
+    static Format detectFormat (const uchar *prefix);
+    static const char *formatName (Format format);
+    /*! Returns the length in bytes of the header of an event in \c format, 0 if \c prefix is no valid start of one. */
+    static uint32_t headerSize (Format format, const uchar *prefix);
+    /*! Returns the length in bytes of the event with the given header, -1 if the header is inconsistent. */
+    static int64_t eventSize (Format format, const uchar *header);
+
+    /*! Publishes the event of \c len bytes at \c data to the connected outputs. */
+    bool processEvent (Event *ev, Format format, const uchar *data, size_t len);
+    void runStartingEvent();
 
-    std::map<uint8_t, double> chData;
-    QVector<double> rawData;
-    uint32_t rawCnt;
-    QVector<bool> enable_ch;
+private:
+    template<typename T> void publish (Event *ev, int output, const uchar *data, uint32_t n);
 
+private:
     const QVector<EventSlot*>& evslots;
     const AbstractModule *owner;
 
-    uint32_t* it;
-
-    void startNewEvent();
-    void continueEvent();
-    bool finishEvent(Event *ev);
-    void printHeader();
-    void printEob();
-
-    madc32_header_t header;
-    madc32_end_of_event_t trailer;
-
-public:
-    FileReaderDemux(const QVector<EventSlot*>& _evslots, const AbstractModule* op,
-                 uint chans = FILEREADER_NUM_CHANNELS,
-                 uint bits = FILEREADER_NUM_BITS);
-//    FileReaderDemux(const QVector<EventSlot*>& _evslots, const AbstractModule* op);
-
-//    bool processData (Event *ev, uint32_t* data, uint32_t len, bool singleev);
-    bool processData (Event *ev, QFile *file, uint32_t len, bool singleev);
-    void runStartingEvent();
+    bool enable_raw_output;
+    bool raw_done;               // raw output filled for the current event
+    QVector<bool> enable_ch;     // data outputs and the meta output
 };
 
 #endif // FILEREADERPLUGIN_H
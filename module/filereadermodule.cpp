@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "confmap.h"
 
 #include "filereader.h"
+#include "datafilereader.h"
+#include "eventindex.h"
 
 #include <QFile>
 
@@ -44,8 +46,13 @@ FileReaderModule::FileReaderModule (int i, const QString &n)
     , gate1_time_counter(0)
     , time_counter(0)
     , buffer_data_length(0)
-    , dmx_ (evslots_, this)
     , finish_reading(false)
+    , dmx_ (evslots_, this)
+    , format_ (FileReaderDemux::Unknown)
+    , paced_ (false)
+    , replayStart_ (0)
+    , recordStart_ (0)
+    , nofEvents_ (0)
 {
     std::cout << "Before starting FileReader module" << std::endl;
     setChannels ();
@@ -63,17 +70,19 @@ FileReaderModule::FileReaderModule (int i, const QString &n)
 void FileReaderModule::setChannels () {
     EventBuffer *evbuf = RunManager::ref ().getEventBuffer ();
 
-    // TODO: I probably don't need this for now
-/*    // Per channel outputs
-    for(int i = 0; i < FILEREADER_NUM_CHANNELS; i++)
-        evslots_ << evbuf->registerSlot (this, tr("out %1").arg(i,1,10), PluginConnector::VectorDouble);
-*/
+    // Per channel outputs, see FileReaderDemux for the formats
+    for(int i = 0; i < FILEREADER_NUM_OUTPUTS; i++)
+        evslots_ << evbuf->registerSlot (this, tr("out %1").arg(i,1,10), PluginConnector::VectorUint32);
+    evslots_ << evbuf->registerSlot (this, "meta out", PluginConnector::VectorUint32);
 
-    // Output for raw data -> to event builder
+    // First channel of each event, for a quick look
     evslots_ << evbuf->registerSlot(this, "raw out", PluginConnector::VectorDouble);
 }
 
+// Called by the run thread at the start of a run, before it polls for data
 int FileReaderModule::configure () {
+    if(!openReplay()) return 1;
+
     // AbstractInterface *iface = getInterface ();
     // 
     // uint32_t baddr = conf_.base_addr;
@@ -482,69 +491,196 @@ bool FileReaderModule::getDataReady() {
     return (data == 1);
 }
 
-// TODO: implement this; high priority; it needs to return true as soon as file exists
 bool FileReaderModule::dataReady () {
     if(finish_reading) {
         return false;
     }
+    if(!file_.isOpen() || file_.atEnd()) {
+        finishReplay();
+        return false;
+    }
+    return !paced_ || eventDue();
+}
+
+int FileReaderModule::acquire (Event* ev) {
+    // only used outside the run thread, which reads through acquireRaw
+    QVector<uint32_t> raw;
+    if(readEvents(&raw, 1) <= 0) return 0;
+    decode(ev, raw);
+    return raw.size();
+}
+
+int FileReaderModule::acquireRaw (QVector<uint32_t> *raw) {
+    readEvents(raw, qMax<uint32_t>(conf_.events_per_read, 1));
+    return 0;
+}
+
+// Appends up to max events that are due, one frame each. Returns the number of events.
+int FileReaderModule::readEvents (QVector<uint32_t> *raw, uint32_t max) {
+    uint32_t n = 0;
+    uint64_t bytes = 0;
+
+    while(!finish_reading && n < max && bytes < FILEREADER_MAX_READ_BYTES) {
+        if(paced_ && !eventDue()) break;
+
+        int64_t size = nextEventSize();
+        const char *data = size > 0 ? file_.peek(size) : NULL;
+        if(!data) {
+            finishReplay();
+            break;
+        }
 
+        // copied straight from the mapped file or the decompressed block
+        uint32_t words = (size + 3) / 4;
+        int pos = raw->size();
+        raw->resize(pos + 1 + words);
+        uint32_t *frame = raw->data() + pos;
+        frame[0] = size;
+        frame[words] = 0;
+        memcpy(frame + 1, data, size);
+        file_.skip(size);
+
+        bytes += size;
+        ++n;
+        ++nofEvents_;
+    }
+    return n;
+}
+
+int FileReaderModule::decode (Event *ev, const QVector<uint32_t> &raw) {
+    if(raw.isEmpty() || eventLength(raw.constData(), raw.size()) != raw.size()) return -1;
+    const uchar *data = reinterpret_cast<const uchar*>(raw.constData() + 1);
+    return dmx_.processEvent(ev, format_, data, raw.at(0)) ? 0 : -1;
+}
+
+int FileReaderModule::eventLength (const uint32_t *data, int len) const {
+    return qMin<int64_t>(1 + (static_cast<int64_t>(data[0]) + 3) / 4, len);
+}
+
+bool FileReaderModule::openReplay()
+{
     QString fileName = conf_.input_file_name;
-    qDebug() << "FileReaderModule::dataReady: " << fileName;
-    if(fileName.isEmpty()) {
-        qDebug() << "empty filename, sorry";
+    nofEvents_ = 0;
+    paced_ = false;
+    index_ = EventIndex();
+
+    if(!file_.open(fileName)) {
+        printf("FileReaderModule: cannot open %s for reading\n", fileName.toStdString().c_str());
+        return false;
+    }
+
+    const char *prefix = file_.peek(FileReaderDemux::PrefixSize);
+    format_ = prefix ? FileReaderDemux::detectFormat(reinterpret_cast<const uchar*>(prefix)) : FileReaderDemux::Unknown;
+    if(format_ == FileReaderDemux::Unknown) {
+        printf("FileReaderModule: %s does not start with an event of a known format\n", fileName.toStdString().c_str());
+        file_.close();
         return false;
     }
+    printf("FileReaderModule: replaying %s, format %s%s\n", fileName.toStdString().c_str(),
+           FileReaderDemux::formatName(format_), file_.isCompressed() ? ", compressed" : "");
 
-    QFile file(fileName);
-    if (!file.open (QIODevice::ReadOnly)) {
-        qDebug() << "cannot open";
-         return false;
+    if(conf_.start_event > 0 && !seekToEvent(conf_.start_event)) {
+        printf("FileReaderModule: event %u not found in %s\n", conf_.start_event, fileName.toStdString().c_str());
+        file_.close();
+        return false;
+    }
+
+    // recording times are only kept in the index written along with EventBuilder files
+    if(conf_.pacing == FileReaderModuleConfig::paRecorded) {
+        if(format_ == FileReaderDemux::EventBuilder && (!index_.isEmpty() || index_.load(fileName))
+           && !index_.isEmpty() && index_.at(0).time != 0)
+        {
+            paced_ = true;
+            replayStart_ = EventIndex::currentTime();
+            recordStart_ = recordedTime(file_.pos());
+        } else {
+            printf("FileReaderModule: no recording times for %s, replaying as fast as possible\n",
+                   fileName.toStdString().c_str());
+        }
     }
-    qDebug() << "opening is possible";
-    file.close();
-    //return getDataReady();
-//    return (getBufferDataLength() > 0);
     return true;
 }
 
-int FileReaderModule::acquire (Event* ev) {
-    int ret;
-    qDebug() << "FileReaderModule::acquire + stop acquisition";
-/*
-    ret = acquireSingle (data, &buffer_data_length);
-    if (ret == 0) writeToBuffer(ev);
-    else printf("FileReaderModule::Error at acquireSingle\n");
-*/
-    //RunManager::ref().getMainWindow()->stopAcquisition();
-//    RunManager::ref().stop("mojca is stopping");
-//    RunManager::ref().abortFromModule();
-    //if(finish_reading) {
-    //    return 0;
-    //} else {
-        int length = 0;
-        QString fileName = conf_.input_file_name;
-        // TODO: some checks
-        QFile file(fileName);
-        if(!file.open(QIODevice::ReadOnly)) {
-            // TODO: throw something more serious than that debug
-            qDebug() << "Cannot open file " << fileName << " for reading.";
-            emit endOfFile();
-            finish_reading = true;
-            return 0;
-        }
-        length = file.size() / 2; // TODO: divided by two because of 16 bits
-        // TODO: remove this limitation
-        if(length > FILEREADER_TEMP_MAX_SIZE) {
-            length = FILEREADER_TEMP_MAX_SIZE;
+void FileReaderModule::finishReplay()
+{
+    if(finish_reading) return;
+    finish_reading = true;
+
+    printf("FileReaderModule: replayed %llu events\n", static_cast<unsigned long long>(nofEvents_));
+    file_.close();
+    emit endOfFile();
+}
+
+// Jumps to an event, counted from 0 at the start of the file. EventBuilder files without an index are scanned once
+// and get one, other files are read through.
+bool FileReaderModule::seekToEvent(uint64_t event)
+{
+    uint64_t n = 0;
+
+    if(format_ == FileReaderDemux::EventBuilder) {
+        if(!index_.load(conf_.input_file_name)) {
+            printf("FileReaderModule: no index for %s, scanning the file\n", conf_.input_file_name.toStdString().c_str());
+            if(!index_.build(&file_, 1000)) return false;
+            index_.save(conf_.input_file_name);
         }
-        bool go_on = dmx_.processData(ev, &file, length, true); // last: single event
-        file.close();
-        buffer_data_length = length; // TODO
 
-        emit endOfFile();
-        finish_reading = true;
-        return buffer_data_length;
-    //}
+        // sidecars written during the run count the events of the run, and every file has an entry for its first event
+        uint64_t first = index_.isEmpty() ? 0 : index_.at(0).event;
+        int i = index_.findEvent(first + event);
+        if(i < 0 || !file_.seek(index_.at(i).offset)) return false;
+        n = index_.at(i).event - first;
+    }
+
+    // Skip the events between the index entry and the one requested
+    for(; n < event; ++n) {
+        int64_t size = nextEventSize();
+        if(size == 0)
+            printf("FileReaderModule: the file holds only %llu events\n", static_cast<unsigned long long>(n));
+        if(size <= 0 || !file_.skip(size)) return false;
+    }
+    return true;
+}
+
+// Returns the size in bytes of the event at the current position, 0 at the end of the data and -1 if there is no valid event
+int64_t FileReaderModule::nextEventSize()
+{
+    if(file_.atEnd()) return 0;
+
+    const uchar *header = reinterpret_cast<const uchar*>(file_.peek(FileReaderDemux::PrefixSize));
+    uint32_t headerSize = header ? FileReaderDemux::headerSize(format_, header) : 0;
+    if(headerSize)
+        header = reinterpret_cast<const uchar*>(file_.peek(headerSize));
+    int64_t size = header && headerSize ? FileReaderDemux::eventSize(format_, header) : -1;
+
+    if(size < static_cast<int64_t>(headerSize) || size == 0) {
+        printf("FileReaderModule: no valid event at offset %llu\n", static_cast<unsigned long long>(file_.pos()));
+        return -1;
+    }
+    if(static_cast<uint64_t>(size) > file_.size() - file_.pos()) {
+        printf("FileReaderModule: last event is incomplete\n");
+        return 0;
+    }
+    return size;
+}
+
+// Compares the time since the start of the replay with the time since the first event replayed was recorded
+bool FileReaderModule::eventDue() const
+{
+    uint64_t recorded = recordedTime(file_.pos());
+    if(recorded <= recordStart_) return true;
+    return recorded - recordStart_ <= EventIndex::currentTime() - replayStart_;
+}
+
+// Returns the recording time of the event at offset, interpolated between the index entries around it
+uint64_t FileReaderModule::recordedTime(uint64_t offset) const
+{
+    int i = qMax(index_.findOffset(offset), 0);
+    const EventIndexEntry &a = index_.at(i);
+    if(i + 1 >= index_.size()) return a.time;
+
+    const EventIndexEntry &b = index_.at(i + 1);
+    if(b.offset <= a.offset || b.time <= a.time || offset <= a.offset) return a.time;
+    return a.time + static_cast<uint64_t>(static_cast<double>(offset - a.offset) * (b.time - a.time) / (b.offset - a.offset));
 }
 
 void FileReaderModule::writeToBuffer(Event *ev)
@@ -784,6 +920,9 @@ int FileReaderModule::updateModuleInfo() {
 typedef ConfMap::confmap_t<FileReaderModuleConfig> confmap_t;
 static const confmap_t confmap [] = {
     confmap_t ("input_file_name", &FileReaderModuleConfig::input_file_name), // mojca
+    confmap_t ("start_event", &FileReaderModuleConfig::start_event),
+    confmap_t ("pacing", &FileReaderModuleConfig::pacing),
+    confmap_t ("events_per_read", &FileReaderModuleConfig::events_per_read),
     // confmap_t ("base_addr", &FileReaderModuleConfig::base_addr),
     // confmap_t ("base_addr_register", &FileReaderModuleConfig::base_addr_register),
     // confmap_t ("module_id", &FileReaderModuleConfig::module_id),
@@ -915,24 +1054,30 @@ uint32_t FileReaderModule::getBaseAddress () const {
     return conf_.base_addr;
 }
 /*!
-\page Mesytec MADC-32 module
+\page File reader module
 <b>Module name:</b> \c fileReader
 
 \section desc Module Description
-The Mesytec MADC-32 module is a 32 channel ADC.
+The file reader replays a data file as if the events came from the crate. It reads the events written by the
+EventBuilder plugin and the raw files of the SIS3302 and SIS3350 writer plugins, compressed or not.
+The format is recognised from the first event. The run stops at the end of the file.
+
+The file is mapped into memory and the events are handed to the run thread in batches, so a replay is not limited
+by the speed of the readout loop. Decoding happens on the plugin threads, like for the other modules.
 
 \section cpanel Configuration Panel
 
 \subsection settings Settings
-
-\subsection irq IRQ
-The IRQ panel controls the conditions on which VME interrupt requests are generated. IRQs are not yet used in data readout.
-
-\subsection info Info
-The Info panel provides some basic information about the firmware that runs on the module.
-This page is not fully implemented yet.
+\li <b>Start at event</b>: number of the first event to replay, counted from 0 at the start of the file. This also holds
+for the later files of a run. EventBuilder files are entered through their index, which is built and saved next to the
+file if it does not exist yet.
+\li <b>Replay</b>: as fast as possible, or at the rate the events were recorded at. The recording times are taken from
+the index of EventBuilder files. Other files are always replayed as fast as possible.
+\li <b>Events per read</b>: number of events handed to the run thread at once.
 
 \section outs Outputs
+\li <b>out 0</b> ... <b>out 7</b>: input \c i of the EventBuilder, or the samples of channel \c i of a SIS3302 or SIS3350
+\li <b>meta out</b>: the meta words of a SIS3350 event
+\li <b>raw out</b>: the first channel with data, as doubles
 
 */
-
@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "basemodule.h"
 #include "baseplugin.h"
 #include "filereaderdmx.h"
+#include "datafilereader.h"
+#include "eventindex.h"
 #include "pluginmanager.h"
 #include "mesytec_madc_32_v2.h"
 #include "filereader.h"
@@ -49,6 +51,7 @@ struct FileReaderModuleConfig {
                         tpAmp0,tpAmpLow,tpAmpHigh,tpToggle};
     enum TimeStampSource{tsVme,tsExternal};
     enum VmeMode{vmSingle,vmDMA32,vmFIFO,vmBLT32,vmBLT64,vm2ESST};
+    enum Pacing{paFast,paRecorded};
 
     AddressSource addr_source;
     uint32_t base_addr;
@@ -126,6 +129,9 @@ struct FileReaderModuleConfig {
 
     // mojca's
     QString input_file_name;
+    uint32_t start_event; // first event to replay, counted from the start of the file
+    int pacing;               // one of Pacing
+    uint32_t events_per_read; // events handed to the run thread per acquisition
 
     FileReaderModuleConfig ()
         : addr_source(asBoard), base_addr(0),
@@ -164,7 +170,10 @@ struct FileReaderModuleConfig {
           rc_module_id_read(0),
           rc_module_id_write(0),
           pollcount (100000),
-          input_file_name("") // TODO: is this the proper way to initialize strings?
+          input_file_name(""), // TODO: is this the proper way to initialize strings?
+          start_event(0),
+          pacing(paFast),
+          events_per_read(64)
     {
         for (int i = 0; i < FILEREADER_NUM_CHANNELS; ++i) {
             enable_channel[i] = false;
@@ -240,6 +249,13 @@ public:
     virtual int reset ();
     virtual int configure ();
 
+    // Events are read in batches and decoded on the plugin threads, one frame per event:
+    // the length of the event in bytes, then the event as in the file, padded to whole words
+    virtual bool hasRawReadout () const { return true; }
+    virtual int acquireRaw (QVector<uint32_t> *raw);
+    virtual int decode (Event *ev, const QVector<uint32_t> &raw);
+    virtual int eventLength (const uint32_t *data, int len) const;
+
     virtual uint32_t getBaseAddress () const;
     virtual void setBaseAddress (uint32_t baddr);
     virtual void runStartingEvent() { dmx_.runStartingEvent(); }
@@ -251,6 +267,13 @@ public:
 private:
     FileReaderModule (int _id, const QString &);
     void writeToBuffer(Event *ev);
+    bool openReplay();
+    void finishReplay();
+    bool seekToEvent(uint64_t event);
+    int64_t nextEventSize();
+    int readEvents(QVector<uint32_t> *raw, uint32_t max);
+    bool eventDue() const;
+    uint64_t recordedTime(uint64_t offset) const;
 
 signals:
     void endOfFile();
@@ -279,9 +302,17 @@ private:
     uint32_t data [MADC32V2_LEN_EVENT_MAX];
     bool finish_reading;
 
-
     FileReaderDemux dmx_;
     QVector<EventSlot*> evslots_;
+
+    // replay
+    DataFileReader file_;
+    FileReaderDemux::Format format_; // constant during a run, so decode can use it
+    EventIndex index_;
+    bool paced_;           // replaying at the recorded rate
+    uint64_t replayStart_; // microseconds since the epoch
+    uint64_t recordStart_; // recording time of the first event replayed
+    uint64_t nofEvents_;
 };
 
 #endif // FILEREADER_H
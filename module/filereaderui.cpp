@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "filereaderui.h"
 #include "filereadermodule.h"
 #include <iostream>
+#include <climits>
 
 FileReaderUI::FileReaderUI(FileReaderModule* _module)
     : module(_module), uif(this,&tabs), applyingSettings(false),
@@ -70,6 +71,12 @@ void FileReaderUI::createUI()
 
     gn.append("File"); ng++; uif.addGroupToTab(tn[nt],gn[ng],"","v");
     uif.addFileBrowserToGroup(tn[nt],gn[ng],"File name:","input_file_name","input_file_browse_button", "Browse ...");
+    uif.addSpinnerToGroup(tn[nt],gn[ng],"Start at event in file:","start_event",0,INT_MAX);
+    uif.addPopupToGroup(tn[nt],gn[ng],"Replay:","pacing",
+                        (QStringList()
+                         << "As fast as possible"
+                         << "At recorded rate"));
+    uif.addSpinnerToGroup(tn[nt],gn[ng],"Events per read:","events_per_read",1,100000);
 
     // // TAB Addressing
     // tn.append("Addr"); nt++; uif.addTab(tn[nt]);
@@ -396,6 +403,9 @@ void FileReaderUI::uiInput(QString _name)
         if(_name == "addr_source") {
             module->conf_.addr_source = static_cast<FileReaderModuleConfig::AddressSource>(cbb->currentIndex());
         }
+        if(_name == "pacing") {
+            module->conf_.pacing = cbb->currentIndex();
+        }
         if(_name == "multi_event_mode") {
             module->conf_.multi_event_mode = static_cast<FileReaderModuleConfig::MultiEventMode>(cbb->currentIndex());
         }
@@ -539,6 +549,12 @@ void FileReaderUI::uiInput(QString _name)
         if(_name == "rc_module_id_write"){
             module->conf_.rc_module_id_write = sb->value();
         }
+        if(_name == "start_event"){
+            module->conf_.start_event = sb->value();
+        }
+        if(_name == "events_per_read"){
+            module->conf_.events_per_read = sb->value();
+        }
         if(_name.startsWith("hold_delay_")) {
             int ch = _name.right(1).toInt();
             module->conf_.hold_delay[ch] = sb->value();
@@ -870,6 +886,7 @@ void FileReaderUI::applySettings()
             QComboBox* w = (*it);
             //printf("Found combobox with the name %s\n",w->objectName().toStdString().c_str());
             if(w->objectName() == "addr_source") w->setCurrentIndex(module->conf_.addr_source);
+            if(w->objectName() == "pacing") w->setCurrentIndex(module->conf_.pacing);
             if(w->objectName() == "multi_event_mode") w->setCurrentIndex(module->conf_.multi_event_mode);
             if(w->objectName() == "vme_mode") w->setCurrentIndex(module->conf_.vme_mode);
             if(w->objectName() == "data_length_format") w->setCurrentIndex(module->conf_.data_length_format);
@@ -912,6 +929,8 @@ void FileReaderUI::applySettings()
             if(w->objectName() == "max_transfer_data") w->setValue(module->conf_.max_transfer_data);
             if(w->objectName() == "rc_module_id_read") w->setValue(module->conf_.rc_module_id_read);
             if(w->objectName() == "rc_module_id_write") w->setValue(module->conf_.rc_module_id_write);
+            if(w->objectName() == "start_event") w->setValue(module->conf_.start_event);
+            if(w->objectName() == "events_per_read") w->setValue(module->conf_.events_per_read);
 
             for(int ch=0; ch<2; ch++)
             {
@@ -33,6 +33,10 @@ MesytecMadc32Demux::MesytecMadc32Demux(const QVector<EventSlot*>& _evslots,
     , nofChannels (chans)
     , nofChannelsInEvent(0)
     , nofBits (bits)
+    , eventCounter (0)
+    , check_event_counter (false)
+    , have_event_counter (false)
+    , lostEvents (0)
     , evslots (_evslots)
     , owner (own)
 {
@@ -71,11 +75,14 @@ void MesytecMadc32Demux::runStartingEvent() {
     }
     if(cnt == 0) enable_per_channel_output = false;
 
+    have_event_counter = false;
+    lostEvents = 0;
+
     printf("MesytecMadc32Demux::runStartingEvent: enable_raw_output %d\n",enable_raw_output);
     printf("MesytecMadc32Demux::runStartingEvent: enable_per_channel_output %d\n",enable_per_channel_output);
 }
 
-bool MesytecMadc32Demux::processData (Event* ev, uint32_t *data, uint32_t len, bool singleev)
+bool MesytecMadc32Demux::processData (Event* ev, const uint32_t *data, uint32_t len, bool singleev)
 {
     //std::cout << "DemuxMesytecMadc32Plugin Processing" << std::endl;
     it = data;
@@ -96,7 +103,7 @@ bool MesytecMadc32Demux::processData (Event* ev, uint32_t *data, uint32_t len, b
         else if(id == MADC32V2_SIG_DATA)
         {
             if(inEvent) continueEvent();
-            else std::cout << "Not in event!" << std::endl;
+            else if((*it) != 0) std::cout << "Not in event!" << std::endl; // zeros are fill words
         }
         else if(id == MADC32V2_SIG_END || id == MADC32V2_SIG_END_BERR)
         {
@@ -175,25 +182,33 @@ bool MesytecMadc32Demux::finishEvent(Event *ev)
 {
     inEvent = false;
 
+    trailer.data = (*it);
+    if(check_event_counter) {
+        // the counter has 30 bits
+        uint32_t lost = (trailer.bits.trigger_counter - eventCounter - 1) & 0x3fffffff;
+        if(have_event_counter && lost != 0) {
+            lostEvents += lost;
+            std::cout << "DemuxMesytecMadc32: lost " << std::dec << lost << " events before event "
+                      << trailer.bits.trigger_counter << " (" << lostEvents << " in this run)" << std::endl;
+        }
+        have_event_counter = true;
+    }
+    eventCounter = trailer.bits.trigger_counter;
+
     if(enable_per_channel_output) {
-        trailer.data = (*it);
-        eventCounter = trailer.bits.trigger_counter;
         //printEob();
 
         for (std::map<uint8_t,uint16_t>::const_iterator i = chData.begin (); i != chData.end (); ++i) {
             // Publish event data
             if (owner->getOutputPlugin ()->isSlotConnected (evslots.at (i->first))) {
-                const EventSlot* sl = evslots.at (i->first);
-                QVector<uint32_t> v = ev->get (sl).value< QVector<uint32_t> > ();
-                v << i->second;
-                ev->put (evslots.at (i->first), QVariant::fromValue (v));
+                ev->store< QVector<uint32_t> > (evslots.at (i->first)) << i->second;
             }
         }
     }
 
     if(enable_raw_output){
         rawData[rawCnt++] = (*it);
-        ev->put(evslots.last(), QVariant::fromValue(rawData));
+        ev->copyData (evslots.last (), rawData.constData (), rawData.size ());
     }
 
     return true;
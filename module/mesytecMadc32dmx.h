@@ -49,6 +49,10 @@ private:
     uint32_t eventCounter;
     uint8_t id;
 
+    bool check_event_counter;
+    bool have_event_counter;
+    uint32_t lostEvents;
+
     std::map<uint8_t, uint16_t> chData;
     QVector<uint32_t> rawData;
     uint32_t rawCnt;
@@ -57,7 +61,7 @@ private:
     const QVector<EventSlot*>& evslots;
     const AbstractModule *owner;
 
-    uint32_t* it;
+    const uint32_t* it;
 
     void startNewEvent();
     void continueEvent();
@@ -73,8 +77,13 @@ public:
                  uint chans = MADC32V2_NUM_CHANNELS,
                  uint bits = MADC32V2_NUM_BITS);
 
-    bool processData (Event *ev, uint32_t* data, uint32_t len, bool singleev);
+    bool processData (Event *ev, const uint32_t* data, uint32_t len, bool singleev);
     void runStartingEvent();
+
+    /*! Check the event counters in the end of event marks for gaps, requires marking type "event counter". */
+    void setEventCounterCheck (bool enable) { check_event_counter = enable; }
+    /*! Returns the number of events lost since the start of the run, as seen from gaps in the event counter. */
+    uint32_t getLostEvents () const { return lostEvents; }
 };
 
 #endif // DEMUXMESYTECMADC32PLUGIN_H
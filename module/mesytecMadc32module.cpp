@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdio>
 #include <cstring>
+#include <vector>
 #include <unistd.h> // usleep()
 
 using namespace std;
@@ -34,6 +35,7 @@ MesytecMadc32Module::MesytecMadc32Module (int i, const QString &n)
     : BaseModule (i, n)
     , firmware(0)
     , module_id(0)
+    , chain_module_id(0)
     , event_counter(0)
     , timestamp_counter(0)
     , adc_busy_counter(0)
@@ -45,6 +47,8 @@ MesytecMadc32Module::MesytecMadc32Module (int i, const QString &n)
     setChannels ();
     createOutputPlugin();
 
+    lastDrain.start ();
+
     setUI (new MesytecMadc32UI (this));
         std::cout << "Instantiated MesytecMadc32 module" << std::endl;
 }
@@ -66,51 +70,44 @@ int MesytecMadc32Module::configure () {
     uint32_t baddr = conf_.base_addr;
     uint16_t data;
     int ret = 0;
+    std::vector<VmeOp> ops;
 
     if(!iface) return 2;
     if(!iface->isOpen()) return 1;
 
+    // all registers are written with one access list, see AbstractInterface::executeList
+
     // set address source
-    ret = iface->writeA32D16 (baddr + MADC32V2_ADDR_SOURCE, conf_.addr_source);
-    if (ret) printf ("Error %d at MADC32V2_ADDR_SOURCE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ADDR_SOURCE, conf_.addr_source));
 
     // set address register
-    ret = iface->writeA32D16(baddr + MADC32V2_ADDR_REGISTER, conf_.base_addr_register);
-    if (ret) printf ("Error %d at MADC32V2_ADDR_REGISTER", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ADDR_REGISTER, conf_.base_addr_register));
 
     // set module id
-    ret = iface->writeA32D16(baddr + MADC32V2_MODULE_ID, conf_.module_id);
-    if (ret) printf ("Error %d at MADC32V2_MODULE_ID", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_MODULE_ID, conf_.module_id));
 
     // set irq level
-    ret = iface->writeA32D16(baddr + MADC32V2_IRQ_LEVEL, conf_.irq_level);
-    if (ret) printf ("Error %d at MADC32V2_", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_IRQ_LEVEL, conf_.irq_level));
 
     // set irq vector
-    ret = iface->writeA32D16(baddr + MADC32V2_IRQ_VECTOR, conf_.irq_vector);
-    if (ret) printf ("Error %d at MADC32V2_IRQ_VECTOR", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_IRQ_VECTOR, conf_.irq_vector));
 
     // set irq threshold
-    ret = iface->writeA32D16(baddr + MADC32V2_IRQ_THRESHOLD, conf_.irq_threshold);
-    if (ret) printf ("Error %d at MADC32V2_IRQ_THRESHOLD", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_IRQ_THRESHOLD, conf_.irq_threshold));
 
     // set max transfer data
-    ret = iface->writeA32D16(baddr + MADC32V2_MAX_TRANSFER_DATA, conf_.max_transfer_data);
-    if (ret) printf ("Error %d at MADC32V2_MAX_TRANSFER_DATA", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_MAX_TRANSFER_DATA, conf_.max_transfer_data));
 
     // set cblt address
-    ret = iface->writeA32D16(baddr + MADC32V2_CBLT_ADDRESS,
-                             (conf_.cblt_addr << MADC32V2_OFF_CBLT_ADDRESS));
-    if (ret) printf ("Error %d at MADC32V2_CBLT_ADDRESS", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_CBLT_ADDRESS,
+                                   (conf_.cblt_addr << MADC32V2_OFF_CBLT_ADDRESS)));
 
     // set mcst address
-    ret = iface->writeA32D16(baddr + MADC32V2_MCST_ADDRESS,
-                             (conf_.mcst_addr << MADC32V2_OFF_MCST_ADDRESS));
-    if (ret) printf ("Error %d at MADC32V2_MCST_ADDRESS", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_MCST_ADDRESS,
+                                   (conf_.mcst_addr << MADC32V2_OFF_MCST_ADDRESS)));
 
     // set data length format
-    ret = iface->writeA32D16(baddr + MADC32V2_DATA_LENGTH_FORMAT, conf_.data_length_format);
-    if (ret) printf ("Error %d at MADC32V2_DATA_LENGTH_FORMAT", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_DATA_LENGTH_FORMAT, conf_.data_length_format));
 
     // set multi event mode
     data = conf_.multi_event_mode;
@@ -118,116 +115,99 @@ int MesytecMadc32Module::configure () {
         data |= MADC32V2_VAL_MULTIEVENT_MODE_MAX_DATA;
     if(conf_.enable_multi_event_send_different_eob_marker)
         data |= MADC32V2_VAL_MULTIEVENT_MODE_EOB_BERR;
-    ret = iface->writeA32D16(baddr + MADC32V2_MULTIEVENT_MODE, data);
-    if (ret) printf ("Error %d at MADC32V2_MULTIEVENT_MODE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_MULTIEVENT_MODE, data));
 
     // set marking type
-    ret = iface->writeA32D16(baddr + MADC32V2_MARKING_TYPE, conf_.marking_type);
-    if (ret) printf ("Error %d at MADC32V2_MARKING_TYPE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_MARKING_TYPE, conf_.marking_type));
 
     // set bank mode
-    ret = iface->writeA32D16(baddr + MADC32V2_BANK_MODE, conf_.bank_operation);
-    if (ret) printf ("Error %d at MADC32V2_BANK_MODE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_BANK_MODE, conf_.bank_operation));
 
     // set adc resolution
-    ret = iface->writeA32D16(baddr + MADC32V2_ADC_RESOLUTION, conf_.adc_resolution);
-    if (ret) printf ("Error %d at MADC32V2_ADC_RESOLUTION", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ADC_RESOLUTION, conf_.adc_resolution));
 
     // set output format (not necessary at the moment)
-    ret = iface->writeA32D16(baddr + MADC32V2_OUTPUT_FORMAT, conf_.output_format);
-    if (ret) printf ("Error %d at MADC32V2_OUTPUT_FORMAT", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_OUTPUT_FORMAT, conf_.output_format));
 
     // set adc override
-    ret = iface->writeA32D16(baddr + MADC32V2_ADC_OVERRIDE,
-                             (conf_.enable_adc_override ?
-                                  conf_.adc_override_resolution : conf_.adc_resolution));
-    if (ret) printf ("Error %d at MADC32V2_ADC_OVERRIDE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ADC_OVERRIDE,
+                                   (conf_.enable_adc_override ?
+                                        conf_.adc_override_resolution : conf_.adc_resolution)));
 
     // set sliding scale disable
-    ret = iface->writeA32D16(baddr + MADC32V2_SLIDING_SCALE_OFF,
-                             (conf_.enable_switch_off_sliding_scale ? 1 : 0));
-    if (ret) printf ("Error %d at MADC32V2_SLIDING_SCALE_OFF", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_SLIDING_SCALE_OFF,
+                                   (conf_.enable_switch_off_sliding_scale ? 1 : 0)));
 
     // set skip out of range
-    ret = iface->writeA32D16(baddr + MADC32V2_SKIP_OUT_OF_RANGE,
-                             (conf_.enable_skip_out_of_range ? 1 : 0));
-    if (ret) printf ("Error %d at MADC32V2_SKIP_OUT_OF_RANGE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_SKIP_OUT_OF_RANGE,
+                                   (conf_.enable_skip_out_of_range ? 1 : 0)));
 
     // set ignore thresholds
-    ret = iface->writeA32D16(baddr + MADC32V2_IGNORE_THRESHOLDS,
-                             (conf_.enable_ignore_thresholds ? 1 : 0));
-    if (ret) printf ("Error %d at MADC32V2_IGNORE_THRESHOLDS", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_IGNORE_THRESHOLDS,
+                                   (conf_.enable_ignore_thresholds ? 1 : 0)));
 
     // set hold delay 0
-    ret = iface->writeA32D16(baddr + MADC32V2_HOLD_DELAY_0, conf_.hold_delay[0]);
-    if (ret) printf ("Error %d at MADC32V2_HOLD_DELAY_0", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_HOLD_DELAY_0, conf_.hold_delay[0]));
 
     // set hold delay 1
-    ret = iface->writeA32D16(baddr + MADC32V2_HOLD_DELAY_1, conf_.hold_delay[1]);
-    if (ret) printf ("Error %d at MADC32V2_HOLD_DELAY_1", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_HOLD_DELAY_1, conf_.hold_delay[1]));
 
     // set hold width 0
-    ret = iface->writeA32D16(baddr + MADC32V2_HOLD_WIDTH_0, conf_.hold_width[0]);
-    if (ret) printf ("Error %d at MADC32V2_HOLD_WIDTH_0", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_HOLD_WIDTH_0, conf_.hold_width[0]));
 
     // set hold width 1
-    ret = iface->writeA32D16(baddr + MADC32V2_HOLD_WIDTH_1, conf_.hold_width[1]);
-    if (ret) printf ("Error %d at MADC32V2_HOLD_WIDTH_1", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_HOLD_WIDTH_1, conf_.hold_width[1]));
 
     // set gate generator mode
-    ret = iface->writeA32D16(baddr + MADC32V2_USE_GATE_GENERATOR, conf_.gate_generator_mode);
-    if (ret) printf ("Error %d at MADC32V2_USE_GATE_GENERATOR", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_USE_GATE_GENERATOR, conf_.gate_generator_mode));
 
     // set input range
-    ret = iface->writeA32D16(baddr + MADC32V2_INPUT_RANGE, conf_.input_range);
-    if (ret) printf ("Error %d at MADC32V2_INPUT_RANGE", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_INPUT_RANGE, conf_.input_range));
 
     // set ecl termination
     data = 0;
     if(conf_.enable_termination_input_gate0) data |= (1 << MADC32V2_OFF_ECL_TERMINATION_GATE_0);
     if(conf_.enable_termination_input_fast_clear) data |= (1 << MADC32V2_OFF_ECL_TERMINATION_FCLEAR);
-    ret = iface->writeA32D16(baddr + MADC32V2_ECL_TERMINATED, data);
-    if (ret) printf ("Error %d at MADC32V2_ECL_TERMINATED", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ECL_TERMINATED, data));
 
     // set ecl gate 1 mode
-    ret = iface->writeA32D16(baddr + MADC32V2_ECL_GATE1_OSC, conf_.ecl_gate1_mode);
-    if (ret) printf ("Error %d at MADC32V2_ECL_GATE1_OSC", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ECL_GATE1_OSC, conf_.ecl_gate1_mode));
 
     // set ecl fast clear mode
-    ret = iface->writeA32D16(baddr + MADC32V2_ECL_FAST_CLEAR_RST, conf_.ecl_fclear_mode);
-    if (ret) printf ("Error %d at MADC32V2_ECL_FAST_CLEAR_RST", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ECL_FAST_CLEAR_RST, conf_.ecl_fclear_mode));
 
     // set ecl busy mode
-    ret = iface->writeA32D16(baddr + MADC32V2_ECL_BUSY, conf_.ecl_busy_mode);
-    if (ret) printf ("Error %d at MADC32V2_ECL_BUSY", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_ECL_BUSY, conf_.ecl_busy_mode));
 
     // set nim gate 1 mode
-    ret = iface->writeA32D16(baddr + MADC32V2_NIM_GATE1_OSC, conf_.nim_gate1_mode);
-    if (ret) printf ("Error %d at MADC32V2_NIM_GATE1_OSC", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_NIM_GATE1_OSC, conf_.nim_gate1_mode));
 
     // set nim fast clear mode
-    ret = iface->writeA32D16(baddr + MADC32V2_NIM_FAST_CLEAR_RST, conf_.nim_fclear_mode);
-    if (ret) printf ("Error %d at MADC32V2_NIM_FAST_CLEAR_RST", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_NIM_FAST_CLEAR_RST, conf_.nim_fclear_mode));
 
     // set nim busy mode
-    ret = iface->writeA32D16(baddr + MADC32V2_NIM_BUSY, conf_.nim_busy_mode);
-    if (ret) printf ("Error %d at MADC32V2_NIM_BUSY", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_NIM_BUSY, conf_.nim_busy_mode));
 
     // set pulser status
-    ret = iface->writeA32D16(baddr + MADC32V2_PULSER_STATUS, conf_.test_pulser_mode);
-    if (ret) printf ("Error %d at MADC32V2_PULSER_STATUS", ret);
+    ops.push_back (VmeOp::write16 (baddr + MADC32V2_PULSER_STATUS, conf_.test_pulser_mode));
 
     // set template
-    //ret = iface->writeA32D16(baddr + MADC32V2_, conf_.);
-    //if (ret) printf ("Error %d at MADC32V2_", ret);
+    //ops.push_back (VmeOp::write16 (baddr + MADC32V2_, conf_.));
 
     // set channel thresholds
     for (int i = 0; i < MADC32V2_NUM_CHANNELS; ++i) {
         uint16_t thr = (conf_.enable_channel[i] ?
                             conf_.thresholds[i] :
                             MADC32V2_VAL_THRESHOLD_SWITCH_OFF);
-        ret = iface->writeA32D16 (baddr + MADC32V2_THRESHOLD_MEM + 2*i,thr);
-        if (ret) printf ("Error %d at MADC32V2_THRESHOLD_MEM[%d]\n", ret, i);
+        ops.push_back (VmeOp::write16 (baddr + MADC32V2_THRESHOLD_MEM + 2*i,thr));
+    }
+
+    ret = iface->executeList (&ops [0], ops.size ());
+    for (size_t i = 0; ret && i < ops.size (); ++i) {
+        if (ops [i].error) {
+            printf ("Error %d at MADC32V2 register 0x%04x\n", ops [i].error, ops [i].addr - baddr);
+            break;
+        }
     }
 
     //REG_DUMP();
@@ -455,7 +435,28 @@ bool MesytecMadc32Module::getDataReady() {
 
 bool MesytecMadc32Module::dataReady () {
     //return getDataReady();
-    return (getBufferDataLength() > 0);
+    return bufferReady (bufferWords ());
+}
+
+int MesytecMadc32Module::appendStatusReads (QVector<VmeOp> *ops) const {
+    ops->push_back (VmeOp::read16 (conf_.base_addr + MADC32V2_BUFFER_DATA_LENGTH));
+    return 1;
+}
+
+bool MesytecMadc32Module::dataReadyFromStatus (const VmeOp *status) {
+    if (status [0].error) {
+        printf ("MesytecMadc32Module::Error %d at MADC32V2_BUFFER_DATA_LENGTH\n", status [0].error);
+        return false;
+    }
+    return bufferReady (toWords (status [0].data));
+}
+
+bool MesytecMadc32Module::bufferReady (uint32_t words) {
+    if (conf_.multi_event_mode == MesytecMadc32ModuleConfig::meSingle || words == 0)
+        return (words > 0);
+
+    // let events collect in the fifo until the irq threshold or the timeout is reached
+    return words >= conf_.irq_threshold || lastDrain.elapsed () >= conf_.multi_event_timeout;
 }
 
 int MesytecMadc32Module::acquire (Event* ev) {
@@ -477,30 +478,133 @@ void MesytecMadc32Module::writeToBuffer(Event *ev)
     }
 }
 
+int MesytecMadc32Module::acquireRaw (QVector<uint32_t> *raw) {
+    uint32_t rd = 0;
+
+    // read the fill level once and transfer exactly that many words, so only complete events are taken
+    uint32_t words_to_read = std::min (bufferWords (), static_cast<uint32_t> (MADC32V2_LEN_BUFFER_MAX));
+    raw->resize (words_to_read + 1);
+
+    int ret = readBuffer (raw->data (), words_to_read, &rd);
+    if (ret) {
+        printf ("MesytecMadc32Module::Error %d at acquireRaw\n", ret);
+        raw->resize (0);
+        return -1;
+    }
+
+    raw->resize (std::min (rd, words_to_read));
+    lastDrain.start ();
+    return raw->size ();
+}
+
+int MesytecMadc32Module::eventLength (const uint32_t *data, int len) const {
+    if (conf_.multi_event_mode == MesytecMadc32ModuleConfig::meSingle || len < 1)
+        return len;
+
+    madc32_header_t hdr;
+    hdr.data = data [0];
+    int n = 1;
+    if (hdr.bits.signature == MADC32V2_SIG_HEADER)
+        n = std::min (len, 1 + static_cast<int> (hdr.bits.data_length));
+
+    // fill words and other stray data up to the next header stay with this event
+    while (n < len && ((data [n] >> MADC32V2_OFF_DATA_SIG) & MADC32V2_MSK_DATA_SIG) != MADC32V2_SIG_HEADER)
+        ++n;
+    return n;
+}
+
+int MesytecMadc32Module::decode (Event *ev, const QVector<uint32_t> &raw) {
+    // called for chained and multi event readout, the readout logic has been reset by then
+    dmx_.processData (ev, raw.constData (), raw.size (), RunManager::ref ().isSingleEventMode ());
+    return 0;
+}
+
+int MesytecMadc32Module::setChainPosition (uint8_t cbltAddr, ChainPosition pos) {
+    AbstractInterface *iface = getInterface ();
+    uint32_t baddr = conf_.base_addr;
+    uint16_t ctrl = 0;
+    int ret;
+
+    if (!iface || !iface->isOpen ()) return 1;
+
+    // a module id of 0xFF puts the upper byte of the base address into the headers
+    chain_module_id = (conf_.module_id == 0xFF) ? ((baddr >> 24) & 0xFF) : conf_.module_id;
+
+    switch (pos) {
+    case ChainFirst:
+        ctrl = (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_CBLT)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_FIRST_MODULE)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_LAST_MODULE);
+        break;
+    case ChainMiddle:
+        ctrl = (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_CBLT)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_FIRST_MODULE)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_LAST_MODULE);
+        break;
+    case ChainLast:
+        ctrl = (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_CBLT)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_FIRST_MODULE)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_ENABLE_LAST_MODULE);
+        break;
+    default:
+        ctrl = (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_CBLT)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_FIRST_MODULE)
+             | (1 << MADC32V2_OFF_CBLT_MCST_CTRL_DISABLE_LAST_MODULE);
+    }
+
+    if (pos != ChainNone) {
+        ret = iface->writeA32D16(baddr + MADC32V2_CBLT_ADDRESS, cbltAddr);
+        if (ret) printf ("Error %d at MADC32V2_CBLT_ADDRESS\n", ret);
+    }
+
+    ret = iface->writeA32D16(baddr + MADC32V2_CBLT_MCST_CTRL, ctrl);
+    if (ret) printf ("Error %d at MADC32V2_CBLT_MCST_CTRL\n", ret);
+
+    return ret;
+}
+
+int MesytecMadc32Module::claimChainedData (const uint32_t *data, int len) const {
+    if (len < 1)
+        return 0;
+
+    madc32_header_t hdr;
+    hdr.data = data [0];
+    if (hdr.bits.signature != MADC32V2_SIG_HEADER || hdr.bits.module_id != chain_module_id)
+        return 0;
+
+    // the header counts the words following it, including the end of event mark
+    return std::min (len, 1 + static_cast<int> (hdr.bits.data_length));
+}
+
 int MesytecMadc32Module::acquireSingle (uint32_t *data, uint32_t *rd) {
     *rd = 0;
+    return readBuffer (data, bufferWords (), rd);
+}
 
-    // Get buffer data length
-    uint32_t words_to_read = 0;
-    buffer_data_length = getBufferDataLength();
+uint32_t MesytecMadc32Module::bufferWords () {
+    return toWords (getBufferDataLength());
+}
+
+uint32_t MesytecMadc32Module::toWords (uint16_t length) {
+    buffer_data_length = length;
     //printf("madc32: Event length (buffer_data_length): %d\n",buffer_data_length);
 
     // Translate buffer data length to number of words to read
     switch(conf_.data_length_format) {
     case MesytecMadc32ModuleConfig::dl8bit:
-        words_to_read = buffer_data_length / 4;
-        break;
+        return buffer_data_length / 4;
     case MesytecMadc32ModuleConfig::dl16bit:
-        words_to_read = buffer_data_length / 2;
-        break;
+        return buffer_data_length / 2;
     case MesytecMadc32ModuleConfig::dl64bit:
-        words_to_read = buffer_data_length * 2;
-        break;
+        return buffer_data_length * 2;
     case MesytecMadc32ModuleConfig::dl32bit:
     default:
-        words_to_read = buffer_data_length;
+        return buffer_data_length;
     }
+}
 
+int MesytecMadc32Module::readBuffer (uint32_t *data, uint32_t words_to_read, uint32_t *rd) {
+    *rd = 0;
     ++words_to_read;
     //printf("madc32: Words to read: %d\n",words_to_read);
 
@@ -714,6 +818,7 @@ static const confmap_t confmap [] = {
     confmap_t ("rc_module_id_read", &MesytecMadc32ModuleConfig::rc_module_id_read),
     confmap_t ("rc_module_id_write", &MesytecMadc32ModuleConfig::rc_module_id_write),
     confmap_t ("max_transfer_data", &MesytecMadc32ModuleConfig::max_transfer_data),
+    confmap_t ("multi_event_timeout", &MesytecMadc32ModuleConfig::multi_event_timeout),
     confmap_t ("cblt_mcst_ctrl", &MesytecMadc32ModuleConfig::cblt_mcst_ctrl),
     confmap_t ("cblt_addr", &MesytecMadc32ModuleConfig::cblt_addr),
     confmap_t ("mcst_addr", &MesytecMadc32ModuleConfig::mcst_addr),
@@ -846,7 +951,7 @@ The Mesytec MADC-32 module is a 32 channel ADC.
 \subsection settings Settings
 
 \subsection irq IRQ
-The IRQ panel controls the conditions on which VME interrupt requests are generated. IRQs are not yet used in data readout.
+The IRQ panel controls the conditions on which VME interrupt requests are generated. With interrupt readout enabled in the thread setup, a trigger module with a non-zero IRQ level is read out when its interrupt arrives instead of being polled.
 
 \subsection info Info
 The Info panel provides some basic information about the firmware that runs on the module.
@@ -26,6 +26,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "mesytec_madc_32_v2.h"
 
+#include <QTime>
+
 struct MesytecMadc32ModuleConfig {
     enum AddressSource{asBoard,asRegister};
     enum DataLengthFormat{dl8bit,dl16bit,dl32bit,dl64bit};
@@ -61,6 +63,7 @@ struct MesytecMadc32ModuleConfig {
     uint8_t irq_vector;
     uint16_t irq_threshold;
     uint16_t max_transfer_data;
+    uint16_t multi_event_timeout; // ms, see MesytecMadc32Module::dataReady
 
     uint8_t cblt_mcst_ctrl;
     uint8_t cblt_addr;
@@ -127,7 +130,7 @@ struct MesytecMadc32ModuleConfig {
           base_addr_register(0),module_id(0xFF),
           firmware_expected(MADC32V2_2_EXPECTED_FIRMWARE),
           irq_level(0),irq_vector(0),irq_threshold(1),
-          max_transfer_data(1),cblt_mcst_ctrl(0),
+          max_transfer_data(1),multi_event_timeout(10),cblt_mcst_ctrl(0),
           cblt_addr(0xAA),mcst_addr(0xBB),
           data_length_format(dl64bit),
           multi_event_mode(meSingle),
@@ -229,13 +232,31 @@ public:
     // Mandatory virtual functions
     virtual void setChannels ();
     virtual int acquire (Event* ev);
+    virtual bool hasRawReadout () const { return conf_.multi_event_mode != MesytecMadc32ModuleConfig::meSingle; }
+    virtual int acquireRaw (QVector<uint32_t> *raw);
+    virtual int decode (Event *ev, const QVector<uint32_t> &raw);
+    virtual int eventLength (const uint32_t *data, int len) const;
+    virtual int setChainPosition (uint8_t cbltAddr, ChainPosition pos);
+    virtual int claimChainedData (const uint32_t *data, int len) const;
+    virtual int chainedReadoutDone () { return readoutReset (); }
     virtual bool dataReady ();
+    virtual int appendStatusReads (QVector<VmeOp> *ops) const;
+    virtual bool dataReadyFromStatus (const VmeOp *status);
+    virtual bool getIrq (uint8_t *level, uint8_t *vector) const {
+        *level = conf_.irq_level & 7;
+        *vector = conf_.irq_vector;
+        return *level != 0;
+    }
     virtual int reset ();
     virtual int configure ();
 
     virtual uint32_t getBaseAddress () const;
     virtual void setBaseAddress (uint32_t baddr);
-    virtual void runStartingEvent() { dmx_.runStartingEvent(); }
+    virtual void runStartingEvent() {
+        dmx_.setEventCounterCheck (conf_.marking_type == MesytecMadc32ModuleConfig::mtEventCounter);
+        dmx_.runStartingEvent();
+    }
+    virtual uint32_t getLostEvents () const { return dmx_.getLostEvents (); }
 
     MesytecMadc32ModuleConfig *getConfig () { return &conf_; }
 
@@ -244,6 +265,10 @@ public:
 private:
     MesytecMadc32Module (int _id, const QString &);
     void writeToBuffer(Event *ev);
+    uint32_t bufferWords (); // 32 bit words in the data fifo
+    uint32_t toWords (uint16_t length); // buffer data length to 32 bit words
+    bool bufferReady (uint32_t words); // rest of dataReady
+    int readBuffer (uint32_t *data, uint32_t words_to_read, uint32_t *rd);
 
 public slots:
     virtual void prepareForNextAcquisition () {}
@@ -260,6 +285,7 @@ public:
 private:
     uint16_t firmware;
     uint16_t module_id;
+    uint8_t chain_module_id; // module id in the event headers, for splitting chained data
     uint32_t event_counter;
     uint32_t timestamp_counter;
     uint32_t adc_busy_counter;
@@ -267,6 +293,7 @@ private:
     uint32_t time_counter;
     uint32_t buffer_data_length; // unit depends of conf_.data_length_format
     uint32_t data [MADC32V2_LEN_EVENT_MAX];
+    QTime lastDrain; // time of the last multi event transfer
 
 
     MesytecMadc32Demux dmx_;
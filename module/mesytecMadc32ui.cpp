@@ -230,6 +230,7 @@ void MesytecMadc32UI::createUI()
     uif.addHexSpinnerToGroup(tn[nt],gn[ng],"IRQ vector","irq_vector",0,0xff);
     uif.addSpinnerToGroup(tn[nt],gn[ng],"IRQ threshold","irq_threshold",0,0x1fff); // bit
     uif.addSpinnerToGroup(tn[nt],gn[ng],"Maximum amount of transfer data","max_transfer_data",0,0x3fff); // 14 bit
+    uif.addSpinnerToGroup(tn[nt],gn[ng],"Multi event timeout (ms)","multi_event_timeout",0,10000);
 
     // TAB Counters
     tn.append("Counters"); nt++; uif.addTab(tn[nt]);
@@ -561,6 +562,9 @@ void MesytecMadc32UI::uiInput(QString _name)
         if(_name == "max_transfer_data"){
             module->conf_.max_transfer_data= sb->value();
         }
+        if(_name == "multi_event_timeout"){
+            module->conf_.multi_event_timeout = sb->value();
+        }
         if(_name == "rc_module_id_read"){
             module->conf_.rc_module_id_read = sb->value();
         }
@@ -874,6 +878,7 @@ void MesytecMadc32UI::applySettings()
             if(w->objectName() == "base_addr_register") w->setValue(module->conf_.base_addr_register);
             if(w->objectName() == "time_stamp_divisor") w->setValue(module->conf_.time_stamp_divisor);
             if(w->objectName() == "max_transfer_data") w->setValue(module->conf_.max_transfer_data);
+            if(w->objectName() == "multi_event_timeout") w->setValue(module->conf_.multi_event_timeout);
             if(w->objectName() == "rc_module_id_read") w->setValue(module->conf_.rc_module_id_read);
             if(w->objectName() == "rc_module_id_write") w->setValue(module->conf_.rc_module_id_write);
 
@@ -15,6 +15,7 @@
 #define MADC32V2_VAL_IRQ_THRESHOLD_MAX    8120
 
 #define MADC32V2_LEN_EVENT_MAX 34
+#define MADC32V2_LEN_BUFFER_MAX 8192 // 32 bit words in the data fifo
 
 // Firmware
 #define MADC32V2_2_EXPECTED_FIRMWARE 0x0202
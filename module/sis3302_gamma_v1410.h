@@ -56,6 +56,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define SIS3302_V1410_MEM_PAGE_LENGTH_WORDS   0x0200000
 #define SIS3302_V1410_MEM_PAGE_LENGTH_BYTES   0x0800000
 #define SIS3302_V1410_MSK_PAGE_LENGTH_SAMPLES 0x03ffffc // 8 MB == 2 MWords
+#define SIS3302_V1410_BANK2_MEM_PAGE          1         // bank 2 starts 8 MB into the ADC memory
 
 #define SIS3302_V1410_CONTROL_STATUS          0x00  /* read/write; D32 */
 #define SIS3302_V1410_MODID                   0x04  /* read only; D32 */
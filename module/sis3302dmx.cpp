@@ -28,19 +28,18 @@ Sis3302Demux::Sis3302Demux(const QList<EventSlot *> &evsl)
 {
 }
 
-void Sis3302Demux::setMetaData(uint32_t _nofTraces, EventDirEntry_t* _evDir, TimestampDir_t *_tsDir)
+void Sis3302Demux::setMetaData(uint32_t _nofTraces, const EventDirEntry_t* _evDir, const TimestampDir_t *_tsDir)
 {
     nofTraces = _nofTraces;
     evDir = _evDir;
     tsDir = _tsDir;
-    pageWrap = true;
+    pageWrap = (_evDir != NULL);
 }
 
-void Sis3302Demux::process (Event *ev, uint32_t *_data, uint32_t _len)
+void Sis3302Demux::process (Event *ev, const uint32_t *_data, uint32_t len)
 {
     //printf("DemuxSis3302Plugin processing...\n");
-    data = (DataStruct_t*)_data;
-    len = _len;
+    const DataStruct_t* data = (const DataStruct_t*)_data;
 
     // Recover channel information
     uint8_t curCh = (len >> 29) & 0x7;
@@ -49,42 +48,40 @@ void Sis3302Demux::process (Event *ev, uint32_t *_data, uint32_t _len)
 
     //printf("sis3302dmx: Current channel: %d with %d data points.\n",curCh,length*2);
 
-    // In case of page wrap mode, untangle data
-    if(pageWrap == true)
+    // Publish event data
+    QVector<uint32_t> &outData = ev->store< QVector<uint32_t> > (evslots.at(curCh));
+    outData.resize(length*2);
+    int cnt = 0;
+    uint32_t done = 0;
+
+    // In case of page wrap mode, untangle data while copying it
+    if(pageWrap == true && nofTraces > 0)
     {
         uint32_t traceLength = length/nofTraces; // lwords
         for(unsigned int tr = 0; tr < nofTraces; tr++)
         {
-            DataStruct_t tmp[traceLength];
+            const DataStruct_t* trace = data + tr*traceLength;
             uint32_t off = evDir[tr].addr/2 - tr*traceLength; // Offset wrt to page border in Lwords
 
-            // Fill temporary vector
             for(unsigned int s = off; s < traceLength; s++)
             {
-                tmp[s-off] = data[tr*traceLength+s];
+                outData[cnt++] = trace[s].low;
+                outData[cnt++] = trace[s].high;
             }
             for(unsigned int s = 0; s < off; s++)
             {
-                tmp[traceLength-off+s] = data[tr*traceLength+s];
-            }
-
-            // Fill rearranged data vector
-            for(unsigned int s = 0; s < traceLength; s++)
-            {
-                data[tr*traceLength+s] = tmp[s];
+                outData[cnt++] = trace[s].low;
+                outData[cnt++] = trace[s].high;
             }
         }
+        done = nofTraces*traceLength;
     }
 
-    // Publish event data
-    QVector<uint32_t> outData(length*2,0);
-    int cnt = 0;
-    for(uint32_t i = 0; i < length; i++)
+    for(uint32_t i = done; i < length; i++)
     {
         outData[cnt++] = data[i].low;
         outData[cnt++] = data[i].high;
     }
-    ev->put (evslots.at(curCh), QVariant::fromValue (outData));
 
     /*printf("Data dump from DMX:\n");
     for(uint32_t i=0; i < length*2; i++)
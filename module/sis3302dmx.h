@@ -37,14 +37,13 @@ class Sis3302Demux
 public:
     Sis3302Demux (const QList<EventSlot*> &);
 
-    virtual void process(Event *ev, uint32_t* _data, uint32_t _len);
-    void setMetaData(uint32_t, EventDirEntry_t*, TimestampDir_t*);
+    virtual void process(Event *ev, const uint32_t* _data, uint32_t _len);
+    /*! Set the directories for page wrap mode. Passing NULL for the event directory disables page wrap mode. */
+    void setMetaData(uint32_t, const EventDirEntry_t*, const TimestampDir_t*);
 
 protected:
-    DataStruct_t* data;
-    uint32_t len;
-    EventDirEntry_t* evDir;
-    TimestampDir_t* tsDir;
+    const EventDirEntry_t* evDir;
+    const TimestampDir_t* tsDir;
 
     uint32_t* curEvent[8];
     uint32_t nofTraces;
@@ -119,20 +119,21 @@ void Sis3302V1410Demux::runStartingEvent(AbstractModule* owner) {
 
 }
 
-void Sis3302V1410Demux::processRaw(Event *ev, uint32_t _data[][SIS3302_V1410_MAX_NOF_LWORDS], uint32_t* len){
+void Sis3302V1410Demux::processRaw(Event *ev, const uint32_t *const *_data, const uint32_t* len){
 
     if(enable_raw_output) {
-        DataStruct_t* data_[SIS3302_V1410_NOF_CHANNELS];
+        const DataStruct_t* data_[SIS3302_V1410_NOF_CHANNELS];
 
         // Recover length
         uint32_t total_length = 0;
 
         for(int ch = 0; ch < SIS3302_V1410_NOF_CHANNELS; ++ch) {
-            data_[ch] = (DataStruct_t*)_data[ch];
+            data_[ch] = (const DataStruct_t*)_data[ch];
             total_length += (len[ch] & 0x1ffffff); // lWords
             //printf("length %d: %d\n",ch,(len[ch] & 0x1ffffff));
         }
 
+        QVector<uint32_t> &rawData = ev->store< QVector<uint32_t> > (evslots.at(output_raw_data_start_idx));
         rawData.resize(total_length);
         //printf("total_length: %d\n",total_length);
 
@@ -145,19 +146,15 @@ void Sis3302V1410Demux::processRaw(Event *ev, uint32_t _data[][SIS3302_V1410_MAX
             }
         }
 
-        ev->put (evslots.at(output_raw_data_start_idx),
-                 QVariant::fromValue (rawData));
-
     }
 }
 
-void Sis3302V1410Demux::process (Event *ev, uint32_t *_data, uint32_t _len, uint32_t raw_length)
+void Sis3302V1410Demux::process (Event *ev, const uint32_t *_data, uint32_t len, uint32_t raw_length)
 {
 
     if(enable_per_channel_output) {
         //printf("DemuxSis3302V1410Plugin processing...\n");
-        data = (DataStruct_t*)_data;
-        len = _len;
+        const DataStruct_t* data = (const DataStruct_t*)_data;
 
         // Recover length
         uint32_t length = (len & 0x1ffffff); // lWords
@@ -187,15 +184,21 @@ void Sis3302V1410Demux::process (Event *ev, uint32_t *_data, uint32_t _len, uint
         //printf("sis3302dmx: raw: %d samples, energy: %d samples.\n",length_raw,length_energy);
         //printf("sis3302dmx: raw: %d offset, energy: %d offset.\n",rawOffset,energyOffset);
 
-        // Event data containers
+        // Event data containers, filled in place
+        QVector<uint32_t> *outData = NULL;
+        QVector<uint32_t> *outData2 = NULL;
+        QVector<double> *outData3 = NULL;
         if(enabled_raw_sample_ch[curCh]) {
-            outData.resize(length_raw*nofEvents);
+            outData = &ev->store< QVector<uint32_t> > (evslots.at(curCh));
+            outData->resize(length_raw*nofEvents);
         }
         if(enabled_energy_sample_ch[curCh]) {
-            outData2.resize(length_energy*nofEvents);
+            outData2 = &ev->store< QVector<uint32_t> > (evslots.at(curCh+SIS3302_V1410_NOF_CHANNELS));
+            outData2->resize(length_energy*nofEvents);
         }
         if(enabled_energy_value_ch[curCh]) {
-            outData3.resize(nofEvents);
+            outData3 = &ev->store< QVector<double> > (evslots.at(curCh+SIS3302_V1410_NOF_CHANNELS*2));
+            outData3->resize(nofEvents);
         }
 
         int rawcnt = 0;
@@ -207,15 +210,15 @@ void Sis3302V1410Demux::process (Event *ev, uint32_t *_data, uint32_t _len, uint
             //  RAW trace
             if(enabled_raw_sample_ch[curCh]) {
                 for(uint32_t i = 0; i < length_raw/2; i++) {
-                    outData[rawcnt++] = data[event_offset + rawOffset + i].low;
-                    outData[rawcnt++] = data[event_offset + rawOffset + i].high;
+                    (*outData)[rawcnt++] = data[event_offset + rawOffset + i].low;
+                    (*outData)[rawcnt++] = data[event_offset + rawOffset + i].high;
                 }
             }
 
             //  Energy trace
             if(enabled_energy_sample_ch[curCh]) {
                 for(uint32_t i = 0; i < length_energy; i++) {
-                    outData2[nrgcnt++] = data[event_offset + energyOffset + i].data;
+                    (*outData2)[nrgcnt++] = data[event_offset + energyOffset + i].data;
                 }
             }
 
@@ -223,29 +226,16 @@ void Sis3302V1410Demux::process (Event *ev, uint32_t *_data, uint32_t _len, uint
             if(enabled_energy_value_ch[curCh]) {
                 double energyValue = - (int32_t)(data[event_offset + energyValueOffset + 1].data)
                                      + (int32_t)(data[event_offset + energyValueOffset].data);
-                outData3[n] = energyValue;
+                (*outData3)[n] = energyValue;
                 //printf("sis3302dmx: energy value[%d]: %d offset, %f value: \n",n,energyValueOffset,energyValue);
             }
         }
 
-        // Publish event data
-        if(enabled_raw_sample_ch[curCh]) {
-            ev->put (evslots.at(curCh),
-                     QVariant::fromValue (outData));
-        }
-        if(enabled_energy_sample_ch[curCh]) {
-            ev->put (evslots.at(curCh+SIS3302_V1410_NOF_CHANNELS),
-                     QVariant::fromValue (outData2));
-        }
-        if(enabled_energy_value_ch[curCh]) {
-            ev->put (evslots.at(curCh+SIS3302_V1410_NOF_CHANNELS*2),
-                     QVariant::fromValue (outData3));
-        }
 
         /*printf("Data dump from DMX:\n");
         for(uint32_t i=0; i < length*2; i++)
         {
-            printf("<%d> %u  ",i,outData[i]);
+            printf("<%d> %u  ",i,(*outData)[i]);
         }
         printf("\n");*/
     }
@@ -42,8 +42,8 @@ class Sis3302V1410Demux
 public:
     Sis3302V1410Demux (const QList<EventSlot*> &);
 
-    virtual void process(Event *ev, uint32_t* _data, uint32_t _len, uint32_t raw_length);
-    void processRaw(Event *ev, uint32_t _data[][SIS3302_V1410_MAX_NOF_LWORDS], uint32_t* _len);
+    virtual void process(Event *ev, const uint32_t* _data, uint32_t len, uint32_t raw_length);
+    void processRaw(Event *ev, const uint32_t *const *_data, const uint32_t* len);
     void setMetaData(uint32_t, EventDirEntry_t*, TimestampDir_t*);
 
     void setMultiEvent(bool _isMultiEvent);
@@ -52,9 +52,6 @@ public:
     void runStartingEvent(AbstractModule* owner);
 
 protected:
-    DataStruct_t* data;
-    uint32_t len;
-
     uint32_t* curEvent[SIS3302_V1410_NOF_CHANNELS];
     uint32_t nofTraces;
     uint32_t nofEvents;
@@ -69,11 +66,6 @@ protected:
     bool enable_per_channel_output;
     bool enable_meta_output;
 
-    QVector<uint32_t> outData;
-    QVector<uint32_t> outData2;
-    QVector<double> outData3;
-
-    QVector<uint32_t> rawData;
     uint32_t rawCnt;
 
     QVector<bool> enabled_raw_sample_ch;
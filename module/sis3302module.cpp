@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "modulemanager.h"
 #include "eventbuffer.h"
 
+#include <algorithm>
+
 /******************************** Struck SIS3302 8 ch FADC *****************************
  *
  *
@@ -339,17 +341,8 @@ int Sis3302Module::getTimeStampDir()
 
     if(vmeMode == 0)
     {
-        for(unsigned int i=0; i<reqNofLwords; i++)
-        {
-            ret = iface->readA32D32(addr,&data);
-            if(ret != 0) { printf("Error %d at VME READ SIS3302_TIMESTAMP_DIRECTORY\n",ret);}
-            else
-            {
-                (*ptr) = data;
-                ptr++;
-            }
-            addr += 4;
-        }
+        ret = readDirectory(addr,ptr,reqNofLwords);
+        if(ret != 0) { printf("Error %d at VME READ SIS3302_TIMESTAMP_DIRECTORY\n",ret);}
     }
     else
     {
@@ -383,17 +376,8 @@ int Sis3302Module::getEventDir(int ch)
 
     if(vmeMode == 0)
     {
-        for(unsigned int i=0; i<reqNofLwords; i++)
-        {
-            ret = iface->readA32D32(addr,&data);
-            if(ret != 0) { printf("Error %d at VME READ SIS3302_EVENT_DIRECTORY_ADC\n",ret);}
-            else
-            {
-                (*ptr) = data;
-                ptr++;
-            }
-            addr += 4;
-        }
+        ret = readDirectory(addr,ptr,reqNofLwords);
+        if(ret != 0) { printf("Error %d at VME READ SIS3302_EVENT_DIRECTORY_ADC\n",ret);}
     }
     else
     {
@@ -413,6 +397,29 @@ int Sis3302Module::getEventDir(int ch)
     return ret;
 }
 
+int Sis3302Module::readDirectory(uint32_t _addr, uint32_t *dest, uint32_t nofLwords)
+{
+    if(nofLwords == 0) return 0;
+
+    // one access list for the whole directory instead of a single cycle per entry
+    dirOps.resize(nofLwords);
+    for(unsigned int i=0; i<nofLwords; i++)
+        dirOps[i] = VmeOp::read32(_addr + 4*i);
+
+    int ret = getInterface()->executeList(&dirOps[0],nofLwords);
+
+    // entries that could not be read are skipped
+    for(unsigned int i=0; i<nofLwords; i++)
+    {
+        if(dirOps[i].error == 0)
+        {
+            (*dest) = dirOps[i].data;
+            dest++;
+        }
+    }
+    return ret;
+}
+
 int Sis3302Module::getNextSampleAddr(int adc, uint32_t* _addr)
 {
     int ret = 0x0;
@@ -556,7 +563,86 @@ int Sis3302Module::acquire(Event *ev)
     return ret;
 }
 
+int Sis3302Module::acquireRaw(QVector<uint32_t> *raw)
+{
+    int ret = 0;
+    uint32_t nofWords = 0;
+
+    if(conf.acMode == Sis3302config::singleEvent ||
+       conf.enable_page_wrap == false) {
+        ret = sampleSingle(&nofWords); }
+    if(conf.acMode == Sis3302config::multiEvent &&
+       conf.enable_page_wrap == true) {
+        ret = sampleMulti(&nofWords); }
+    if(ret != 0) {
+        printf("sis3302: Failed acquiring event, ret = 0x%x\n",ret);
+        return ret;
+    }
+
+    // DMA straight into the raw data of the event. Events alternate in the buffer, so the transfer of this
+    // event overlaps with the decoding of the previous one without any intermediate copy.
+    // One frame per enabled channel: length, page wrap flag, number of traces, event directory, data
+    for(unsigned int i = 0; i < 8; i++)
+    {
+        if(conf.ch_enabled[i] == false) continue;
+        uint32_t nofTraces = conf.enable_page_wrap ? std::min (conf.nof_events, (uint32_t)512) : 0;
+        int pos = raw->size();
+        raw->resize(pos + 3 + nofTraces + nofWords);
+        uint32_t *frame = raw->data() + pos;
+        frame[1] = conf.enable_page_wrap;
+        frame[2] = nofTraces;
+        for(uint32_t tr = 0; tr < nofTraces; tr++)
+            frame[3 + tr] = eventDir[i][tr].data;
+        readAdcChannel(i, nofWords, frame + 3 + nofTraces);
+        frame[0] = readLength[i];
+        raw->resize(pos + 3 + nofTraces + (readLength[i] & 0x1ffffff));
+    }
+    return 0;
+}
+
+int Sis3302Module::decode(Event *ev, const QVector<uint32_t> &raw)
+{
+    const uint32_t *it = raw.constData();
+    const uint32_t *end = it + raw.size();
+    while(end - it >= 3)
+    {
+        uint32_t len = it[0];
+        bool pageWrap = it[1];
+        uint32_t dirLength = pageWrap ? it[2] : 0;
+        uint32_t dataLength = len & 0x1ffffff;
+        it += 3;
+        if(dirLength + dataLength > (uint32_t)(end - it)) return -1;
+
+        if(pageWrap) dmx.setMetaData(dirLength, reinterpret_cast<const EventDirEntry_t*> (it), NULL);
+        else dmx.setMetaData(0, NULL, NULL);
+        it += dirLength;
+        dmx.process (ev, it, len);
+        it += dataLength;
+    }
+    return 0;
+}
+
 int Sis3302Module::acquisitionStartSingle()
+{
+    uint32_t nofWords = 0;
+    int ret = sampleSingle(&nofWords);
+
+    for(int i=0; i<8; i++)
+    {
+        readAdcChannel(i, nofWords, readBuffer[i]);
+        /*if(conf.ch_enabled[i])
+        {
+            for(uint32_t s = 0; s < readLength[i]; s++)
+            {
+                printf("Data: %d: 0x%x\n",s,readBuffer[i][s]);
+            }
+        }*/
+    }
+
+    return ret;
+}
+
+int Sis3302Module::sampleSingle(uint32_t *nofWords)
 {
     int ret = 0;
     uint32_t evCnt = 0;
@@ -609,24 +695,25 @@ int Sis3302Module::acquisitionStartSingle()
     // Read the timestamp dir (only one entry)
     getTimeStampDir();
 
-    for(int i=0; i<8; i++)
+    *nofWords = (conf.event_length/2)*evCnt;
+    return ret;
+}
+
+int Sis3302Module::acquisitionStartMulti()
+{
+    uint32_t nofWords = 0;
+    int ret = sampleMulti(&nofWords);
+
+    // Read data from the ADC buffers
+    for(int ch=0; ch<8; ch++)
     {
-        readAdcChannel(i, (conf.event_length/2)*evCnt);
-        /*if(conf.ch_enabled[i])
-        {
-            for(uint32_t s = 0; s < readLength[i]; s++)
-            {
-                printf("Data: %d: 0x%x\n",s,readBuffer[i][s]);
-            }
-        }*/
-        // Store channel information in highest 3 bits of readLength[i];
-        readLength[i] |= (i << 29);
+        readAdcChannel(ch, nofWords, readBuffer[ch]);
     }
 
     return ret;
 }
 
-int Sis3302Module::acquisitionStartMulti()
+int Sis3302Module::sampleMulti(uint32_t *nofWords)
 {
     int ret = 0;
     uint32_t evCnt = 0;
@@ -670,12 +757,7 @@ int Sis3302Module::acquisitionStartMulti()
             getEventDir(ch);
     }
 
-    // Read data from the ADC buffers
-    for(int ch=0; ch<8; ch++)
-    {
-        readAdcChannel(ch, nofReqWords);
-    }
-
+    *nofWords = nofReqWords;
     return ret;
 }
 
@@ -698,7 +780,7 @@ bool Sis3302Module::dataReady()
     return dready;
 }
 
-int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords)
+int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords, uint32_t *dest)
 {
     //printf("sis3302 Starting ADC ch %d read of %d lwords\n",ch,_reqNofWords);
 
@@ -727,9 +809,7 @@ int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords)
         uint32_t reqNofLwords = 0;  // LWord aligned
         uint32_t gotNofLwords = 0;  // LWord aligned
 
-        uintptr_t readBufferPtr = 0;    // Byte aligned
-
-        uint32_t startPos = 0x0;    // Byte aligned
+        uint32_t startPos = readLength[ch];    // LWord aligned
 
         subEventSampleAddr      =  (nextEventSampleStartAddr & pageLengthMask) ;
         subMaxPageSampleLength  =  pageLength - subEventSampleAddr ;
@@ -763,21 +843,18 @@ int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords)
 
         //printf("sis3302: Starting read from adc %d from addr: 0x%x\n",ch,addr);
 
-        readBufferPtr = (uintptr_t) &(readBuffer[ch][startPos]);
-
         if (vmeMode == 0) { // Single Cycles
             for (uint32_t i=0; i<reqNofLwords; i++) {
-                uint32_t* ptr = (uint32_t*)(readBufferPtr+4*i);
+                uint32_t* ptr = dest + startPos + i;
                 ret = iface->readA32D32(addr,ptr);
                 if (ret != 0) printf("sis3302 return_code = 0x%08x at addr = 0x%08x\n",ret,addr);
                 //printf("sis3302: read from addr 0x%x value: 0x%x to buffer 0x%x\n",addr,(*ptr),ptr);
                 addr = addr + 4 ;
             }
-            startPos += reqNofLwords*4;
             readLength[ch] += reqNofLwords;
         }
         else { // DMA
-            ret = iface->readA32MBLT64(addr,(uint32_t*)(readBufferPtr),reqNofLwords,&gotNofLwords);
+            ret = iface->readA32MBLT64(addr,dest + startPos,reqNofLwords,&gotNofLwords);
             if(ret != 0) {
                 printf("sis3302 return_code = 0x%08x at addr = 0x%08x\n", ret, addr );
                 printf("sis3302 reqNofLwords = 0x%08x  gotNofLwords = 0x%08x\n", reqNofLwords, gotNofLwords );
@@ -787,14 +864,10 @@ int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords)
                 printf("sis3302 Length Error sis1100w_Vme_Dma_Read:   reqNofLwords = 0x%08x  gotNofLwords = 0x%08x\n", reqNofLwords, gotNofLwords );
                 return -1;
             }
-            startPos += gotNofLwords*4;
             readLength[ch] += gotNofLwords;
         }
 
-	// Store channel info
-	readLength[ch] |= ((ch & 0x7) << 29);
-
-        //printf("\nsis3302 After read Ch %d: StartPos: %d byte, ReadLength: %d lwords\n",ch,startPos,readLength[ch]);
+        //printf("\nsis3302 After read Ch %d: StartPos: %d lwords, ReadLength: %d lwords\n",ch,startPos,readLength[ch]);
 
         /*printf("\nsis3302 Dump data ch %d\n",ch);
         for(uint32_t i=0; i<gotNofLwords; i++)
@@ -806,6 +879,9 @@ int Sis3302Module::readAdcChannel(int ch, uint32_t _reqNofWords)
         restEventSampleLength    =  restEventSampleLength - subEventSampleLength     ;
 
     } while ((ret == 0) && (restEventSampleLength > 0)) ;
+
+    // Store channel info
+    readLength[ch] |= ((ch & 0x7) << 29);
     return ret;
 }
 
@@ -146,6 +146,9 @@ public:
     virtual void applySettings(QSettings*);
     void setChannels();
     virtual int acquire(Event *);
+    virtual bool hasRawReadout() const { return true; }
+    virtual int acquireRaw(QVector<uint32_t> *raw);
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw);
     virtual bool dataReady();
     virtual int configure();
     virtual int reset();
@@ -165,9 +168,11 @@ public:
     int reset_DDR2_logic();
     int timestamp_clear();
     int waitForSamplingComplete();
-    int readAdcChannel(int ch, uint32_t _reqNofWords);
+    int readAdcChannel(int ch, uint32_t _reqNofWords, uint32_t *dest);
     int acquisitionStartSingle();
     int acquisitionStartMulti();
+    int sampleSingle(uint32_t *nofWords);
+    int sampleMulti(uint32_t *nofWords);
     int checkConfig();
     int writeToBuffer(Event *);
     bool isArmedNotBusy();
@@ -176,6 +181,7 @@ public:
     uint32_t getWrapSizeFromConfig(Sis3302config::WrapSize);
 
     int sis3302_write_dac_offset(unsigned int *offset_value_array);
+    int readDirectory(uint32_t addr, uint32_t *dest, uint32_t nofLwords);
 
 public slots:
     virtual void prepareForNextAcquisition() {}
@@ -188,6 +194,7 @@ private:
 
     EventDirEntry_t eventDir[8][512];
     TimestampDir_t timestampDir[512];
+    std::vector<VmeOp> dirOps; // access list for reading the directories
     QList<EventSlot*> evslots;
     Sis3302Demux dmx;
 };
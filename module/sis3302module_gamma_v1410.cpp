@@ -48,6 +48,8 @@ Sis3302V1410Module::Sis3302V1410Module(int _id, QString _name)
     , addr(0)
     , data(0)
     , nof_adrr_mismatch(0)
+    , armedBank(1)
+    , rawFramePos(0)
     , dmx (evslots)
 {   
     init();
@@ -418,6 +420,43 @@ int Sis3302V1410Module::getNextSampleAddr(int ch, uint32_t* _addr)
     return ret;
 }
 
+// This function returns the sampling address at which the previously armed bank was left
+// adc: Range 0..7 denotes the adc channel
+// _addr: Placeholder to store the value
+int Sis3302V1410Module::getPrevBankSampleAddr(int ch, uint32_t* _addr)
+{
+    int ret = 0x0;
+    addr = conf.base_addr + SIS3302_V1410_PRV_BNK_SAMPLE_ADDR(ch);
+    data = 0;
+    ret = getInterface ()->readA32D32(addr,&data);
+    if(ret != 0) {
+        printf("Error %d at VME READ SIS3302_V1410_PRV_BNK_SAMPLE_ADDR(%d)",ret,ch);
+        (*_addr) = 0;
+    }
+    else (*_addr) = data & SIS3302_V1410_MSK_PREV_BANK_SAMPLE_ADDR;
+    return ret;
+}
+
+// Selects the 8 MB page of the ADC memories visible in the VME window
+int Sis3302V1410Module::setMemoryPage(uint32_t page)
+{
+    int ret = 0x0;
+    addr = conf.base_addr + SIS3302_V1410_ADC_MEMORY_PAGE; data = page;
+    ret = getInterface()->writeA32D32(addr,data);
+    if(ret != 0) printf("Error %d at SIS3302_V1410_ADC_MEMORY_PAGE",ret);
+    return ret;
+}
+
+// Arms the other bank in a single write, so sampling continues without dead time.
+// Returns the bank that was armed before, which holds the data to be read out.
+uint8_t Sis3302V1410Module::switchBank()
+{
+    uint8_t full = armedBank;
+    armedBank = (armedBank == 1) ? 2 : 1;
+    this->arm(armedBank);
+    return full;
+}
+
 int Sis3302V1410Module::reset()
 {
     printf("sis3302::reset\n");
@@ -438,6 +477,7 @@ int Sis3302V1410Module::resetSampleLogic()
     if(ret != 0) printf("Error %d at SIS3302_V1410_SAMPLE_LOGIC_RESET",ret);
 
     this->arm(1);
+    armedBank = 1;
 
     return ret;
 }
@@ -740,7 +780,51 @@ int Sis3302V1410Module::acquire(Event *ev)
     return ret;
 }
 
-int Sis3302V1410Module::acquisitionStartSingle()
+int Sis3302V1410Module::acquireRaw(QVector<uint32_t> *raw)
+{
+    int ret = 0;
+
+    // Each channel is read straight into the raw data of the event, so with bank switching the transfer
+    // of this event overlaps with the decoding of the previous one on the plugin threads.
+    if(conf.acMode == Sis3302V1410config::singleEvent) {
+        ret = acquisitionStartSingle(raw); }
+    if(conf.acMode == Sis3302V1410config::multiEvent) {
+        ret = acquisitionStartMulti(raw); }
+    if(ret != 0) printf("sis3302: Failed acquiring event, ret = 0x%x\n",ret);
+
+    return ret;
+}
+
+int Sis3302V1410Module::decode(Event *ev, const QVector<uint32_t> &raw)
+{
+    // One frame per enabled channel: length with the channel in the highest 3 bits, data
+    const uint32_t *chData[NOF_CHANNELS];
+    uint32_t chLen[NOF_CHANNELS];
+    for(int i = 0; i < NOF_CHANNELS; ++i) {
+        chData[i] = NULL;
+        chLen[i] = 0;
+    }
+
+    const uint32_t *it = raw.constData();
+    const uint32_t *end = it + raw.size();
+    while(end - it >= 1)
+    {
+        uint32_t len = it[0];
+        uint32_t dataLength = len & 0x1ffffff;
+        ++it;
+        if(dataLength > (uint32_t)(end - it)) return -1;
+
+        int ch = (len >> 29) & 0x7;
+        chData[ch] = it;
+        chLen[ch] = len;
+        it += dataLength;
+    }
+
+    demultiplex(ev, chData, chLen);
+    return 0;
+}
+
+int Sis3302V1410Module::acquisitionStartSingle(QVector<uint32_t> *raw)
 {
     int ret = 0;
     int waitCounter = 0;
@@ -752,14 +836,20 @@ int Sis3302V1410Module::acquisitionStartSingle()
     ret = this->waitForAddrThreshold();
     if(ret == false) ERROR("timeout while waiting for address threshold flag\n",ret);
 
-    //INFO("Disarming bank 1");
-    ret = this->disarm();
+    if(conf.enable_bank_switching) {
+        // Keep sampling into the other bank while this one is read out
+        uint8_t bank = switchBank();
+        setMemoryPage(bank == 2 ? SIS3302_V1410_BANK2_MEM_PAGE : 0);
+    } else {
+        //INFO("Disarming bank 1");
+        ret = this->disarm();
 
-    // Wait until sampling complete
-    while(isArmedOrBusy()) {
-        ++waitCounter;
+        // Wait until sampling complete
+        while(isArmedOrBusy()) {
+            ++waitCounter;
+        }
+        //INFO("waitCounter",waitCounter);
     }
-    //INFO("waitCounter",waitCounter);
 
     //INFO("Reading channel data");
     for(int i=0; i<NOF_CHANNELS; ++i) {
@@ -782,7 +872,8 @@ int Sis3302V1410Module::acquisitionStartSingle()
 
             //INFO_i("Start reading on channel.",i);
             uint32_t nofSamplesRead = 0;
-            this->getNextSampleAddr(i,&nofSamplesRead);
+            if(conf.enable_bank_switching) this->getPrevBankSampleAddr(i,&nofSamplesRead);
+            else this->getNextSampleAddr(i,&nofSamplesRead);
             //INFO_i("nofSamplesRead",i,nofSamplesRead);
             endSampleAddr_words[i] = nofSamplesRead/2;
 
@@ -803,44 +894,50 @@ int Sis3302V1410Module::acquisitionStartSingle()
             //uint32_t reqNofWords = endSampleAddr_words[i];
             uint32_t reqNofWords = expectedNextSamplingAddr_words;
             //INFO_i("reqNofWords",i,reqNofWords);
-            this->readAdcChannelSinglePage(i,reqNofWords);
+            uint32_t *buf = channelBuffer(i,reqNofWords,raw);
+            this->readAdcChannelSinglePage(i,reqNofWords,buf);
             //INFO_i("readLength[i]",i,readLength[i]);
 
             // Check event trailer
-            if(readLength[i] > 1 && readBuffer[i][readLength[i]-trailerOffset] != SIS3302_V1410_MSK_EVENT_BUF_TRAILER) {
-                ERROR_i("Event trailer does not match",i,readBuffer[i][readLength[i]-1]);
+            if(readLength[i] > 1 && buf[readLength[i]-trailerOffset] != SIS3302_V1410_MSK_EVENT_BUF_TRAILER) {
+                ERROR_i("Event trailer does not match",i,buf[readLength[i]-1]);
                 ERROR_i("reqNofWords, readLength[ch]",i,reqNofWords,readLength[i]);
-                DUMP("readBuffer[i]",readBuffer[i],readLength[i]);
+                DUMP("readBuffer[i]",buf,readLength[i]);
             }
-            // Store channel information in highest 3 bits of readLength[i];
-            readLength[i] |= (i << 29);
+            finishChannel(i,raw);
         }
     }
 
-    ret = this->arm(1);
+    if(!conf.enable_bank_switching) ret = this->arm(1);
 
     return ret;
 }
 
-int Sis3302V1410Module::acquisitionStartMulti()
+int Sis3302V1410Module::acquisitionStartMulti(QVector<uint32_t> *raw)
 {
     int ret = 0;
     int waitCounter = 0;
 
     //INFO("Arming bank 1");
-    ret = this->arm(1);
+    if(!conf.enable_bank_switching) ret = this->arm(1); // with bank switching, a bank is always armed
     //INFO("Waiting for Addr Threshold");
     ret = this->waitForAddrThreshold();
     if(ret == false) ERROR("timeout while waiting for address threshold flag\n",ret);
 
-    //INFO("Disarming bank 1");
-    ret = this->disarm();
+    if(conf.enable_bank_switching) {
+        // Keep sampling into the other bank while this one is read out
+        uint8_t bank = switchBank();
+        setMemoryPage(bank == 2 ? SIS3302_V1410_BANK2_MEM_PAGE : 0);
+    } else {
+        //INFO("Disarming bank 1");
+        ret = this->disarm();
 
-    // Wait until sampling complete
-    while(isArmedOrBusy()) {
-        ++waitCounter;
+        // Wait until sampling complete
+        while(isArmedOrBusy()) {
+            ++waitCounter;
+        }
+        //INFO("waitCounter",waitCounter);
     }
-    //INFO("waitCounter",waitCounter);
 
     //INFO("Reading channel data");
     for(int i=0; i<NOF_CHANNELS; ++i) {
@@ -854,7 +951,8 @@ int Sis3302V1410Module::acquisitionStartMulti()
 
             //INFO_i("Start reading on channel.",i);
             uint32_t nofSamplesRead = 0;
-            this->getNextSampleAddr(i,&nofSamplesRead);
+            if(conf.enable_bank_switching) this->getPrevBankSampleAddr(i,&nofSamplesRead);
+            else this->getNextSampleAddr(i,&nofSamplesRead);
             //INFO_i("nofSamplesRead",i,nofSamplesRead);
             endSampleAddr_words[i] = nofSamplesRead/2;
 
@@ -866,24 +964,59 @@ int Sis3302V1410Module::acquisitionStartMulti()
             uint32_t reqNofWords = endSampleAddr_words[i];
             //uint32_t reqNofWords = expectedNextSamplingAddr_words;
             //INFO_i("reqNofWords",i,reqNofWords);
-            this->readAdcChannelSinglePage(i,reqNofWords);
+            uint32_t *buf = channelBuffer(i,reqNofWords,raw);
+            this->readAdcChannelSinglePage(i,reqNofWords,buf);
             //INFO_i("readLength[i]",i,readLength[i]);
 
             // Check event trailer
-            if(readLength[i] > 1 && readBuffer[i][readLength[i]-1] != SIS3302_V1410_MSK_EVENT_BUF_TRAILER) {
-                ERROR_i("Event trailer does not match",i,readBuffer[i][readLength[i]-1]);
+            if(readLength[i] > 1 && buf[readLength[i]-1] != SIS3302_V1410_MSK_EVENT_BUF_TRAILER) {
+                ERROR_i("Event trailer does not match",i,buf[readLength[i]-1]);
                 ERROR_i("reqNofWords, readLength[ch]",i,reqNofWords,readLength[i]);
-                DUMP("readBuffer[i]",readBuffer[i],readLength[i]);
+                DUMP("readBuffer[i]",buf,readLength[i]);
             }
-            // Store channel information in highest 3 bits of readLength[i];
-            readLength[i] |= (i << 29);
+            finishChannel(i,raw);
         }
     }
 
     return ret;
 }
 
+/*! Returns the destination for the readout of channel ch.
+ *  Without raw data this is the static read buffer, otherwise a new frame at the end of raw.
+ */
+uint32_t *Sis3302V1410Module::channelBuffer(int ch, uint32_t _reqNofWords, QVector<uint32_t> *raw)
+{
+    if(raw == NULL) return readBuffer[ch];
+
+    // MBLT64 rounds up to an even number of words, 2E reads at least 16 words
+    rawFramePos = raw->size();
+    raw->resize(rawFramePos + 1 + std::max(_reqNofWords + 1, (uint32_t)16));
+    return raw->data() + rawFramePos + 1;
+}
+
+/*! Stores the channel information in the highest 3 bits of readLength[ch]
+ *  and trims the frame of the channel to the words that were read.
+ */
+void Sis3302V1410Module::finishChannel(int ch, QVector<uint32_t> *raw)
+{
+    readLength[ch] |= (ch << 29);
+    if(raw == NULL) return;
+
+    (*raw)[rawFramePos] = readLength[ch];
+    raw->resize(rawFramePos + 1 + (readLength[ch] & 0x1ffffff));
+}
+
 int Sis3302V1410Module::writeToBuffer(Event *ev)
+{
+    const uint32_t *chData[NOF_CHANNELS];
+    for(unsigned int i = 0; i < NOF_CHANNELS; i++)
+        chData[i] = conf.enable_ch[i] ? readBuffer[i] : NULL;
+
+    demultiplex(ev, chData, readLength);
+    return 0;
+}
+
+void Sis3302V1410Module::demultiplex(Event *ev, const uint32_t *const *chData, const uint32_t *chLen)
 {
     if(conf.acMode == Sis3302V1410config::multiEvent) {
         dmx.setMultiEvent(true);
@@ -893,16 +1026,15 @@ int Sis3302V1410Module::writeToBuffer(Event *ev)
         dmx.setNofEvents(1);
     }
 
-    dmx.processRaw (ev, readBuffer, readLength);
+    dmx.processRaw (ev, chData, chLen);
 
     for(unsigned int i = 0; i < NOF_CHANNELS; i++)
     {
         //printf("sis3302: ch %d: Trying to write to buffer (ev = 0x%x)\n",i,ev);
-        if(conf.enable_ch[i] == false) continue;
-        dmx.process (ev, readBuffer[i], readLength[i], conf.raw_sample_length[i/2]);
+        if(chData[i] == NULL) continue;
+        dmx.process (ev, chData[i], chLen[i], conf.raw_sample_length[i/2]);
         //printf("sis3302: ch %d: Success!\n",i);
     }
-    return 0;
 }
 
 bool Sis3302V1410Module::dataReady()
@@ -923,11 +1055,11 @@ bool Sis3302V1410Module::dataReady()
  *
  *  Read out mode can be controlled using conf.vmeMode
  *
- *  Side effects: Data from the channel i is stored in readBuffer[ch]
+ *  Side effects: Data from the channel i is stored in dest
  *                starting at index 0.
  *                Number of words read is stored in readLength[ch]
  */
-int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
+int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords, uint32_t *dest)
 {
     int ret = 0;
 
@@ -949,12 +1081,12 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
         //INFO("words",words);
         while(words--) {
             //INFO_i("address",words,addr);
-            ret = iface->readA32D32(addr,&readBuffer[ch][bufIdx++]);
+            ret = iface->readA32D32(addr,&dest[bufIdx++]);
             if(ret != 0) {
                 ERROR_i("readAdcChannelSinglePage with vmeSingle"
                         "read error in ch = a, ret = b",words,ch,ret);
             } /*else {
-                INFO_i("data",words,readBuffer[ch][bufIdx-1]);
+                INFO_i("data",words,dest[bufIdx-1]);
             }*/
             addr+=4;
         }
@@ -966,10 +1098,10 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
         uint32_t words = 0;
         if (_reqNofWords < 16) {
             int minNofWords = 16;
-            ret = iface->readA322E(addr,&readBuffer[ch][0],minNofWords,&words);
+            ret = iface->readA322E(addr,dest,minNofWords,&words);
             words = _reqNofWords;
         } else {
-            ret = iface->readA322E(addr,&readBuffer[ch][0],_reqNofWords,&words);
+            ret = iface->readA322E(addr,dest,_reqNofWords,&words);
         }
         if(ret != 0) {
             ERROR("readAdcChannelSinglePage with vme2E"
@@ -985,7 +1117,7 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
 
     case Sis3302V1410config::vmeBLT32: {
         uint32_t words = 0;
-        ret = iface->readA32BLT32(addr,&readBuffer[ch][0],_reqNofWords,&words);
+        ret = iface->readA32BLT32(addr,dest,_reqNofWords,&words);
         if(ret != 0) {
             ERROR("readAdcChannelSinglePage with vmeBLT32"
                    "read error in ch = a, ret = b",ch,ret);
@@ -1001,7 +1133,7 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
     case Sis3302V1410config::vmeMBLT64: {
         uint32_t words = 0;
         if(_reqNofWords & 0x1) ++_reqNofWords;
-        ret = iface->readA32MBLT64(addr,&readBuffer[ch][0],_reqNofWords,&words);
+        ret = iface->readA32MBLT64(addr,dest,_reqNofWords,&words);
         if(ret != 0) {
             ERROR("readAdcChannelSinglePage with vmeMBLT64"
                    "read error in ch = a, ret = b",ch,ret);
@@ -1016,7 +1148,7 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
 
     case Sis3302V1410config::vmeDMA32: {
         uint32_t words = 0;
-        ret = iface->readA32DMA32(addr,&readBuffer[ch][0],_reqNofWords,&words);
+        ret = iface->readA32DMA32(addr,dest,_reqNofWords,&words);
         if(ret != 0) {
             ERROR("readAdcChannelSinglePage with vmeDMA32"
                    "read error in ch = a, ret = b",ch,ret);
@@ -1035,7 +1167,7 @@ int Sis3302V1410Module::readAdcChannelSinglePage(int ch, uint32_t _reqNofWords)
     }
 
     // Store channel length in first word 0xTTTLLLI (T = time, L = Length, I = ID)
-    readBuffer[ch][0] |= (readLength[ch]  << 4);
+    dest[0] |= (readLength[ch]  << 4);
 
     return ret;
 }
@@ -1323,6 +1455,7 @@ static const confmap_t confmap [] = {
     confmap_t ("enable_irq", &Sis3302V1410config::enable_irq),
     confmap_t ("update_irq", &Sis3302V1410config::update_irq),
     confmap_t ("enable_user_led", &Sis3302V1410config::enable_user_led),
+    confmap_t ("enable_bank_switching", &Sis3302V1410config::enable_bank_switching),
     confmap_t ("enable_vipa", &Sis3302V1410config::enable_vipa),
     confmap_t ("enable_geo_addressing", &Sis3302V1410config::enable_geo_addressing),
     confmap_t ("enable_reduced_addressing", &Sis3302V1410config::enable_reduced_addressing),
@@ -72,6 +72,7 @@ public:
     VmeMode vmeMode;
     ClockSource clockSource;
     bool enable_user_led;
+    bool enable_bank_switching; // sample into one bank while the other one is read out
 
     // Addressing setup values
     bool enable_vipa;
@@ -171,6 +172,7 @@ public:
         vmeMode(vmeSingle),
         clockSource(creal100),
         enable_user_led(false),
+        enable_bank_switching(false),
         enable_vipa(false),
         enable_geo_addressing(false),
         enable_reduced_addressing(false),
@@ -286,6 +288,9 @@ public:
     virtual void applySettings(QSettings*);
     void setChannels();
     virtual int acquire(Event *);
+    virtual bool hasRawReadout() const { return true; }
+    virtual int acquireRaw(QVector<uint32_t> *raw);
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw);
     virtual bool dataReady();
     virtual int configure();
     virtual int reset();
@@ -299,6 +304,9 @@ public:
     int getModuleId(uint32_t* _modId);
     int getEventCounter(uint32_t*);
     int getNextSampleAddr(int adc, uint32_t* _addr);
+    int getPrevBankSampleAddr(int adc, uint32_t* _addr);
+    int setMemoryPage(uint32_t page);
+    uint8_t switchBank();
     int getTimeStampDir();
     int getEventDir(int ch);
     int arm(uint8_t bank);
@@ -311,13 +319,16 @@ public:
     int timestamp_clear();
     int waitForNotBusy();
     int waitForAddrThreshold();
-    int readAdcChannelSinglePage(int ch, uint32_t _reqNofWords);
+    int readAdcChannelSinglePage(int ch, uint32_t _reqNofWords, uint32_t *dest);
     int readAdcChannel(int ch, uint32_t _reqNofWords);
     int singleShot();
-    int acquisitionStartSingle();
-    int acquisitionStartMulti();
+    int acquisitionStartSingle(QVector<uint32_t> *raw = NULL);
+    int acquisitionStartMulti(QVector<uint32_t> *raw = NULL);
+    uint32_t *channelBuffer(int ch, uint32_t _reqNofWords, QVector<uint32_t> *raw);
+    void finishChannel(int ch, QVector<uint32_t> *raw);
     int checkConfig();
     int writeToBuffer(Event *);
+    void demultiplex(Event *ev, const uint32_t *const *chData, const uint32_t *chLen);
     int getMcaTrgStartCounter(uint8_t ch, uint32_t* _evCnt);
     int updateModuleInfo();
     int getDecimationFactor(Sis3302V1410config::EnDecimMode);
@@ -362,6 +373,8 @@ private:
     volatile uint32_t endSampleAddr_words[NOF_CHANNELS];
 
     uint32_t nof_adrr_mismatch;
+    uint8_t armedBank;
+    int rawFramePos;
 
 public:
     // Values for display in the module
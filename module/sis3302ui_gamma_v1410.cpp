@@ -71,6 +71,7 @@ void Sis3302V1410UI::createUI()
                          << "Block Transfer 64bit"
                          << "VME2E accelerated mode"));
     uif.addLineEditToGroup(tn[nt],gn[ng],"Header ID","header_id","3302");
+    uif.addCheckBoxToGroup(tn[nt],gn[ng],"Double-buffered banks","enable_bank_switching");
 
     gn.append("Control"); ng++; uif.addGroupToTab(tn[nt],gn[ng],"","v");
     uif.addUnnamedGroupToGroup(tn[nt],gn[ng],"b0_");
@@ -389,6 +390,9 @@ void Sis3302V1410UI::uiInput(QString _name)
         if(_name == "send_int_trg_to_ext_as_or") {
             module->conf.send_int_trg_to_ext_as_or = cb->isChecked();
         }
+        if(_name == "enable_bank_switching") {
+            module->conf.enable_bank_switching = cb->isChecked();
+        }
         if(_name.startsWith("enable_lemo_in_")) {
             int ch = _name.right(1).toInt();
             module->conf.enable_lemo_in[ch] = cb->isChecked();
@@ -811,6 +815,7 @@ void Sis3302V1410UI::applySettings()
 
             if(w->objectName() == "enable_irq") w->setChecked(module->conf.enable_irq);
             if(w->objectName() == "send_int_trg_to_ext_as_or") w->setChecked(module->conf.send_int_trg_to_ext_as_or);
+            if(w->objectName() == "enable_bank_switching") w->setChecked(module->conf.enable_bank_switching);
 
             for(int ch=0; ch<NOF_CHANNELS; ch++) {
                 if(w->objectName() == tr("enable_lemo_in_%1").arg(ch)) w->setChecked(module->conf.enable_lemo_in[ch]);
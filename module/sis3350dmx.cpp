@@ -37,7 +37,7 @@ Sis3350Demux::Sis3350Demux (const QVector<EventSlot *> &_evslots, const Abstract
     //std::cout << "Instantiated Sis3350Demux" << std::endl;
 }
 
-void Sis3350Demux::process (Event *_ev, uint32_t *_data, uint32_t _len)
+void Sis3350Demux::process (Event *_ev, const uint32_t *_data, uint32_t _len)
 {
     //std::cout << "Sis3350Demux Processing" << std::endl;
     data = _data;
@@ -91,18 +91,18 @@ void Sis3350Demux::startNewTrace()
     if(curChannel == 3)
     {
         int len = curEvent[curChannel]->sampleLen + 8;
-        QVector<uint32_t> metainfo (8,0); // Standard container for meta info
-        metainfo [0] = 0xBBBB3000;   // base address
-        metainfo [1] = len;
-        metainfo [2] = curEvent[curChannel]->timeStamp >> 32;
-        metainfo [3] = curEvent[curChannel]->timeStamp & 0xFFFFFFFF;
-        metainfo [4] = curEvent[curChannel]->sampleLen;
-        metainfo [5] = chMask;
-        metainfo [6] = 0x0;          // Module count
-        metainfo [7] = 0xFFFFFFFF;   // unused
-
-        if (owner_->getOutputPlugin ()->isSlotConnected (evslots.at (4)))
-            ev->put (evslots.at (4), QVariant::fromValue (metainfo));
+        if (owner_->getOutputPlugin ()->isSlotConnected (evslots.at (4))) {
+            QVector<uint32_t> &metainfo = ev->store< QVector<uint32_t> > (evslots.at (4)); // Standard container for meta info
+            metainfo.resize (8);
+            metainfo [0] = 0xBBBB3000;   // base address
+            metainfo [1] = len;
+            metainfo [2] = curEvent[curChannel]->timeStamp >> 32;
+            metainfo [3] = curEvent[curChannel]->timeStamp & 0xFFFFFFFF;
+            metainfo [4] = curEvent[curChannel]->sampleLen;
+            metainfo [5] = chMask;
+            metainfo [6] = 0x0;          // Module count
+            metainfo [7] = 0xFFFFFFFF;   // unused
+        }
     }
 }
 
@@ -127,8 +127,8 @@ void Sis3350Demux::continueTrace()
 
         // Publish event data
         if (owner_->getOutputPlugin ()->isSlotConnected (evslots.at (curChannel))) {
-            QVector<uint32_t> outData (QVector<uint32_t>::fromStdVector (curEvent[curChannel]->data));
-            ev->put (evslots.at (curChannel), QVariant::fromValue (outData));
+            const std::vector<uint32_t> &trace = curEvent[curChannel]->data;
+            ev->copyData (evslots.at (curChannel), trace.data (), trace.size ());
         }
     }
     else
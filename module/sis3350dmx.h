@@ -52,8 +52,8 @@ private:
     struct Sis3350Event* outEvent[4];
     int curChannel;
 
-    uint32_t* it;
-    uint32_t* data;
+    const uint32_t* it;
+    const uint32_t* data;
     uint32_t len;
 
     const QVector<EventSlot*> &evslots;
@@ -69,7 +69,7 @@ private:
 public:
     Sis3350Demux (const QVector<EventSlot*> &_evslots, const AbstractModule* own);
 
-    void process(Event *_ev, uint32_t *_data, uint32_t _len);
+    void process(Event *_ev, const uint32_t *_data, uint32_t _len);
 };
 
 #endif // DEMUXSIS3350PLUGIN_H
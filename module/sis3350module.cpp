@@ -581,6 +581,67 @@ int Sis3350Module::acquire(Event *ev)
     return ret;
 }
 
+int Sis3350Module::acquireRaw(QVector<uint32_t> *raw)
+{
+    int ret = 0;
+
+    switch(conf.acMode)
+    {
+        case Sis3350config::ringBufferAsync:
+        case Sis3350config::ringBufferSync:
+        case Sis3350config::directMemStart:
+        {
+            uint32_t stop_next_sample_addr[4];
+            ret = getStopSampleAddresses(stop_next_sample_addr);
+
+            // DMA straight into the raw data of the event. Events alternate in the buffer, so the transfer of this
+            // event overlaps with the decoding of the previous one without any intermediate copy.
+            // One frame per channel: length followed by the data
+            for(uint32_t j = 0; j < 4; j++)
+            {
+                if(stop_next_sample_addr[j] > 2*MAX_NOF_LWORDS)
+                {
+                    printf("Buffer length too short!\n");
+                    ret = -1;
+                    break;
+                }
+                int pos = raw->size();
+                raw->resize(pos + 1 + stop_next_sample_addr[j]/2);
+                uint32_t *frame = raw->data() + pos;
+                ret = readChannel(j, stop_next_sample_addr[j], frame + 1, frame);
+                uint32_t len = frame[0];
+                raw->resize(pos + 1 + len);
+            }
+        }
+            break;
+        case Sis3350config::directMemGateAsync:
+        case Sis3350config::directMemGateSync:
+        case Sis3350config::directMemStop:
+            break;
+        default:
+            ret = -1;
+            break;
+    }
+
+    arm();
+    return ret;
+}
+
+int Sis3350Module::decode(Event *ev, const QVector<uint32_t> &raw)
+{
+    const uint32_t *it = raw.constData();
+    const uint32_t *end = it + raw.size();
+    while(it != end)
+    {
+        uint32_t len = *it++;
+        if(len > (uint32_t)(end - it))
+            return -1;
+        demux.process (ev, it, len);
+        it += len;
+    }
+    return 0;
+}
+
 int Sis3350Module::writeToBuffer(Event* ev)
 {
     for(unsigned int i = 0; i < 4; i++)
@@ -635,44 +696,12 @@ int Sis3350Module::acquireRingBufferASync()
 {
     std::cout << "acquireRingBufferASync "<< std::endl;
 
-    uint32_t i = 0,j = 0;
     uint32_t stop_next_sample_addr[4];
-    uintptr_t read_data_block_ptr = 0;
-    uint32_t got_nof_lwords = 0;
-    uint32_t sample_length = 0;
-    uint32_t event_length = 0;
-    int ret = 0;
-
-    sample_length = conf.sample_length;
-
-    event_length = (sample_length/2)+4;
+    int ret = getStopSampleAddresses(stop_next_sample_addr);
 
     // Read all four channels
-    for(j=0;j<4;j++)
+    for(uint32_t j=0;j<4;j++)
     {
-        ret = 0;
-
-        // Read stop sample counter
-        switch(j)
-        {
-            case 0:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC1;
-                break;
-            case 1:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC2;
-                break;
-            case 2:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC3;
-                break;
-            case 3:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC4;
-                break;
-            default:
-                break;
-        }
-        ret = getInterface()->readA32D32(addr,&data);
-        if(ret != 0) printf("Error %d at VME READ ACTUAL SAMPLE ADDR %d\n",ret,j);
-        stop_next_sample_addr[j] = data;
         printf("Stop next sample address 0x%08x\n",stop_next_sample_addr[j]);
 
         // Check buffer length
@@ -682,37 +711,7 @@ int Sis3350Module::acquireRingBufferASync()
                 return -1;
         }
 
-        // Read data buffer
-        read_data_block_ptr = (uintptr_t) rblt_data[j];
-        if(stop_next_sample_addr[j] != 0)
-        {
-                ret = readDmaMblt64AdcDataBuffer(conf.base_addr,
-                                           j,0x0,stop_next_sample_addr[j],&got_nof_lwords,
-                                           (uint32_t *)read_data_block_ptr);
-                read_data_block_length[j] = got_nof_lwords;
-                if(ret != 0) printf("Error 0x%08x at readDmaMblt64AdcDataBuffer\n",ret);
-        }
-        else
-        {
-                printf("<%08d> ADC%d No data read!\n",i,j);
-                read_data_block_length[j] = 0;
-                ret++;
-                continue;
-        }
-
-        if(event_length*conf.multievent_max_nof_events - read_data_block_length[j] > 8) // Optimization results in offsets
-        {
-                printf("<%08d> ADC%d Data block length was too short for amount of events.\n",i,j);
-                printf("0x%08x, 0x%08x\n",read_data_block_length[j],
-                                event_length*conf.multievent_max_nof_events);
-                ret++;
-        }
-
-        // Add channel information to first byte of data
-        for(unsigned int i = 0; i < conf.multievent_max_nof_events; i++)
-        {
-            rblt_data[j][i*event_length] |= (j << 28);
-        }
+        ret = readChannel(j,stop_next_sample_addr[j],rblt_data[j],&read_data_block_length[j]);
     }
 
     return ret;
@@ -720,26 +719,8 @@ int Sis3350Module::acquireRingBufferASync()
 
 int Sis3350Module::acquireRingBufferSync()
 {
-    uint32_t i = 0,j = 0;
     uint32_t stop_next_sample_addr[4];
-    uintptr_t read_data_block_ptr = 0;
-    uint32_t got_nof_lwords = 0;
-    uint32_t sample_length = 0;
-    uint32_t event_length = 0;
-    int ret = 0;
-
-    if(conf.acMode==Sis3350config::ringBufferSync)
-    {
-        sample_length = conf.sample_length;
-    }
-    else if(conf.acMode==Sis3350config::directMemStart)
-    {
-        sample_length = conf.direct_mem_sample_length;
-    }
-
-    else sample_length = conf.sample_length;
-
-    event_length = (sample_length/2)+4;
+    int ret = getStopSampleAddresses(stop_next_sample_addr);
 
     // Read Multievent counter
 //    if(conf.multievent_max_nof_events > 1)
@@ -750,31 +731,8 @@ int Sis3350Module::acquireRingBufferSync()
 //    }
 
     // Read all four channels
-    for(j=0;j<4;j++)
+    for(uint32_t j=0;j<4;j++)
     {
-        ret = 0;
-
-        // Read stop sample counter
-        switch(j)
-        {
-            case 0:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC1;
-                break;
-            case 1:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC2;
-                break;
-            case 2:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC3;
-                break;
-            case 3:
-                addr = conf.base_addr + SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC4;
-                break;
-            default:
-                break;
-        }
-        ret = getInterface()->readA32D32(addr,&data);
-        if(ret != 0) printf("Error %d at VME READ ACTUAL SAMPLE ADDR %d\n",ret,j);
-        stop_next_sample_addr[j] = data;
         //printf("Stop next sample address 0x%08x\n",stop_next_sample_addr[j]);
 
         // Check buffer length
@@ -784,37 +742,71 @@ int Sis3350Module::acquireRingBufferSync()
                 return -1;
         }
 
-        // Read data buffer
-        read_data_block_ptr = (uintptr_t) rblt_data[j];
-        if(stop_next_sample_addr[j] != 0)
-        {
-                ret = readDmaMblt64AdcDataBuffer(conf.base_addr,
-                                           j,0x0,stop_next_sample_addr[j],&got_nof_lwords,
-                                           (uint32_t *)read_data_block_ptr);
-                read_data_block_length[j] = got_nof_lwords;
-                if(ret != 0) printf("Error 0x%08x at readDmaMblt64AdcDataBuffer\n",ret);
-        }
-        else
-        {
-                printf("<%08d> ADC%d No data read!\n",i,j);
-                read_data_block_length[j] = 0;
-                ret++;
-                continue;
-        }
+        ret = readChannel(j,stop_next_sample_addr[j],rblt_data[j],&read_data_block_length[j]);
+    }
 
-        if(event_length*conf.multievent_max_nof_events - read_data_block_length[j] > 8) // Optimization results in offsets
-        {
-                printf("<%08d> ADC%d Data block length was too short for amount of events.\n",i,j);
-                printf("0x%08x, 0x%08x\n",read_data_block_length[j],
-                                event_length*conf.multievent_max_nof_events);
-                ret++;
-        }
+    return ret;
+}
 
-        // Add channel information to first byte of data
-        for(unsigned int i = 0; i < conf.multievent_max_nof_events; i++)
-        {
-            rblt_data[j][i*event_length] |= (j << 28);
-        }
+int Sis3350Module::getStopSampleAddresses(uint32_t *stop_next_sample_addr)
+{
+    static const uint32_t regs[4] = { SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC1, SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC2,
+                                      SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC3, SIS3350_ACTUAL_SAMPLE_ADDRESS_ADC4 };
+    int ret = 0;
+    for(uint32_t j=0;j<4;j++)
+    {
+        // Read stop sample counter
+        addr = conf.base_addr + regs[j];
+        ret = getInterface()->readA32D32(addr,&data);
+        if(ret != 0) printf("Error %d at VME READ ACTUAL SAMPLE ADDR %d\n",ret,j);
+        stop_next_sample_addr[j] = data;
+    }
+    return ret;
+}
+
+int Sis3350Module::readChannel(uint32_t j, uint32_t stop_next_sample_addr, uint32_t *dest, uint32_t *read_length)
+{
+    uint32_t got_nof_lwords = 0;
+    uint32_t sample_length = 0;
+    uint32_t event_length = 0;
+    int ret = 0;
+
+    if(conf.acMode==Sis3350config::directMemStart)
+    {
+        sample_length = conf.direct_mem_sample_length;
+    }
+    else sample_length = conf.sample_length;
+
+    event_length = (sample_length/2)+4;
+
+    // Read data buffer
+    if(stop_next_sample_addr != 0)
+    {
+            ret = readDmaMblt64AdcDataBuffer(conf.base_addr,
+                                       j,0x0,stop_next_sample_addr,&got_nof_lwords,
+                                       dest);
+            *read_length = got_nof_lwords;
+            if(ret != 0) printf("Error 0x%08x at readDmaMblt64AdcDataBuffer\n",ret);
+    }
+    else
+    {
+            printf("ADC%d No data read!\n",j);
+            *read_length = 0;
+            return 1;
+    }
+
+    if(event_length*conf.multievent_max_nof_events - *read_length > 8) // Optimization results in offsets
+    {
+            printf("ADC%d Data block length was too short for amount of events.\n",j);
+            printf("0x%08x, 0x%08x\n",*read_length,
+                            event_length*conf.multievent_max_nof_events);
+            ret++;
+    }
+
+    // Add channel information to first byte of data
+    for(unsigned int i = 0; i < conf.multievent_max_nof_events && i*event_length < *read_length; i++)
+    {
+        dest[i*event_length] |= (j << 28);
     }
 
     return ret;
@@ -158,6 +158,9 @@ public:
     uint32_t read_data_block_length[4];
 
     virtual int acquire(Event *);
+    virtual bool hasRawReadout() const { return true; }
+    virtual int acquireRaw(QVector<uint32_t> *raw);
+    virtual int decode(Event *ev, const QVector<uint32_t> &raw);
     virtual bool dataReady();
     virtual int configure();
     virtual int reset();
@@ -171,6 +174,8 @@ public:
     int acquireRingBufferSync();
     int acquireRingBufferASync();
     int acquireDirectMemStart();
+    int getStopSampleAddresses(uint32_t *stop_next_sample_addr);
+    int readChannel(uint32_t j, uint32_t stop_next_sample_addr, uint32_t *dest, uint32_t *read_length);
 
 public slots:
     virtual void prepareForNextAcquisition();
@@ -19,10 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "inttodoubleplugin.h"
 #include "pluginmanager.h"
-#include "pluginconnectorqueued.h"
 
 #include <iostream>
 #include <string>
+#include <algorithm>
 
 #include <QGridLayout>
 #include <QLabel>
@@ -42,8 +42,10 @@ IntToDoublePlugin::IntToDoublePlugin(int id, QString name, const Attributes &att
     attrs_.insert ("nofChannels", nofChannels_);
 
     for (int i = 0; i < nofChannels_; ++i) {
-        addConnector (new PluginConnectorQVUint (this, ScopeCommon::in, QString ("in %1").arg (i)));
-        addConnector (new PluginConnectorQVDouble (this, ScopeCommon::out, QString ("out %1").arg (i)));
+        ins_ << new PluginConnectorTypedQVUint (this, ScopeCommon::in, QString ("in %1").arg (i));
+        outs_ << new PluginConnectorTypedQVDouble (this, ScopeCommon::out, QString ("out %1").arg (i));
+        addConnector (ins_.last ());
+        addConnector (outs_.last ());
     }
 }
 
@@ -68,15 +70,13 @@ AbstractPlugin::Attributes IntToDoublePlugin::getAttributes () const {
 
 void IntToDoublePlugin::process () {
     for (int i = 0; i < nofChannels_; ++i) {
-        if (inputs->at (i)->dataAvailable ()) {
-            QVector<uint32_t> idata = inputs->at (i)->getData ().value< QVector<uint32_t> > ();
-            QVector<double> odata;
-
-            odata.reserve (idata.size ());
-            for (int j = 0; j < idata.size (); ++j)
-                odata << idata.at (j);
-            outputs->at (i)->setData (QVariant::fromValue (odata));
-            inputs->at (i)->useData ();
+        if (ins_.at (i)->dataAvailable ()) {
+            const QVector<uint32_t> &idata = ins_.at (i)->peek ();
+            QVector<double> &odata = outs_.at (i)->produce ();
+
+            odata.resize (idata.size ());
+            std::copy (idata.begin (), idata.end (), odata.begin ());
+            ins_.at (i)->useData ();
         }
     }
 }
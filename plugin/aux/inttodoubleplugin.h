@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define INTTODOUBLEPLUGIN_H
 
 #include "baseplugin.h"
+#include "pluginconnectortyped.h"
 
 #include <vector>
 
@@ -48,6 +49,8 @@ private:
     Attributes attrs_;
 
     int nofChannels_;
+    QVector<PluginConnectorTypedQVUint*> ins_;
+    QVector<PluginConnectorTypedQVDouble*> outs_;
 };
 
 #endif // INTTODOUBLEPLUGIN_H
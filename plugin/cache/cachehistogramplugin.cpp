@@ -34,7 +34,9 @@ CacheHistogramPlugin::CacheHistogramPlugin(int _id, QString _name)
     : BaseCachePlugin(_id, _name),
     binWidth(1),
     writeToFile(false),
-    fileCount(0)
+    fileCount(0),
+    inBatch(false),
+    batchFilled(false)
 {
     createSettings(settingsLayout);
 
@@ -310,6 +312,40 @@ void CacheHistogramPlugin::userProcess()
     //std::cout << "CacheHistogramPlugin userProcess" << std::endl;
     QVector<double> idata = inputs->first()->getData().value< QVector<double> > ();
 
+    // within a batch the cache is prepared before the first event and published after the last one
+    if(!batchFilled) prepareCache();
+    fillCache(idata);
+    if(inBatch) batchFilled = true;
+    else publishCache();
+}
+
+/*!
+* @brief Fills the data of all events in the batch, but updates the plot and the outputs only once
+*/
+void CacheHistogramPlugin::processBatch(int nofEvents)
+{
+    // normalization is applied after every event, so the result depends on the event boundaries
+    if(conf.normalize)
+    {
+        BasePlugin::processBatch(nofEvents);
+        return;
+    }
+
+    // the base implementation keeps the per event input checks and bookkeeping
+    inBatch = true;
+    batchFilled = false;
+    BasePlugin::processBatch(nofEvents);
+    inBatch = false;
+
+    if(batchFilled)
+    {
+        batchFilled = false;
+        publishCache();
+    }
+}
+
+void CacheHistogramPlugin::prepareCache()
+{
     SamDSP dsp;
 
     if(scheduleReset)
@@ -330,7 +366,10 @@ void CacheHistogramPlugin::userProcess()
     }
 
     if((int)(cache.size()) != conf.nofBins) cache.resize(conf.nofBins);
+}
 
+void CacheHistogramPlugin::fillCache(const QVector<double>& idata)
+{
     // Add data to histogram
     foreach(double datum, idata)
     {
@@ -345,6 +384,11 @@ void CacheHistogramPlugin::userProcess()
             }
         }
     }
+}
+
+void CacheHistogramPlugin::publishCache()
+{
+    SamDSP dsp;
 
     if(conf.normalize) dsp.fast_scale(cache,1.0/(dsp.max(cache)[AMP]));
 
@@ -79,8 +79,15 @@ protected:
 
     uint64_t nofCounts;
 
+    bool inBatch;
+    bool batchFilled;
+
     virtual void createSettings(QGridLayout*);
 
+    void prepareCache();
+    void fillCache(const QVector<double>&);
+    void publishCache();
+
 public:
     CacheHistogramPlugin(int _id, QString _name);
     static AbstractPlugin *create (int _id, const QString &_name, const Attributes &_attrs) {
@@ -92,6 +99,7 @@ public:
     virtual void applySettings(QSettings*);
     virtual void saveSettings(QSettings*);
     virtual void userProcess();
+    virtual void processBatch(int nofEvents);
 
     virtual void runStartingEvent();
 
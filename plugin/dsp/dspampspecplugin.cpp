@@ -19,7 +19,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dspampspecplugin.h"
 #include "pluginmanager.h"
-#include "pluginconnectorqueued.h"
 #include "samqvector.h"
 
 #include <QGridLayout>
@@ -39,8 +38,8 @@ DspAmpSpecPlugin::DspAmpSpecPlugin(int _id, QString _name)
 
     createSettings(settingsLayout);
 
-    addConnector(new PluginConnectorQVUint(this,ScopeCommon::in,"in"));
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::out,"spectrum"));
+    addConnector(input = new PluginConnectorTypedQVUint(this,ScopeCommon::in,"in"));
+    addConnector(output = new PluginConnectorTypedQVDouble(this,ScopeCommon::out,"spectrum"));
 
     std::cout << "Instantiated DspAmpSpecPlugin" << std::endl;
 }
@@ -148,11 +147,11 @@ void DspAmpSpecPlugin::userProcess()
     double pol = -1.;
 
     //std::cout << "DspAmpSpecPlugin Processing" << std::endl;
-    QVector<uint32_t> idata = inputs->first()->getData().value< QVector<uint32_t> > ();
+    const QVector<uint32_t>& idata = input->peek();
     SamDSP dsp;
 
-    // Convert to double
-    QVector<double> data (idata.size ());
+    // Convert to double, reusing the storage of the previous event
+    data.resize (idata.size ());
     std::copy (idata.begin (), idata.end (), data.begin ());
 
     // Correct baseline
@@ -225,7 +224,8 @@ void DspAmpSpecPlugin::userProcess()
         (*outData) [(int)(estimateForAmplitude)]++;
     }
 
-    outputs->first()->setData(QVariant::fromValue (*outData));
+    // Shares the spectrum with the output, no copy is made
+    output->produce() = *outData;
 }
 
 void DspAmpSpecPlugin::resetSpectra()
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPushButton>
 #include <QLineEdit>
 #include "baseplugin.h"
+#include "pluginconnectortyped.h"
 #include <samdsp.h>
 
 class BasePlugin;
@@ -56,6 +57,10 @@ protected:
     QLineEdit* hiClip;
 
     QVector<double>* outData;
+    QVector<double> data;
+
+    PluginConnectorTypedQVUint* input;
+    PluginConnectorTypedQVDouble* output;
 
     double estimateForBaseline;
     double estimateForAmplitude;
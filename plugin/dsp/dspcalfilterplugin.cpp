@@ -19,7 +19,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dspcalfilterplugin.h"
 #include "pluginmanager.h"
-#include "pluginconnectorqueued.h"
 
 #include <algorithm>
 
@@ -33,8 +32,8 @@ DspCalFilterPlugin::DspCalFilterPlugin(int _id, QString _name)
 {
     createSettings(settingsLayout);
 
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::in,"in"));
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::out,"calorimetry"));
+    addConnector(input = new PluginConnectorTypedQVDouble(this,ScopeCommon::in,"in"));
+    addConnector(output = new PluginConnectorTypedQVDouble(this,ScopeCommon::out,"calorimetry"));
 
     std::cout << "Instantiated DspTimeFilterPlugin" << std::endl;
 }
@@ -144,11 +143,12 @@ void DspCalFilterPlugin::saveSettings(QSettings* settings)
 void DspCalFilterPlugin::userProcess()
 {
     //std::cout << "DspCalFilterPlugin Processing" << std::endl;
-    QVector<double> idata = inputs->first()->getData().value< QVector<double> > ();
+    const QVector<double>& idata = input->peek();
+    QVector<double>& outData = output->produce();
     SamDSP dsp;
 
-    // Convert to double
-    QVector<double> outData (idata.size ());
+    // The filters work in place, so fill the output buffer with the input first
+    outData.resize (idata.size ());
     std::copy (idata.begin(), idata.end(), outData.begin ());
 
     //dsp.vectorToFile(outData,"/tmp/cal.dat");
@@ -167,8 +167,6 @@ void DspCalFilterPlugin::userProcess()
     // why not a simple rotate function?
     if(conf.shift != 0) dsp.fast_shift(outData,conf.shift);
     if(conf.gain != 1.0) dsp.fast_scale(outData,conf.gain);
-
-    outputs->first()->setData(QVariant::fromValue (outData));
 }
 
 /*!
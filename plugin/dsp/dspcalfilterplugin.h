@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdint.h>
 #include <QDoubleSpinBox>
 #include "baseplugin.h"
+#include "pluginconnectortyped.h"
 #include <samdsp.h>
 
 class BasePlugin;
@@ -56,6 +57,9 @@ protected:
     QSpinBox* shiftSpinner;
     QDoubleSpinBox* gainSpinner;
 
+    PluginConnectorTypedQVDouble* input;
+    PluginConnectorTypedQVDouble* output;
+
 public:
     DspCalFilterPlugin(int _id, QString _name);
     static AbstractPlugin *create (int _id, const QString &_name, const Attributes &_attrs) {
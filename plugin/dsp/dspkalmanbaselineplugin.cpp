@@ -19,7 +19,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dspkalmanbaselineplugin.h"
 #include "pluginmanager.h"
-#include "pluginconnectorqueued.h"
 
 #include <QGridLayout>
 #include <QLabel>
@@ -33,8 +32,8 @@ DspKalmanBaselinePlugin::DspKalmanBaselinePlugin(int _id, QString _name)
 {
     createSettings(settingsLayout);
 
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::in,"signal"));
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::out,"baseline"));
+    addConnector(input = new PluginConnectorTypedQVDouble(this,ScopeCommon::in,"signal"));
+    addConnector(output = new PluginConnectorTypedQVDouble(this,ScopeCommon::out,"baseline"));
 
     std::cout << "Instantiated DspKalmanBaselinePlugin" << std::endl;
 }
@@ -144,7 +143,7 @@ void DspKalmanBaselinePlugin::saveSettings(QSettings* settings)
 void DspKalmanBaselinePlugin::userProcess()
 {
     //std::cout << "DspKalmanBaselinePlugin Processing" << std::endl;
-    QVector<double> signal = inputs->at(0)->getData().value< QVector<double> > ();
+    const QVector<double>& signal = input->peek();
 
     SamDSP dsp;
 
@@ -152,7 +151,8 @@ void DspKalmanBaselinePlugin::userProcess()
     //outData.resize(psignal->size(),0);
     double x0 = 0;
     if(outData.size() > 0) x0 = outData.back();
-    outData.clear();
+    // resize instead of clear, to keep the allocated storage
+    outData.resize(0);
 
     // Kalman filter data
     double r  = conf.err;
@@ -161,5 +161,6 @@ void DspKalmanBaselinePlugin::userProcess()
     dsp.kalmanBaseline(signal,outData,r,ri,q,x0);
 
 
-    outputs->first()->setData (QVariant::fromValue (outData));
+    // Shares the data with the output. Once the consumer is done, outData is detached again
+    output->produce() = outData;
 }
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdio>
 #include <stdint.h>
 #include "baseplugin.h"
+#include "pluginconnectortyped.h"
 #include <samdsp.h>
 
 class BasePlugin;
@@ -53,6 +54,9 @@ protected:
 
     QVector<double> outData;
 
+    PluginConnectorTypedQVDouble* input;
+    PluginConnectorTypedQVDouble* output;
+
 public:
     DspKalmanBaselinePlugin(int _id, QString _name);
     static AbstractPlugin *create (int id, const QString &name, const Attributes &attrs) {
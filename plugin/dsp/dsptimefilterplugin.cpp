@@ -19,7 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dsptimefilterplugin.h"
 #include "pluginmanager.h"
-#include "pluginconnectorqueued.h"
+
+#include <algorithm>
 
 #include <QGridLayout>
 #include <QLabel>
@@ -32,8 +33,8 @@ DspTimeFilterPlugin::DspTimeFilterPlugin(int _id, QString _name)
 {
     createSettings(settingsLayout);
 
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::in,"in"));
-    addConnector(new PluginConnectorQVDouble(this,ScopeCommon::out,"timing"));
+    addConnector(input = new PluginConnectorTypedQVDouble(this,ScopeCommon::in,"in"));
+    addConnector(output = new PluginConnectorTypedQVDouble(this,ScopeCommon::out,"timing"));
 
     std::cout << "Instantiated DspTimeFilterPlugin" << std::endl;
 }
@@ -119,17 +120,16 @@ void DspTimeFilterPlugin::saveSettings(QSettings* settings)
 void DspTimeFilterPlugin::userProcess()
 {
     //std::cout << "DspTimeFilterPlugin Processing" << std::endl;
-    QVector<double> data = inputs->first()->getData().value< QVector<double> > ();
-    QVector<double> odata (data.size (), 0);
+    const QVector<double>& data = input->peek();
+    QVector<double>& odata = output->produce();
     SamDSP dsp;
 
-    // Convert to double
-    for (int i= 0; i < data.size (); ++i)
-        odata [i] = data.at (i);
+    // The filter works in place, so fill the output buffer with the input first
+    odata.resize (data.size ());
+    std::copy (data.begin (), data.end (), odata.begin ());
 
     //std::cout << conf.width << "  " << conf.spacing << std::endl;
     dsp.fast_pad(odata,conf.width+conf.spacing,0,odata[0]);
     dsp.fast_differentiator(odata,conf.width,conf.spacing);
     odata.resize(data.size());
-    outputs->first()->setData(QVariant::fromValue (odata));
 }
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdio>
 #include <stdint.h>
 #include "baseplugin.h"
+#include "pluginconnectortyped.h"
 #include <samdsp.h>
 
 class BasePlugin;
@@ -48,6 +49,9 @@ protected:
     QSpinBox* widthSpinner;
     QSpinBox* spacingSpinner;
 
+    PluginConnectorTypedQVDouble* input;
+    PluginConnectorTypedQVDouble* output;
+
 public:
     DspTimeFilterPlugin(int _id, QString _name);
     static AbstractPlugin *create (int _id, const QString &_name, const Attributes &_attrs) {
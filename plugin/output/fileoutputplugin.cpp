@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "fileoutputplugin.h"
 #include "pluginmanager.h"
 #include "pluginconnectorqueued.h"
+#include "filewriterui.h"
+
+#include <QtEndian>
 
 static PluginRegistrar registrar ("fileoutput", FileOutputPlugin::create, AbstractPlugin::GroupOutput);
 
@@ -52,6 +55,10 @@ void FileOutputPlugin::createSettings(QGridLayout * l)
         cl->addWidget(fileoutputLabel,0,0,1,1);
         cl->addWidget(filePathLineEdit,0,1,1,1);
         cl->addWidget(filePathButton,0,2,1,1);
+        connect(this,SIGNAL(fileNameChanged(QString)),filePathLineEdit,SLOT(setText(QString)),Qt::QueuedConnection);
+
+        writerUI = new FileWriterUI(&writerConf);
+        cl->addWidget(writerUI,1,0,1,3);
 
         container->setLayout(cl);
     }
@@ -64,40 +71,67 @@ void FileOutputPlugin::createSettings(QGridLayout * l)
 void FileOutputPlugin::setFilePath(QString _filePath)
 {
     filePath = _filePath;
-    fileName = filePath + tr("/%1%2.dat").arg(prefix).arg(QDateTime::currentDateTime().toString("_yyMMdd_hhmm"));
+    updateFileName();
     filePathLineEdit->setText(fileName);
 }
 
+void FileOutputPlugin::updateFileName()
+{
+    fileName = filePath + tr("/%1%2.dat").arg(prefix).arg(QDateTime::currentDateTime().toString("_yyMMdd_hhmm"));
+}
+
 void FileOutputPlugin::filePathButtonClicked()
 {
     setFilePath(QFileDialog::getExistingDirectory(this,tr("Choose filename"),
                                                   "/tmp",QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks));
 }
 
-void FileOutputPlugin::userProcess()
+void FileOutputPlugin::runStartingEvent()
 {
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly|QIODevice::Append);
-    if(!file.isOpen())
+    // a new file for every run
+    updateFileName();
+    emit fileNameChanged(fileName);
+
+    writer.setConfig(writerConf);
+    if(!writer.open(fileName))
     {
         std::cout << "File could not be opened." << std::endl;
     }
-    if(file.isWritable())
-    {
-        QDataStream out(&file);
-
-        QVector<uint32_t> d = inputs->first()->getData().value< QVector<uint32_t> > ();
-        if(d.size() == 0) std::cout << "No data." << std::endl;
-        for(int i=0; i<d.size(); i++)
-        {
-            out << (uint32_t) (d.at(i));
-            //std::cout << std::hex << d->at(i) << std::endl;
-        }
-    }
-    else
+}
+
+void FileOutputPlugin::runStoppingEvent()
+{
+    writer.close();
+}
+
+void FileOutputPlugin::userProcess()
+{
+    if(!writer.isOpen()) return;
+
+    QVector<uint32_t> d = inputs->first()->getData().value< QVector<uint32_t> > ();
+    if(d.size() == 0) std::cout << "No data." << std::endl;
+
+    // big endian, like QDataStream wrote it
+    uint32_t* out = reinterpret_cast<uint32_t*> (writer.reserve(d.size()*sizeof(uint32_t)));
+    for(int i=0; i<d.size(); i++)
     {
-        std::cout << "File not writeable." << std::endl;
+        out[i] = qToBigEndian<quint32> (d.at(i));
     }
-    file.close();
+    writer.commit(d.size()*sizeof(uint32_t));
 }
 
+void FileOutputPlugin::applySettings(QSettings* s)
+{
+    s->beginGroup(getName());
+    writerConf.apply(s);
+    s->endGroup();
+
+    writerUI->applySettings();
+}
+
+void FileOutputPlugin::saveSettings(QSettings* s)
+{
+    s->beginGroup(getName());
+    writerConf.save(s);
+    s->endGroup();
+}
@@ -34,8 +34,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "baseplugin.h"
+#include "filewriter.h"
 
 class BasePlugin;
+class FileWriterUI;
 
 class FileOutputPlugin : public BasePlugin
 {
@@ -46,8 +48,12 @@ protected:
     QString fileName;
     QString prefix;
 
+    FileWriterConfig writerConf;
+    FileWriter writer;
+
     QLineEdit* filePathLineEdit;
     QPushButton* filePathButton;
+    FileWriterUI* writerUI;
 
     virtual void createSettings(QGridLayout*);
 
@@ -61,14 +67,24 @@ public:
     QString getFilePath() { return filePath; }
 
     void setFilePath(QString _filePath);
+    /*! Picks the name of the next file in filePath. Leaves the UI alone, so the plugin thread may call it. */
+    void updateFileName();
 
     virtual void userProcess();
 
-    virtual void applySettings(QSettings*) {}
-    virtual void saveSettings(QSettings*) {}
+    virtual void applySettings(QSettings*);
+    virtual void saveSettings(QSettings*);
+
+    virtual void runStartingEvent();
+    virtual bool isRecording () const { return true; }
+    virtual void runStoppingEvent();
 
 public slots:
     void filePathButtonClicked();
+
+signals:
+    /*! Updates the file name shown in the UI from the GUI thread. */
+    void fileNameChanged(QString);
 };
 
 #endif // FILEOUTPUTPLUGIN_H
@@ -21,6 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "runmanager.h"
 #include "pluginconnectorqueued.h"
+#include "filewriterui.h"
+
+#include <QtEndian>
 
 static PluginRegistrar registrar ("rawwritesis3302v1410", RawWriteSis3302v1410Plugin::create, AbstractPlugin::GroupOutput);
 
@@ -33,6 +36,7 @@ RawWriteSis3302v1410Plugin::RawWriteSis3302v1410Plugin(int _id, QString _name)
     interval_minutes = 2;
     interval_number = 0;
     nof_events = 100;
+    nof_events_written = 0;
 
     now.start();
     next_interval_time.start();
@@ -81,6 +85,9 @@ void RawWriteSis3302v1410Plugin::createSettings(QGridLayout * l)
 
         cl->addWidget(writingDataLabel,3,0,1,3);
 
+        writerUI = new FileWriterUI(&writerConf);
+        cl->addWidget(writerUI,4,0,1,3);
+
         connect(filePathButton,SIGNAL(clicked()),this,SLOT(filePathButtonClicked()));
         connect(intervalSpinBox,SIGNAL(valueChanged(int)),this,SLOT(settingsChanged()));
         connect(nofEventsSpinBox,SIGNAL(valueChanged(int)),this,SLOT(settingsChanged()));
@@ -121,6 +128,7 @@ void RawWriteSis3302v1410Plugin::applySettings(QSettings* settings)
         set = "intervalMode";   if(settings->contains(set)) intervalMode = settings->value(set).toBool();
         set = "interval_minutes";   if(settings->contains(set)) interval_minutes = settings->value(set).toInt();
         set = "nof_events";   if(settings->contains(set)) nof_events = settings->value(set).toInt();
+        writerConf.apply(settings);
     settings->endGroup();
 
     // UI update
@@ -128,6 +136,7 @@ void RawWriteSis3302v1410Plugin::applySettings(QSettings* settings)
     intervalModeCheckBox->setChecked(intervalMode);
     intervalSpinBox->setValue(interval_minutes);
     nofEventsSpinBox->setValue(nof_events);
+    writerUI->applySettings();
 
     settings_changed = true;
 }
@@ -148,6 +157,7 @@ void RawWriteSis3302v1410Plugin::saveSettings(QSettings* settings)
             settings->setValue("intervalMode",intervalModeCheckBox->isChecked());
             settings->setValue("interval_minutes",intervalSpinBox->value());
             settings->setValue("nof_events",nofEventsSpinBox->value());
+            writerConf.save(settings);
         settings->endGroup();
         std::cout << " done" << std::endl;
     }
@@ -182,10 +192,7 @@ void RawWriteSis3302v1410Plugin::userProcess()
         settings_changed = false;
         next_interval_time.start();
         nof_events_written = 0;
-        if(file && file->isOpen()) {
-            file->close();
-            delete file;
-        }
+        writer.close();
         writingDataLabel->setText(tr("Status: Idle"));
     }
 
@@ -197,10 +204,8 @@ void RawWriteSis3302v1410Plugin::userProcess()
 
     // Close the file, if we are done
     if(events_to_go == 0) {
-        if(file && file->isOpen()) {
-            file->close();
-            delete file;
-            file = 0;
+        if(writer.isOpen()) {
+            writer.close();
             writingDataLabel->setText(tr("Status: Idle, next start: %1").arg(next_interval_time.toString()));
         }
     }
@@ -223,61 +228,58 @@ void RawWriteSis3302v1410Plugin::userProcess()
 
     // Only if the next deadline has passed
     // or we still have to write events
-    if(file && nof_events_written == 0) {
+    if(writer.isOpen() && nof_events_written == 0) {
         interval_number += 1;
-        if(file && file->isOpen()) {
-            file->close();
-            delete file;
-            file = 0;
-        }
+        writer.close();
         writingDataLabel->setText(tr("Status: Idle, next start: %1").arg(next_interval_time.toString()));
     }
-    if(!file){
+    if(!writer.isOpen()){
         setFilePath(filePath);
-        file = new QFile(fileName);
-        file->open(QIODevice::WriteOnly|QIODevice::Append);
+        writer.setConfig(writerConf);
+        if(!writer.open(fileName)) {
+            std::cout << "File could not be opened." << std::endl;
+            return;
+        }
         last_interval_time = now;
         next_interval_time = now.addSecs(60*interval_minutes);
         nof_events_written = 0;
         writingDataLabel->setText(tr("Status: Writing data since ").arg(now.toString()));
     }
-    if(!file->isOpen()) {
-        std::cout << "File could not be opened." << std::endl;
-    }
 
-    // Write one event
-    if(file->isWritable())
-    {
-        QDataStream out(file);
-        out.setByteOrder(QDataStream::LittleEndian); //!
-
-        uint32_t header = 0x33021410;
-        uint32_t header_length = 4 + nof_enabled_channels;
-        uint32_t total_length = header_length + total_data_length;
-
-        // Write header data
-        out << header;
-        out << header_length;
-        out << ch_mask;
-        out << total_length;
-        for(int ch = 0; ch < 8; ++ch) {
-            if(data_length[ch] > 0) out << data_length[ch];
+    // Write one event, little endian like QDataStream wrote it
+    uint32_t header = 0x33021410;
+    uint32_t header_length = 4 + nof_enabled_channels;
+    uint32_t total_length = header_length + total_data_length;
+
+    size_t len = header_length*sizeof(uint32_t) + total_data_length*sizeof(uint16_t);
+    uchar* out = reinterpret_cast<uchar*> (writer.reserve(len));
+
+    // Write header data
+    qToLittleEndian<quint32> (header, out);
+    qToLittleEndian<quint32> (header_length, out + 4);
+    qToLittleEndian<quint32> (ch_mask, out + 8);
+    qToLittleEndian<quint32> (total_length, out + 12);
+    out += 16;
+    for(int ch = 0; ch < 8; ++ch) {
+        if(data_length[ch] > 0) {
+            qToLittleEndian<quint32> (data_length[ch], out);
+            out += sizeof(uint32_t);
         }
+    }
 
-        // Write channel contents
-        for(int ch = 0; ch < 8; ++ch) {
-            if(data[ch].empty ()) {
-                //std::cout << "No data." << std::endl;
-                continue;
-            }
-            for(int i = 0; i < data[ch].size(); i++) {
-                out << (uint16_t)(data[ch].at(i) & 0xFFFF);
-            }
+    // Write channel contents
+    for(int ch = 0; ch < 8; ++ch) {
+        for(int i = 0; i < data[ch].size(); i++) {
+            qToLittleEndian<quint16> (data[ch].at(i) & 0xFFFF, out);
+            out += sizeof(uint16_t);
         }
-
-        ++nof_events_written;
-    } else {
-        std::cout << "File not writeable." << std::endl;
-        file->close();
     }
+    writer.commit(len);
+
+    ++nof_events_written;
+}
+
+void RawWriteSis3302v1410Plugin::runStoppingEvent()
+{
+    writer.close();
 }
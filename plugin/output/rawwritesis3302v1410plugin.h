@@ -38,8 +38,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "baseplugin.h"
+#include "filewriter.h"
 
 class BasePlugin;
+class FileWriterUI;
 
 class RawWriteSis3302v1410Plugin : public BasePlugin
 {
@@ -56,6 +58,7 @@ protected:
     QSpinBox* intervalSpinBox;
     QSpinBox* nofEventsSpinBox;
     QLabel* writingDataLabel;
+    FileWriterUI* writerUI;
 
     virtual void createSettings(QGridLayout*);
 
@@ -71,7 +74,8 @@ protected:
 
     bool settings_changed;
 
-    QFile* file;
+    FileWriterConfig writerConf;
+    FileWriter writer;
 
 public:
     RawWriteSis3302v1410Plugin(int _id, QString _name);
@@ -86,9 +90,12 @@ public:
     void setFilePath(QString _filePath);
 
     virtual void userProcess();
+    virtual bool isRecording () const { return true; }
     virtual void applySettings(QSettings*);
     virtual void saveSettings(QSettings*);
 
+    virtual void runStoppingEvent();
+
 public slots:
     void filePathButtonClicked();
     void settingsChanged();
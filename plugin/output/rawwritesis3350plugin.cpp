@@ -21,6 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "runmanager.h"
 #include "pluginconnectorqueued.h"
+#include "filewriterui.h"
+
+#include <QtEndian>
 
 static PluginRegistrar registrar ("rawwritesis3350", RawWriteSis3350Plugin::create, AbstractPlugin::GroupOutput);
 
@@ -54,6 +57,10 @@ void RawWriteSis3350Plugin::createSettings(QGridLayout * l)
         cl->addWidget(fileoutputLabel,0,0,1,1);
         cl->addWidget(filePathLineEdit,0,1,1,1);
         cl->addWidget(filePathButton,0,2,1,1);
+        connect(this,SIGNAL(fileNameChanged(QString)),filePathLineEdit,SLOT(setText(QString)),Qt::QueuedConnection);
+
+        writerUI = new FileWriterUI(&writerConf);
+        cl->addWidget(writerUI,1,0,1,3);
 
         container->setLayout(cl);
     }
@@ -66,10 +73,15 @@ void RawWriteSis3350Plugin::createSettings(QGridLayout * l)
 void RawWriteSis3350Plugin::setFilePath(QString _filePath)
 {
     filePath = _filePath;
-    fileName = filePath + tr("/%1%2.dat").arg(prefix).arg(QDateTime::currentDateTime().toString("_yyMMdd_hhmm"));
+    updateFileName();
     filePathLineEdit->setText(fileName);
 }
 
+void RawWriteSis3350Plugin::updateFileName()
+{
+    fileName = filePath + tr("/%1%2.dat").arg(prefix).arg(QDateTime::currentDateTime().toString("_yyMMdd_hhmm"));
+}
+
 void RawWriteSis3350Plugin::filePathButtonClicked()
 {
     setFilePath(QFileDialog::getExistingDirectory(this,tr("Choose filename"),
@@ -82,10 +94,12 @@ void RawWriteSis3350Plugin::applySettings(QSettings* settings)
     settings->beginGroup(getName());
         set = "filePath";   if(settings->contains(set)) filePath = settings->value(set).toString();
         set = "fileName";   if(settings->contains(set)) fileName = settings->value(set).toString();
+        writerConf.apply(settings);
     settings->endGroup();
 
     // UI update
     filePathLineEdit->setText(fileName);
+    writerUI->applySettings();
 }
 
 void RawWriteSis3350Plugin::saveSettings(QSettings* settings)
@@ -101,47 +115,57 @@ void RawWriteSis3350Plugin::saveSettings(QSettings* settings)
         settings->beginGroup(getName());
             settings->setValue("filePath",filePath);
             settings->setValue("fileName",fileName);
+            writerConf.save(settings);
         settings->endGroup();
         std::cout << " done" << std::endl;
     }
 }
 
+void RawWriteSis3350Plugin::runStartingEvent()
+{
+    // a new file for every run
+    updateFileName();
+    emit fileNameChanged(fileName);
+
+    writer.setConfig(writerConf);
+    if(!writer.open(fileName))
+    {
+        std::cout << "File could not be opened." << std::endl;
+    }
+}
+
+void RawWriteSis3350Plugin::runStoppingEvent()
+{
+    writer.close();
+}
+
 void RawWriteSis3350Plugin::userProcess()
 {
     //std::cout << "RawWriteSis3350Plugin Processing" << std::endl;
 
+    if(!writer.isOpen()) return;
+
     QVector<uint32_t> data = inputs->at(0)->getData().value< QVector<uint32_t> > ();
     QVector<uint32_t> meta = inputs->at(1)->getData().value< QVector<uint32_t> > ();
 
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly|QIODevice::Append);
-    if(!file.isOpen())
+    if(data.empty ())
     {
-        std::cout << "File could not be opened." << std::endl;
+        std::cout << "No data." << std::endl;
+        return;
     }
-    if(file.isWritable())
+
+    // little endian, like QDataStream wrote it
+    size_t len = meta.size()*sizeof(uint32_t) + data.size()*sizeof(uint16_t);
+    uchar* out = reinterpret_cast<uchar*> (writer.reserve(len));
+    for(int i = 0; i < meta.size(); i++)
     {
-        QDataStream out(&file);
-        out.setByteOrder(QDataStream::LittleEndian); //!
-
-        if(data.empty ())
-        {
-            std::cout << "No data." << std::endl;
-            return;
-        }
-
-        for(int i = 0; i < meta.size(); i++)
-        {
-            out << meta.at(i);
-        }
-        for(int i = 0; i < data.size(); i++)
-        {
-            out << (uint16_t)(data.at(i) & 0xFFFF);
-        }
+        qToLittleEndian<quint32> (meta.at(i), out);
+        out += sizeof(uint32_t);
     }
-    else
+    for(int i = 0; i < data.size(); i++)
     {
-        std::cout << "File not writeable." << std::endl;
+        qToLittleEndian<quint16> (data.at(i) & 0xFFFF, out);
+        out += sizeof(uint16_t);
     }
-    file.close();
+    writer.commit(len);
 }
@@ -36,8 +36,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "baseplugin.h"
+#include "filewriter.h"
 
 class BasePlugin;
+class FileWriterUI;
 
 class RawWriteSis3350Plugin : public BasePlugin
 {
@@ -48,8 +50,12 @@ protected:
     QString fileName;
     QString prefix;
 
+    FileWriterConfig writerConf;
+    FileWriter writer;
+
     QLineEdit* filePathLineEdit;
     QPushButton* filePathButton;
+    FileWriterUI* writerUI;
 
     virtual void createSettings(QGridLayout*);
 
@@ -64,13 +70,23 @@ public:
     QString getFilePath() { return filePath; }
 
     void setFilePath(QString _filePath);
+    /*! Picks the name of the next file in filePath. Leaves the UI alone, so the plugin thread may call it. */
+    void updateFileName();
 
     virtual void userProcess();
     virtual void applySettings(QSettings*);
     virtual void saveSettings(QSettings*);
 
+    virtual void runStartingEvent();
+    virtual bool isRecording () const { return true; }
+    virtual void runStoppingEvent();
+
 public slots:
     void filePathButtonClicked();
+
+signals:
+    /*! Updates the file name shown in the UI from the GUI thread. */
+    void fileNameChanged(QString);
 };
 
 #endif // RAWWRITESIS3350PLUGIN_H
@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "runmanager.h"
 #include "pluginconnectorqueued.h"
+#include "filewriterui.h"
+
+#include <QtEndian>
 
 static PluginRegistrar registrar ("rawwritesis3350V2", RawWriteSis3350PluginV2::create, AbstractPlugin::GroupOutput);
 
@@ -78,6 +81,9 @@ void RawWriteSis3350PluginV2::createSettings(QGridLayout * l)
         }
         connect(mapper,SIGNAL(mapped(int)),this,SLOT(fileSaveCheckToggled(int)));
 
+        writerUI = new FileWriterUI(&writerConf);
+        cl->addWidget(writerUI,6,0,1,3);
+
         container->setLayout(cl);
     }
 
@@ -145,6 +151,7 @@ void RawWriteSis3350PluginV2::applySettings(QSettings* settings)
         set = "saveEnabled_1";   if(settings->contains(set)) saveEnabled[1] = settings->value(set).toBool();
         set = "saveEnabled_2";   if(settings->contains(set)) saveEnabled[2] = settings->value(set).toBool();
         set = "saveEnabled_3";   if(settings->contains(set)) saveEnabled[3] = settings->value(set).toBool();
+        writerConf.apply(settings);
    settings->endGroup();
 
     // UI update
@@ -154,6 +161,7 @@ void RawWriteSis3350PluginV2::applySettings(QSettings* settings)
     if(saveEnabled[2] == true) fileSaveCheck[2]->setCheckState(Qt::Checked);
     if(saveEnabled[3] == true) fileSaveCheck[3]->setCheckState(Qt::Checked);
     updateChMask();
+    writerUI->applySettings();
 }
 
 void RawWriteSis3350PluginV2::saveSettings(QSettings* settings)
@@ -173,15 +181,37 @@ void RawWriteSis3350PluginV2::saveSettings(QSettings* settings)
             settings->setValue("saveEnabled_1",saveEnabled[1]);
             settings->setValue("saveEnabled_2",saveEnabled[2]);
             settings->setValue("saveEnabled_3",saveEnabled[3]);
+            writerConf.save(settings);
         settings->endGroup();
         std::cout << " done" << std::endl;
     }
 }
 
+QString RawWriteSis3350PluginV2::numberedFileName() const
+{
+    return tr("%1%2").arg(fileName).arg(fileNo,6,10,QChar('0'));
+}
+
+void RawWriteSis3350PluginV2::runStartingEvent()
+{
+    writer.setConfig(writerConf);
+    if(!writer.open(numberedFileName()))
+    {
+        std::cout << "File could not be opened." << std::endl;
+    }
+}
+
+void RawWriteSis3350PluginV2::runStoppingEvent()
+{
+    writer.close();
+}
+
 void RawWriteSis3350PluginV2::userProcess()
 {
     //std::cout << "RawWriteSis3350PluginV2 Processing" << std::endl;
 
+    if(!writer.isOpen()) return;
+
     QVector<uint32_t> data[4];
     for(int i = 0; i < 4; i++)
     {
@@ -190,51 +220,43 @@ void RawWriteSis3350PluginV2::userProcess()
 
     QVector<uint32_t> meta = inputs->at(4)->getData().value< QVector<uint32_t> > ();
 
-    QString fileNameWithNumber(tr("%1%2").arg(fileName).arg(fileNo,6,10,QChar('0')));
-
-    QFile file(fileNameWithNumber);
-    file.open(QIODevice::WriteOnly|QIODevice::Append);
-    if(!file.isOpen())
+    size_t len = meta.size()*sizeof(uint32_t);
+    for(unsigned int ch = 0; ch < 4; ch++)
     {
-        std::cout << "File could not be opened." << std::endl;
+        if(saveEnabled[ch] == true) len += data[ch].size()*sizeof(uint16_t);
     }
-    if(file.isWritable())
+
+    // little endian, like QDataStream wrote it
+    uchar* out = reinterpret_cast<uchar*> (writer.reserve(len));
+    for(int i = 0; i < meta.size(); i++)
     {
-        QDataStream out(&file);
-        out.setByteOrder(QDataStream::LittleEndian); //!
+        // Update total length information
+        if(i==1) qToLittleEndian<quint32> (8 + (meta.at(4) * nofEnabledChannels), out);
+        // Update channel mask information
+        else if(i==5) qToLittleEndian<quint32> (chMask, out);
+        else qToLittleEndian<quint32> (meta.at(i), out);
+        out += sizeof(uint32_t);
+    }
 
-        for(int i = 0; i < meta.size(); i++)
+    for(unsigned int ch = 0; ch < 4; ch++)
+    {
+        if(data[ch].empty())
         {
-            // Update total length information
-            if(i==1) out << (uint32_t) (8 + (meta.at(4) * nofEnabledChannels));
-            // Update channel mask information
-            else if(i==5) out << (uint32_t)(chMask);
-            else out << meta.at(i);
+            std::cout << "No data in ch " << std::dec << ch << std::endl;
+            continue;
         }
 
-        for(unsigned int ch = 0; ch < 4; ch++)
+        if(saveEnabled[ch] == true)
         {
-            if(data[ch].empty())
+            for(int i = 0; i < data[ch].size(); i++)
             {
-                std::cout << "No data in ch " << std::dec << ch << std::endl;
-                continue;
-            }
-
-            if(saveEnabled[ch] == true)
-            {
-                for(int i = 0; i < data[ch].size(); i++)
-                {
-                    out << (uint16_t)(data[ch].at(i) & 0xFFFF);
-                }
-                bytesWritten += data[ch].size()*2;
+                qToLittleEndian<quint16> (data[ch].at(i) & 0xFFFF, out);
+                out += sizeof(uint16_t);
             }
+            bytesWritten += data[ch].size()*2;
         }
     }
-    else
-    {
-        std::cout << "File not writeable." << std::endl;
-    }
-    file.close();
+    writer.commit(len);
 
     cycles++;
     cycleSkip++;
@@ -244,6 +266,7 @@ void RawWriteSis3350PluginV2::userProcess()
     {
         cycleSkip = 0;
         fileNo++;
+        writer.switchFile(numberedFileName());
         std::cout << std::dec << (quint64)bytesWritten/1024/1024 << " Mbytes written in " 
               << std::dec << cycles << " cycles." << std::endl;
     }
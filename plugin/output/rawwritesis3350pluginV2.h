@@ -37,8 +37,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "baseplugin.h"
+#include "filewriter.h"
 
 class BasePlugin;
+class FileWriterUI;
 
 class RawWriteSis3350PluginV2 : public BasePlugin
 {
@@ -49,8 +51,12 @@ protected:
     QString fileName;
     QString prefix;
 
+    FileWriterConfig writerConf;
+    FileWriter writer;
+
     QLineEdit* filePathLineEdit;
     QPushButton* filePathButton;
+    FileWriterUI* writerUI;
 
     QCheckBox* fileSaveCheck[4];
 
@@ -72,6 +78,10 @@ public:
     virtual void applySettings(QSettings*);
     virtual void saveSettings(QSettings*);
 
+    virtual void runStartingEvent();
+    virtual bool isRecording () const { return true; }
+    virtual void runStoppingEvent();
+
 public slots:
     void filePathButtonClicked();
     void fileNameEditChanged();
@@ -80,6 +90,8 @@ public slots:
     void updateChMask();
 
 private:
+    QString numberedFileName() const;
+
     bool saveEnabled[4];
     uint64_t bytesWritten;
     uint32_t cycles;
@@ -22,11 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "runmanager.h"
 #include "pluginconnectorqueued.h"
 #include "confmap.h"
+#include "filewriterui.h"
+
+#include <cstdio>
 
 static PluginRegistrar registrar ("vectoroutput", VectorOutputPlugin::create, AbstractPlugin::GroupOutput);
 
 struct VectorOutputConfig {
     QString prefix;
+    FileWriterConfig writer;
 };
 
 VectorOutputPlugin::VectorOutputPlugin(int _id, QString _name)
@@ -58,6 +62,9 @@ void VectorOutputPlugin::createSettings(QGridLayout * l)
         cl->addWidget (new QLabel (tr ("Last file:")), 1, 0, 1, 1);
         cl->addWidget (pathLabel, 1, 1, 1, 1);
 
+        writerUI = new FileWriterUI (&cfg->writer);
+        cl->addWidget (writerUI, 2, 0, 1, 2);
+
         container->setLayout(cl);
 
         connect (prefixLineEdit, SIGNAL(textChanged(QString)), SLOT(prefixChanged()));
@@ -76,30 +83,20 @@ void VectorOutputPlugin::prefixChanged ()
 void VectorOutputPlugin::userProcess()
 {
     //std::cout << "VectorOutputPlugin Processing" << std::endl;
+    if(!writer.isOpen()) return;
 
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly|QIODevice::Append);
-    if(!file.isOpen())
-    {
-        std::cout << "File could not be opened." << std::endl;
-    }
-    if(file.isWritable())
-    {
-        QTextStream out(&file);
-
-        QVector<double> d = inputs->first()->getData().value< QVector<double> > ();
-        if(d.empty()) std::cout << "No data." << std::endl;
+    QVector<double> d = inputs->first()->getData().value< QVector<double> > ();
+    if(d.empty()) std::cout << "No data." << std::endl;
 
-        for(int i = 0; i < d.size(); i++)
-        {
-            out << d.at(i) << "\n";
-        }
-    }
-    else
+    // one value per line, formatted like QTextStream does
+    const int maxLineLength = 32;
+    char *out = writer.reserve (d.size() * maxLineLength);
+    size_t len = 0;
+    for(int i = 0; i < d.size(); i++)
     {
-        std::cout << "File not writeable." << std::endl;
+        len += snprintf (out + len, maxLineLength, "%g\n", d.at(i));
     }
-    file.close();
+    writer.commit (len);
 }
 
 void VectorOutputPlugin::runStartingEvent () {
@@ -108,6 +105,14 @@ void VectorOutputPlugin::runStartingEvent () {
             QDateTime::currentDateTime().toString("_yyMMdd_hhmm") + ".dat");
 
     pathLabel->setText (fileName);
+
+    writer.setConfig (cfg->writer);
+    if (!writer.open (fileName))
+        std::cout << "File could not be opened." << std::endl;
+}
+
+void VectorOutputPlugin::runStoppingEvent () {
+    writer.close ();
 }
 
 typedef ConfMap::confmap_t<VectorOutputConfig> confmap_t;
@@ -118,13 +123,16 @@ static const confmap_t confmap [] = {
 void VectorOutputPlugin::applySettings(QSettings *s) {
     s->beginGroup (getName());
     ConfMap::apply (s, cfg, confmap);
+    cfg->writer.apply (s);
     s->endGroup ();
 
     prefixLineEdit->setText (cfg->prefix);
+    writerUI->applySettings ();
 }
 
 void VectorOutputPlugin::saveSettings(QSettings *s) {
     s->beginGroup (getName());
     ConfMap::save (s, cfg, confmap);
+    cfg->writer.save (s);
     s->endGroup ();
 }
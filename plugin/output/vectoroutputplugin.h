@@ -35,9 +35,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "baseplugin.h"
+#include "filewriter.h"
 
 class BasePlugin;
 class VectorOutputConfig;
+class FileWriterUI;
 
 class VectorOutputPlugin : public BasePlugin
 {
@@ -47,9 +49,11 @@ protected:
     VectorOutputConfig *cfg;
 
     QString fileName;
+    FileWriter writer;
 
     QLabel* pathLabel;
     QLineEdit* prefixLineEdit;
+    FileWriterUI* writerUI;
 
     virtual void createSettings(QGridLayout*);
 
@@ -66,6 +70,8 @@ public:
     virtual void saveSettings(QSettings*);
 
     virtual void runStartingEvent();
+    virtual bool isRecording () const { return true; }
+    virtual void runStoppingEvent();
 
 public slots:
     void prefixChanged();
@@ -21,7 +21,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginmanager.h"
 #include "runmanager.h"
 #include "pluginconnectorqueued.h"
+#include "filewriterui.h"
 
+#include <QtEndian>
+#include <climits>
 
 static PluginRegistrar registrar ("eventbuilder", EventBuilderPlugin::create, AbstractPlugin::GroupPack, EventBuilderPlugin::getEventBuilderAttributeMap());
 
@@ -30,16 +33,19 @@ EventBuilderPlugin::EventBuilderPlugin(int _id, QString _name, const Attributes
             , attribs_ (_attrs)
             , filePrefix("run")
             , port(40000)
+            , index_stride(1000)
             , addr(QHostAddress::LocalHost)
             , net(0)
             , total_bytes_written(0)
             , current_bytes_written(0)
-            , current_file_number(0)
-            , open_new_file(true)
+            , nof_events(0)
             , runPath("/tmp")
             , total_data_length(0)
             , nofEnabledInputs(0)
 {
+    // new file every GiB
+    writerConf.rotate_mib = 1024;
+
     createSettings(settingsLayout);
 
     bool ok;
@@ -86,14 +92,23 @@ void EventBuilderPlugin::createSettings(QGridLayout * l)
         totalBytesWrittenLabel = new QLabel(tr("%1 MBytes").arg(total_bytes_written/1024./1024.));
         currentBytesWrittenLabel = new QLabel(tr("%1 MBytes").arg(current_bytes_written/1024./1024.));
         currentFileNameLabel = new QLabel(makeFileName());
+        // the plugin thread opens the files
+        connect(this,SIGNAL(fileNameChanged(QString)),currentFileNameLabel,SLOT(setText(QString)),Qt::QueuedConnection);
         runPath = RunManager::ptr()->getRunName().toStdString().c_str();
         boost::uintmax_t freeBytes = boost::filesystem::space(runPath).available;
         bytesFreeOnDiskLabel = new QLabel(tr("%1 GBytes").arg((double)(freeBytes/1024./1024./1024.)));
+        writerStallsLabel = new QLabel(tr("0"));
 
         portSpinner = new QSpinBox();
         portSpinner->setMinimum(1024);
         portSpinner->setMaximum(65535);
 
+        indexStrideSpinner = new QSpinBox();
+        indexStrideSpinner->setMinimum(0);
+        indexStrideSpinner->setMaximum(INT_MAX);
+        indexStrideSpinner->setSuffix(tr(" events"));
+        indexStrideSpinner->setSpecialValueText(tr("no index"));
+
         QString Octet = "(?:[0-1]?[0-9]?[0-9]|2[0-4][0-9]|25[0-5])";
         QRegExpValidator* v = new QRegExpValidator(QRegExp("^" + Octet + "\\."
                                                           + Octet + "\\."
@@ -118,10 +133,17 @@ void EventBuilderPlugin::createSettings(QGridLayout * l)
             cl->addWidget(totalBytesWrittenLabel,               3,1,1,1);
             cl->addWidget(new QLabel("Disk free:"),             4,0,1,1);
             cl->addWidget(bytesFreeOnDiskLabel,                 4,1,1,1);
+            cl->addWidget(new QLabel("Writer stalls:"),         5,0,1,1);
+            cl->addWidget(writerStallsLabel,                    5,1,1,1);
+            cl->addWidget(new QLabel("Index every:"),           6,0,1,1);
+            cl->addWidget(indexStrideSpinner,                   6,1,1,1);
             gf->setLayout(cl);
         }
         cl->addWidget(gf,0,0,1,2);
 
+        writerUI = new FileWriterUI(&writerConf);
+        cl->addWidget(writerUI,2,0,1,2);
+
         QGroupBox* gn = new QGroupBox("Network Setup");
         {
             QGridLayout* cl = new QGridLayout();
@@ -138,6 +160,7 @@ void EventBuilderPlugin::createSettings(QGridLayout * l)
         connect(RunManager::ptr(),SIGNAL(runNameChanged()),this,SLOT(updateRunName()));
         connect(portSpinner,SIGNAL(valueChanged(int)),this,SLOT(uiInput()));
         connect(addrEdit,SIGNAL(editingFinished()),this,SLOT(uiInput()));
+        connect(indexStrideSpinner,SIGNAL(valueChanged(int)),this,SLOT(uiInput()));
     }
 
     // End
@@ -148,6 +171,7 @@ void EventBuilderPlugin::createSettings(QGridLayout * l)
 void EventBuilderPlugin::uiInput() {
     port = portSpinner->value();
     addr = QHostAddress(addrEdit->text());
+    index_stride = indexStrideSpinner->value();
 }
 
 void EventBuilderPlugin::applySettings(QSettings* settings)
@@ -156,10 +180,14 @@ void EventBuilderPlugin::applySettings(QSettings* settings)
     settings->beginGroup(getName());
         set = "port";   if(settings->contains(set)) port = settings->value(set).toUInt();
         set = "addr";   if(settings->contains(set)) addr = settings->value(set).toString();
+        set = "index_stride";   if(settings->contains(set)) index_stride = settings->value(set).toUInt();
+        writerConf.apply(settings);
     settings->endGroup();
 
     portSpinner->setValue(port);
     addrEdit->setText(addr.toString());
+    indexStrideSpinner->setValue(index_stride);
+    writerUI->applySettings();
 }
 
 void EventBuilderPlugin::saveSettings(QSettings* settings)
@@ -175,6 +203,8 @@ void EventBuilderPlugin::saveSettings(QSettings* settings)
         settings->beginGroup(getName());
             settings->setValue("port",port);
             settings->setValue("addr",addr.toString());
+            settings->setValue("index_stride",index_stride);
+            writerConf.save(settings);
         settings->endGroup();
         std::cout << " done" << std::endl;
     }
@@ -185,20 +215,18 @@ void EventBuilderPlugin::updateByteCounters() {
     currentBytesWrittenLabel->setText(tr("%1 MBytes").arg(current_bytes_written/1024./1024.,2,'f',3));
     bytesFreeOnDiskLabel->setText(tr("%1 GBytes").arg((double)(freeBytes/1024./1024./1024.),2,'f',3));
     totalBytesWrittenLabel->setText(tr("%1 MBytes").arg(total_bytes_written/1024./1024.,2,'f',3));
+    writerStallsLabel->setText(tr("%1").arg(writer.getStalls()));
 }
 
 void EventBuilderPlugin::updateRunName() {
     runPath = RunManager::ptr()->getRunName().toStdString().c_str();
-    currentFileNameLabel->setText(makeFileName());
-    open_new_file = true;
+    currentFileNameLabel->setText(makeFileName().arg(0,4,10,QChar('0')));
 }
 
+// %1 is replaced by the file number, see FileWriter::open
 QString EventBuilderPlugin::makeFileName() {
-    return RunManager::ptr()->getRunName() +
-            tr("/%1%2%3.dat")
-            .arg(filePrefix)
-            .arg(QDateTime::currentDateTime().toString("_yyMMdd_hhmmss_"))
-            .arg(current_file_number,4,10,QChar('0'));
+    return RunManager::ptr()->getRunName() + "/" + filePrefix +
+            QDateTime::currentDateTime().toString("_yyMMdd_hhmmss_") + "%1.dat";
 }
 
 void EventBuilderPlugin::runStartingEvent() {
@@ -215,8 +243,8 @@ void EventBuilderPlugin::runStartingEvent() {
 
     // Reset counters
     current_bytes_written = 0;
-    current_file_number = 0;
     total_bytes_written = 0;
+    nof_events = 0;
     ch_mask = 0;
 
     // Clear vectors
@@ -228,6 +256,24 @@ void EventBuilderPlugin::runStartingEvent() {
     updateByteCounters();
     nofInputsLabel->setText(tr("%1").arg(nofInputs));
 
+    // Open the first file of the run
+    outDir = QDir(RunManager::ptr()->getRunName());
+    if (outDir.exists()) {
+        writer.setConfig(writerConf);
+        QString fileName = makeFileName();
+        if (writer.open(fileName)) {
+            emit fileNameChanged(writer.getFileName());
+            if (index_stride) index.open(writer, index_stride);
+        }
+    } else {
+        printf("EventBuilder: The output directory does not exist! (%s)\n",outDir.absolutePath().toStdString().c_str());
+    }
+}
+
+void EventBuilderPlugin::runStoppingEvent() {
+    index.close();
+    writer.close();
+    updateByteCounters();
 }
 
 void EventBuilderPlugin::userProcess()
@@ -257,86 +303,82 @@ void EventBuilderPlugin::userProcess()
         }
     }
 
-    // File switch at 1 Gigabyte
-    if(current_bytes_written >= 1024*1024*1024) {
-        open_new_file = true;
-    }
-
-    if(open_new_file == true) {
-        // If necessary, close old file
-        if(outFile.isOpen()) {
-            outFile.close();
+    // Event header
+    uint16_t header = 0xFEED;
+    //uint16_t header_length = 2 + (nofEnabledInputs/2)+1; // in words (INCORRECT)
+    uint16_t header_length = 2 + nofEnabledInputs; // in words (CORRECT)
+    total_data_length += header_length
+                      + (nofEnabledInputs); // To account for separators
+
+    // Encode straight into the file buffer. Without a file, the event is still sent over the network
+    uint32_t* out;
+    if(writer.isOpen()) {
+        out = reinterpret_cast<uint32_t*> (writer.reserve(total_data_length*4));
+
+        // Time stamp from the first input that carries meta words
+        if(index.isDue(writer, nof_events)) {
+            uint64_t timestamp = 0;
+            for(uint32_t i = 0; i < nofInputs && !timestamp; ++i) {
+                if(data_length[i] > 0) timestamp = EventIndex::moduleTimestamp(data[i].constData(), data_length[i]);
+            }
+            index.add(writer, nof_events, ch_mask, timestamp);
         }
+    } else {
+        printf("EventBuilder: File is not open for writing.\n");
+        outData.resize(total_data_length);
+        out = outData.data();
+    }
 
-        // Open new file
-        outDir = QDir(RunManager::ptr()->getRunName());
-        if (outDir.exists()) {
-            outFile.setFileName(makeFileName());
-            outFile.open(QIODevice::WriteOnly);
-            updateRunName();
-            current_bytes_written = 0;
-            ++current_file_number;
-            open_new_file = false;
-        } else {
-            printf("EventBuilder: The output directory does not exist! (%s)\n",outDir.absolutePath().toStdString().c_str());
+    // The file is little endian
+    uchar* hdr = reinterpret_cast<uchar*> (out);
+    qToLittleEndian<quint16>(header, hdr);
+    qToLittleEndian<quint16>(header_length, hdr + 2);
+    qToLittleEndian<quint32>(ch_mask, hdr + 4);
+    uint32_t* p = out + 2;
+
+    // Channel lengths
+    for(uint32_t i = 0; i < nofInputs; ++i) {
+        if(data_length[i] > 0) {
+            *p++ = qToLittleEndian<quint32>(data_length[i]);
         }
     }
 
-    QByteArray netData;
-    QDataStream netOut(&netData,QIODevice::WriteOnly);
-
-    // Write to the file
-    if(outFile.isOpen()) {
-        QDataStream out(&outFile);
-
-        out.setByteOrder(QDataStream::LittleEndian);
-
-        // Event header
-        uint16_t header = 0xFEED;
-        //uint16_t header_length = 2 + (nofEnabledInputs/2)+1; // in words (INCORRECT)
-        uint16_t header_length = 2 + nofEnabledInputs; // in words (CORRECT)
-        total_data_length += header_length
-                          + (nofEnabledInputs); // To account for separators
-
-        out << header;
-        out << header_length;
-        out << ch_mask;
-
-        netOut << header;
-        netOut << header_length;
-        netOut << ch_mask;
-
-        // Write channel lengths
-        for(uint32_t i = 0; i < nofInputs; ++i) {
-            if(data_length[i] > 0) {
-                out << data_length[i];
-                netOut << data_length[i];
+    // Channel data with separators
+    for(uint32_t ch = 0; ch < nofInputs; ++ch) {
+        if(data_length[ch] > 0) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            memcpy(p, data[ch].constData(), data_length[ch]*4);
+            p += data_length[ch];
+#else
+            for(uint32_t i = 0; i < data_length[ch]; ++i) {
+                *p++ = qToLittleEndian<quint32>(data[ch][i]);
             }
+#endif
+            *p++ = 0xFFFFFFFF;
         }
+    }
 
-        // Write channel data with separators
-        for(uint32_t ch = 0; ch < nofInputs; ++ch) {
-            if(data_length[ch] > 0) {
-                for(uint32_t i = 0; i < data_length[ch]; ++i) {
-                    out << data[ch][i];
-                    netOut << data[ch][i];
-                }
-                uint32_t separator = 0xFFFFFFFF;
-                out << separator;
-                netOut << separator;
-            }
-        }
+    // The network stream stays big endian
+    QByteArray netData(total_data_length*4, 0);
+    uchar* net_out = reinterpret_cast<uchar*> (netData.data());
+    qToBigEndian<quint16>(header, net_out);
+    qToBigEndian<quint16>(header_length, net_out + 2);
+    for(uint32_t i = 1; i < total_data_length; ++i) {
+        qToBigEndian<quint32>(qFromLittleEndian<quint32>(reinterpret_cast<uchar*> (out + i)), net_out + 4*i);
+    }
 
-        current_bytes_written += total_data_length * 4;
+    if(writer.isOpen()) {
+        writer.commit(total_data_length*4);
+        current_bytes_written = writer.getFileBytes();
         total_bytes_written += total_data_length * 4;
-    } else {
-        printf("EventBuilder: File is not open for writing.\n");
     }
+    ++nof_events;
 
     // Write to network
     net->writeDatagram(netData,addr,port);
 
     if(lastUpdateTime.msecsTo(QTime::currentTime()) > 500) {
+        emit fileNameChanged(writer.getFileName());
         updateByteCounters();
         lastUpdateTime.start();
     }
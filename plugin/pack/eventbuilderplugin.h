@@ -40,8 +40,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <boost/filesystem/convenience.hpp>
 
 #include "baseplugin.h"
+#include "filewriter.h"
+#include "eventindex.h"
 
 class BasePlugin;
+class FileWriterUI;
 
 class EventBuilderPlugin : public BasePlugin
 {
@@ -55,29 +58,33 @@ protected:
     QLabel* currentFileNameLabel;
     QLabel* currentBytesWrittenLabel;
     QLabel* bytesFreeOnDiskLabel;
+    QLabel* writerStallsLabel;
     QLabel* nofInputsLabel;
     QLineEdit* addrEdit;
     QSpinBox* portSpinner;
+    QSpinBox* indexStrideSpinner;
+    FileWriterUI* writerUI;
 
     QVector<uint32_t> outData;
     Attributes attribs_;
 
-    QFile outFile;
+    FileWriterConfig writerConf;
+    FileWriter writer;
+    EventIndexWriter index;
     QDir outDir;
     QTime lastUpdateTime;
 
     QString filePrefix;
 
     uint16_t port;
+    uint32_t index_stride; // events between index entries, 0 disables the index
     QHostAddress addr;
 
     QUdpSocket* net;
 
     uint64_t total_bytes_written;
-    uint32_t current_bytes_written;
-    uint32_t current_file_number;
-
-    bool open_new_file;
+    uint64_t current_bytes_written;
+    uint64_t nof_events;
 
     boost::filesystem::path runPath;
 
@@ -95,13 +102,19 @@ public:
     virtual void userProcess();
     virtual void applySettings(QSettings*);
     virtual void saveSettings(QSettings*);
+    virtual bool isRecording () const { return true; }
 
 public slots:
     void updateRunName();
     void updateByteCounters();
     void runStartingEvent();
+    void runStoppingEvent();
     void uiInput();
 
+signals:
+    /*! Updates the name of the current file in the UI from the GUI thread. */
+    void fileNameChanged(QString);
+
 private:
     uint32_t nofInputs;
     uint32_t total_data_length;